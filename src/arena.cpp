@@ -0,0 +1,111 @@
+/*!
+ *
+ * \file arena.cpp
+ * \brief CArena routines
+ * \details Per-timestep (monotonic) memory allocation for coastline, profile, and polygon objects
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include "cme.h"
+#include "arena.h"
+
+
+//! Constructor, the parameter is the default size (bytes) of each block
+CArena::CArena(size_t const tBlockSize)
+:
+   m_tBlockSize(tBlockSize),
+   m_tOffset(0),
+   m_nBlock(0),
+   m_ulResets(0),
+   m_ulBytesInUse(0),
+   m_ulMaxBytesInUse(0)
+{
+}
+
+CArena::~CArena(void)
+{
+   for (unsigned int n = 0; n < m_pcVBlock.size(); n++)
+      ::operator delete(m_pcVBlock[n]);
+}
+
+
+//! Returns storage for tBytes bytes with the given alignment. Blocks which are left over from before the last reset are re-used before any new block is allocated
+void* CArena::pAllocate(size_t const tBytes, size_t const tAlign)
+{
+   while (m_nBlock < m_pcVBlock.size())
+   {
+      // Round the offset up to the required alignment (::operator new returns storage which is suitably aligned for any type, so the start of each block is aligned)
+      size_t tStart = (m_tOffset + tAlign - 1) & ~(tAlign - 1);
+      if (tStart + tBytes <= m_tVBlockSize[m_nBlock])
+      {
+         m_tOffset = tStart + tBytes;
+         m_ulBytesInUse += tBytes;
+         m_ulMaxBytesInUse = tMax(m_ulMaxBytesInUse, m_ulBytesInUse);
+
+         return m_pcVBlock[m_nBlock] + tStart;
+      }
+
+      // Does not fit, so move on to the next block
+      m_nBlock++;
+      m_tOffset = 0;
+   }
+
+   // We need a new block, make sure that it is big enough for this request
+   size_t tSize = tMax(m_tBlockSize, tBytes);
+   m_pcVBlock.push_back(static_cast<char*>(::operator new(tSize)));
+   m_tVBlockSize.push_back(tSize);
+
+   m_nBlock = m_pcVBlock.size()-1;
+   m_tOffset = tBytes;
+   m_ulBytesInUse += tBytes;
+   m_ulMaxBytesInUse = tMax(m_ulMaxBytesInUse, m_ulBytesInUse);
+
+   return m_pcVBlock[m_nBlock];
+}
+
+
+//! Makes all of the arena's storage available again. Any objects which were constructed in the arena must already have been destroyed
+void CArena::Reset(void)
+{
+   m_nBlock = 0;
+   m_tOffset = 0;
+   m_ulBytesInUse = 0;
+   m_ulResets++;
+}
+
+
+unsigned long CArena::ulGetResets(void) const
+{
+   return m_ulResets;
+}
+
+unsigned long CArena::ulGetMaxBytesInUse(void) const
+{
+   return m_ulMaxBytesInUse;
+}
+
+//! Returns the total size (bytes) of all blocks held by the arena
+unsigned long CArena::ulGetBytesReserved(void) const
+{
+   unsigned long ulTot = 0;
+   for (unsigned int n = 0; n < m_tVBlockSize.size(); n++)
+      ulTot += m_tVBlockSize[n];
+
+   return ulTot;
+}
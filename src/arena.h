@@ -0,0 +1,123 @@
+/*!
+ *
+ * \class CArena
+ * \brief Class used for per-timestep (monotonic) memory allocation
+ * \details Coastline, profile, and polygon objects only live for a single timestep (or for two timesteps, if coastlines are re-traced incrementally). So rather than allocating and freeing memory for each of them individually, storage is taken from large blocks, with a 'bump pointer'. Nothing is freed individually: instead, the whole arena is reset in one go at the start of a later timestep, and its blocks are then re-used
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file arena.h
+ * \brief Contains CArena and CArenaAllocator definitions
+ *
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <cstddef>
+using std::size_t;
+
+#include <new>
+
+#include <type_traits>
+
+#include <vector>
+using std::vector;
+
+
+class CArena
+{
+private:
+   size_t
+      m_tBlockSize,                       // Default size (bytes) of each new block
+      m_tOffset;                          // Offset of the first free byte in the current block
+
+   unsigned int
+      m_nBlock;                           // The block from which storage is currently being taken
+
+   unsigned long
+      m_ulResets,
+      m_ulBytesInUse,                     // Bytes handed out since the last reset
+      m_ulMaxBytesInUse;                  // Greatest value of m_ulBytesInUse
+
+   vector<char*>
+      m_pcVBlock;
+
+   vector<size_t>
+      m_tVBlockSize;
+
+public:
+   explicit CArena(size_t const = 1048576);
+   ~CArena(void);
+
+   void* pAllocate(size_t const, size_t const);
+   void Reset(void);
+
+   unsigned long ulGetResets(void) const;
+   unsigned long ulGetMaxBytesInUse(void) const;
+   unsigned long ulGetBytesReserved(void) const;
+};
+
+
+//! A minimal C++11 allocator which takes storage from a CArena, so that it can be used with standard containers. If the arena pointer is NULL, then the allocator falls back to the ordinary heap
+template <class T> class CArenaAllocator
+{
+public:
+   typedef T value_type;
+
+   // These are needed so that containers which are assigned or swapped also take the other container's arena
+   typedef std::true_type propagate_on_container_copy_assignment;
+   typedef std::true_type propagate_on_container_move_assignment;
+   typedef std::true_type propagate_on_container_swap;
+
+   CArena* m_pArena;
+
+   CArenaAllocator(CArena* const pArena = NULL)
+   :  m_pArena(pArena)
+   {
+   }
+
+   template <class U> CArenaAllocator(CArenaAllocator<U> const& Other)
+   :  m_pArena(Other.m_pArena)
+   {
+   }
+
+   T* allocate(size_t const n)
+   {
+      if (m_pArena == NULL)
+         return static_cast<T*>(::operator new(n * sizeof(T)));
+
+      return static_cast<T*>(m_pArena->pAllocate(n * sizeof(T), alignof(T)));
+   }
+
+   void deallocate(T* const p, size_t const)
+   {
+      // Storage which came from an arena is only given back when the arena is reset
+      if (m_pArena == NULL)
+         ::operator delete(p);
+   }
+};
+
+template <class T, class U> bool operator==(CArenaAllocator<T> const& a, CArenaAllocator<U> const& b)
+{
+   return a.m_pArena == b.m_pArena;
+}
+
+template <class T, class U> bool operator!=(CArenaAllocator<T> const& a, CArenaAllocator<U> const& b)
+{
+   return a.m_pArena != b.m_pArena;
+}
+#endif // ARENA_H
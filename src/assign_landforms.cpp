@@ -32,14 +32,11 @@ using std::endl;
 #include "cme.h"
 #include "simulation.h"
 #include "coast.h"
-#include "cliff.h"
-#include "drift.h"
-#include "intervention.h"
 
 
 /*==============================================================================================================================
 
- Each timestep, classify coastal landforms and assign a coastal landform object to every point on every coastline. If, for a given cell, the coastal landform class has not changed then it inherits values from the previous timestep
+ Each timestep, classify coastal landforms and assign a coastal landform to every point on every coastline. If, for a given cell, the coastal landform class has not changed then it inherits values from the previous timestep
 
 ===============================================================================================================================*/
 int CSimulation::nAssignAllCoastalLandforms(void)
@@ -49,7 +46,7 @@ int CSimulation::nAssignAllCoastalLandforms(void)
    {
       for (int j = 0; j < m_VCoast[nCoast].nGetCoastlineSize(); j++)
       {
-         // Get the coords of the grid cell marked as coastline for the coastal landform object
+         // Get the coords of the grid cell marked as coastline for the coastal landform
          int 
             nX = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(j)->nGetX(),
             nY = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(j)->nGetY();
@@ -61,9 +58,8 @@ int CSimulation::nAssignAllCoastalLandforms(void)
          // OK, start assigning coastal landforms. First, is there an intervention here?
          if (m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->nGetLFCategory() == LF_CAT_INTERVENTION)
          {
-            // There is, so create an intervention object on the vector coastline with these attributes
-            CACoastLandform* pIntervention = new CRWIntervention(&m_VCoast[nCoast], nCoast, j);
-            m_VCoast[nCoast].AppendCoastLandform(pIntervention);
+            // There is, so put an intervention on the vector coastline
+            m_VCoast[nCoast].AppendCoastLandform(LF_CAT_INTERVENTION, 0, 0, 0, 0);
             
             continue;
          }
@@ -92,26 +88,24 @@ int CSimulation::nAssignAllCoastalLandforms(void)
 
          if (m_ulTimestep == 1)
          {
-            // The first timestep: no coastal landforms (other than interventions) already exist, so no grid cells are flagged with coastal landform attributes. So we must update the grid now using the initial values for the coastal landform object's attributes, ready for nLandformToGrid() at the end of the first timestep
+            // The first timestep: no coastal landforms (other than interventions) already exist, so no grid cells are flagged with coastal landform attributes. So we must update the grid now using the initial values for the coastal landform's attributes, ready for nLandformToGrid() at the end of the first timestep
             if (bConsSedAtSWL)
             {
-               // First timestep: we have consolidated sediment at SWL, so this is a cliff cell. Set some initial values for the cliff object's attributes
+               // First timestep: we have consolidated sediment at SWL, so this is a cliff cell. Set some initial values for the cliff's attributes
                m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetLFSubCategory(LF_SUBCAT_CLIFF_ON_COASTLINE);
                m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetCliffNotchBaseElev(m_dMinSWL);
                m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetCliffNotchOverhang(0);
                m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetCliffRemaining(m_dCellSide);
 
-               // Create a cliff object on the vector coastline with these attributes
-               CACoastLandform* pCliff = new CRWCliff(&m_VCoast[nCoast], nCoast, j, m_dCellSide, m_dMinSWL, 0, 0);
-               m_VCoast[nCoast].AppendCoastLandform(pCliff);
+               // Put a cliff on the vector coastline with these attributes
+               m_VCoast[nCoast].AppendCoastLandform(LF_CAT_CLIFF, m_dCellSide, m_dMinSWL, 0, 0);
 
 //                LogStream << m_ulTimestep << ": CLIFF CREATED [" << nX << "][" << nY << "] = {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
             }
             else
             {
-               // First timestep: we have unconsolidated sediment at SWL, so this is a drift cell: create a drift object on the vector coastline with these attributes
-               CACoastLandform* pDrift = new CRWDrift(&m_VCoast[nCoast], nCoast, j);
-               m_VCoast[nCoast].AppendCoastLandform(pDrift);
+               // First timestep: we have unconsolidated sediment at SWL, so this is a drift cell: put drift on the vector coastline
+               m_VCoast[nCoast].AppendCoastLandform(LF_CAT_DRIFT, 0, 0, 0, 0);
 
                // Safety check
                if (m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->nGetLFCategory() != LF_CAT_DRIFT)
@@ -136,7 +130,7 @@ int CSimulation::nAssignAllCoastalLandforms(void)
                // Get the existing landform category of this cell
                if (m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->nGetLFCategory() == LF_CAT_CLIFF)
                {
-                  // This cell was a cliff in a previous timestep, so get the data stored in the cell, this will be stored in the cliff object on the vector coastline
+                  // This cell was a cliff in a previous timestep, so get the data stored in the cell, this will be stored with the cliff on the vector coastline
                   m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetLFSubCategory(LF_SUBCAT_CLIFF_ON_COASTLINE);
                   dAccumWaveEnergy = m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->dGetAccumWaveEnergy(),
                   dNotchOverhang   = m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->dGetCliffNotchOverhang(),
@@ -147,7 +141,7 @@ int CSimulation::nAssignAllCoastalLandforms(void)
                }
                else
                {
-                  // This cell was not a cliff object in a previous timestep, so mark it as one now and set the cell with the default values for the cliff object's attributes
+                  // This cell was not a cliff in a previous timestep, so mark it as one now and set the cell with the default values for the cliff's attributes
                   m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetLFSubCategory(LF_SUBCAT_CLIFF_ON_COASTLINE);
                   dAccumWaveEnergy = m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->dGetAccumWaveEnergy(),
                   m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetCliffNotchOverhang(dNotchOverhang);
@@ -157,15 +151,13 @@ int CSimulation::nAssignAllCoastalLandforms(void)
 //                   LogStream << m_ulTimestep << ": CLIFF CREATED [" << nX << "][" << nY << "] = {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
                }
 
-               // Create a cliff object on the vector coastline with these attributes
-               CACoastLandform* pCliff = new CRWCliff(&m_VCoast[nCoast], nCoast, j, dRemaining, dNotchBaseElev, dNotchOverhang, dAccumWaveEnergy);
-               m_VCoast[nCoast].AppendCoastLandform(pCliff);
+               // Put a cliff on the vector coastline with these attributes
+               m_VCoast[nCoast].AppendCoastLandform(LF_CAT_CLIFF, dRemaining, dNotchBaseElev, dNotchOverhang, dAccumWaveEnergy);
             }
             else
             {
-               // We have unconsolidated sediment at SWL, so this is a drift cell: create a drift object on the vector coastline with these attributes
-               CACoastLandform* pDrift = new CRWDrift(&m_VCoast[nCoast], nCoast, j);
-               m_VCoast[nCoast].AppendCoastLandform(pDrift);
+               // We have unconsolidated sediment at SWL, so this is a drift cell: put drift on the vector coastline
+               m_VCoast[nCoast].AppendCoastLandform(LF_CAT_DRIFT, 0, 0, 0, 0);
 
                // Safety check
                if (m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->nGetLFCategory() != LF_CAT_DRIFT)
@@ -278,33 +270,29 @@ int CSimulation::nAssignAllCoastalLandforms(void)
 
 /*===============================================================================================================================
 
- At the end of each timestep, this routine stores the attributes from a single coastal landform object in the grid cell 'under' the object, ready for the next timestep
+ At the end of each timestep, this routine stores the attributes of the coastal landform at a single coast point in the grid cell 'under' the landform, ready for the next timestep
 
 ===============================================================================================================================*/
 int CSimulation::nLandformToGrid(int const nCoast, int const nPoint)
 {
    // What is the coastal landform here?
-   CACoastLandform* pCoastLandform = m_VCoast[nCoast].pGetCoastLandform(nPoint);
-   int nCategory = pCoastLandform->nGetLandFormCategory();
+   int nCategory = m_VCoast[nCoast].nGetLandformCategory(nPoint);
 
    if (nCategory == LF_CAT_CLIFF)
    {
-      // It's a cliff
-      CRWCliff* pCliff = reinterpret_cast<CRWCliff*>(pCoastLandform);
-
-      // Get attribute values from the cliff object
-      double dNotchBaseElev = pCliff->dGetNotchBaseElev();
-      double dNotchOverhang = pCliff->dGetNotchOverhang();
-      double dRemaining = pCliff->dGetRemaining();
+      // It's a cliff, so get its attribute values
+      double dNotchBaseElev = m_VCoast[nCoast].dGetCliffNotchBaseElev(nPoint);
+      double dNotchOverhang = m_VCoast[nCoast].dGetCliffNotchOverhang(nPoint);
+      double dRemaining = m_VCoast[nCoast].dGetCliffRemaining(nPoint);
 
       int nX = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nPoint)->nGetX();
       int nY = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nPoint)->nGetY();
 
-      if (pCliff->bAllSedimentGone())
+      if (m_VCoast[nCoast].bCliffAllSedimentGone(nPoint))
       {
 //         cout << m_ulTimestep << ": cell [" << nX << "][" << nY << "] before removing cliff, dGetVolEquivSedTopElev() = " << m_pRasterGrid->m_Cell[nX][nY].dGetVolEquivSedTopElev() << ", dGetSedimentTopElev() = " << m_pRasterGrid->m_Cell[nX][nY].dGetSedimentTopElev() << endl;
 
-         // All the sediment is gone from this cliff object via cliff collapse, so this cell is no longer a cliff
+         // All the sediment is gone from this cliff via cliff collapse, so this cell is no longer a cliff
          m_pRasterGrid->m_Cell[nX][nY].SetInContiguousSea();
 
          // Check the x-y extremities of the contiguous sea for the bounding box (used later in wave propagation)
@@ -343,7 +331,7 @@ int CSimulation::nLandformToGrid(int const nCoast, int const nPoint)
       }
       else
       {
-         // Still some sediment available in this cliff object, so store the attribute values in the cell
+         // Still some sediment available in this cliff, so store the attribute values in the cell
          m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetLFSubCategory(LF_SUBCAT_CLIFF_ON_COASTLINE);
          m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetCliffNotchBaseElev(dNotchBaseElev);
          m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetCliffNotchOverhang(dNotchOverhang);
@@ -353,7 +341,7 @@ int CSimulation::nLandformToGrid(int const nCoast, int const nPoint)
       }
 
       // Always accumulate wave energy
-      m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetAccumWaveEnergy(pCliff->dGetTotAccumWaveEnergy());
+      m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetAccumWaveEnergy(m_VCoast[nCoast].dGetTotAccumWaveEnergy(nPoint));
    }
    else if (nCategory == LF_CAT_DRIFT)
    {
@@ -372,24 +360,33 @@ int CSimulation::nLandformToGrid(int const nCoast, int const nPoint)
 ===============================================================================================================================*/
 int CSimulation::nAssignNonCoastlineLandforms(void)
 {
-   // Go through all cells in the RasterGrid array
+   // Go through all cells in the RasterGrid array. If the grid is tiled, only visit the tiles which have been in use during this timestep or the last: no other cell can be coastline now, or can have been coastline (and so perhaps a cliff) during the last timestep. This only changes landform subcategories, which are kept from one timestep to the next, so is a passive sweep: otherwise every tile which it visits would count as in use, and so be visited again next timestep
+   m_pRasterGrid->m_Cell.StartPassiveSweep();
+   vector<pair<int, int> > prVRun;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
-      for (int nY = 0; nY < m_nYGridMax; nY++)
+      m_pRasterGrid->m_Cell.GetActiveRuns(nX, 2, &prVRun);
+      for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
       {
-         if ((! m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (! m_pRasterGrid->m_Cell[nX][nY].bIsCoastline()))
+         for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
          {
-            // Is dry land but is not coastline
-            if (m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->nGetLFCategory() == LF_CAT_CLIFF)
+            if ((! m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (! m_pRasterGrid->m_Cell[nX][nY].bIsCoastline()))
             {
-               // This was a cliff during the last timestep, but it is no longer on the coastline. So classify it as a former cliff
-               m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetLFSubCategory(LF_SUBCAT_CLIFF_INLAND);
+               // Is dry land but is not coastline
+               if (m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->nGetLFCategory() == LF_CAT_CLIFF)
+               {
+                  // This was a cliff during the last timestep, but it is no longer on the coastline. So classify it as a former cliff
+                  m_pRasterGrid->m_Cell[nX][nY].pGetLandform()->SetLFSubCategory(LF_SUBCAT_CLIFF_INLAND);
 
 //                LogStream << m_ulTimestep << ": FORMER CLIFF CREATED from cliff landform [" << nX << "][" << nY << "] = {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
+               }
             }
          }
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
+   m_pRasterGrid->m_Cell.EndPassiveSweep();
 
    return RTN_OK;
 }
@@ -0,0 +1,163 @@
+/*!
+ *
+ * \file beach_profile_cache.cpp
+ * \brief CBeachProfileCache routines
+ * \details Keeps the geometry of parallel profiles from the estimation of actual beach erosion, for re-use during actual beach erosion in the same timestep
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <cmath>
+
+#include "cme.h"
+#include "beach_profile_cache.h"
+
+
+CBeachProfileCache::CBeachProfileCache(void)
+:
+   m_ulHits(0),
+   m_ulMisses(0),
+   m_nEntries(0)
+{
+}
+
+CBeachProfileCache::~CBeachProfileCache(void)
+{
+}
+
+
+//! Empties the cache, this is done at the start of beach erosion each timestep. The storage of each entry is kept for re-use, but the map of keys to entries is rebuilt
+void CBeachProfileCache::Clear(void)
+{
+   m_nEntries = 0;
+   m_nMKeyToEntry.clear();
+}
+
+
+//! Looks for the parallel profile which was constructed for the given polygon, direction and coast point. Returns the entry number, or INT_NODATA if there is none or if it was constructed with a different x-y offset
+int CBeachProfileCache::nFindEntry(int const nPolyID, int const nDirection, int const nCoastPoint, int const nXOffset, int const nYOffset)
+{
+   map<pair<pair<int, int>, int>, int>::iterator it = m_nMKeyToEntry.find(std::make_pair(std::make_pair(nPolyID, nDirection), nCoastPoint));
+   if ((it == m_nMKeyToEntry.end()) || (m_VEntry[it->second].nXOffset != nXOffset) || (m_VEntry[it->second].nYOffset != nYOffset))
+   {
+      m_ulMisses++;
+      return INT_NODATA;
+   }
+
+   m_ulHits++;
+   return it->second;
+}
+
+
+//! Adds a parallel profile (at an inland offset of zero) to the cache, and returns its entry number
+int CBeachProfileCache::nAddEntry(int const nPolyID, int const nDirection, int const nCoastPoint, int const nXOffset, int const nYOffset, vector<CGeom2DIPoint> const* pPtiVCell)
+{
+   if (m_nEntries == m_VEntry.size())
+      m_VEntry.push_back(CacheEntry());
+
+   int nEntry = m_nEntries++;
+
+   // Assignment re-uses the entry's existing storage, if there is enough of it. The Dean profile shapes of a re-used entry are kept, and are overwritten as inland offsets are added
+   m_VEntry[nEntry].nXOffset = nXOffset;
+   m_VEntry[nEntry].nYOffset = nYOffset;
+   m_VEntry[nEntry].PtiVCell = *pPtiVCell;
+   m_VEntry[nEntry].nInlandOffsets = 0;
+
+   m_nMKeyToEntry[std::make_pair(std::make_pair(nPolyID, nDirection), nCoastPoint)] = nEntry;
+
+   return nEntry;
+}
+
+
+//! Appends a landward cell to a cached parallel profile, as the profile is extended inland
+void CBeachProfileCache::AppendCell(int const nEntry, CGeom2DIPoint const* pPti)
+{
+   m_VEntry[nEntry].PtiVCell.push_back(*pPti);
+}
+
+
+//! Calculates, stores and returns the Dean profile shape for a cached parallel profile at its present inland offset, given the profile's length. The calculation is the same as in the Dean profile loops, so results are identical
+vector<double> const* CBeachProfileCache::pdVAddDeanShape(int const nEntry, double const dLength)
+{
+   CacheEntry* pEntry = &m_VEntry[nEntry];
+   int nLen = pEntry->PtiVCell.size();
+
+   int nOffset = pEntry->nInlandOffsets++;
+   if (nOffset == static_cast<int>(pEntry->dVLength.size()))
+   {
+      pEntry->dVLength.push_back(0);
+      pEntry->dVVDeanShape.push_back(vector<double>());
+   }
+
+   // Assignment re-uses the shape's existing storage, if there is enough of it
+   pEntry->dVLength[nOffset] = dLength;
+   vector<double>& dVShape = pEntry->dVVDeanShape[nOffset];
+   dVShape.assign(nLen + 1, 0);
+
+   double const dPower = 2.0 / 3.0;
+   dVShape[0] = pow(dLength, dPower);
+
+   double
+      dDistFromParProfStart = 0,
+      dInc = dLength / (nLen-1);
+   for (int n = 0; n < nLen; n++)
+   {
+      dVShape[n+1] = pow(dDistFromParProfStart, dPower);
+      dDistFromParProfStart += dInc;
+   }
+
+   return &dVShape;
+}
+
+
+int CBeachProfileCache::nGetNumCells(int const nEntry) const
+{
+   return m_VEntry[nEntry].PtiVCell.size();
+}
+
+CGeom2DIPoint const* CBeachProfileCache::pPtiGetCell(int const nEntry, int const n) const
+{
+   return &m_VEntry[nEntry].PtiVCell[n];
+}
+
+//! Returns the number of inland offsets for which the parallel profile's length and Dean profile shape are cached
+int CBeachProfileCache::nGetNumInlandOffsets(int const nEntry) const
+{
+   return m_VEntry[nEntry].nInlandOffsets;
+}
+
+double CBeachProfileCache::dGetLength(int const nEntry, int const nInlandOffset) const
+{
+   return m_VEntry[nEntry].dVLength[nInlandOffset];
+}
+
+vector<double> const* CBeachProfileCache::pdVGetDeanShape(int const nEntry, int const nInlandOffset) const
+{
+   return &m_VEntry[nEntry].dVVDeanShape[nInlandOffset];
+}
+
+
+unsigned long CBeachProfileCache::ulGetHits(void) const
+{
+   return m_ulHits;
+}
+
+unsigned long CBeachProfileCache::ulGetMisses(void) const
+{
+   return m_ulMisses;
+}
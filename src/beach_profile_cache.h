@@ -0,0 +1,98 @@
+/*!
+ *
+ * \class CBeachProfileCache
+ * \brief Class used to keep the geometry of the parallel profiles which are constructed while estimating actual beach erosion, so that it can be re-used during actual beach erosion
+ * \details While estimating actual beach erosion on a polygon, and again while doing actual beach erosion on that polygon, a profile is constructed at each coast point which is parallel to one of the polygon's boundary profiles, and is extended inland one cell at a time until a Dean equilibrium profile fitted to it gives enough erosion. For each inland offset, the length of the parallel profile and the elevation-independent part of the Dean profile (pow(length, 2/3), then pow(distance, 2/3) for each cell) are calculated. All of this depends only on the cells under the parallel profile, and these depend only on the polygon, the direction, the coast point, and the x-y offset between the coast point and the end of the boundary part-profile. So the geometry is recorded during estimation and re-used during actual erosion if the offset is unchanged. Elevations are not kept, since actual erosion changes them as it goes
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file beach_profile_cache.h
+ * \brief Contains CBeachProfileCache definitions
+ *
+ */
+
+#ifndef BEACHPROFILECACHE_H
+#define BEACHPROFILECACHE_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <vector>
+using std::vector;
+
+#include <map>
+using std::map;
+
+#include <utility>
+using std::pair;
+
+#include "2di_point.h"
+
+
+class CBeachProfileCache
+{
+private:
+   struct CacheEntry
+   {
+      int
+         nXOffset,                        // The x-y offset between the coast point and the end of the boundary part-profile
+         nYOffset;
+
+      vector<CGeom2DIPoint>
+         PtiVCell;                        // The cells under the parallel profile, in reverse (sea to coast) sequence, as far inland as the profile was extended
+
+      int
+         nInlandOffsets;                  // The number of inland offsets in dVLength and dVVDeanShape which are in use. Those beyond this are kept (with their storage) for re-use
+
+      vector<double>
+         dVLength;                        // For each inland offset, the length of the parallel profile (external CRS units)
+
+      vector<vector<double> >
+         dVVDeanShape;                    // For each inland offset, pow(length, 2/3) followed by pow(distance, 2/3) for each cell on the parallel profile
+   };
+
+   unsigned long
+      m_ulHits,
+      m_ulMisses;
+
+   // Number of entries in m_VEntry which are in use. Entries beyond this are kept (with their storage, including that of their Dean profile shapes) for re-use after the cache is cleared
+   unsigned int
+      m_nEntries;
+
+   vector<CacheEntry>
+      m_VEntry;
+
+   map<pair<pair<int, int>, int>, int>
+      m_nMKeyToEntry;                     // Maps (polygon global ID, direction, coast point) to a slot in m_VEntry
+
+public:
+   CBeachProfileCache(void);
+   ~CBeachProfileCache(void);
+
+   void Clear(void);
+
+   int nFindEntry(int const, int const, int const, int const, int const);
+   int nAddEntry(int const, int const, int const, int const, int const, vector<CGeom2DIPoint> const*);
+   void AppendCell(int const, CGeom2DIPoint const*);
+   vector<double> const* pdVAddDeanShape(int const, double const);
+
+   int nGetNumCells(int const) const;
+   CGeom2DIPoint const* pPtiGetCell(int const, int const) const;
+   int nGetNumInlandOffsets(int const) const;
+   double dGetLength(int const, int const) const;
+   vector<double> const* pdVGetDeanShape(int const, int const) const;
+
+   unsigned long ulGetHits(void) const;
+   unsigned long ulGetMisses(void) const;
+};
+#endif // BEACHPROFILECACHE_H
@@ -0,0 +1,385 @@
+/*!
+ *
+ * \file benchmark.cpp
+ * \brief CBenchmark routines
+ * \details Times individual stages of a CoastalME timestep, on a synthetic scenario
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <algorithm>
+using std::sort;
+
+#include <chrono>
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+#include <fstream>
+using std::ofstream;
+
+#include <iomanip>
+using std::setw;
+using std::fixed;
+using std::setprecision;
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::ios;
+
+#include "cme.h"
+#include "simulation.h"
+#include "raster_grid.h"
+#include "coast.h"
+#include "parallel_profile_cache.h"
+#include "synthetic_dem.h"
+#include "benchmark.h"
+
+
+static string const BENCH_STAGE_NAME[BENCH_NUM_STAGES] = { "FloodFillSea", "nTraceCoastLine", "nCreateAllNormalProfiles", "nModifyAllIntersectingProfiles", "MarkPolygonCells", "nInterpolateWavePropertiesToSeaCells", "bWriteRasterGISFloat" };
+
+
+//! Returns the time (ms) since a given time
+static double dGetElapsedMs(steady_clock::time_point const& tStart)
+{
+   return duration<double, std::milli>(steady_clock::now() - tStart).count();
+}
+
+
+CBenchmark::CBenchmark(CSimulation* pSim, CSyntheticDEM* pDEM)
+:
+   m_pSim(pSim),
+   m_pDEM(pDEM)
+{
+   m_dVVStageTime.resize(BENCH_NUM_STAGES);
+}
+
+CBenchmark::~CBenchmark(void)
+{
+}
+
+
+/*===============================================================================================================================
+
+ Sets up the simulation object, in the same way as CSimulation::nDoSimulation() does. All settings are read from the run-data file, but the basement DEM and sediment layers are replaced by the synthetic scenario, which is written to the output folder. Other initial raster files (suspended sediment, landforms, interventions) are ignored
+
+===============================================================================================================================*/
+int CBenchmark::nSetUp(string const& strCMEDir, string const& strDataPathName, string const& strOutPath)
+{
+   CSimulation* pSim = m_pSim;
+
+   pSim->m_strCMEDir = strCMEDir;
+   pSim->m_strDataPathName = strDataPathName;
+   pSim->m_strOutPath = strOutPath;
+
+   if (! pSim->bReadRunData())
+      return RTN_ERR_RUNDATA;
+
+   // Only COVE is supported, since CShore writes its input and output files to the working folder and so would swamp the timings
+   pSim->m_nWavePropagationModel = MODEL_COVE;
+
+   if (! pSim->bOpenLogFile())
+      return RTN_ERR_LOGFILE;
+
+   pSim->InitRand0(pSim->m_ulRandSeed[0]);
+   pSim->InitRand1(pSim->m_ulRandSeed[1]);
+
+   if (pSim->m_nCoastSmooth == SMOOTH_SAVITZKY_GOLAY)
+      pSim->CalcSavitzkyGolayCoeffs();
+
+   // Write the synthetic scenario, relative to the run-data file's initial still water level
+   cout << "Writing " << m_pDEM->nGetSize() << " x " << m_pDEM->nGetSize() << " synthetic scenario with " << m_pDEM->nGetLayers() << " layer(s) to " << strOutPath << endl;
+   m_pDEM->SetStillWaterLevel(pSim->m_dOrigSWL);
+   if (! m_pDEM->bWriteAll(strOutPath))
+      return RTN_ERR_DEMFILE;
+
+   // Now use it instead of the run-data file's initial rasters
+   pSim->m_strInitialBasementDEMFile = m_pDEM->strGetBasementDEMFile();
+
+   // The number of layers may differ from the run-data file's, so resize everything which is per-layer
+   pSim->m_nLayers = m_pDEM->nGetLayers();
+   pSim->m_VstrInitialFineUnconsSedimentFile.resize(pSim->m_nLayers);
+   pSim->m_VstrInitialSandUnconsSedimentFile.resize(pSim->m_nLayers);
+   pSim->m_VstrInitialCoarseUnconsSedimentFile.resize(pSim->m_nLayers);
+   pSim->m_VstrInitialFineConsSedimentFile.resize(pSim->m_nLayers);
+   pSim->m_VstrInitialSandConsSedimentFile.resize(pSim->m_nLayers);
+   pSim->m_VstrInitialCoarseConsSedimentFile.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUFDriverCode.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUFDriverDesc.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUFProjection.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUFDataType.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUSDriverCode.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUSDriverDesc.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUSProjection.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUSDataType.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUCDriverCode.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUCDriverDesc.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUCProjection.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALIUCDataType.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICFDriverCode.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICFDriverDesc.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICFProjection.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICFDataType.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICSDriverCode.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICSDriverDesc.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICSProjection.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICSDataType.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICCDriverCode.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICCDriverDesc.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICCProjection.resize(pSim->m_nLayers);
+   pSim->m_VstrGDALICCDataType.resize(pSim->m_nLayers);
+   for (int nLayer = 0; nLayer < pSim->m_nLayers; nLayer++)
+   {
+      pSim->m_VstrInitialFineUnconsSedimentFile[nLayer] = m_pDEM->strGetLayerFile(nLayer, SYNTHETIC_FINE_UNCONS);
+      pSim->m_VstrInitialSandUnconsSedimentFile[nLayer] = m_pDEM->strGetLayerFile(nLayer, SYNTHETIC_SAND_UNCONS);
+      pSim->m_VstrInitialCoarseUnconsSedimentFile[nLayer] = m_pDEM->strGetLayerFile(nLayer, SYNTHETIC_COARSE_UNCONS);
+      pSim->m_VstrInitialFineConsSedimentFile[nLayer] = m_pDEM->strGetLayerFile(nLayer, SYNTHETIC_FINE_CONS);
+      pSim->m_VstrInitialSandConsSedimentFile[nLayer] = m_pDEM->strGetLayerFile(nLayer, SYNTHETIC_SAND_CONS);
+      pSim->m_VstrInitialCoarseConsSedimentFile[nLayer] = m_pDEM->strGetLayerFile(nLayer, SYNTHETIC_COARSE_CONS);
+   }
+   pSim->m_strInitialSuspSedimentFile = "";
+   pSim->m_strInitialLandformFile = "";
+   pSim->m_strInterventionClassFile = "";
+   pSim->m_strInterventionHeightFile = "";
+
+   // Create the raster grid and read in the synthetic scenario, in the same way as CSimulation::nDoSimulation()
+   int nRet = pSim->nCreateGridAndReadInitialRasters();
+   if (nRet != RTN_OK)
+      return nRet;
+
+   if (! pSim->bCheckRasterGISOutputFormat())
+      return RTN_ERR_RASTER_GIS_OUT_FORMAT;
+
+   if (! pSim->bCheckVectorGISOutputFormat())
+      return RTN_ERR_VECTOR_GIS_OUT_FORMAT;
+
+   // Misc initialization calcs, and create any caches, as in CSimulation::nDoSimulation()
+   pSim->DoMiscInitialization();
+
+   // The still water level is held constant, so that every repetition sees the same coastline
+   pSim->m_dThisTimestepSWL = pSim->m_dOrigSWL;
+
+   return RTN_OK;
+}
+
+
+/*===============================================================================================================================
+
+ Runs the first part of a timestep once, up to and including interpolation of wave properties to sea cells, then writes one raster GIS file. Since no sediment is moved, every repetition does the same work
+
+===============================================================================================================================*/
+int CBenchmark::nRunOnce(void)
+{
+   CSimulation* pSim = m_pSim;
+
+   pSim->m_ulTimestep++;
+
+   int nRet = pSim->nInitGridAndCalcStillWaterLevel();
+   if (nRet != RTN_OK)
+      return nRet;
+
+   // FloodFillSea() is called from here, once per sea-connected grid edge cell which has not already been flooded
+   steady_clock::time_point tStart = steady_clock::now();
+   pSim->FindAllSeaCells();
+   m_dVVStageTime[BENCH_FLOOD_FILL_SEA].push_back(dGetElapsedMs(tStart));
+
+   // Ditto for nTraceCoastLine(), once per coastline
+   tStart = steady_clock::now();
+   nRet = pSim->nTraceAllCoasts();
+   m_dVVStageTime[BENCH_TRACE_COAST_LINE].push_back(dGetElapsedMs(tStart));
+   if (nRet != RTN_OK)
+      return nRet;
+
+   if (pSim->m_pProfileRasterCache)
+      pSim->UpdateProfileRasterCache();
+
+   if (pSim->m_VCoast.empty())
+   {
+      cerr << ERR << "no coastline located in synthetic scenario: check that the run-data file's still water level and grid edge settings suit a coastline with the sea to the S" << endl;
+      return RTN_ERR_NOCOAST;
+   }
+
+   // The coastlines have been located, so set the tiles of the raster grid which are kept in memory, as in CSimulation::nDoSimulation()
+   pSim->SetGridTileBand();
+
+   nRet = pSim->nLocateAllEstuaries();
+   if (nRet != RTN_OK)
+      return nRet;
+
+   nRet = pSim->nAssignNonCoastlineLandforms();
+   if (nRet != RTN_OK)
+      return nRet;
+
+   nRet = pSim->nAssignAllCoastalLandforms();
+   if (nRet != RTN_OK)
+      return nRet;
+
+   if (pSim->m_pParallelProfileCache)
+      pSim->m_pParallelProfileCache->Clear();
+
+   tStart = steady_clock::now();
+   nRet = pSim->nCreateAllNormalProfiles();
+   m_dVVStageTime[BENCH_CREATE_ALL_NORMAL_PROFILES].push_back(dGetElapsedMs(tStart));
+   if (nRet != RTN_OK)
+      return nRet;
+
+   tStart = steady_clock::now();
+   nRet = pSim->nModifyAllIntersectingProfiles();
+   m_dVVStageTime[BENCH_MODIFY_ALL_INTERSECTING_PROFILES].push_back(dGetElapsedMs(tStart));
+   if (nRet != RTN_OK)
+      return nRet;
+
+   nRet = pSim->nPutAllProfilesOntoGrid();
+   if (nRet != RTN_OK)
+      return nRet;
+
+   nRet = pSim->nCreateAllPolygons();
+   if (nRet != RTN_OK)
+      return nRet;
+
+   tStart = steady_clock::now();
+   pSim->MarkPolygonCells();
+   m_dVVStageTime[BENCH_MARK_POLYGON_CELLS].push_back(dGetElapsedMs(tStart));
+
+   pSim->DoPolygonSharedBoundaries();
+
+   // Calculate wave properties on every profile, as in CSimulation::nDoAllPropagateWaves() but bypassing any wave result cache, then interpolate them to sea cells
+   vector<int>
+      VnX,
+      VnY;
+   vector<double>
+      VdHeightX,
+      VdHeightY;
+   vector<bool> VbBreaking;
+
+   for (int nCoast = 0; nCoast < static_cast<int>(pSim->m_VCoast.size()); nCoast++)
+   {
+      int
+         nCoastSize = pSim->m_VCoast[nCoast].nGetCoastlineSize(),
+         nNumProfiles = pSim->m_VCoast[nCoast].nGetNumProfiles();
+
+      for (int nProfile = 0; nProfile < nNumProfiles; nProfile++)
+      {
+         nRet = pSim->nCalcWavePropertiesOnProfile(nCoast, nCoastSize, nProfile, &VnX, &VnY, &VdHeightX, &VdHeightY, &VbBreaking);
+         if (nRet != RTN_OK)
+            return nRet;
+      }
+   }
+
+   tStart = steady_clock::now();
+   nRet = pSim->nInterpolateWavePropertiesToSeaCells(&VnX, &VnY, &VdHeightX, &VdHeightY);
+   m_dVVStageTime[BENCH_INTERPOLATE_WAVES_TO_SEA_CELLS].push_back(dGetElapsedMs(tStart));
+   if (nRet != RTN_OK)
+      return nRet;
+
+   tStart = steady_clock::now();
+   bool bOK = pSim->bWriteRasterGISFloat(PLOT_SEDIMENT_TOP_ELEV, &PLOT_SEDIMENT_TOP_ELEV_TITLE);
+   m_dVVStageTime[BENCH_WRITE_RASTER_GIS_FLOAT].push_back(dGetElapsedMs(tStart));
+   if (! bOK)
+      return RTN_ERR_RASTER_FILE_WRITE;
+
+   // Were all the raster grid's tiles paged in and out OK?
+   if (pSim->m_pRasterGrid->m_Cell.bFailed())
+      return RTN_ERR_SCRATCH_FILE;
+
+   return RTN_OK;
+}
+
+
+//! Runs the timed stages the given number of times
+int CBenchmark::nRun(int const nReps)
+{
+   for (int nRep = 0; nRep < nReps; nRep++)
+   {
+      int nRet = nRunOnce();
+      if (nRet != RTN_OK)
+      {
+         cerr << ERR << "repetition " << nRep+1 << " failed with return code " << nRet << endl;
+         return nRet;
+      }
+
+      cout << "Repetition " << nRep+1 << " of " << nReps << ": " << m_pSim->m_VCoast.size() << " coastline(s)" << endl;
+   }
+
+   return RTN_OK;
+}
+
+
+/*===============================================================================================================================
+
+ Writes the minimum, median, mean and maximum time (ms) for each stage
+
+===============================================================================================================================*/
+void CBenchmark::WriteResults(ostream& Stream) const
+{
+   Stream << endl << "Grid " << m_pSim->m_nXGridMax << " x " << m_pSim->m_nYGridMax << ", " << m_pSim->m_nLayers << " layer(s), " << m_dVVStageTime[0].size() << " repetition(s), times in ms" << endl;
+   Stream << std::left << setw(40) << "Stage" << std::right << setw(12) << "Min" << setw(12) << "Median" << setw(12) << "Mean" << setw(12) << "Max" << endl;
+   Stream << fixed << setprecision(3);
+
+   for (int nStage = 0; nStage < BENCH_NUM_STAGES; nStage++)
+   {
+      vector<double> dVTime = m_dVVStageTime[nStage];
+      if (dVTime.empty())
+         continue;
+
+      sort(dVTime.begin(), dVTime.end());
+
+      int nSize = static_cast<int>(dVTime.size());
+      double
+         dMedian = (nSize % 2) ? dVTime[nSize / 2] : (dVTime[(nSize / 2) - 1] + dVTime[nSize / 2]) / 2,
+         dMean = 0;
+      for (int n = 0; n < nSize; n++)
+         dMean += dVTime[n];
+      dMean /= nSize;
+
+      Stream << std::left << setw(40) << BENCH_STAGE_NAME[nStage] << std::right << setw(12) << dVTime[0] << setw(12) << dMedian << setw(12) << dMean << setw(12) << dVTime[nSize-1] << endl;
+   }
+}
+
+
+//! Writes every timing to a CSV file, one row per repetition, so that runs can be compared
+bool CBenchmark::bWriteCSV(string const& strFile) const
+{
+   ofstream CSVStream(strFile.c_str(), ios::out | ios::trunc);
+   if (! CSVStream)
+   {
+      cerr << ERR << "cannot open " << strFile << " for output" << endl;
+      return false;
+   }
+
+   CSVStream << "Size,Layers,Repetition";
+   for (int nStage = 0; nStage < BENCH_NUM_STAGES; nStage++)
+      CSVStream << "," << BENCH_STAGE_NAME[nStage];
+   CSVStream << endl;
+
+   CSVStream << fixed << setprecision(3);
+   for (unsigned int nRep = 0; nRep < m_dVVStageTime[0].size(); nRep++)
+   {
+      CSVStream << m_pSim->m_nXGridMax << "," << m_pSim->m_nLayers << "," << nRep+1;
+      for (int nStage = 0; nStage < BENCH_NUM_STAGES; nStage++)
+      {
+         CSVStream << ",";
+         if (nRep < m_dVVStageTime[nStage].size())
+            CSVStream << m_dVVStageTime[nStage][nRep];
+      }
+      CSVStream << endl;
+   }
+
+   return true;
+}
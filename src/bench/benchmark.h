@@ -0,0 +1,76 @@
+/*!
+ *
+ * \class CBenchmark
+ * \brief Class used to time individual stages of a CoastalME timestep
+ * \details Sets up a CSimulation object from a run-data file, but with a synthetic scenario (see CSyntheticDEM) instead of the run-data file's DEM and sediment layers. Then runs the first part of a timestep repeatedly, timing the stages which are most affected by grid size: the stages in between are run but not timed
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file benchmark.h
+ * \brief Contains CBenchmark definitions
+ *
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <ostream>
+using std::ostream;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+
+// The stages which are timed
+int const      BENCH_FLOOD_FILL_SEA                   = 0;
+int const      BENCH_TRACE_COAST_LINE                 = 1;
+int const      BENCH_CREATE_ALL_NORMAL_PROFILES       = 2;
+int const      BENCH_MODIFY_ALL_INTERSECTING_PROFILES = 3;
+int const      BENCH_MARK_POLYGON_CELLS               = 4;
+int const      BENCH_INTERPOLATE_WAVES_TO_SEA_CELLS   = 5;
+int const      BENCH_WRITE_RASTER_GIS_FLOAT           = 6;
+int const      BENCH_NUM_STAGES                       = 7;
+
+class CSimulation;
+class CSyntheticDEM;
+
+class CBenchmark
+{
+private:
+   CSimulation*
+      m_pSim;
+
+   CSyntheticDEM*
+      m_pDEM;
+
+   vector<vector<double> >
+      m_dVVStageTime;                     // For each stage, the time (ms) taken in each repetition
+
+   int nRunOnce(void);
+
+public:
+   CBenchmark(CSimulation*, CSyntheticDEM*);
+   ~CBenchmark(void);
+
+   int nSetUp(string const&, string const&, string const&);
+   int nRun(int const);
+   void WriteResults(ostream&) const;
+   bool bWriteCSV(string const&) const;
+};
+#endif // BENCHMARK_H
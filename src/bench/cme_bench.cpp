@@ -0,0 +1,193 @@
+/*!
+ *
+ * \file cme_bench.cpp
+ * \brief The start-up routine for the CoastalME benchmark
+ * \details Generates a synthetic coastal scenario of a given size, then times the grid-size-dependent stages of a timestep on it. This gives reproducible numbers for evaluating changes which affect scaling, without needing real site data. Run from the CoastalME folder, e.g.
+ *
+ *    cme_bench --size 5000 --bays-per-km 3 --layers 2 --reps 5
+ *
+ * All other settings are taken from the run-data file given with --dat. The synthetic coastline runs from the W edge of the grid to the E edge with the sea to the S, so the run-data file's wave orientation and grid edge settings must suit this
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <unistd.h>
+
+#include <cstdlib>
+using std::atof;
+using std::atoi;
+using std::strtoul;
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include <gdal_priv.h>
+
+#include "cme.h"
+#include "simulation.h"
+#include "synthetic_dem.h"
+#include "benchmark.h"
+
+
+int const      BENCH_MIN_SIZE                         = 1000;
+int const      BENCH_MAX_SIZE                         = 20000;
+
+
+//! Tells the user how to run the benchmark
+static void Usage(void)
+{
+   cout << "Usage: cme_bench [options]" << endl;
+   cout << "   --size N             grid is N x N cells, " << BENCH_MIN_SIZE << " to " << BENCH_MAX_SIZE << " (default 1000)" << endl;
+   cout << "   --cell-side M        cell side in m (default 10)" << endl;
+   cout << "   --bays-per-km B      bay-headland pairs per km of coastline (default 2)" << endl;
+   cout << "   --platform-slope S   seaward slope of the wave-cut platform (default 0.01)" << endl;
+   cout << "   --layers L           number of sediment layers (default 1)" << endl;
+   cout << "   --seed N             seed for the synthetic coastline (default 1)" << endl;
+   cout << "   --reps R             number of timed repetitions (default 3)" << endl;
+   cout << "   --dat FILE           run-data file (default in/GMD2017/CliffFineBays/CliffFineBays.dat)" << endl;
+   cout << "   --out PATH           folder for the synthetic scenario and results (default out/)" << endl;
+   cout << "   --generate-only      write the synthetic scenario, then stop" << endl;
+}
+
+
+/*===============================================================================================================================
+
+ The CoastalME benchmark's main function
+
+===============================================================================================================================*/
+int main (int argc, char* argv[])
+{
+   int
+      nSize = 1000,
+      nLayers = 1,
+      nReps = 3;
+   unsigned long ulSeed = 1;
+   double
+      dCellSide = 10,
+      dBaysPerKm = 2,
+      dPlatformSlope = 0.01;
+   bool bGenerateOnly = false;
+   string
+      strDat = "in/GMD2017/CliffFineBays/CliffFineBays.dat",
+      strOut = "out/";
+
+   for (int n = 1; n < argc; n++)
+   {
+      string strArg = argv[n];
+
+      if (strArg == "--generate-only")
+      {
+         bGenerateOnly = true;
+         continue;
+      }
+
+      if ((strArg == "--help") || (n+1 >= argc))
+      {
+         Usage();
+         return RTN_HELPONLY;
+      }
+
+      char* pcVal = argv[++n];
+      if (strArg == "--size")
+         nSize = atoi(pcVal);
+      else if (strArg == "--cell-side")
+         dCellSide = atof(pcVal);
+      else if (strArg == "--bays-per-km")
+         dBaysPerKm = atof(pcVal);
+      else if (strArg == "--platform-slope")
+         dPlatformSlope = atof(pcVal);
+      else if (strArg == "--layers")
+         nLayers = atoi(pcVal);
+      else if (strArg == "--seed")
+         ulSeed = strtoul(pcVal, NULL, 10);
+      else if (strArg == "--reps")
+         nReps = atoi(pcVal);
+      else if (strArg == "--dat")
+         strDat = pcVal;
+      else if (strArg == "--out")
+         strOut = pcVal;
+      else
+      {
+         cerr << ERR << "unknown option " << strArg << endl;
+         Usage();
+         return RTN_ERR_BADPARAM;
+      }
+   }
+
+   if ((nSize < BENCH_MIN_SIZE) || (nSize > BENCH_MAX_SIZE) || (dCellSide <= 0) || (dBaysPerKm <= 0) || (dPlatformSlope <= 0) || (nLayers < 1) || (nReps < 1))
+   {
+      cerr << ERR << "option out of range" << endl;
+      Usage();
+      return RTN_ERR_BADPARAM;
+   }
+
+   // Relative paths are relative to the current folder, which is treated as the CoastalME folder
+   char szBuf[BUF_SIZE] = "";
+   if (getcwd(szBuf, BUF_SIZE) == NULL)
+      return RTN_ERR_CMEDIR;
+   string strCMEDir = szBuf;
+   strCMEDir.append(1, PATH_SEPARATOR);
+
+   if (strDat[0] != PATH_SEPARATOR)
+      strDat.insert(0, strCMEDir);
+   if (strOut[0] != PATH_SEPARATOR)
+      strOut.insert(0, strCMEDir);
+   if (strOut[strOut.size()-1] != PATH_SEPARATOR)
+      strOut.append(1, PATH_SEPARATOR);
+
+   GDALAllRegister();
+   VSIMkdir(strOut.c_str(), 0755);
+
+   CSyntheticDEM* pDEM = new CSyntheticDEM(nSize, dCellSide, dBaysPerKm, dPlatformSlope, nLayers, ulSeed);
+
+   int nRtn = RTN_OK;
+   if (bGenerateOnly)
+   {
+      // No run-data file is read, so elevations are relative to a still water level of zero
+      if (! pDEM->bWriteAll(strOut))
+         nRtn = RTN_ERR_DEMFILE;
+
+      delete pDEM;
+      return nRtn;
+   }
+
+   CSimulation* pSimulation = new CSimulation;
+   CBenchmark* pBenchmark = new CBenchmark(pSimulation, pDEM);
+
+   nRtn = pBenchmark->nSetUp(strCMEDir, strDat, strOut);
+   if (nRtn == RTN_OK)
+      nRtn = pBenchmark->nRun(nReps);
+
+   if (nRtn == RTN_OK)
+   {
+      pBenchmark->WriteResults(cout);
+
+      string strCSV = strOut;
+      strCSV.append("cme_bench.csv");
+      if (! pBenchmark->bWriteCSV(strCSV))
+         nRtn = RTN_ERR_TEXT_FILE_WRITE;
+   }
+
+   delete pBenchmark;
+   delete pSimulation;
+   delete pDEM;
+
+   return nRtn;
+}
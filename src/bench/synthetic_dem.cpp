@@ -0,0 +1,263 @@
+/*!
+ *
+ * \file synthetic_dem.cpp
+ * \brief CSyntheticDEM routines
+ * \details Generates a synthetic coastal scenario for benchmarking
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <cmath>
+using std::exp;
+using std::sin;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <random>
+using std::mt19937;
+
+#include <gdal_priv.h>
+
+#include "cme.h"
+#include "synthetic_dem.h"
+
+
+static string const SYNTHETIC_FRACTION_NAME[SYNTHETIC_NUM_FRACTIONS] = { "fine_uncons", "sand_uncons", "coarse_uncons", "fine_cons", "sand_cons", "coarse_cons" };
+
+
+//! Constructor: the grid size (cells), cell side (m), number of bay-headland pairs per km of coastline, wave-cut platform slope, number of layers, and seed. The shape of the coastline is decided here
+CSyntheticDEM::CSyntheticDEM(int const nSize, double const dCellSide, double const dBaysPerKm, double const dPlatformSlope, int const nLayers, unsigned long const ulSeed)
+:
+   m_nSize(nSize),
+   m_nLayers(nLayers),
+   m_ulSeed(ulSeed),
+   m_dCellSide(dCellSide),
+   m_dBaysPerKm(dBaysPerKm),
+   m_dPlatformSlope(dPlatformSlope),
+   m_dSWL(0),
+   m_dShorelineAmplitude(0)
+{
+   // The wavelength (in cells) of one bay plus one headland. Headlands stick out by a quarter of this, but never by more than an eighth of the grid
+   double dWavelength = 1000 / (m_dBaysPerKm * m_dCellSide);
+   m_dShorelineAmplitude = tMin(dWavelength / 4, m_nSize / 8.0);
+
+   // Some less regular variation is added to the bays and headlands, using a few harmonics with random amplitudes and phases. Note that std::uniform_real_distribution is not used, since its output may differ between standard libraries
+   mt19937 Rand(m_ulSeed);
+   double const dInvRandMax = 1.0 / 4294967296.0;
+
+   double dPhase = 2 * PI * Rand() * dInvRandMax;
+   double
+      dHarmonicAmplitude[3],
+      dHarmonicPhase[3];
+   for (int n = 0; n < 3; n++)
+   {
+      dHarmonicAmplitude[n] = 0.1 * m_dShorelineAmplitude * Rand() * dInvRandMax;
+      dHarmonicPhase[n] = 2 * PI * Rand() * dInvRandMax;
+   }
+
+   m_dVShorelineY.resize(m_nSize);
+   for (int nX = 0; nX < m_nSize; nX++)
+   {
+      double dY = (m_nSize / 2.0) + m_dShorelineAmplitude * sin((2 * PI * nX / dWavelength) + dPhase);
+      for (int n = 0; n < 3; n++)
+         dY += dHarmonicAmplitude[n] * sin((2 * PI * (n+2) * nX / dWavelength) + dHarmonicPhase[n]);
+
+      m_dVShorelineY[nX] = dY;
+   }
+
+   m_strVLayerFile.resize(m_nLayers * SYNTHETIC_NUM_FRACTIONS);
+}
+
+CSyntheticDEM::~CSyntheticDEM(void)
+{
+}
+
+
+//! Sets the still water level: all elevations are relative to this
+void CSyntheticDEM::SetStillWaterLevel(double const dSWL)
+{
+   m_dSWL = dSWL;
+}
+
+
+//! Returns the distance (m) of a cell's centroid from the shoreline, +ve inland and -ve seaward
+double CSyntheticDEM::dGetDistanceInland(int const nX, int const nY) const
+{
+   return (m_dVShorelineY[nX] - (nY + 0.5)) * m_dCellSide;
+}
+
+
+//! Returns a value between 0 (tip of a headland) and 1 (back of a bay) for a column of the grid
+double CSyntheticDEM::dGetBayness(int const nX) const
+{
+   double dBayness = (m_nSize / 2.0 + m_dShorelineAmplitude - m_dVShorelineY[nX]) / (2 * m_dShorelineAmplitude);
+   return tMax(0.0, tMin(dBayness, 1.0));
+}
+
+
+//! Returns the elevation of the top of the sediment for a cell. Inland, this rises steeply at headlands (cliffs) and gently in bays. Seaward, the wave-cut platform slopes down
+double CSyntheticDEM::dGetSurfaceElev(int const nX, int const nY) const
+{
+   double dDist = dGetDistanceInland(nX, nY);
+
+   if (dDist >= 0)
+   {
+      double dLandSlope = 0.02 + (0.2 * (1 - dGetBayness(nX)));
+      return m_dSWL + 1 + tMin(dLandSlope * dDist, 40.0);
+   }
+
+   return m_dSWL - tMin(0.5 - (m_dPlatformSlope * dDist), 60.0);
+}
+
+
+//! Returns the thickness (m) of each sediment fraction in a layer of a cell. Every layer is mostly consolidated sediment: the top layer also has an unconsolidated sandy beach, which is thickest at the back of bays and near the shoreline
+void CSyntheticDEM::GetThicknesses(int const nX, int const nY, int const nLayer, double* pdThickness) const
+{
+   for (int n = 0; n < SYNTHETIC_NUM_FRACTIONS; n++)
+      pdThickness[n] = 0;
+
+   if (nLayer == 0)
+   {
+      double dBeach = 2 * dGetBayness(nX) * exp(-tAbs(dGetDistanceInland(nX, nY)) / 150);
+      pdThickness[SYNTHETIC_FINE_UNCONS] = 0.05 * dBeach;
+      pdThickness[SYNTHETIC_SAND_UNCONS] = 0.8 * dBeach;
+      pdThickness[SYNTHETIC_COARSE_UNCONS] = 0.15 * dBeach;
+   }
+
+   double dFineFraction = 0.2 + (0.1 * (nLayer % 3));
+   pdThickness[SYNTHETIC_FINE_CONS] = 3 * dFineFraction;
+   pdThickness[SYNTHETIC_SAND_CONS] = 3 * (0.7 - dFineFraction);
+   pdThickness[SYNTHETIC_COARSE_CONS] = 3 * 0.3;
+}
+
+
+//! Writes a single raster as a GeoTIFF, row by row so that large grids do not need to be held in memory. If nLayer is negative, then this is the basement DEM
+bool CSyntheticDEM::bWriteRaster(string const& strFile, int const nLayer, int const nFraction) const
+{
+   GDALDriver* pGDALDriver = GetGDALDriverManager()->GetDriverByName("GTiff");
+   if (pGDALDriver == NULL)
+   {
+      cerr << ERR << "cannot load GeoTIFF driver: " << CPLGetLastErrorMsg() << endl;
+      return false;
+   }
+
+   GDALDataset* pGDALDataSet = pGDALDriver->Create(strFile.c_str(), m_nSize, m_nSize, 1, GDT_Float32, NULL);
+   if (pGDALDataSet == NULL)
+   {
+      cerr << ERR << "cannot create " << strFile << ": " << CPLGetLastErrorMsg() << endl;
+      return false;
+   }
+
+   // The grid's origin is at 0,0 in external CRS units (m)
+   double dGeoTransform[6] = { 0, m_dCellSide, 0, m_nSize * m_dCellSide, 0, -m_dCellSide };
+   pGDALDataSet->SetGeoTransform(dGeoTransform);
+
+   GDALRasterBand* pBand = pGDALDataSet->GetRasterBand(1);
+   vector<float> fVRow(m_nSize);
+   double dThickness[SYNTHETIC_NUM_FRACTIONS];
+
+   for (int nY = 0; nY < m_nSize; nY++)
+   {
+      for (int nX = 0; nX < m_nSize; nX++)
+      {
+         if (nLayer < 0)
+         {
+            // The basement is below the sediment top by the total thickness of all layers
+            double dElev = dGetSurfaceElev(nX, nY);
+            for (int nL = 0; nL < m_nLayers; nL++)
+            {
+               GetThicknesses(nX, nY, nL, dThickness);
+               for (int n = 0; n < SYNTHETIC_NUM_FRACTIONS; n++)
+                  dElev -= dThickness[n];
+            }
+
+            fVRow[nX] = static_cast<float>(dElev);
+         }
+         else
+         {
+            GetThicknesses(nX, nY, nLayer, dThickness);
+            fVRow[nX] = static_cast<float>(dThickness[nFraction]);
+         }
+      }
+
+      if (pBand->RasterIO(GF_Write, 0, nY, m_nSize, 1, &fVRow[0], m_nSize, 1, GDT_Float32, 0, 0, NULL) != CE_None)
+      {
+         cerr << ERR << "cannot write row " << nY << " of " << strFile << ": " << CPLGetLastErrorMsg() << endl;
+         GDALClose(pGDALDataSet);
+         return false;
+      }
+   }
+
+   GDALClose(pGDALDataSet);
+
+   return true;
+}
+
+
+//! Writes the basement DEM and all sediment layer files to the given folder (which must end with a path separator)
+bool CSyntheticDEM::bWriteAll(string const& strPath)
+{
+   m_strBasementDEMFile = strPath;
+   m_strBasementDEMFile.append("synthetic_basement_dem.tif");
+   if (! bWriteRaster(m_strBasementDEMFile, -1, 0))
+      return false;
+
+   for (int nLayer = 0; nLayer < m_nLayers; nLayer++)
+   {
+      for (int n = 0; n < SYNTHETIC_NUM_FRACTIONS; n++)
+      {
+         string strFile = strPath;
+         strFile.append("synthetic_layer_");
+         strFile.append(std::to_string(nLayer+1));
+         strFile.append("_");
+         strFile.append(SYNTHETIC_FRACTION_NAME[n]);
+         strFile.append(".tif");
+
+         if (! bWriteRaster(strFile, nLayer, n))
+            return false;
+
+         m_strVLayerFile[(nLayer * SYNTHETIC_NUM_FRACTIONS) + n] = strFile;
+      }
+   }
+
+   return true;
+}
+
+
+int CSyntheticDEM::nGetSize(void) const
+{
+   return m_nSize;
+}
+
+int CSyntheticDEM::nGetLayers(void) const
+{
+   return m_nLayers;
+}
+
+string CSyntheticDEM::strGetBasementDEMFile(void) const
+{
+   return m_strBasementDEMFile;
+}
+
+//! Returns the name of the file for a sediment fraction in a layer, this is empty until bWriteAll() has been called
+string CSyntheticDEM::strGetLayerFile(int const nLayer, int const nFraction) const
+{
+   return m_strVLayerFile[(nLayer * SYNTHETIC_NUM_FRACTIONS) + nFraction];
+}
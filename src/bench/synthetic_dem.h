@@ -0,0 +1,90 @@
+/*!
+ *
+ * \class CSyntheticDEM
+ * \brief Class used to generate a synthetic coastal scenario for benchmarking
+ * \details Writes a basement DEM, and consolidated and unconsolidated sediment layers, for a square grid with a wave-cut platform seaward of a coastline which runs from the W edge to the E edge of the grid. The sea is to the S. The coastline has a configurable number of bays and headlands per km: the bays are backed by sandy beaches, the headlands are cliffed. Everything is generated from a seed, so that the same settings always give the same scenario
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file synthetic_dem.h
+ * \brief Contains CSyntheticDEM definitions
+ *
+ */
+
+#ifndef SYNTHETICDEM_H
+#define SYNTHETICDEM_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+
+// The sediment fractions of each layer, in the order in which they are written
+int const      SYNTHETIC_FINE_UNCONS                  = 0;
+int const      SYNTHETIC_SAND_UNCONS                  = 1;
+int const      SYNTHETIC_COARSE_UNCONS                = 2;
+int const      SYNTHETIC_FINE_CONS                    = 3;
+int const      SYNTHETIC_SAND_CONS                    = 4;
+int const      SYNTHETIC_COARSE_CONS                  = 5;
+int const      SYNTHETIC_NUM_FRACTIONS                = 6;
+
+class CSyntheticDEM
+{
+private:
+   int
+      m_nSize,                            // The grid is m_nSize cells square
+      m_nLayers;
+
+   unsigned long
+      m_ulSeed;
+
+   double
+      m_dCellSide,                        // In m
+      m_dBaysPerKm,                       // Number of bay-headland pairs per km of coastline
+      m_dPlatformSlope,                   // Seaward slope of the wave-cut platform
+      m_dSWL,                             // Still water level, elevations are relative to this
+      m_dShorelineAmplitude;              // In cells, the distance between the mean shoreline and the tip of a headland
+
+   vector<double>
+      m_dVShorelineY;                     // For each column of the grid, the Y co-ordinate (in cells, may be fractional) of the shoreline
+
+   string
+      m_strBasementDEMFile;
+
+   vector<string>
+      m_strVLayerFile;                    // SYNTHETIC_NUM_FRACTIONS files per layer
+
+   double dGetDistanceInland(int const, int const) const;
+   double dGetBayness(int const) const;
+   double dGetSurfaceElev(int const, int const) const;
+   void GetThicknesses(int const, int const, int const, double*) const;
+   bool bWriteRaster(string const&, int const, int const) const;
+
+public:
+   CSyntheticDEM(int const, double const, double const, double const, int const, unsigned long const);
+   ~CSyntheticDEM(void);
+
+   void SetStillWaterLevel(double const);
+   bool bWriteAll(string const&);
+
+   int nGetSize(void) const;
+   int nGetLayers(void) const;
+   string strGetBasementDEMFile(void) const;
+   string strGetLayerFile(int const, int const) const;
+};
+#endif // SYNTHETICDEM_H
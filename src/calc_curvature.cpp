@@ -37,16 +37,44 @@ using std::inner_product;
 
 /*===============================================================================================================================
 
- Calculates both detailed and smoothed curvature for every point on a coastline
+ Calculates both detailed and smoothed curvature for every point on a coastline. If the previous timestep's version of this coastline is given, together with the number of points at the start and at the end of the coastline which are unchanged since then, then curvature values which cannot have changed are copied rather than recalculated
 
 ===============================================================================================================================*/
-void CSimulation::DoCoastCurvature(int const nCoast, int const nHandedness)
+void CSimulation::DoCoastCurvature(int const nCoast, int const nHandedness, CRWCoast* const pPrevCoast, int const nSameAtStart, int const nSameAtEnd)
 {
-   int nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
+   int
+      nCoastSize = m_VCoast[nCoast].nGetCoastlineSize(),
+      nSizeChange = 0,
+      nPrevStraightPoint = INT_NODATA;
+
+   if (pPrevCoast != NULL)
+   {
+      nSizeChange = nCoastSize - pPrevCoast->nGetCoastlineSize();
+
+      // If the previous coastline was straight, then its mid-point curvature values were set artificially and must not be re-used
+      if (pPrevCoast->bIsStraightCoast())
+         nPrevStraightPoint = dRound(pPrevCoast->nGetCoastlineSize() / 2.0);
+   }
    
    // Start with detailed curvature, do every point on the coastline, apart from the first and last points
    for (int nThisCoastPoint = 1; nThisCoastPoint < (nCoastSize-1); nThisCoastPoint++)
    {
+      if (pPrevCoast != NULL)
+      {
+         // Detailed curvature depends on this point and the points before and after, so is unchanged if all three points are unchanged
+         int nPrevCoastPoint = INT_NODATA;
+         if (nThisCoastPoint+1 < nSameAtStart)
+            nPrevCoastPoint = nThisCoastPoint;
+         else if (nThisCoastPoint-1 >= nCoastSize - nSameAtEnd)
+            nPrevCoastPoint = nThisCoastPoint - nSizeChange;
+
+         if ((nPrevCoastPoint != INT_NODATA) && (nPrevCoastPoint != nPrevStraightPoint))
+         {
+            m_VCoast[nCoast].SetDetailedCurvature(nThisCoastPoint, pPrevCoast->dGetDetailedCurvature(nPrevCoastPoint));
+            continue;
+         }
+      }
+
       // Calculate the signed curvature based on this point, and the points before and after
       double dCurvature = dCalcCurvature(nHandedness, m_VCoast[nCoast].pPtGetVectorCoastlinePoint(nThisCoastPoint-1), m_VCoast[nCoast].pPtGetVectorCoastlinePoint(nThisCoastPoint), m_VCoast[nCoast].pPtGetVectorCoastlinePoint(nThisCoastPoint+1));
 
@@ -68,6 +96,22 @@ void CSimulation::DoCoastCurvature(int const nCoast, int const nHandedness)
    // Apply a running mean smoothing filter, with a variable window size at both ends of the line
    for (int i = 0; i < nCoastSize; i++)
    {
+      if (pPrevCoast != NULL)
+      {
+         // Smoothed curvature is unchanged if every detailed curvature value in the window is unchanged
+         int nPrevCoastPoint = INT_NODATA;
+         if (i + nHalfWindow < nSameAtStart-1)
+            nPrevCoastPoint = i;
+         else if (i - nHalfWindow > nCoastSize - nSameAtEnd)
+            nPrevCoastPoint = i - nSizeChange;
+
+         if ((nPrevCoastPoint != INT_NODATA) && (nPrevCoastPoint != nPrevStraightPoint))
+         {
+            m_VCoast[nCoast].SetSmoothCurvature(i, pPrevCoast->dGetSmoothCurvature(nPrevCoastPoint));
+            continue;
+         }
+      }
+
       int nTmpWindow = 0;
       double dWindowTot = 0;
       for (int j = -nHalfWindow; j < WINDOWSIZE - nHalfWindow; j++)
@@ -86,7 +130,7 @@ void CSimulation::DoCoastCurvature(int const nCoast, int const nHandedness)
    }
    
    // Now calculate the mean and standard deviation of each set of curvature values
-   vector<double>* pVDetailed = m_VCoast[nCoast].pVGetDetailedCurvature();
+   vector<double, CArenaAllocator<double> >* pVDetailed = m_VCoast[nCoast].pVGetDetailedCurvature();
    double 
       dSum = std::accumulate(pVDetailed->begin(), pVDetailed->end(), 0.0),
       dMean = dSum / pVDetailed->size();
@@ -96,7 +140,7 @@ void CSimulation::DoCoastCurvature(int const nCoast, int const nHandedness)
       dSTD = std::sqrt(dSquareSum / pVDetailed->size() - dMean * dMean);
    m_VCoast[nCoast].SetDetailedCurvatureSTD(dSTD);
 
-   vector<double>* pVSmooth = m_VCoast[nCoast].pVGetSmoothCurvature();
+   vector<double, CArenaAllocator<double> >* pVSmooth = m_VCoast[nCoast].pVGetSmoothCurvature();
    dSum = std::accumulate(pVSmooth->begin(), pVSmooth->end(), 0.0),
    dMean = dSum / pVSmooth->size();
    m_VCoast[nCoast].SetSmoothCurvatureMean(dMean);
@@ -141,6 +185,8 @@ void CSimulation::DoCoastCurvature(int const nCoast, int const nHandedness)
       
       // And set the point of maximum smoothed convexity at the same point
       m_VCoast[nCoast].SetSmoothCurvature(nMaxConvexSmoothedCoastPoint, STRAIGHT_COAST_MAX_SMOOTH_CURVATURE);
+
+      m_VCoast[nCoast].SetStraightCoast(true);
    }
    
 //    LogStream << "-----------------" << endl;
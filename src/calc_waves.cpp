@@ -45,6 +45,10 @@ using std::setw;
 #include <algorithm>
 using std::sort;
 using std::remove;
+using std::reverse;
+
+#include <map>
+using std::map;
 
 #include <utility>
 using std::pair;
@@ -59,6 +63,8 @@ using std::stack;
 
 #include "hermite_cubic.h"
 #include "linearinterp.h"
+#include "wave_result_cache.h"
+#include "trace_writer.h"
 
 
 /*===============================================================================================================================
@@ -68,6 +74,40 @@ using std::stack;
 ===============================================================================================================================*/
 int CSimulation::nDoAllPropagateWaves(void)
 {
+   unsigned long long ullCacheKey = 0;
+   vector<long long> llVCacheForcing;
+   vector<int>
+      nVCacheCoastCell,
+      nVCacheBlockSeaCells;
+   vector<double> dVCacheBlockElev;
+   vector<char> cVActiveZoneBeforeHoles;
+   vector<double>
+      dVTotWaveHeightBefore,
+      dVTotWaveOrientationBefore;
+
+   if (m_pWaveResultCache)
+   {
+      // We are caching wave propagation results, so is there already a result for this timestep's (binned) wave forcing, coastlines and bathymetry?
+      ullCacheKey = ullGetWaveResultCacheSignature(&llVCacheForcing, &nVCacheCoastCell, &nVCacheBlockSeaCells, &dVCacheBlockElev);
+      if (bRestoreWaveResultFromCache(ullCacheKey, &llVCacheForcing, &nVCacheCoastCell, &nVCacheBlockSeaCells, &dVCacheBlockElev))
+      {
+         // There is, so just calculate wave energy at every point on the coastline
+         CalcWaveEnergyAtAllCoastPoints();
+
+         return RTN_OK;
+      }
+
+      // There isn't, so remember the total wave height and total wave orientation of every cell in the bounding box. Then we can find how much wave propagation changes these
+      for (int nX = m_nXMinBoundingBox; nX <= m_nXMaxBoundingBox; nX++)
+      {
+         for (int nY = m_nYMinBoundingBox; nY <= m_nYMaxBoundingBox; nY++)
+         {
+            dVTotWaveHeightBefore.push_back(m_pRasterGrid->m_Cell[nX][nY].dGetTotWaveHeight());
+            dVTotWaveOrientationBefore.push_back(m_pRasterGrid->m_Cell[nX][nY].dGetTotWaveOrientation());
+         }
+      }
+   }
+
    // Set up vectors to hold the wave attribute data at every profile point
    vector<int> 
       VnX,
@@ -83,14 +123,29 @@ int CSimulation::nDoAllPropagateWaves(void)
       int
          nCoastSize = m_VCoast[nCoast].nGetCoastlineSize(),
          nNumProfiles = m_VCoast[nCoast].nGetNumProfiles();
+
+      double dCoastTraceStart = 0;
+      if (m_pTraceWriter && m_pTraceWriter->bIsActive())
+         dCoastTraceStart = m_pTraceWriter->dGetTime();
          
       // Calculate wave properties at every point along each valid profile, and for the cells under the profiles. Do this in the original (curvature-related) profile sequence
       for (int nProfile = 0; nProfile < nNumProfiles; nProfile++)
       {
+         bool bTrace = (m_pTraceWriter && m_pTraceWriter->bTraceItem(nProfile));
+         double dTraceStart = 0;
+         if (bTrace)
+            dTraceStart = m_pTraceWriter->dGetTime();
+
          int nRet = nCalcWavePropertiesOnProfile(nCoast, nCoastSize, nProfile, &VnX, &VnY, &VdHeightX, &VdHeightY, &VbBreaking);
          if (nRet != RTN_OK)
             return nRet;
-      }         
+
+         if (bTrace)
+            m_pTraceWriter->AddSpan("Wave properties on profile", "profile", dTraceStart, nCoast, "profile", nProfile);
+      }
+
+      if (m_pTraceWriter && m_pTraceWriter->bIsActive())
+         m_pTraceWriter->AddSpan("Wave properties on coast", "coast", dCoastTraceStart, nCoast, NULL, 0);
    }
       
    // Interpolate the wave attributes from all profile points to all sea cells outside the active zone
@@ -107,6 +162,16 @@ int CSimulation::nDoAllPropagateWaves(void)
    nRet = nDoAllShadowZones();
    if (nRet != RTN_OK)
       return nRet;
+
+   // If we are caching wave propagation results, then remember which cells are in the active zone before holes are filled, since this is needed for the polygon d50 calculation
+   if (m_pWaveResultCache)
+   {
+      for (int nX = m_nXMinBoundingBox; nX <= m_nXMaxBoundingBox; nX++)
+      {
+         for (int nY = m_nYMinBoundingBox; nY <= m_nYMaxBoundingBox; nY++)
+            cVActiveZoneBeforeHoles.push_back(m_pRasterGrid->m_Cell[nX][nY].bIsInActiveZone());
+      }
+   }
    
    // Fill in artefactual 'holes' in active zone and wave property patterns
    CalcD50AndFillWaveCalcHoles();   
@@ -123,15 +188,34 @@ int CSimulation::nDoAllPropagateWaves(void)
    // Interpolate these wave properties for all remaining coastline points. Do this in along-coastline sequence
    for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
    {
-      int
-         nCoastSize = m_VCoast[nCoast].nGetCoastlineSize(),
-         nNumProfiles = m_VCoast[nCoast].nGetNumProfiles();
+      int nNumProfiles = m_VCoast[nCoast].nGetNumProfiles();
 
-      // Interpolate these wave properties for all remaining coastline points. Do this in along-coastline sequence
       for (int n = 0; n < nNumProfiles; n++)
          InterpolateWavePropertiesToCoastline(nCoast, n, nNumProfiles);
+   }
+
+   // Store the results, if we are caching them
+   if (m_pWaveResultCache)
+      SaveWaveResultToCache(ullCacheKey, &llVCacheForcing, &nVCacheCoastCell, &nVCacheBlockSeaCells, &dVCacheBlockElev, &dVTotWaveHeightBefore, &dVTotWaveOrientationBefore, &cVActiveZoneBeforeHoles);
+
+   // Calculate wave energy at every point on the coastline
+   CalcWaveEnergyAtAllCoastPoints();
+
+   return RTN_OK;
+}
+
+
+/*===============================================================================================================================
+
+ Calculates wave energy at every point on every coastline, from the breaking wave height
+
+===============================================================================================================================*/
+void CSimulation::CalcWaveEnergyAtAllCoastPoints(void)
+{
+   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   {
+      int nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
 
-      // Calculate wave energy at every point on the coastline
       for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
       {
          // Equation 4 from Walkden & Hall, 2005
@@ -146,8 +230,206 @@ int CSimulation::nDoAllPropagateWaves(void)
          }
       }
    }
-      
-   return RTN_OK;
+}
+
+
+/*===============================================================================================================================
+
+ Gets the signature of this timestep's wave propagation, for cached wave propagation results, and returns its key. The signature is the binned deep water wave height, wave period, deep water wave orientation, and still water level, the bounding box of the sea, and the size of each coastline; the cells which are marked as coastline; and, for each WAVE_CACHE_BLOCK_SIZE x WAVE_CACHE_BLOCK_SIZE block of cells within the bounding box, the number of cells in the contiguous sea and the mean elevation. The key is a hash of the first part only, so it does not change as the bathymetry evolves
+
+===============================================================================================================================*/
+unsigned long long CSimulation::ullGetWaveResultCacheSignature(vector<long long>* pllVForcing, vector<int>* pnVCoastCell, vector<int>* pnVBlockSeaCells, vector<double>* pdVBlockElev)
+{
+   pllVForcing->push_back(llround(m_dDeepWaterWaveHeight / WAVE_CACHE_HEIGHT_BIN));
+   pllVForcing->push_back(llround(m_dWavePeriod / WAVE_CACHE_PERIOD_BIN));
+   pllVForcing->push_back(llround(m_dDeepWaterWaveOrientation / WAVE_CACHE_ORIENTATION_BIN));
+   pllVForcing->push_back(llround(m_dThisTimestepSWL / WAVE_CACHE_SWL_BIN));
+
+   pllVForcing->push_back(m_nXMinBoundingBox);
+   pllVForcing->push_back(m_nYMinBoundingBox);
+   pllVForcing->push_back(m_nXMaxBoundingBox);
+   pllVForcing->push_back(m_nYMaxBoundingBox);
+
+   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   {
+      int nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
+      pllVForcing->push_back(nCoastSize);
+      pllVForcing->push_back(m_VCoast[nCoast].nGetNumProfiles());
+
+      for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
+      {
+         CGeom2DIPoint const* pPti = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nCoastPoint);
+         pnVCoastCell->push_back((pPti->nGetX() * m_nYGridMax) + pPti->nGetY());
+      }
+   }
+
+   // The coarse bathymetry signature
+   int
+      nXBlocks = ((m_nXMaxBoundingBox - m_nXMinBoundingBox) / WAVE_CACHE_BLOCK_SIZE) + 1,
+      nYBlocks = ((m_nYMaxBoundingBox - m_nYMinBoundingBox) / WAVE_CACHE_BLOCK_SIZE) + 1;
+   vector<int> nVBlockCells(nXBlocks * nYBlocks, 0);
+   pnVBlockSeaCells->assign(nXBlocks * nYBlocks, 0);
+   pdVBlockElev->assign(nXBlocks * nYBlocks, 0);
+
+   for (int nX = m_nXMinBoundingBox; nX <= m_nXMaxBoundingBox; nX++)
+   {
+      int nXBlock = (nX - m_nXMinBoundingBox) / WAVE_CACHE_BLOCK_SIZE;
+      for (int nY = m_nYMinBoundingBox; nY <= m_nYMaxBoundingBox; nY++)
+      {
+         int nBlock = (nXBlock * nYBlocks) + ((nY - m_nYMinBoundingBox) / WAVE_CACHE_BLOCK_SIZE);
+
+         nVBlockCells[nBlock]++;
+         pdVBlockElev->at(nBlock) += m_pRasterGrid->m_Cell[nX][nY].dGetSedimentTopElev() + m_pRasterGrid->m_Cell[nX][nY].dGetInterventionHeight();
+         if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
+            pnVBlockSeaCells->at(nBlock)++;
+      }
+   }
+
+   for (int n = 0; n < nXBlocks * nYBlocks; n++)
+      pdVBlockElev->at(n) /= nVBlockCells[n];
+
+   // This is the FNV-1a offset basis
+   unsigned long long ullKey = 14695981039346656037ULL;
+   for (unsigned int n = 0; n < pllVForcing->size(); n++)
+      ullKey = CWaveResultCache::ullHash(ullKey, pllVForcing->at(n));
+
+   return ullKey;
+}
+
+
+/*===============================================================================================================================
+
+ Stores this timestep's wave propagation results in the cache
+
+===============================================================================================================================*/
+void CSimulation::SaveWaveResultToCache(unsigned long long const ullKey, vector<long long> const* pllVForcing, vector<int> const* pnVCoastCell, vector<int> const* pnVBlockSeaCells, vector<double> const* pdVBlockElev, vector<double> const* pdVTotWaveHeightBefore, vector<double> const* pdVTotWaveOrientationBefore, vector<char> const* pcVActiveZoneBeforeHoles)
+{
+   CWaveResultCache::CacheEntry* pEntry = m_pWaveResultCache->pAddEntry(ullKey, pllVForcing, pnVCoastCell, pnVBlockSeaCells, pdVBlockElev);
+
+   // Assignment and clear() keep the entry's existing storage, if there is enough of it
+   pEntry->cVFlags.clear();
+   pEntry->nVShadowZoneCode.clear();
+   pEntry->dVWaveHeight.clear();
+   pEntry->dVWaveOrientation.clear();
+   pEntry->dVTotWaveHeightIncr.clear();
+   pEntry->dVTotWaveOrientationIncr.clear();
+
+   int n = 0;
+   for (int nX = m_nXMinBoundingBox; nX <= m_nXMaxBoundingBox; nX++)
+   {
+      for (int nY = m_nYMinBoundingBox; nY <= m_nYMaxBoundingBox; nY++)
+      {
+         CGeomCell* pCell = &m_pRasterGrid->m_Cell[nX][nY];
+
+         char cFlags = pcVActiveZoneBeforeHoles->at(n) ? 1 : 0;
+         if (pCell->bIsInActiveZone())
+            cFlags |= 2;
+         if (pCell->bIsShadowZoneBoundary())
+            cFlags |= 4;
+
+         pEntry->cVFlags.push_back(cFlags);
+         pEntry->nVShadowZoneCode.push_back(pCell->nGetShadowZoneCode());
+         pEntry->dVWaveHeight.push_back(pCell->dGetWaveHeight());
+         pEntry->dVWaveOrientation.push_back(pCell->dGetWaveOrientation());
+         pEntry->dVTotWaveHeightIncr.push_back(pCell->dGetTotWaveHeight() - pdVTotWaveHeightBefore->at(n));
+         pEntry->dVTotWaveOrientationIncr.push_back(pCell->dGetTotWaveOrientation() - pdVTotWaveOrientationBefore->at(n));
+
+         n++;
+      }
+   }
+
+   pEntry->VCoast.resize(m_VCoast.size());
+   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   {
+      CWaveResultCache::CoastResult* pCoast = &pEntry->VCoast[nCoast];
+      int nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
+
+      for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
+      {
+         pCoast->nVBreakingDistance.push_back(m_VCoast[nCoast].nGetBreakingDistance(nCoastPoint));
+         pCoast->dVBreakingWaveHeight.push_back(m_VCoast[nCoast].dGetBreakingWaveHeight(nCoastPoint));
+         pCoast->dVBreakingWaveOrientation.push_back(m_VCoast[nCoast].dGetBreakingWaveOrientation(nCoastPoint));
+         pCoast->dVDepthOfBreaking.push_back(m_VCoast[nCoast].dGetDepthOfBreaking(nCoastPoint));
+         pCoast->dVFluxOrientation.push_back(m_VCoast[nCoast].dGetFluxOrientation(nCoastPoint));
+      }
+
+      for (int n = 0; n < m_VCoast[nCoast].nGetNumShadowZoneBoundaries(); n++)
+         pCoast->LVShadowZoneBoundary.push_back(*m_VCoast[nCoast].pGetShadowZoneBoundary(n));
+   }
+
+   // Keep the cache within its memory limit, this may discard older results (but not this one)
+   m_pWaveResultCache->LimitMemory(pEntry);
+}
+
+
+/*===============================================================================================================================
+
+ If the cache holds wave propagation results with the given key and a matching signature, then copies these results to the raster grid and to the coastlines, and returns true. Otherwise returns false
+
+===============================================================================================================================*/
+bool CSimulation::bRestoreWaveResultFromCache(unsigned long long const ullKey, vector<long long> const* pllVForcing, vector<int> const* pnVCoastCell, vector<int> const* pnVBlockSeaCells, vector<double> const* pdVBlockElev)
+{
+   // The signature includes the bounding box and every coastline cell, so if there is a matching entry then it has the same number of cells and coastline points as now
+   CWaveResultCache::CacheEntry const* pEntry = m_pWaveResultCache->pFindEntry(ullKey, pllVForcing, pnVCoastCell, pnVBlockSeaCells, pdVBlockElev);
+   if (pEntry == NULL)
+      return false;
+
+   // These are otherwise calculated during wave propagation on each profile
+   m_dC_0 = (m_dG * m_dWavePeriod) / (2 * PI);
+   m_dL_0 = m_dC_0 * m_dWavePeriod;
+
+   // Restore the raster grid's wave values, but only restore the active zone as it was before holes were filled in
+   int n = 0;
+   for (int nX = m_nXMinBoundingBox; nX <= m_nXMaxBoundingBox; nX++)
+   {
+      for (int nY = m_nYMinBoundingBox; nY <= m_nYMaxBoundingBox; nY++)
+      {
+         CGeomCell* pCell = &m_pRasterGrid->m_Cell[nX][nY];
+
+         pCell->SetCachedWaveValues(pEntry->dVWaveHeight[n], pEntry->dVTotWaveHeightIncr[n], pEntry->dVWaveOrientation[n], pEntry->dVTotWaveOrientationIncr[n]);
+         pCell->SetShadowZoneCode(pEntry->nVShadowZoneCode[n]);
+         pCell->SetInActiveZone(pEntry->cVFlags[n] & 1);
+         if (pEntry->cVFlags[n] & 4)
+            pCell->SetShadowZoneBoundary();
+
+         n++;
+      }
+   }
+
+   // The unconsolidated sediment will have changed since these results were cached, so calculate each polygon's d50 afresh
+   CalcAllPolygonD50();
+
+   // Now restore the active zone with holes filled in
+   n = 0;
+   for (int nX = m_nXMinBoundingBox; nX <= m_nXMaxBoundingBox; nX++)
+   {
+      for (int nY = m_nYMinBoundingBox; nY <= m_nYMaxBoundingBox; nY++)
+      {
+         m_pRasterGrid->m_Cell[nX][nY].SetInActiveZone((pEntry->cVFlags[n] & 2) != 0);
+         n++;
+      }
+   }
+
+   // And restore the breaking wave values at every coastline point
+   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   {
+      CWaveResultCache::CoastResult const* pCoast = &pEntry->VCoast[nCoast];
+      int nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
+
+      for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
+      {
+         m_VCoast[nCoast].SetBreakingDistance(nCoastPoint, pCoast->nVBreakingDistance[nCoastPoint]);
+         m_VCoast[nCoast].SetBreakingWaveHeight(nCoastPoint, pCoast->dVBreakingWaveHeight[nCoastPoint]);
+         m_VCoast[nCoast].SetBreakingWaveOrientation(nCoastPoint, pCoast->dVBreakingWaveOrientation[nCoastPoint]);
+         m_VCoast[nCoast].SetDepthOfBreaking(nCoastPoint, pCoast->dVDepthOfBreaking[nCoastPoint]);
+         m_VCoast[nCoast].SetFluxOrientation(nCoastPoint, pCoast->dVFluxOrientation[nCoastPoint]);
+      }
+
+      for (unsigned int m = 0; m < pCoast->LVShadowZoneBoundary.size(); m++)
+         m_VCoast[nCoast].AppendShadowZoneBoundary(pCoast->LVShadowZoneBoundary[m]);
+   }
+
+   return true;
 }
 
 
@@ -313,13 +595,33 @@ void CSimulation::InterpolateWavePropertiesToCoastline(int const nCoast, int con
  Calculates tangents to a coastline: the tangent is assumed to be the orientation of energy/sediment flux along a coast. The tangent is specified as an angle (in degrees) measured clockwise from north. Based on a routine by Martin Hurst
 
  ===============================================================================================================================*/
-void CSimulation::CalcCoastTangents(int const nCoast)
+void CSimulation::CalcCoastTangents(int const nCoast, CRWCoast* const pPrevCoast, int const nSameAtStart, int const nSameAtEnd)
 {
    int
-      nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
+      nCoastSize = m_VCoast[nCoast].nGetCoastlineSize(),
+      nSizeChange = 0;
+
+   if (pPrevCoast != NULL)
+      nSizeChange = nCoastSize - pPrevCoast->nGetCoastlineSize();
 
    for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
    {
+      if (pPrevCoast != NULL)
+      {
+         // The tangent depends on this point and the points before and after, so is unchanged if these points are unchanged
+         if (nCoastPoint+1 < nSameAtStart)
+         {
+            m_VCoast[nCoast].SetFluxOrientation(nCoastPoint, pPrevCoast->dGetFluxOrientation(nCoastPoint));
+            continue;
+         }
+
+         if (nCoastPoint-1 >= nCoastSize - nSameAtEnd)
+         {
+            m_VCoast[nCoast].SetFluxOrientation(nCoastPoint, pPrevCoast->dGetFluxOrientation(nCoastPoint - nSizeChange));
+            continue;
+         }
+      }
+
       double
          dXDiff,
          dYDiff;
@@ -409,6 +711,10 @@ bool CSimulation::bCurvaturePairCompareAscending(const pair<int, double>& prLeft
 ===============================================================================================================================*/
 int CSimulation::nDoAllShadowZones(void)
 {
+   // Are we finding shadow zones using a sweep line?
+   if (m_bSweepLineShadowZones)
+      return nDoAllShadowZonesBySweepLine();
+
    int const nSearchDist = tMax(m_nXGridMax, m_nYGridMax);
    
    // Do this once for each coastline
@@ -845,45 +1151,7 @@ int CSimulation::nDoAllShadowZones(void)
 //          LogStream << nZone << "\t" << VnCoastPoint[nZone] << "\t" << VnCapePoint[nZone] << endl;
 
       // The third stage: look for and remove 'nested' shadow zone boundaries
-      for (unsigned int nZone = 0; nZone < VnCapeX.size(); nZone++)
-      {
-         if ((VnCapePoint[nZone] != INT_NODATA) && (VnCoastPoint[nZone] != INT_NODATA))
-         {
-            for (unsigned int nOtherZone = 0; nOtherZone < VnCapeX.size(); nOtherZone++)
-            {
-               if (nOtherZone == nZone)
-                  continue;
-
-               if ((VnCapePoint[nOtherZone] == INT_NODATA) || (VnCoastPoint[nOtherZone] == INT_NODATA))
-                  continue;
-               
-               if (VnCapePoint[nZone] > VnCoastPoint[nZone])
-               {
-                  // The cape point is down-coast from the coast point   
-                  if ((bIsBetween(VnCoastPoint[nOtherZone], VnCoastPoint[nZone], VnCapePoint[nZone])) && (bIsBetween(VnCapePoint[nOtherZone], VnCoastPoint[nZone], VnCapePoint[nZone])))
-                  {
-                     // The nOtherZone shadow zone is nested within the nZone shadow zone
-                     VnCoastPoint[nOtherZone] = INT_NODATA;
-                     VnCapePoint[nOtherZone] = INT_NODATA;
-                     
-//                      LogStream << m_ulTimestep << ": shadow zone stage 3 (down-coast), zone " << nOtherZone << " is nested within zone " << nZone << " and will be ignored" << endl;
-                  }
-               }
-               else
-               {
-                  // The cape point is up-coast from the coast point               
-                  if ((bIsBetween(VnCoastPoint[nOtherZone], VnCapePoint[nZone], VnCoastPoint[nZone])) && (bIsBetween(VnCapePoint[nOtherZone], VnCapePoint[nZone], VnCoastPoint[nZone])))
-                  {
-                     // The nOtherZone shadow zone is nested within the nZone shadow zone
-                     VnCoastPoint[nOtherZone] = INT_NODATA;
-                     VnCapePoint[nOtherZone] = INT_NODATA;
-                     
-//                      LogStream << m_ulTimestep << ": shadow zone stage 3 (up-coast), zone " << nOtherZone << " is nested within zone " << nZone << " and will be ignored" << endl;                     
-                  }
-               }
-            }
-         }         
-      }
+      RemoveNestedShadowZones(&VnCapePoint, &VnCoastPoint);
       
       nEndPoints = 0;
       for (unsigned int nZone = 0; nZone < VnCapeX.size(); nZone++)
@@ -970,6 +1238,379 @@ int CSimulation::nDoAllShadowZones(void)
 }
 
 
+/*===============================================================================================================================
+ 
+ Calculates the wave shadow of every cell, for the deep water wave orientation, in a single pass over the grid. The cells are visited in order along the wave direction, i.e. using a sweep line (a row or a column of the grid, whichever is closer to being normal to the wave direction) which moves down-wave. Each cell gets its shadow from the previous sweep line, by linear interpolation between the two cells which straddle the up-wave ray through this cell. Cells which are not in the contiguous sea cast a full shadow. For each cell, also gets the nearest up-wave cell, the land cell which casts the shadow (INT_NODATA if this is open sea), and the number of sea cells which the ray has crossed since that land cell (INT_MAX if open sea). Cells are indexed as (nX * m_nYGridMax) + nY
+ 
+===============================================================================================================================*/
+void CSimulation::CalcWaveShadowBySweepLine(vector<double>* pdVShadow, vector<int>* pnVUpWave, vector<int>* pnVSource, vector<int>* pnVSeaRun)
+{
+   int nCells = m_nXGridMax * m_nYGridMax;
+   pdVShadow->assign(nCells, 0);
+   pnVUpWave->assign(nCells, INT_NODATA);
+   pnVSource->assign(nCells, INT_NODATA);
+   pnVSeaRun->assign(nCells, INT_MAX);
+
+   // The down-wave direction, as used for shadow zone lines (in the grid CRS)
+   double
+      dXDir = sin((PI / 180) * m_dDeepWaterWaveOrientation),
+      dYDir = -cos((PI / 180) * m_dDeepWaterWaveOrientation);
+
+   // Is the sweep line a row or a column of the grid?
+   bool bSweepRows = (tAbs(dYDir) >= tAbs(dXDir));
+   int
+      nMajorMax = (bSweepRows ? m_nYGridMax : m_nXGridMax),
+      nMinorMax = (bSweepRows ? m_nXGridMax : m_nYGridMax),
+      nMajorInc = ((bSweepRows ? dYDir : dXDir) > 0 ? 1 : -1),
+      nMajorStart = (nMajorInc > 0 ? 0 : nMajorMax-1);
+
+   // For each move of the sweep line, this is how far the up-wave ray moves along the sweep line
+   double dMinorOffset = (bSweepRows ? -dXDir / tAbs(dYDir) : -dYDir / tAbs(dXDir));
+
+   for (int nSweep = 0; nSweep < nMajorMax; nSweep++)
+   {
+      int nMajor = nMajorStart + (nSweep * nMajorInc);
+
+      for (int nMinor = 0; nMinor < nMinorMax; nMinor++)
+      {
+         int
+            nX = (bSweepRows ? nMinor : nMajor),
+            nY = (bSweepRows ? nMajor : nMinor),
+            nThis = (nX * m_nYGridMax) + nY;
+
+         // The first sweep line is at the up-wave edge of the grid, so is not in shadow
+         if (nSweep == 0)
+            continue;
+
+         // Find the two cells on the previous sweep line which straddle the up-wave ray
+         double dUpWave = nMinor + dMinorOffset;
+         int
+            nLow = static_cast<int>(floor(dUpWave)),
+            nNearest = (dUpWave - nLow < 0.5 ? nLow : nLow + 1),
+            nUpWaveMajor = nMajor - nMajorInc;
+         double dFractPart = dUpWave - nLow;
+
+         double dShadow = 0;
+         for (int n = 0; n < 2; n++)
+         {
+            int nUpWaveMinor = nLow + n;
+
+            // Cells beyond the edge of the grid are assumed to be open sea, so cast no shadow
+            if ((nUpWaveMinor < 0) || (nUpWaveMinor >= nMinorMax))
+               continue;
+
+            int
+               nUpWaveX = (bSweepRows ? nUpWaveMinor : nUpWaveMajor),
+               nUpWaveY = (bSweepRows ? nUpWaveMajor : nUpWaveMinor),
+               nUpWave = (nUpWaveX * m_nYGridMax) + nUpWaveY;
+
+            double dWeight = (n == 0 ? 1 - dFractPart : dFractPart);
+            if (m_pRasterGrid->m_Cell[nUpWaveX][nUpWaveY].bIsInContiguousSea())
+               dShadow += dWeight * pdVShadow->at(nUpWave);
+            else
+               dShadow += dWeight;
+
+            if (nUpWaveMinor == nNearest)
+               pnVUpWave->at(nThis) = nUpWave;
+         }
+
+         pdVShadow->at(nThis) = dShadow;
+
+         // Now use the nearest up-wave cell to get the land cell which casts the shadow, and the length of the intervening sea
+         int nUpWave = pnVUpWave->at(nThis);
+         if (nUpWave == INT_NODATA)
+            continue;
+
+         int nSeaRun = 0;
+         if (m_pRasterGrid->m_Cell[nUpWave / m_nYGridMax][nUpWave % m_nYGridMax].bIsInContiguousSea())
+         {
+            pnVSource->at(nThis) = pnVSource->at(nUpWave);
+            nSeaRun = pnVSeaRun->at(nUpWave);
+         }
+         else
+            pnVSource->at(nThis) = nUpWave;
+
+         if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea() && (nSeaRun < INT_MAX))
+            nSeaRun++;
+
+         pnVSeaRun->at(nThis) = nSeaRun;
+      }
+   }
+}
+
+
+/*===============================================================================================================================
+ 
+ Finds wave shadow zones using the sweep line wave shadow, and modifies waves in and near them. Rather than searching for capes using coastline curvature and then tracing a trial shadow zone line from each, a shadow zone is found wherever a run of coastline points is in shadow (cast across a sufficient length of sea), with a lit coastline point at one end of the run. The cape is the coastline point which casts the shadow on this end point
+ 
+===============================================================================================================================*/
+int CSimulation::nDoAllShadowZonesBySweepLine(void)
+{
+   vector<double> dVShadow;
+   vector<int>
+      nVUpWave,
+      nVSource,
+      nVSeaRun;
+   CalcWaveShadowBySweepLine(&dVShadow, &nVUpWave, &nVSource, &nVSeaRun);
+
+   // The length (m) of each move of the sweep line
+   double dSweepInc = m_dCellSide / tMax(tAbs(sin((PI / 180) * m_dDeepWaterWaveOrientation)), tAbs(cos((PI / 180) * m_dDeepWaterWaveOrientation)));
+
+   for (unsigned int nCoast = 0; nCoast < m_VCoast.size(); nCoast++)
+   {
+      int nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
+
+      // Classify every coastline point: 0 is lit, 1 is in shadow which is cast across a sufficient length of sea, 2 is in shadow which is cast from nearby (e.g. this part of the coastline faces away from the waves)
+      vector<int> nVState(nCoastSize, 0);
+      map<int, int> nMCellToCoastPoint;
+      for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
+      {
+         CGeom2DIPoint const* pPti = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nCoastPoint);
+         int nCell = (pPti->nGetX() * m_nYGridMax) + pPti->nGetY();
+         nMCellToCoastPoint[nCell] = nCoastPoint;
+
+         if (dVShadow[nCell] < 0.5)
+            continue;
+
+         int nSeaRun = nVSeaRun[nCell];
+         if ((nSeaRun > SHADOW_LINE_MIN_SINCE_HIT_SEA) && ((nSeaRun * dSweepInc) >= MIN_SEA_LENGTH_OF_SHADOW_ZONE_LINE))
+            nVState[nCoastPoint] = 1;
+         else
+            nVState[nCoastPoint] = 2;
+      }
+
+      // Now look for runs of in-shadow coastline points, omitting the first and last few points on the coast (as when searching for capes)
+      vector<pair<int, pair<int, int> > > prVZone;
+      int nCoastPoint = GRID_MARGIN;
+      while (nCoastPoint < nCoastSize - GRID_MARGIN)
+      {
+         if (nVState[nCoastPoint] != 1)
+         {
+            nCoastPoint++;
+            continue;
+         }
+
+         int nRunStart = nCoastPoint;
+         while ((nCoastPoint < nCoastSize - GRID_MARGIN) && (nVState[nCoastPoint] == 1))
+            nCoastPoint++;
+         int nRunEnd = nCoastPoint-1;
+
+         // Look at each end of the run which is next to a lit coastline point: the shadow zone line reaches the coast here
+         int
+            nBestEnd = INT_NODATA,
+            nBestCape = INT_NODATA;
+         for (int n = 0; n < 2; n++)
+         {
+            int
+               nEnd = (n == 0 ? nRunStart : nRunEnd),
+               nNext = (n == 0 ? nRunStart-1 : nRunEnd+1);
+
+            if (nVState[nNext] != 0)
+               continue;
+
+            // Which coastline point casts the shadow here?
+            CGeom2DIPoint const* pPtiEnd = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nEnd);
+            int nSource = nVSource[(pPtiEnd->nGetX() * m_nYGridMax) + pPtiEnd->nGetY()];
+            map<int, int>::iterator it = nMCellToCoastPoint.find(nSource);
+            if (it == nMCellToCoastPoint.end())
+               continue;
+
+            // The cape must be outside the run, and must not be too close to the edge of the grid
+            int nCape = it->second;
+            if (bIsBetween(nCape, nRunStart, nRunEnd) || (nCape < GRID_MARGIN) || (nCape >= nCoastSize - GRID_MARGIN))
+               continue;
+
+            if ((nBestEnd == INT_NODATA) || (tAbs(nEnd - nCape) > tAbs(nBestEnd - nBestCape)))
+            {
+               nBestEnd = nEnd;
+               nBestCape = nCape;
+            }
+         }
+
+         if (nBestEnd != INT_NODATA)
+            prVZone.push_back(make_pair(tAbs(nBestEnd - nBestCape), make_pair(nBestCape, nBestEnd)));
+      }
+
+      // Keep only the biggest shadow zones
+      sort(prVZone.begin(), prVZone.end());
+      reverse(prVZone.begin(), prVZone.end());
+      if (prVZone.size() > MAX_NUM_SHADOW_ZONES)
+         prVZone.resize(MAX_NUM_SHADOW_ZONES);
+
+      int nZones = prVZone.size();
+      vector<int>
+         VnCapePoint(nZones),
+         VnCoastPoint(nZones);
+      for (int nZone = 0; nZone < nZones; nZone++)
+      {
+         VnCapePoint[nZone] = prVZone[nZone].second.first;
+         VnCoastPoint[nZone] = prVZone[nZone].second.second;
+      }
+
+      // Look for and remove 'nested' shadow zone boundaries
+      RemoveNestedShadowZones(&VnCapePoint, &VnCoastPoint);
+
+      // For non-nested shadow zones, store the boundary, mark the shadow zone, then change wave properties within the shadow zone and downdrift from it
+      for (int nZone = 0; nZone < nZones; nZone++)
+      {
+         if ((VnCapePoint[nZone] == INT_NODATA) || (VnCoastPoint[nZone] == INT_NODATA))
+            continue;
+
+         CGeom2DIPoint
+            PtiCape = *m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(VnCapePoint[nZone]),
+            PtiCoast = *m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(VnCoastPoint[nZone]);
+
+         // Store the shadow zone boundary, with the coast point first
+         CGeom2DPoint
+            PtCoast(dGridCentroidXToExtCRSX(PtiCoast.nGetX()), dGridCentroidYToExtCRSY(PtiCoast.nGetY())),
+            PtCape(dGridCentroidXToExtCRSX(PtiCape.nGetX()), dGridCentroidYToExtCRSY(PtiCape.nGetY()));
+         m_VCoast[nCoast].AppendShadowZoneBoundary(CGeomLine(&PtCoast, &PtCape));
+
+         // Mark the cells between the cape and the coast point as shadow zone boundary, using a simple DDA line algorithm
+         double
+            dXDiff = PtiCoast.nGetX() - PtiCape.nGetX(),
+            dYDiff = PtiCoast.nGetY() - PtiCape.nGetY(),
+            dLength = tMax(tAbs(dXDiff), tAbs(dYDiff)),
+            dX = PtiCape.nGetX(),
+            dY = PtiCape.nGetY();
+         for (int nLen = 0; nLen <= static_cast<int>(dLength); nLen++)
+         {
+            int
+               nX = static_cast<int>(dRound(dX)),
+               nY = static_cast<int>(dRound(dY));
+
+            m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneBoundary();
+
+            dX += dXDiff / dLength;
+            dY += dYDiff / dLength;
+         }
+
+         // Mark the shadow zone: this is every in-shadow sea cell which is connected to the sea cell up-wave of the coast point
+         int nStart = nVUpWave[(PtiCoast.nGetX() * m_nYGridMax) + PtiCoast.nGetY()];
+         if ((nStart == INT_NODATA) || (! m_pRasterGrid->m_Cell[nStart / m_nYGridMax][nStart % m_nYGridMax].bIsInContiguousSea()))
+            continue;
+
+         vector<int> nVZoneCell;
+         stack<int> nStack;
+         nStack.push(nStart);
+         while (! nStack.empty())
+         {
+            int nCell = nStack.top();
+            nStack.pop();
+
+            int
+               nX = nCell / m_nYGridMax,
+               nY = nCell % m_nYGridMax;
+
+            if ((! m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) || (dVShadow[nCell] < 0.5) || (m_pRasterGrid->m_Cell[nX][nY].nGetShadowZoneCode() != NOT_IN_SHADOW_ZONE))
+               continue;
+
+            m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(IN_SHADOW_ZONE_NOT_YET_DONE);
+            nVZoneCell.push_back(nCell);
+
+            if (nX > 0)
+               nStack.push(nCell - m_nYGridMax);
+            if (nX < m_nXGridMax-1)
+               nStack.push(nCell + m_nYGridMax);
+            if (nY > 0)
+               nStack.push(nCell - 1);
+            if (nY < m_nYGridMax-1)
+               nStack.push(nCell + 1);
+         }
+
+         // Change wave orientation and height for every cell in the shadow zone. This uses the same equations as nSweepShadowZone(), but since each cell is on a line from the cape to some point on the coast, the angle subtended by this point and the end of the shadow line is the same as the angle subtended by the cell and the end of the shadow line
+         int nShadowZoneCoastToCapeSeaHand = (m_VCoast[nCoast].nGetSeaHandedness() == LEFT_HANDED ? RIGHT_HANDED : LEFT_HANDED);
+         for (unsigned int n = 0; n < nVZoneCell.size(); n++)
+         {
+            int
+               nX = nVZoneCell[n] / m_nYGridMax,
+               nY = nVZoneCell[n] % m_nYGridMax;
+
+            m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(IN_SHADOW_ZONE_DONE);
+
+            CGeom2DIPoint PtiCell(nX, nY);
+            double dOmega = 180 * dAngleSubtended(&PtiCape, &PtiCell, &PtiCoast) / PI;
+
+            // If dOmega is 90 degrees or more in either direction, set both wave angle and wave height to zero
+            if (tAbs(dOmega) >= 90)
+            {
+               m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(0);
+               m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(0);
+               continue;
+            }
+
+            // Adapted from equations 12 and 13 in Hurst et al.
+            double dDeltaShadowWaveAngle = 1.5 * dOmega;
+            double dWaveOrientation = m_pRasterGrid->m_Cell[nX][nY].dGetWaveOrientation();
+            if (nShadowZoneCoastToCapeSeaHand == LEFT_HANDED)
+               m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dKeepWithin360(dWaveOrientation + dDeltaShadowWaveAngle));
+            else
+               m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dKeepWithin360(dWaveOrientation - dDeltaShadowWaveAngle));
+
+            double dKp = 0.5 * cos(dOmega * PI / 180);
+            m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dKp * m_pRasterGrid->m_Cell[nX][nY].dGetWaveHeight());
+         }
+
+         // Sweep the coast downdrift of the shadow zone, changing wave height in order to conserve energy. The length of the sweep is the number of coastline points between the coast point and the cape
+         int nRet = nSweepDownDriftFromShadowZone(nCoast, VnCapePoint[nZone], &PtiCape, VnCoastPoint[nZone], &PtiCoast, tAbs(VnCapePoint[nZone] - VnCoastPoint[nZone]) - 1);
+         if (nRet != RTN_OK)
+            return nRet;
+      }
+   }
+
+   return RTN_OK;
+}
+
+
+/*===============================================================================================================================
+ 
+ Looks for 'nested' shadow zones i.e. shadow zones which are within another shadow zone, and removes them
+ 
+===============================================================================================================================*/
+void CSimulation::RemoveNestedShadowZones(vector<int>* pVnCapePoint, vector<int>* pVnCoastPoint)
+{
+   for (unsigned int nZone = 0; nZone < pVnCapePoint->size(); nZone++)
+   {
+      if ((pVnCapePoint->at(nZone) != INT_NODATA) && (pVnCoastPoint->at(nZone) != INT_NODATA))
+      {
+         for (unsigned int nOtherZone = 0; nOtherZone < pVnCapePoint->size(); nOtherZone++)
+         {
+            if (nOtherZone == nZone)
+               continue;
+
+            if ((pVnCapePoint->at(nOtherZone) == INT_NODATA) || (pVnCoastPoint->at(nOtherZone) == INT_NODATA))
+               continue;
+            
+            if (pVnCapePoint->at(nZone) > pVnCoastPoint->at(nZone))
+            {
+               // The cape point is down-coast from the coast point   
+               if ((bIsBetween(pVnCoastPoint->at(nOtherZone), pVnCoastPoint->at(nZone), pVnCapePoint->at(nZone))) && (bIsBetween(pVnCapePoint->at(nOtherZone), pVnCoastPoint->at(nZone), pVnCapePoint->at(nZone))))
+               {
+                  // The nOtherZone shadow zone is nested within the nZone shadow zone
+                  pVnCoastPoint->at(nOtherZone) = INT_NODATA;
+                  pVnCapePoint->at(nOtherZone) = INT_NODATA;
+                  
+//                   LogStream << m_ulTimestep << ": shadow zone stage 3 (down-coast), zone " << nOtherZone << " is nested within zone " << nZone << " and will be ignored" << endl;
+               }
+            }
+            else
+            {
+               // The cape point is up-coast from the coast point               
+               if ((bIsBetween(pVnCoastPoint->at(nOtherZone), pVnCapePoint->at(nZone), pVnCoastPoint->at(nZone))) && (bIsBetween(pVnCapePoint->at(nOtherZone), pVnCapePoint->at(nZone), pVnCoastPoint->at(nZone))))
+               {
+                  // The nOtherZone shadow zone is nested within the nZone shadow zone
+                  pVnCoastPoint->at(nOtherZone) = INT_NODATA;
+                  pVnCapePoint->at(nOtherZone) = INT_NODATA;
+                  
+//                   LogStream << m_ulTimestep << ": shadow zone stage 3 (up-coast), zone " << nOtherZone << " is nested within zone " << nZone << " and will be ignored" << endl;                     
+               }
+            }
+         }
+      }         
+   }
+}
+
+
 /*===============================================================================================================================
  
  Flood fills a shadow zone
@@ -1556,168 +2197,225 @@ void CSimulation::CalcD50AndFillWaveCalcHoles(void)
    vector<int> VnPolygonD50Count(m_nGlobalPolygonID+1, 0);
    vector<double> VdPolygonD50(m_nGlobalPolygonID+1, 0);
 
+   // If the grid is tiled, only visit the tiles which have been in use during this timestep: no other cell can be a sea cell
+   vector<pair<int, int> > prVRun;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
-      for (int nY = 0; nY < m_nYGridMax; nY++)
+      m_pRasterGrid->m_Cell.GetActiveRuns(nX, 1, &prVRun);
+      for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
       {
-         if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
+         for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
          {
-            // This is a sea cell, is it in the active zone?
-            if (m_pRasterGrid->m_Cell[nX][nY].bIsInActiveZone())
+            if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
             {
-               // It is, so does it have unconsolidated sediment on it?
-               double dTmpd50 = m_pRasterGrid->m_Cell[nX][nY].dGetUnconsD50();
-               if (dTmpd50 != DBL_NODATA)
+               // This is a sea cell, is it in the active zone?
+               if (m_pRasterGrid->m_Cell[nX][nY].bIsInActiveZone())
                {
-                  // It does, so which polygon is it in?
-                  int nID = m_pRasterGrid->m_Cell[nX][nY].nGetPolygonID();
-                  if (nID != INT_NODATA)
+                  // It is, so does it have unconsolidated sediment on it?
+                  double dTmpd50 = m_pRasterGrid->m_Cell[nX][nY].dGetUnconsD50();
+                  if (dTmpd50 != DBL_NODATA)
                   {
-                     VnPolygonD50Count[nID]++;
-                     VdPolygonD50[nID] += dTmpd50;
+                     // It does, so which polygon is it in?
+                     int nID = m_pRasterGrid->m_Cell[nX][nY].nGetPolygonID();
+                     if (nID != INT_NODATA)
+                     {
+                        VnPolygonD50Count[nID]++;
+                        VdPolygonD50[nID] += dTmpd50;
+                     }
                   }
                }
-            }
 
-            // Now fill in wave calc holes, start by looking at the cell's N-S and W-E neighbours
-            int
-               nXTmp,
-               nYTmp,
-               nActive = 0,
-               nShadowOrDownDrift = 0,
-               nDownDrift = 0,
-               nRead = 0;
-            double
-               dWaveHeight = 0,
-               dWaveAngle = 0;
-
-            // North
-            nXTmp = nX;
-            nYTmp = nY-1;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
-            {
-               nRead++;
-               dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
-               dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
+               // Now fill in wave calc holes, start by looking at the cell's N-S and W-E neighbours
+               int
+                  nXTmp,
+                  nYTmp,
+                  nActive = 0,
+                  nShadowOrDownDrift = 0,
+                  nDownDrift = 0,
+                  nRead = 0;
+               double
+                  dWaveHeight = 0,
+                  dWaveAngle = 0;
+
+               // North
+               nXTmp = nX;
+               nYTmp = nY-1;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
+               {
+                  nRead++;
+                  dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
+                  dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
 
-               if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
-                  nActive++;
+                  if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
+                     nActive++;
                
-               int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
-               if (nZoneCode != NOT_IN_SHADOW_ZONE) 
-                  nShadowOrDownDrift++;
-               if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
-                  nDownDrift++;               
-            }
+                  int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
+                  if (nZoneCode != NOT_IN_SHADOW_ZONE) 
+                     nShadowOrDownDrift++;
+                  if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
+                     nDownDrift++;               
+               }
 
-            // East
-            nXTmp = nX+1;
-            nYTmp = nY;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
-            {
-               nRead++;
-               dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
-               dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
+               // East
+               nXTmp = nX+1;
+               nYTmp = nY;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
+               {
+                  nRead++;
+                  dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
+                  dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
 
-               if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
-                  nActive++;
+                  if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
+                     nActive++;
                
-               int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
-               if (nZoneCode != NOT_IN_SHADOW_ZONE) 
-                  nShadowOrDownDrift++;
-               if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
-                  nDownDrift++;               
-            }
+                  int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
+                  if (nZoneCode != NOT_IN_SHADOW_ZONE) 
+                     nShadowOrDownDrift++;
+                  if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
+                     nDownDrift++;               
+               }
 
-            // South
-            nXTmp = nX;
-            nYTmp = nY+1;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
-            {
-               nRead++;
-               dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
-               dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
+               // South
+               nXTmp = nX;
+               nYTmp = nY+1;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
+               {
+                  nRead++;
+                  dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
+                  dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
 
-               if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
-                  nActive++;
+                  if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
+                     nActive++;
                
-               int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
-               if (nZoneCode != NOT_IN_SHADOW_ZONE) 
-                  nShadowOrDownDrift++;
-               if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
-                  nDownDrift++;               
-            }
+                  int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
+                  if (nZoneCode != NOT_IN_SHADOW_ZONE) 
+                     nShadowOrDownDrift++;
+                  if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
+                     nDownDrift++;               
+               }
 
-            // West
-            nXTmp = nX-1;
-            nYTmp = nY;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
-            {
-               nRead++;
-               dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
-               dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
+               // West
+               nXTmp = nX-1;
+               nYTmp = nY;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInContiguousSea()))
+               {
+                  nRead++;
+                  dWaveHeight += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveHeight();
+                  dWaveAngle += (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetWaveOrientation());
 
-               if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
-                  nActive++;
+                  if (m_pRasterGrid->m_Cell[nXTmp][nYTmp].bIsInActiveZone())
+                     nActive++;
                
-               int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
-               if (nZoneCode != NOT_IN_SHADOW_ZONE) 
-                  nShadowOrDownDrift++;
-               if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
-                  nDownDrift++;               
-            }
+                  int nZoneCode = m_pRasterGrid->m_Cell[nXTmp][nYTmp].nGetShadowZoneCode();
+                  if (nZoneCode != NOT_IN_SHADOW_ZONE) 
+                     nShadowOrDownDrift++;
+                  if (nZoneCode == DOWNDRIFT_OF_SHADOW_ZONE)
+                     nDownDrift++;               
+               }
 
-            if (nRead > 0)
-            {
-               // Calculate the average of neighbours
-               dWaveHeight /= nRead;
-               dWaveAngle /= nRead;
-               dWaveAngle = dKeepWithin360(dWaveAngle);
+               if (nRead > 0)
+               {
+                  // Calculate the average of neighbours
+                  dWaveHeight /= nRead;
+                  dWaveAngle /= nRead;
+                  dWaveAngle = dKeepWithin360(dWaveAngle);
                
-               // If this sea cell has four active-zone neighbours, then it must also be in the active zone
-               if (nActive == 4)
-                  m_pRasterGrid->m_Cell[nX][nY].SetInActiveZone(true);
+                  // If this sea cell has four active-zone neighbours, then it must also be in the active zone
+                  if (nActive == 4)
+                     m_pRasterGrid->m_Cell[nX][nY].SetInActiveZone(true);
                
-               // If this cell has the (default) deep-water wave height, but its neighbours have a different average wave height, then give it the average of its neighbours
-               if ((m_pRasterGrid->m_Cell[nX][nY].dGetWaveHeight() == m_dDeepWaterWaveHeight) && (! bFPIsEqual(m_dDeepWaterWaveHeight, dWaveHeight, TOLERANCE)))
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
+                  // If this cell has the (default) deep-water wave height, but its neighbours have a different average wave height, then give it the average of its neighbours
+                  if ((m_pRasterGrid->m_Cell[nX][nY].dGetWaveHeight() == m_dDeepWaterWaveHeight) && (! bFPIsEqual(m_dDeepWaterWaveHeight, dWaveHeight, TOLERANCE)))
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
 
-               // If this cell has the (default) deep-water wave angle, but its neighbours have a different average wave angle, then give it the average of its neighbours
-               if ((m_pRasterGrid->m_Cell[nX][nY].dGetWaveOrientation() == m_dDeepWaterWaveOrientation) && (! bFPIsEqual(m_dDeepWaterWaveOrientation, dWaveAngle, TOLERANCE)))
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);
+                  // If this cell has the (default) deep-water wave angle, but its neighbours have a different average wave angle, then give it the average of its neighbours
+                  if ((m_pRasterGrid->m_Cell[nX][nY].dGetWaveOrientation() == m_dDeepWaterWaveOrientation) && (! bFPIsEqual(m_dDeepWaterWaveOrientation, dWaveAngle, TOLERANCE)))
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);
                
-               // If this sea cell is marked as IN_SHADOW_ZONE_NOT_YET_DONE then give it the average of its neighbours
-               int nZoneCode = m_pRasterGrid->m_Cell[nX][nY].nGetShadowZoneCode();
-               if (nZoneCode == IN_SHADOW_ZONE_NOT_YET_DONE)
-               {
-                  m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(IN_SHADOW_ZONE_DONE);
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);
-                  continue;
-               }
+                  // If this sea cell is marked as IN_SHADOW_ZONE_NOT_YET_DONE then give it the average of its neighbours
+                  int nZoneCode = m_pRasterGrid->m_Cell[nX][nY].nGetShadowZoneCode();
+                  if (nZoneCode == IN_SHADOW_ZONE_NOT_YET_DONE)
+                  {
+                     m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(IN_SHADOW_ZONE_DONE);
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);
+                     continue;
+                  }
                
-               // If this sea cell has four neighbours which are marked as downdrift of the shadow zone, then it must also be downdrift of the shadow zone, give it the average of its neighbours
-               if (nDownDrift == 4)
-               {
-                  m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(DOWNDRIFT_OF_SHADOW_ZONE);
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);   
-                  continue;
-               }
+                  // If this sea cell has four neighbours which are marked as downdrift of the shadow zone, then it must also be downdrift of the shadow zone, give it the average of its neighbours
+                  if (nDownDrift == 4)
+                  {
+                     m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(DOWNDRIFT_OF_SHADOW_ZONE);
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);   
+                     continue;
+                  }
                
-               // If this sea cell has four neighbours which are not in the shadow zone, but is not itself marked as in the shadow zone or down drift from the shadow zone, then assume it is in the shadow zone and give it the average of its neighbours
-               if ((nShadowOrDownDrift == 4) && (nZoneCode == NOT_IN_SHADOW_ZONE))
-               {
-                  m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(IN_SHADOW_ZONE_DONE);
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
-                  m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);                  
+                  // If this sea cell has four neighbours which are not in the shadow zone, but is not itself marked as in the shadow zone or down drift from the shadow zone, then assume it is in the shadow zone and give it the average of its neighbours
+                  if ((nShadowOrDownDrift == 4) && (nZoneCode == NOT_IN_SHADOW_ZONE))
+                  {
+                     m_pRasterGrid->m_Cell[nX][nY].SetShadowZoneCode(IN_SHADOW_ZONE_DONE);
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveHeight(dWaveHeight);
+                     m_pRasterGrid->m_Cell[nX][nY].SetWaveOrientation(dWaveAngle);                  
+                  }
                }
             }
          }
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 
    // Calculate the average d50 for every polygon
+   SetAllPolygonD50(&VnPolygonD50Count, &VdPolygonD50);
+}
+
+
+/*===============================================================================================================================
+
+ Calculates the average d50 of the unconsolidated sediment on the active-zone sea cells of each polygon. Is used when the wave results have been restored from the wave result cache, so holes have already been filled in. Only the sea's bounding box is searched, since all sea cells are within it
+
+===============================================================================================================================*/
+void CSimulation::CalcAllPolygonD50(void)
+{
+   vector<int> VnPolygonD50Count(m_nGlobalPolygonID+1, 0);
+   vector<double> VdPolygonD50(m_nGlobalPolygonID+1, 0);
+
+   for (int nX = m_nXMinBoundingBox; nX <= m_nXMaxBoundingBox; nX++)
+   {
+      for (int nY = m_nYMinBoundingBox; nY <= m_nYMaxBoundingBox; nY++)
+      {
+         if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea() && m_pRasterGrid->m_Cell[nX][nY].bIsInActiveZone())
+         {
+            // This is an active-zone sea cell, so does it have unconsolidated sediment on it?
+            double dTmpd50 = m_pRasterGrid->m_Cell[nX][nY].dGetUnconsD50();
+            if (dTmpd50 != DBL_NODATA)
+            {
+               // It does, so which polygon is it in?
+               int nID = m_pRasterGrid->m_Cell[nX][nY].nGetPolygonID();
+               if (nID != INT_NODATA)
+               {
+                  VnPolygonD50Count[nID]++;
+                  VdPolygonD50[nID] += dTmpd50;
+               }
+            }
+         }
+      }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
+   }
+
+   SetAllPolygonD50(&VnPolygonD50Count, &VdPolygonD50);
+}
+
+
+/*===============================================================================================================================
+
+ Given the sum of the d50 values of each polygon's active-zone cells, and the number of these cells, stores each polygon's average d50
+
+===============================================================================================================================*/
+void CSimulation::SetAllPolygonD50(vector<int> const* pVnPolygonD50Count, vector<double>* pVdPolygonD50)
+{
    for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
    {
       for (int nPoly = 0; nPoly < m_VCoast[nCoast].nGetNumPolygons(); nPoly++)
@@ -1725,10 +2423,10 @@ void CSimulation::CalcD50AndFillWaveCalcHoles(void)
          CGeomCoastPolygon* pPolygon = m_VCoast[nCoast].pGetPolygon(nPoly);
          int nID = pPolygon->nGetGlobalID();
 
-         if (VnPolygonD50Count[nID] > 0)
-            VdPolygonD50[nID] /= VnPolygonD50Count[nID];
+         if (pVnPolygonD50Count->at(nID) > 0)
+            pVdPolygonD50->at(nID) /= pVnPolygonD50Count->at(nID);
 
-         pPolygon->SetAvgUnconsD50(VdPolygonD50[nID]);
+         pPolygon->SetAvgUnconsD50(pVdPolygonD50->at(nID));
       }
    }
 }
@@ -1989,7 +2687,29 @@ int CSimulation::nCalcWavePropertiesOnProfile(int const nCoast, int const nCoast
     {
       // We are using COVE's linear wave theory to propoagate the waves
       double dDepthLookupMax = m_dWaveDepthRatioForWaveCalcs * m_dDeepWaterWaveHeight;
-         
+
+      // If we are using the linear wave theory look-up tables, then calculate unbroken wave height and wave angle for every point on the profile in a single batch. These do not depend on conditions further seaward, so it does not matter that most will not be used
+      vector<double>
+         VdUnbrokenWaveHeight,
+         VdUnbrokenAlpha;
+      if (m_bTabulateLinearWaves)
+      {
+         vector<double> VdSeaDepth(nProfileSize, dDepthLookupMax);
+         for (int nProfilePoint = (nProfileSize-1); nProfilePoint > 0; nProfilePoint--)
+         {
+            int
+               nX = pProfile->pPtiGetCellInProfile(nProfilePoint)->nGetX(),
+               nY = pProfile->pPtiGetCellInProfile(nProfilePoint)->nGetY();
+
+            if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
+               VdSeaDepth[nProfilePoint] = m_pRasterGrid->m_Cell[nX][nY].dGetSeaDepth();
+         }
+
+         VdUnbrokenWaveHeight.resize(nProfileSize, 0);
+         VdUnbrokenAlpha.resize(nProfileSize, 0);
+         CalcLinearWavesOnProfile(nProfileSize, &VdSeaDepth[0], dWaveToNormalAngle, &VdUnbrokenWaveHeight[0], &VdUnbrokenAlpha[0]);
+      }
+
       // Go landwards along the profile, calculating wave height and wave angle for every inundated point on the profile (don't do point zero, this is on the coastline) until the waves start to break  after breaking wave height is assumed to decrease linearly to zero at the shoreline and wave angle is equalt to wave angle at breaking
       for (int nProfilePoint = (nProfileSize-1); nProfilePoint > 0; nProfilePoint--)
       {
@@ -2013,15 +2733,25 @@ int CSimulation::nCalcWavePropertiesOnProfile(int const nCoast, int const nCoast
          {
             if (! bBreaking)
             {
-               // Start calculating wave properties using linear wave theory
-               double dL = m_dL_0 * sqrt(tanh((2 * PI * dSeaDepth) / m_dL_0));               // Wavelength (m) in intermediate-shallow waters
-               double dC = m_dC_0 * tanh((2 * PI * dSeaDepth) / dL);                         // Wave speed (m/s) set by dSeaDepth, dL and m_dC_0
-               double dk = 2 * PI / dL;                                                      // Wave number (1/m)
-               double dn = ((2 * dSeaDepth * dk) / (sinh(2 * dSeaDepth * dk)) + 1) / 2;      // Shoaling factor
-               double dKs = sqrt(m_dC_0 / (dn * dC * 2));                                    // Shoaling coefficient
-               double dAlpha = (180 / PI) * asin((dC / m_dC_0) * sin((PI / 180) * dWaveToNormalAngle));  // Calculate angle between wave direction and the normal to the coast tangent
-               double dKr = sqrt(cos((PI / 180) * dWaveToNormalAngle) / cos((PI / 180) * dAlpha));       // Refraction coefficient
-               dWaveHeight = m_dDeepWaterWaveHeight * dKs * dKr;                             // Calculate wave height, based on the previous (more seaward) wave height
+               double dAlpha;
+               if (m_bTabulateLinearWaves)
+               {
+                  // Use the values which were calculated from the look-up tables
+                  dWaveHeight = VdUnbrokenWaveHeight[nProfilePoint];
+                  dAlpha = VdUnbrokenAlpha[nProfilePoint];
+               }
+               else
+               {
+                  // Start calculating wave properties using linear wave theory
+                  double dL = m_dL_0 * sqrt(tanh((2 * PI * dSeaDepth) / m_dL_0));               // Wavelength (m) in intermediate-shallow waters
+                  double dC = m_dC_0 * tanh((2 * PI * dSeaDepth) / dL);                         // Wave speed (m/s) set by dSeaDepth, dL and m_dC_0
+                  double dk = 2 * PI / dL;                                                      // Wave number (1/m)
+                  double dn = ((2 * dSeaDepth * dk) / (sinh(2 * dSeaDepth * dk)) + 1) / 2;      // Shoaling factor
+                  double dKs = sqrt(m_dC_0 / (dn * dC * 2));                                    // Shoaling coefficient
+                  dAlpha = (180 / PI) * asin((dC / m_dC_0) * sin((PI / 180) * dWaveToNormalAngle));         // Calculate angle between wave direction and the normal to the coast tangent
+                  double dKr = sqrt(cos((PI / 180) * dWaveToNormalAngle) / cos((PI / 180) * dAlpha));       // Refraction coefficient
+                  dWaveHeight = m_dDeepWaterWaveHeight * dKs * dKr;                             // Calculate wave height, based on the previous (more seaward) wave height
+               }
                if (nSeaHand == LEFT_HANDED)
                   dWaveOrientation = dKeepWithin360(dAlpha + 90 + dFluxOrientationThis);
                else
@@ -2108,6 +2838,83 @@ int CSimulation::nCalcWavePropertiesOnProfile(int const nCoast, int const nCoast
 }
 
 
+/*===============================================================================================================================
+
+ Creates the look-up tables for COVE's linear wave theory calculations. With COVE's approximation to the dispersion relation, the shoaling coefficient and the ratio of wave speed to deep water wave speed depend only on (depth / deep water wavelength), so the tables are indexed by this and are valid for every wave period. So that the tables can be linearly interpolated in shallow water, where the shoaling coefficient tends to infinity and wave speed tends to zero, the shoaling coefficient is stored multiplied by (depth / deep water wavelength)^(1/4), and the wave speed ratio is stored divided by (depth / deep water wavelength)^(1/2): both are smooth everywhere. With an increment of 0.001, the interpolated shoaling coefficient and wave speed ratio are within a relative error of 1e-5 of the values calculated directly
+
+===============================================================================================================================*/
+void CSimulation::CreateLinearWaveLookUp(void)
+{
+   int nSize = dRound(LINEAR_WAVE_DEPTH_OVER_L0_MAX * INVERSE_LINEAR_WAVE_DEPTH_OVER_L0_INCREMENT) + 1;
+
+   m_VdLinearWaveKsLookUp.assign(nSize + 1, 0);
+   m_VdLinearWaveCLookUp.assign(nSize + 1, 0);
+
+   // At zero depth, use the shallow water limits: here the shoaling coefficient is (2 * (2 * PI * depth / L_0)^(1/2))^(-1/2) and the wave speed ratio is (2 * PI * depth / L_0)^(1/2)
+   m_VdLinearWaveKsLookUp[0] = 1 / sqrt(2 * sqrt(2 * PI));
+   m_VdLinearWaveCLookUp[0] = sqrt(2 * PI);
+
+   for (int n = 1; n < nSize; n++)
+   {
+      double dDepthOverL0 = n * LINEAR_WAVE_DEPTH_OVER_L0_INCREMENT;
+
+      // This is the same as the calculation in nCalcWavePropertiesOnProfile(), but with depth and wavelength divided by the deep water wavelength, and wave speed divided by the deep water wave speed
+      double dL = sqrt(tanh(2 * PI * dDepthOverL0));
+      double dC = tanh((2 * PI * dDepthOverL0) / dL);
+      double dk = 2 * PI / dL;
+      double dn = ((2 * dDepthOverL0 * dk) / (sinh(2 * dDepthOverL0 * dk)) + 1) / 2;
+      double dKs = sqrt(1 / (dn * dC * 2));
+
+      m_VdLinearWaveKsLookUp[n] = dKs * sqrt(sqrt(dDepthOverL0));
+      m_VdLinearWaveCLookUp[n] = dC / sqrt(dDepthOverL0);
+   }
+
+   // Pad the end of each table with a copy of the final value, so that the look-up never needs a bounds check
+   m_VdLinearWaveKsLookUp[nSize] = m_VdLinearWaveKsLookUp[nSize-1];
+   m_VdLinearWaveCLookUp[nSize] = m_VdLinearWaveCLookUp[nSize-1];
+}
+
+
+/*===============================================================================================================================
+
+ Uses the linear wave theory look-up tables to calculate unbroken wave height and the angle between wave direction and the normal to the coast tangent, at nPoints values of sea depth. The loop has no branches, so that the compiler can vectorize it. Depths greater than LINEAR_WAVE_DEPTH_OVER_L0_MAX times the deep water wavelength are treated as this depth (the resulting relative error is less than 1e-9)
+
+===============================================================================================================================*/
+void CSimulation::CalcLinearWavesOnProfile(int const nPoints, double const* pdSeaDepth, double const dWaveToNormalAngle, double* pdWaveHeight, double* pdAlpha) const
+{
+   double const
+      dInvL0 = 1 / m_dL_0,
+      dSinWaveToNormalAngle = sin((PI / 180) * dWaveToNormalAngle),
+      dCosWaveToNormalAngle = cos((PI / 180) * dWaveToNormalAngle);
+   double const* pdKsTable = &m_VdLinearWaveKsLookUp[0];
+   double const* pdCTable = &m_VdLinearWaveCLookUp[0];
+
+#ifdef _OPENMP
+   #pragma omp simd
+#endif
+   for (int i = 0; i < nPoints; i++)
+   {
+      double dDepthOverL0 = tMin(tMax(pdSeaDepth[i] * dInvL0, 0.0), LINEAR_WAVE_DEPTH_OVER_L0_MAX);
+      double dSqrtDepthOverL0 = sqrt(dDepthOverL0);
+
+      // Split the look-up index into integer and fractional parts, and interpolate linearly
+      double dLookUpIndex = dDepthOverL0 * INVERSE_LINEAR_WAVE_DEPTH_OVER_L0_INCREMENT;
+      int nIndex = static_cast<int>(dLookUpIndex);
+      double dFractPart = dLookUpIndex - nIndex;
+
+      double dKs = (pdKsTable[nIndex] - (dFractPart * (pdKsTable[nIndex] - pdKsTable[nIndex + 1]))) / sqrt(dSqrtDepthOverL0);     // Shoaling coefficient
+      double dCOverC0 = (pdCTable[nIndex] - (dFractPart * (pdCTable[nIndex] - pdCTable[nIndex + 1]))) * dSqrtDepthOverL0;       // Wave speed over deep water wave speed
+
+      // Refraction: cos(asin(x)) is sqrt(1 - x^2)
+      double dSinAlpha = dCOverC0 * dSinWaveToNormalAngle;
+      double dKr = sqrt(dCosWaveToNormalAngle / sqrt(1 - (dSinAlpha * dSinAlpha)));                  // Refraction coefficient
+
+      pdWaveHeight[i] = m_dDeepWaterWaveHeight * dKs * dKr;
+      pdAlpha[i] = (180 / PI) * asin(dSinAlpha);
+   }
+}
+
+
 /*===============================================================================================================================
 
  Create the CShore input file
@@ -24,8 +24,12 @@
 ===============================================================================================================================*/
 //#include <assert.h>
 
+#include <cstring>
+using std::memcpy;
+
 #include "cme.h"
 #include "cell.h"
+#include "raster_grid.h"
 
 
 CGeomCell::CGeomCell()
@@ -576,6 +580,15 @@ double CGeomCell::dGetTotWaveOrientation(void) const
    return m_dTotWaveOrientation;
 }
 
+//! Sets the wave height and wave orientation on this cell to values from an earlier timestep, and increments the totals by the amounts which they were incremented in that timestep
+void CGeomCell::SetCachedWaveValues(double const dWaveHeight, double const dTotWaveHeightIncr, double const dWaveOrientation, double const dTotWaveOrientationIncr)
+{
+   m_dWaveHeight = dWaveHeight;
+   m_dTotWaveHeight += dTotWaveHeightIncr;
+   m_dWaveOrientation = dWaveOrientation;
+   m_dTotWaveOrientation += dTotWaveOrientationIncr;
+}
+
 
 // Sets this cell's beach protection factor
 void CGeomCell::SetBeachProtectionFactor(double const dFactor)
@@ -764,3 +777,139 @@ double CGeomCell::dGetInterventionTopElev(void) const
    return m_VdAllHorizonTopElev.back() + m_dInterventionHeight;   
 }
 
+
+
+/*===============================================================================================================================
+
+ Copies a single value to, or from, a buffer of bytes
+
+===============================================================================================================================*/
+template <class T> static void AppendValue(vector<char>* pcVBuffer, T const Value)
+{
+   char const* pc = reinterpret_cast<char const*>(&Value);
+   pcVBuffer->insert(pcVBuffer->end(), pc, pc + sizeof(T));
+}
+
+template <class T> static char const* pcReadValue(char const* pc, T* pValue)
+{
+   memcpy(pValue, pc, sizeof(T));
+   return pc + sizeof(T);
+}
+
+
+//! Appends all of this cell's data to a buffer of bytes, so that the cell can be written to the grid tile scratch file
+void CGeomCell::AppendToBuffer(vector<char>* pcVBuffer)
+{
+   AppendValue(pcVBuffer, m_bInContiguousSea);
+   AppendValue(pcVBuffer, m_bIsInActiveZone);
+   AppendValue(pcVBuffer, m_bCoastline);
+   AppendValue(pcVBuffer, m_bEstimated);
+   AppendValue(pcVBuffer, m_bShadowBoundary);
+
+   AppendValue(pcVBuffer, m_nPolygonID);
+   AppendValue(pcVBuffer, m_nCoastlineNormal);
+   AppendValue(pcVBuffer, m_nShadowZoneCode);
+
+   double const dValue[] = { m_dLocalConsSlope, m_dBasementElevation, m_dSeaDepth, m_dTotSeaDepth, m_dWaveHeight, m_dTotWaveHeight, m_dWaveOrientation, m_dTotWaveOrientation, m_dBeachProtectionFactor, m_dSuspendedSediment, m_dTotSuspendedSediment, m_dPotentialPlatformErosion, m_dTotPotentialPlatformErosion, m_dActualPlatformErosion, m_dTotActualPlatformErosion, m_dCliffCollapse, m_dTotCliffCollapse, m_dCliffCollapseDeposition, m_dTotCliffCollapseDeposition, m_dPotentialBeachErosion, m_dTotPotentialBeachErosion, m_dActualBeachErosion, m_dTotActualBeachErosion, m_dBeachDeposition, m_dTotBeachDeposition, m_dUnconsD50, m_dInterventionHeight };
+   char const* pc = reinterpret_cast<char const*>(dValue);
+   pcVBuffer->insert(pcVBuffer->end(), pc, pc + sizeof(dValue));
+
+   // The landform. The cliff data is the largest member of the landform's union, so copying it also copies any other member
+   AppendValue(pcVBuffer, m_Landform.nGetLFCategory());
+   AppendValue(pcVBuffer, m_Landform.nGetLFSubCategory());
+   AppendValue(pcVBuffer, m_Landform.nGetCoast());
+   AppendValue(pcVBuffer, m_Landform.nGetPointOnCoast());
+   AppendValue(pcVBuffer, m_Landform.dGetAccumWaveEnergy());
+   AppendValue(pcVBuffer, m_Landform.dGetCliffNotchBaseElev());
+   AppendValue(pcVBuffer, m_Landform.dGetCliffNotchOverhang());
+   AppendValue(pcVBuffer, m_Landform.dGetCliffRemaining());
+
+   // The layers
+   AppendValue(pcVBuffer, static_cast<int>(m_VLayerAboveBasement.size()));
+   for (unsigned int n = 0; n < m_VLayerAboveBasement.size(); n++)
+   {
+      CRWCellSediment* pSediment[2] = { m_VLayerAboveBasement[n].pGetUnconsolidatedSediment(), m_VLayerAboveBasement[n].pGetConsolidatedSediment() };
+      for (int m = 0; m < 2; m++)
+      {
+         AppendValue(pcVBuffer, pSediment[m]->dGetFine());
+         AppendValue(pcVBuffer, pSediment[m]->dGetNotchFineLost());
+         AppendValue(pcVBuffer, pSediment[m]->dGetSand());
+         AppendValue(pcVBuffer, pSediment[m]->dGetNotchSandLost());
+         AppendValue(pcVBuffer, pSediment[m]->dGetCoarse());
+         AppendValue(pcVBuffer, pSediment[m]->dGetNotchCoarseLost());
+      }
+   }
+
+   AppendValue(pcVBuffer, static_cast<int>(m_VdAllHorizonTopElev.size()));
+   for (unsigned int n = 0; n < m_VdAllHorizonTopElev.size(); n++)
+      AppendValue(pcVBuffer, m_VdAllHorizonTopElev[n]);
+}
+
+
+//! Sets all of this cell's data from a buffer of bytes, as written by AppendToBuffer(). Returns a pointer to the byte after this cell's data
+char const* CGeomCell::pcReadFromBuffer(char const* pc)
+{
+   pc = pcReadValue(pc, &m_bInContiguousSea);
+   pc = pcReadValue(pc, &m_bIsInActiveZone);
+   pc = pcReadValue(pc, &m_bCoastline);
+   pc = pcReadValue(pc, &m_bEstimated);
+   pc = pcReadValue(pc, &m_bShadowBoundary);
+
+   pc = pcReadValue(pc, &m_nPolygonID);
+   pc = pcReadValue(pc, &m_nCoastlineNormal);
+   pc = pcReadValue(pc, &m_nShadowZoneCode);
+
+   double* pdValue[] = { &m_dLocalConsSlope, &m_dBasementElevation, &m_dSeaDepth, &m_dTotSeaDepth, &m_dWaveHeight, &m_dTotWaveHeight, &m_dWaveOrientation, &m_dTotWaveOrientation, &m_dBeachProtectionFactor, &m_dSuspendedSediment, &m_dTotSuspendedSediment, &m_dPotentialPlatformErosion, &m_dTotPotentialPlatformErosion, &m_dActualPlatformErosion, &m_dTotActualPlatformErosion, &m_dCliffCollapse, &m_dTotCliffCollapse, &m_dCliffCollapseDeposition, &m_dTotCliffCollapseDeposition, &m_dPotentialBeachErosion, &m_dTotPotentialBeachErosion, &m_dActualBeachErosion, &m_dTotActualBeachErosion, &m_dBeachDeposition, &m_dTotBeachDeposition, &m_dUnconsD50, &m_dInterventionHeight };
+   for (unsigned int n = 0; n < sizeof(pdValue) / sizeof(pdValue[0]); n++)
+      pc = pcReadValue(pc, pdValue[n]);
+
+   int nTmp;
+   double dTmp;
+   pc = pcReadValue(pc, &nTmp);
+   m_Landform.SetLFCategory(nTmp);
+   pc = pcReadValue(pc, &nTmp);
+   m_Landform.SetLFSubCategory(nTmp);
+   pc = pcReadValue(pc, &nTmp);
+   m_Landform.SetCoast(nTmp);
+   pc = pcReadValue(pc, &nTmp);
+   m_Landform.SetPointOnCoast(nTmp);
+   pc = pcReadValue(pc, &dTmp);
+   m_Landform.SetAccumWaveEnergy(dTmp);
+   pc = pcReadValue(pc, &dTmp);
+   m_Landform.SetCliffNotchBaseElev(dTmp);
+   pc = pcReadValue(pc, &dTmp);
+   m_Landform.SetCliffNotchOverhang(dTmp);
+   pc = pcReadValue(pc, &dTmp);
+   m_Landform.SetCliffRemaining(dTmp);
+
+   int nLayers;
+   pc = pcReadValue(pc, &nLayers);
+   m_VLayerAboveBasement.resize(nLayers);
+   for (int n = 0; n < nLayers; n++)
+   {
+      CRWCellSediment* pSediment[2] = { m_VLayerAboveBasement[n].pGetUnconsolidatedSediment(), m_VLayerAboveBasement[n].pGetConsolidatedSediment() };
+      for (int m = 0; m < 2; m++)
+      {
+         pc = pcReadValue(pc, &dTmp);
+         pSediment[m]->SetFine(dTmp);
+         pc = pcReadValue(pc, &dTmp);
+         pSediment[m]->SetNotchFineLost(dTmp);
+         pc = pcReadValue(pc, &dTmp);
+         pSediment[m]->SetSand(dTmp);
+         pc = pcReadValue(pc, &dTmp);
+         pSediment[m]->SetNotchSandLost(dTmp);
+         pc = pcReadValue(pc, &dTmp);
+         pSediment[m]->SetCoarse(dTmp);
+         pc = pcReadValue(pc, &dTmp);
+         pSediment[m]->SetNotchCoarseLost(dTmp);
+      }
+   }
+
+   int nHorizons;
+   pc = pcReadValue(pc, &nHorizons);
+   m_VdAllHorizonTopElev.resize(nHorizons);
+   for (int n = 0; n < nHorizons; n++)
+      pc = pcReadValue(pc, &m_VdAllHorizonTopElev[n]);
+
+   return pc;
+}
@@ -29,9 +29,10 @@
 #include "cme.h"
 #include "cell_landform.h"
 #include "cell_layer.h"
-#include "raster_grid.h"
 
 
+class CGeomRasterGrid;     // Forward declaration
+
 class CGeomCell
 {
    friend class CSimulation;
@@ -140,6 +141,7 @@ public:
    void SetWaveOrientation(double const);
    double dGetWaveOrientation(void) const;
    double dGetTotWaveOrientation(void) const;
+   void SetCachedWaveValues(double const, double const, double const, double const);
 
    void SetBeachProtectionFactor(double const);
    double dGetBeachProtectionFactor(void) const;
@@ -203,5 +205,8 @@ public:
    void SetShadowZoneCode(int const);
    int nGetShadowZoneCode(void) const;
    bool bIsinShadowZone(void) const;
+
+   void AppendToBuffer(vector<char>*);
+   char const* pcReadFromBuffer(char const*);
 };
 #endif // CELL_H
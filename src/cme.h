@@ -52,6 +52,10 @@
 #include <climits>
 #include <sstream>
 
+#ifdef _OPENMP
+   #include <omp.h>
+#endif
+
 #include "simulation.h"
 
 
@@ -230,6 +234,56 @@ double const   WALKDEN_HALL_PARAM_2                   = 0.75;              // Se
 
 double const   DEPTH_OVER_DB_INCREMENT                = 0.001;             // Depth Over DB increment for erosion potential look-up function
 double const   INVERSE_DEPTH_OVER_DB_INCREMENT        = 1000;              // Inverse of the above
+int const      EROSION_POTENTIAL_LOOKUP_PADDING       = 8;                 // Number of trailing zeros added to the padded erosion potential look-up table
+
+double const   LINEAR_WAVE_DEPTH_OVER_L0_INCREMENT    = 0.001;             // Depth over deep water wavelength increment for the linear wave theory look-up tables
+double const   INVERSE_LINEAR_WAVE_DEPTH_OVER_L0_INCREMENT = 1000;         // Inverse of the above
+double const   LINEAR_WAVE_DEPTH_OVER_L0_MAX          = 2;                 // Linear wave theory look-up tables go up to this depth over deep water wavelength (deeper is treated as this)
+
+double const   WAVE_CACHE_HEIGHT_BIN                  = 0.05;              // Bin width (m) for deep water wave height, when looking up cached wave propagation results
+double const   WAVE_CACHE_PERIOD_BIN                  = 0.1;               // Bin width (s) for wave period, ditto
+double const   WAVE_CACHE_ORIENTATION_BIN             = 1;                 // Bin width (degrees) for deep water wave orientation, ditto
+double const   WAVE_CACHE_SWL_BIN                     = 0.01;              // Bin width (m) for still water level, ditto
+int const      WAVE_CACHE_BLOCK_SIZE                  = 8;                 // Side (cells) of the square blocks into which the bounding box of the sea is split, for the bathymetry signature of cached wave propagation results
+double const   WAVE_CACHE_ELEV_TOLERANCE              = 0.05;              // Cached wave propagation results are only re-used if the mean elevation (m) of every block differs by no more than this
+double const   WAVE_CACHE_MAX_MB                      = 256;               // Maximum memory (Mb) for cached wave propagation results, the least recently used are discarded when this is exceeded
+
+int const      CLIFF_DEPOSITION_MAX_SEAWARD_OFFSET    = 0;                 // Largest seaward offset of a cliff collapse talus deposition profile, the deposition footprints used to batch collapses cover every offset up to this
+
+int const      VECTOR_GIS_TRANSACTION_FEATURES        = 20000;             // Maximum number of vector GIS features created in a single transaction, if the driver supports transactions
+int const      STATUS_SERVER_BACKLOG                  = 4;                 // Maximum number of queued connections to the status server
+int const      STATUS_SERVER_POLL_MS                  = 200;               // Status server checks whether it should stop this often, also gives up on a slow client after this long
+double const   STATUS_ROLLING_WEIGHT                  = 0.2;               // Weight given to the latest timestep in the rolling timings sent by the status server
+int const      SHARED_EXPORT_MAX_COASTS               = 256;               // Maximum number of coastlines in the shared-memory export
+int const      SHARED_EXPORT_COAST_POINTS_MULT        = 4;                 // Maximum number of coastline points in the shared-memory export is this times the sum of the grid's dimensions
+int const      GRID_TILE_MIN_SIDE                     = 8;                 // Smallest and largest allowed side (in cells) of a raster grid tile
+int const      GRID_TILE_MAX_SIDE                     = 4096;
+int const      GRID_TILE_HEAP_OVERHEAD                = 16;                // Allowance in bytes for the overhead of each heap block, when estimating the memory needed for a grid tile
+double const   GRID_TILE_PAGE_OUT_TARGET              = 0.75;              // When more grid tiles are in memory than the cache allows, page out tiles until this fraction of the cache is used
+
+// The stages of each timestep, for which wall-clock time may be recorded
+int const      STAGE_INIT_GRID                        = 0;
+int const      STAGE_LOCATE_SEA_AND_COASTS            = 1;
+int const      STAGE_ASSIGN_LANDFORMS                 = 2;
+int const      STAGE_CREATE_PROFILES                  = 3;
+int const      STAGE_CREATE_POLYGONS                  = 4;
+int const      STAGE_PROPAGATE_WAVES                  = 5;
+int const      STAGE_PLATFORM_EROSION                 = 6;
+int const      STAGE_CLIFF_COLLAPSE                   = 7;
+int const      STAGE_BEACH_EROSION_DEPOSITION         = 8;
+int const      STAGE_UPDATE_GRID                      = 9;
+int const      STAGE_GIS_OUTPUT                       = 10;
+int const      STAGE_TEXT_OUTPUT                      = 11;
+
+string const   STAGE_NAME[NUM_STAGES] = { "Grid initialization", "Sea and coastline location", "Landform assignment", "Profile creation", "Polygon creation", "Wave propagation", "Shore platform erosion", "Cliff collapse", "Beach erosion and deposition", "Grid update", "GIS output", "Text and time series output" };
+
+// The hardware performance counters which may be recorded for each stage of the timestep
+int const      HW_CYCLES                              = 0;
+int const      HW_INSTRUCTIONS                        = 1;
+int const      HW_CACHE_MISSES                        = 2;
+int const      HW_BRANCH_MISSES                       = 3;
+
+string const   HW_COUNTER_NAME[NUM_HW_COUNTERS] = { "cycles", "instructions", "cache misses", "branch misses" };
 
 // TODO Let the user define the CShore wave friction factor
 double const   CSHORE_FRICTION_FACTOR                 = 0.015;             // Friction factor for CShore model
@@ -285,6 +339,8 @@ string const   PERFORMHEAD =
 string const   OUTEXT                              = ".out";
 string const   LOGEXT                              = ".log";
 string const   CSVEXT                              = ".csv";
+string const   JSONEXT                             = ".json";
+string const   SCRATCHEXT                          = ".scratch";
 
 int const      ORIENTATION_NONE                    = 0;
 int const      ORIENTATION_NORTH                   = 1;
@@ -296,6 +352,13 @@ int const      ORIENTATION_SOUTH_WEST              = 6;
 int const      ORIENTATION_WEST                    = 7;
 int const      ORIENTATION_NORTH_WEST              = 8;
 
+// Random number stream codes, these keep the counter-based random number streams used by different routines (for the same polygon or cell) independent
+int const      RAND_STREAM_BEACH_EROSION_DOWNCOAST         = 1;
+int const      RAND_STREAM_BEACH_EROSION_UPCOAST           = 2;
+int const      RAND_STREAM_BEACH_DEPOSITION_DOWNCOAST      = 3;
+int const      RAND_STREAM_BEACH_DEPOSITION_UPCOAST        = 4;
+int const      RAND_STREAM_PLATFORM_EROSION_ADJ_CELL       = 5;
+
 int const      DIRECTION_DOWNCOAST                 = 0;        // Down-coast, i.e. along the coast so that the index of coastline points INCREASES
 int const      DIRECTION_UPCOAST                   = 1;        // Up-coast, i.e. along the coast so that the index of coastline points DECREASES
 
@@ -548,6 +611,11 @@ string const   VECTOR_CLIFF_NOTCH_SIZE_NAME                 = "cliff_notch";
 string const   VECTOR_PLOT_SHADOW_ZONE_BOUNDARY_CODE            = "shadow_boundary";
 string const   VECTOR_SHADOW_ZONE_LINE_NAME                 = "shadow_boundary";
 
+// GIS vector output container: file name, and attribute fields added when the container holds the whole run
+string const   VECTOR_CONTAINER_NAME                        = "vector";
+string const   VECTOR_CONTAINER_TIMESTEP_FIELD              = "Timestep";
+string const   VECTOR_CONTAINER_SAVE_FIELD                  = "Save";
+
 // GIS vector output codes and titles
 int const      PLOT_COAST                                   = 1;
 string const   PLOT_COAST_TITLE                             = "Coastline";
@@ -595,6 +663,19 @@ string const   SEDLOSTFROMGRIDTSCODE               = "sedlost";
 string const   SUSPSEDTSNAME                       = "suspended_sediment";
 string const   SUSPSEDTSCODE                       = "suspended";
 
+string const   STAGETSNAME                         = "stages";              // Written if per-stage timings, memory use or hardware counters are being recorded
+
+string const   TRACENAME                           = "trace";               // Chrome trace-event file, written if a trace is required
+
+string const   GRIDTILESNAME                       = "grid_tiles";          // Scratch file for the raster grid, only used if the grid is tiled. Deleted at the end of the run
+
+// States reported by the status server
+string const   STATUS_INITIALIZING                 = "initializing";
+string const   STATUS_RUNNING                      = "running";
+string const   STATUS_FINISHED                     = "finished";
+
+string const   SHARED_EXPORT_DEFAULT_PREFIX        = "/cme_";               // Followed by the run name and the process ID, if no name is given for the shared-memory export segment
+
 // CShore codes
 string const   WAVEENERGYFLUX                      = "wave_energy_flux";
 string const   WAVEHEIGHTX                         = "WAVEHEIGHTX.csv";
@@ -657,6 +738,7 @@ int const      RTN_ERR_CSHORE_OUTPUT_FILE             = 50;
 int const      RTN_ERR_CSHORE_INPUT_FILE              = 51;
 int const      RTN_ERR_WAVE_INTERPOLATION_LOOKUP      = 52;
 int const      RTN_ERR_GRIDCREATE                     = 53;
+int const      RTN_ERR_SCRATCH_FILE                   = 54;
 
 // Elevation and 'slice' codes
 int const      ELEV_IN_BASEMENT                    = -1;
@@ -677,6 +759,11 @@ int const      GRID_EDGE_MOBIUS                    = 2;
 int const      MODEL_COVE                          = 0;
 int const      MODEL_CSHORE                        = 1;
 
+// Vector GIS output container
+int const      VECTOR_CONTAINER_NONE               = 0;     // One file per data item per save
+int const      VECTOR_CONTAINER_SAVE               = 1;     // One file per save, with one layer per data item
+int const      VECTOR_CONTAINER_RUN                = 2;     // One file for the whole run, with one layer per data item
+
 // CShore interpolation method
 int const      CSHORE_INTERPOLATION_LINEAR         = 0;
 int const      CSHORE_INTERPOLATION_HERMITE_CUBIC  = 1;
@@ -733,6 +820,20 @@ double dRound(double const);
 // bool bIsWhole(double const);
 bool bIsNumber(double const);
 // bool bIsFinite(double const);
+
+// Definitions are in mem_accounting.cpp
+void SetAllocCounting(bool const);
+unsigned long long ullGetNumAllocs(void);
+unsigned long long ullGetAllocBytes(void);
+double dGetCurrentRSS(void);
+double dGetPeakRSS(void);
+bool bResetPeakRSS(void);
+
+// Definitions are in hw_counters.cpp
+bool bStartHWCounters(void);
+void StopHWCounters(void);
+bool bHWCounterAvailable(int const);
+void ReadHWCounters(unsigned long long*);
 struct FillToWidth
 {
    FillToWidth(char f, int w) : chFill(f), nWidth(w) 
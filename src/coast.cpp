@@ -30,24 +30,49 @@
 #include "i_line.h"
 
 
-CRWCoast::CRWCoast(void)
-:  m_nSeaHandedness(NULL_HANDED),
+//! Constructor, if pArena is not NULL then the coast's attribute vectors, profiles and polygons are all allocated from this per-timestep arena
+CRWCoast::CRWCoast(CArena* const pArena)
+:  m_bStraightCoast(false),
+   m_nSeaHandedness(NULL_HANDED),
    m_nStartEdge(INT_NODATA),
    m_nEndEdge(INT_NODATA),
    m_dCurvatureDetailedMean(0),
    m_dCurvatureDetailedSTD(0),
    m_dCurvatureSmoothMean(0),
-   m_dCurvatureSmoothSTD(0)
+   m_dCurvatureSmoothSTD(0),
+   m_pArena(pArena),
+   m_nVProfileNumber(CArenaAllocator<int>(pArena)),
+   m_nVBreakingDistance(CArenaAllocator<int>(pArena)),
+   m_nVPolygonNode(CArenaAllocator<int>(pArena)),
+   m_dVCurvatureDetailed(CArenaAllocator<double>(pArena)),
+   m_dVCurvatureSmooth(CArenaAllocator<double>(pArena)),
+   m_dVBreakingWaveHeight(CArenaAllocator<double>(pArena)),
+   m_dVBreakingWaveAngle(CArenaAllocator<double>(pArena)),
+   m_dVDepthOfBreaking(CArenaAllocator<double>(pArena)),
+   m_dVFluxOrientation(CArenaAllocator<double>(pArena)),
+   m_dVWaveEnergy(CArenaAllocator<double>(pArena)),
+   m_nVLandformCategory(CArenaAllocator<int>(pArena)),
+   m_cVCliffAllSedimentGone(CArenaAllocator<char>(pArena)),
+   m_dVCliffNotchBaseElev(CArenaAllocator<double>(pArena)),
+   m_dVCliffNotchOverhang(CArenaAllocator<double>(pArena)),
+   m_dVCliffRemaining(CArenaAllocator<double>(pArena)),
+   m_dVTotAccumWaveEnergy(CArenaAllocator<double>(pArena)),
+   m_VProfile(CArenaAllocator<CGeomProfile>(pArena)),
+   m_nVProfileCoastIndex(CArenaAllocator<int>(pArena)),
+   m_dVPolygonLength(CArenaAllocator<double>(pArena))
 {
 }
 
 CRWCoast::~CRWCoast(void)
 {
-   for (unsigned int i = 0; i < m_pVLandforms.size(); i++)
-      delete m_pVLandforms[i];
-
    for (unsigned int i = 0; i < m_pVPolygon.size(); i++)
-      delete m_pVPolygon[i];
+   {
+      // Polygons which were constructed in the arena are just destroyed, their storage is reclaimed when the arena is reset
+      if (m_pArena != NULL)
+         m_pVPolygon[i]->~CGeomCoastPolygon();
+      else
+         delete m_pVPolygon[i];
+   }
 }
 
 
@@ -144,6 +169,27 @@ CGeom2DIPoint* CRWCoast::pPtiGetCellMarkedAsCoastline(int const n)
    return &m_VCellsMarkedAsCoastline[n];
 }
 
+
+void CRWCoast::SetTracedCells(CGeomILine const* pILCells)
+{
+   m_ILTracedCells = *pILCells;
+}
+
+CGeomILine* CRWCoast::pILGetTracedCells(void)
+{
+   return &m_ILTracedCells;
+}
+
+void CRWCoast::SetTracedSmoothed(CGeomLine const* pLSmoothed)
+{
+   m_LTracedSmoothed = *pLSmoothed;
+}
+
+CGeomLine* CRWCoast::pLGetTracedSmoothed(void)
+{
+   return &m_LTracedSmoothed;
+}
+
 // int CRWCoast::nGetNCellsMarkedAsCoastline(void) const
 // {
 //    return m_VCellsMarkedAsCoastline.size();
@@ -194,7 +240,7 @@ void CRWCoast::SetDetailedCurvature(int const nCoastPoint, double const dCurvatu
    m_dVCurvatureDetailed[nCoastPoint] = dCurvature;
 }
 
-vector<double>* CRWCoast::pVGetDetailedCurvature(void)
+vector<double, CArenaAllocator<double> >* CRWCoast::pVGetDetailedCurvature(void)
 {
    return &m_dVCurvatureDetailed;
 }
@@ -211,7 +257,7 @@ void CRWCoast::SetSmoothCurvature(int const nCoastPoint, double const dCurvature
    m_dVCurvatureSmooth[nCoastPoint] = dCurvature;
 }
 
-vector<double>* CRWCoast::pVGetSmoothCurvature(void)
+vector<double, CArenaAllocator<double> >* CRWCoast::pVGetSmoothCurvature(void)
 {
    return &m_dVCurvatureSmooth;
 }
@@ -257,6 +303,16 @@ double CRWCoast::dGetSmoothCurvatureSTD(void) const
    return m_dCurvatureSmoothSTD;
 }
 
+void CRWCoast::SetStraightCoast(bool const bFlag)
+{
+   m_bStraightCoast = bFlag;
+}
+
+bool CRWCoast::bIsStraightCoast(void) const
+{
+   return m_bStraightCoast;
+}
+
 
 CGeomProfile* CRWCoast::pGetProfile(int const nProfile)
 {
@@ -399,15 +455,102 @@ double CRWCoast::dGetWaveEnergy(int const nCoastPoint) const
 }
 
 
-void CRWCoast::AppendCoastLandform(CACoastLandform* pCoastLandform)
+//! Appends a coastal landform with the given category, cliff attributes (remaining sediment, notch base elevation, and notch overhang), and accumulated wave energy
+void CRWCoast::AppendCoastLandform(int const nCategory, double const dRemaining, double const dNotchBaseElev, double const dNotchOverhang, double const dAccumWaveEnergy)
+{
+   m_nVLandformCategory.push_back(nCategory);
+   m_cVCliffAllSedimentGone.push_back(0);
+   m_dVCliffNotchBaseElev.push_back(dNotchBaseElev);
+   m_dVCliffNotchOverhang.push_back(dNotchOverhang);
+   m_dVCliffRemaining.push_back(dRemaining);
+   m_dVTotAccumWaveEnergy.push_back(dAccumWaveEnergy);
+}
+
+int CRWCoast::nGetLandformCategory(int const nCoastPoint) const
+{
+   // NOTE no check to see if nCoastPoint < m_nVLandformCategory.size()
+   return m_nVLandformCategory[nCoastPoint];
+}
+
+double CRWCoast::dGetTotAccumWaveEnergy(int const nCoastPoint) const
+{
+   // NOTE no check to see if nCoastPoint < m_dVTotAccumWaveEnergy.size()
+   return m_dVTotAccumWaveEnergy[nCoastPoint];
+}
+
+//! Adds this timestep's wave energy to the accumulated wave energy of every coastal landform, and extends the erosional notch of every cliff by the cliff erodibility times this timestep's wave energy (but by no more than the maximum extension, and no more than the sediment remaining). This is done as a single pass over all coast points. The actual notch extension for each point is returned in the first output vector, and the coast points of cliffs which are now ready to collapse (because the notch overhang is at least the threshold overhang, or because there is no sediment remaining) are returned in the second
+void CRWCoast::AccumulateWaveEnergyAndErodeCliffNotches(double const dCliffErodibility, double const dMaxExtension, double const dThresholdOverhang, vector<double>* pdVNotchExtension, vector<int>* pnVReadyToCollapse)
+{
+   int nPoints = m_nVLandformCategory.size();
+   pdVNotchExtension->resize(nPoints);
+   pnVReadyToCollapse->clear();
+   if (nPoints == 0)
+      return;
+
+   int const* pnCategory = &m_nVLandformCategory[0];
+   double const* pdWaveEnergy = &m_dVWaveEnergy[0];
+   double
+      * pdAccumWaveEnergy = &m_dVTotAccumWaveEnergy[0],
+      * pdRemaining = &m_dVCliffRemaining[0],
+      * pdOverhang = &m_dVCliffNotchOverhang[0],
+      * pdExtension = &pdVNotchExtension->at(0);
+
+#ifdef _OPENMP
+   #pragma omp simd
+#endif
+   for (int n = 0; n < nPoints; n++)
+   {
+      pdAccumWaveEnergy[n] += pdWaveEnergy[n];
+
+      // The extension cannot exceed the maximum, and also cannot exceed the XY-plane length of sediment remaining. It is zero for landforms which are not cliffs
+      double dExtension = tMin(tMin(dMaxExtension, dCliffErodibility * pdWaveEnergy[n]), pdRemaining[n]);
+      dExtension = (pnCategory[n] == LF_CAT_CLIFF) ? dExtension : 0;
+
+      pdRemaining[n] -= dExtension;
+      pdOverhang[n] += dExtension;
+      pdExtension[n] = dExtension;
+   }
+
+   for (int n = 0; n < nPoints; n++)
+   {
+      if ((pnCategory[n] == LF_CAT_CLIFF) && ((pdRemaining[n] <= 0) || (pdOverhang[n] >= dThresholdOverhang)))
+         pnVReadyToCollapse->push_back(n);
+   }
+}
+
+double CRWCoast::dGetCliffNotchBaseElev(int const nCoastPoint) const
+{
+   return m_dVCliffNotchBaseElev[nCoastPoint];
+}
+
+void CRWCoast::SetCliffNotchBaseElev(int const nCoastPoint, double const dNewElev)
+{
+   m_dVCliffNotchBaseElev[nCoastPoint] = dNewElev;
+}
+
+double CRWCoast::dGetCliffNotchOverhang(int const nCoastPoint) const
+{
+   return m_dVCliffNotchOverhang[nCoastPoint];
+}
+
+void CRWCoast::SetCliffNotchOverhang(int const nCoastPoint, double const dLenIn)
+{
+   m_dVCliffNotchOverhang[nCoastPoint] = dLenIn;
+}
+
+double CRWCoast::dGetCliffRemaining(int const nCoastPoint) const
+{
+   return m_dVCliffRemaining[nCoastPoint];
+}
+
+bool CRWCoast::bCliffAllSedimentGone(int const nCoastPoint) const
 {
-   m_pVLandforms.push_back(pCoastLandform);
+   return (m_cVCliffAllSedimentGone[nCoastPoint] != 0);
 }
 
-CACoastLandform* CRWCoast::pGetCoastLandform(int const nCoastPoint)
+void CRWCoast::SetCliffAllSedimentGone(int const nCoastPoint)
 {
-   // NOTE no check to see if nCoastPoint < m_VCellsMarkedAsCoastline.size()
-   return m_pVLandforms[nCoastPoint];
+   m_cVCliffAllSedimentGone[nCoastPoint] = 1;
 }
 
 
@@ -425,7 +568,11 @@ int CRWCoast::nGetPolygonNode(int const nPoint) const
 
 void CRWCoast::CreatePolygon(int const nGlobalID, int const nCoastID, int const nCoastPoint, CGeom2DIPoint const* PtiNode, CGeom2DIPoint const* PtiAntiNode, int const nProfileUpCoast, int const nProfileDownCoast, vector<CGeom2DPoint> const* pVIn, int const nPointsUpCoastProfile, int const nPointsDownCoastProfile, int const nPointInPolygonStartPoint)
 {
-   CGeomCoastPolygon* pPolygon = new CGeomCoastPolygon(nGlobalID, nCoastID, nCoastPoint, nProfileUpCoast, nProfileDownCoast, pVIn, nPointsUpCoastProfile, nPointsDownCoastProfile, PtiNode, PtiAntiNode, nPointInPolygonStartPoint);
+   CGeomCoastPolygon* pPolygon;
+   if (m_pArena != NULL)
+      pPolygon = new(m_pArena->pAllocate(sizeof(CGeomCoastPolygon), alignof(CGeomCoastPolygon))) CGeomCoastPolygon(nGlobalID, nCoastID, nCoastPoint, nProfileUpCoast, nProfileDownCoast, pVIn, nPointsUpCoastProfile, nPointsDownCoastProfile, PtiNode, PtiAntiNode, nPointInPolygonStartPoint);
+   else
+      pPolygon = new CGeomCoastPolygon(nGlobalID, nCoastID, nCoastPoint, nProfileUpCoast, nProfileDownCoast, pVIn, nPointsUpCoastProfile, nPointsDownCoastProfile, PtiNode, PtiAntiNode, nPointInPolygonStartPoint);
 
    m_pVPolygon.push_back(pPolygon);
 }
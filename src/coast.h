@@ -27,19 +27,22 @@
 
 ===============================================================================================================================*/
 #include "cme.h"
+#include "i_line.h"
 #include "profile.h"
 #include "cell.h"
-#include "coast_landform.h"
 #include "coast_polygon.h"
+#include "arena.h"
 
 
 class CGeomProfile;
-class CACoastLandform;
 class CGeomCoastPolygon;
 
 class CRWCoast
 {
 private:
+   bool
+      m_bStraightCoast;          // Was the coast straight, so that curvature at the mid-point was set artificially?
+
    int
       m_nSeaHandedness,          // Handedness of the direction of the sea from the coastline, travelling down-coast (i.e. in direction of increasing coast point indices)
       m_nStartEdge,
@@ -54,12 +57,21 @@ private:
    CGeomLine
       m_LCoastline;              // Smoothed line of points (external CRS) giving the plan view of the vector coast
 
+   // These are only kept if the coastline is re-traced incrementally. They are the same length as each other but may be longer than m_LCoastline, since they include duplicate smoothed points
+   CGeomILine
+      m_ILTracedCells;           // Every cell (grid CRS) found by the coastline tracer, before smoothing
+   CGeomLine
+      m_LTracedSmoothed;         // Smoothed version (external CRS) of m_ILTracedCells
+
+   CArena*
+      m_pArena;                  // If not NULL, the per-timestep arena from which this coast's attribute vectors, profiles and polygons are allocated
+
    // All these are the same length as m_LCoastline (which may be different each timestep)
-   vector<int>
+   vector<int, CArenaAllocator<int> >
       m_nVProfileNumber,         // At each point on m_LCoastline: INT_NODATA if no profile there, otherwise the profile number
       m_nVBreakingDistance,      // Distance of breaking (in cells), at each point on m_LCoastline
       m_nVPolygonNode;           // At every point on m_LCoastline: INT_NODATA if no nodepoint there, otherwise the node (point of greatest concave curvature) number for a coast polygon
-   vector<double>
+   vector<double, CArenaAllocator<double> >
       m_dVCurvatureDetailed,     // Detailed curvature at each point on m_LCoastline
       m_dVCurvatureSmooth,       // Smoothed curvature at each point on m_LCoastline
       m_dVBreakingWaveHeight,    // Breaking wave height at each point on m_LCoastline
@@ -69,23 +81,32 @@ private:
       m_dVWaveEnergy;            // Wave energy at each point on m_LCoastline
    vector<CGeom2DIPoint>
       m_VCellsMarkedAsCoastline; // Unsmoothed integer x-y co-ords (grid CRS) of the cell marked as coastline at each point on the vector coastline. Note that this is the same as point zero in profile coords
-   vector<CACoastLandform*>
-      m_pVLandforms;             // Pointer to a coastal landform object, at each point on m_LCoastline
+
+   // The coastal landform at each point on m_LCoastline. These are also the same length as m_LCoastline, once landforms have been assigned. The cliff attributes are only meaningful for cliff landforms
+   vector<int, CArenaAllocator<int> >
+      m_nVLandformCategory;      // Landform category code
+   vector<char, CArenaAllocator<char> >
+      m_cVCliffAllSedimentGone;  // Non-zero if all sediment has gone from the cliff as a result of cliff collapse
+   vector<double, CArenaAllocator<double> >
+      m_dVCliffNotchBaseElev,    // Z-plane elevation (in external CRS units) of the base of the cliff's erosional notch. The notch is assumed to extend across the whole width of the coast cell on the side of the cell that touches the sea
+      m_dVCliffNotchOverhang,    // The XY-plane length (in external CRS units) of the cliff's erosional notch, measured inland from the side of the cell that touches the sea
+      m_dVCliffRemaining,        // The XY-plane length (in external CRS units) of the remaining sediment on the cliff's coast cell at the elevation of the notch, measured in the same direction as the notch overhang
+      m_dVTotAccumWaveEnergy;    // Total accumulated wave energy since beginning of simulation
 
    // These do not have the same length as m_LCoastline
-   vector<CGeomProfile>
+   vector<CGeomProfile, CArenaAllocator<CGeomProfile> >
       m_VProfile;                // Coast profile objects, in the sequence in which they were created (concave coastline curvature)
-   vector<int>
+   vector<int, CArenaAllocator<int> >
       m_nVProfileCoastIndex;     // Indices of coast profiles sorted into along-coastline sequence, size = number of profiles
    vector<CGeomCoastPolygon*>
       m_pVPolygon;               // Coast polygons, size = number of polygons
-   vector<double>
+   vector<double, CArenaAllocator<double> >
       m_dVPolygonLength;         // Lengths of coast polygons, size = number of polygons
    vector<CGeomLine>
       m_LShadowZoneBoundary;     // Lines which delineate the edge of a shadow zone, ext CRS
 
 public:
-   CRWCoast(void);
+   explicit CRWCoast(CArena* const = NULL);
    ~CRWCoast(void);
 
    void SetSeaHandedness(int const);
@@ -108,15 +129,20 @@ public:
    void AppendCellMarkedAsCoastline(int const, int const);
 //    void SetCellsMarkedAsCoastline(vector<CGeom2DIPoint>*);
    CGeom2DIPoint* pPtiGetCellMarkedAsCoastline(int const);
+
+   void SetTracedCells(CGeomILine const*);
+   CGeomILine* pILGetTracedCells(void);
+   void SetTracedSmoothed(CGeomLine const*);
+   CGeomLine* pLGetTracedSmoothed(void);
 //    int nGetNCellsMarkedAsCoastline(void) const;
    int nGetCoastPointGivenCell(CGeom2DIPoint const*);
 
    double dGetDetailedCurvature(int const) const;
    void SetDetailedCurvature(int const, double const);
-   vector<double>* pVGetDetailedCurvature(void);
+   vector<double, CArenaAllocator<double> >* pVGetDetailedCurvature(void);
    double dGetSmoothCurvature(int const) const;
    void SetSmoothCurvature(int const, double const);
-   vector<double>* pVGetSmoothCurvature(void);
+   vector<double, CArenaAllocator<double> >* pVGetSmoothCurvature(void);
    void SetDetailedCurvatureMean(double const);
    double dGetDetailedCurvatureMean(void) const;
    void SetDetailedCurvatureSTD(double const);
@@ -125,6 +151,8 @@ public:
    double dGetSmoothCurvatureMean(void) const;
    void SetSmoothCurvatureSTD(double const);
    double dGetSmoothCurvatureSTD(void) const;
+   void SetStraightCoast(bool const);
+   bool bIsStraightCoast(void) const;
    
    CGeomProfile* pGetProfile(int const);
    void AppendProfile(int const, int const);
@@ -150,8 +178,17 @@ public:
    void SetWaveEnergy(int const, double const);
    double dGetWaveEnergy(int const) const;
 
-   void AppendCoastLandform(CACoastLandform*);
-   CACoastLandform* pGetCoastLandform(int const);
+   void AppendCoastLandform(int const, double const, double const, double const, double const);
+   int nGetLandformCategory(int const) const;
+   double dGetTotAccumWaveEnergy(int const) const;
+   void AccumulateWaveEnergyAndErodeCliffNotches(double const, double const, double const, vector<double>*, vector<int>*);
+   double dGetCliffNotchBaseElev(int const) const;
+   void SetCliffNotchBaseElev(int const, double const);
+   double dGetCliffNotchOverhang(int const) const;
+   void SetCliffNotchOverhang(int const, double const);
+   double dGetCliffRemaining(int const) const;
+   bool bCliffAllSedimentGone(int const) const;
+   void SetCliffAllSedimentGone(int const);
 
    void SetPolygonNode(int const, int const);
    int nGetPolygonNode(int const) const;
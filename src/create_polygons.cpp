@@ -29,6 +29,16 @@ using std::endl;
 #include <stack>
 using std::stack;
 
+#include <algorithm>
+using std::sort;
+
+#include <utility>
+using std::pair;
+using std::make_pair;
+
+#include <cmath>
+using std::ceil;
+
 #include "cme.h"
 #include "simulation.h"
 #include "coast.h"
@@ -258,6 +268,68 @@ void CSimulation::RasterizePolygonJoiningLine(CGeom2DPoint const* pPt1, CGeom2DP
 ===============================================================================================================================*/
 void CSimulation::MarkPolygonCells(void)
 {
+   if (m_bScanlinePolygonRaster)
+   {
+      // We are using the scanline rasterizer instead of the flood fill. First make a list of every polygon on every coast
+      vector<CGeomCoastPolygon*> pVPolygon;
+      for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+      {
+         for (int nPoly = 0; nPoly < m_VCoast[nCoast].nGetNumPolygons(); nPoly++)
+         {
+            CGeomCoastPolygon* pPolygon = m_VCoast[nCoast].pGetPolygon(nPoly);
+
+            // Safety check: ignoring the duplicated node point, the boundary must have at least three points
+            if (pPolygon->nGetBoundarySize() < 4)
+            {
+               LogStream << m_ulTimestep << ": " << WARN << "degenerate polygon, not rasterized: coast " << nCoast << ", polygon " << nPoly << " has " << pPolygon->nGetBoundarySize() << " boundary points" << endl;
+
+               pPolygon->SetNumCells(0);
+               continue;
+            }
+
+            pVPolygon.push_back(pPolygon);
+         }
+      }
+
+      int nNumPolygons = pVPolygon.size();
+      vector<vector<int> > nVVSpan(nNumPolygons);
+
+      // Find the row spans of cells within each polygon. The raster grid is not used here, so this can be done for all polygons in parallel
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic)
+#endif
+      for (int n = 0; n < nNumPolygons; n++)
+         RasterizePolygonInterior(pVPolygon[n], &nVVSpan[n]);
+
+      // Now mark the cells. Cells which are already marked as belonging to a polygon (e.g. the boundary cells, including the coastline) are left alone. Polygons do not overlap, but a cell which lies exactly on a shared boundary could be claimed by both polygons: so do this serially, in polygon sequence, so that the result is always the same
+      for (int n = 0; n < nNumPolygons; n++)
+      {
+         int
+            nPolyID = pVPolygon[n]->nGetGlobalID(),
+            nCellsInPolygon = 0;
+
+         for (unsigned int m = 0; m+2 < nVVSpan[n].size(); m += 3)
+         {
+            int nY = nVVSpan[n][m];
+            for (int nX = nVVSpan[n][m+1]; nX <= nVVSpan[n][m+2]; nX++)
+            {
+               if (m_pRasterGrid->m_Cell[nX][nY].nGetPolygonID() == INT_NODATA)
+               {
+                  m_pRasterGrid->m_Cell[nX][nY].SetPolygonID(nPolyID);
+                  nCellsInPolygon++;
+               }
+            }
+         }
+
+         if (nVVSpan[n].empty())
+            LogStream << m_ulTimestep << ": " << WARN << "degenerate polygon, no cell centroids within polygon " << nPolyID << endl;
+
+         pVPolygon[n]->SetNumCells(nCellsInPolygon);
+      }
+
+      return;
+   }
+
    // Do this for each coast
    for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
    {
@@ -274,40 +346,8 @@ void CSimulation::MarkPolygonCells(void)
          // Create an empty stack
          stack<CGeom2DIPoint> PtiStack;
 
-         // Since the polygon's vector boundary does not coincide exactly with the polygon's raster boundary, and the point-in-polygon check gives an indeterminate result if the point is exectly on the polygon's boundary, for safety we must construct a vector 'inner buffer' which is smaller than, and inside, the vector boundary
-         int
-            nHand = m_VCoast[nCoast].nGetSeaHandedness(),
-            nSize = pPolygon->nGetBoundarySize();
-         vector<CGeom2DPoint> PtVInnerBuffer;
-         for (int i = 0; i < nSize-1; i++)
-         {
-            int j = i+1;
-            if (i == nSize-2)       // We must ignore the duplicated node point
-               j = 0;
-            CGeom2DPoint
-               PtThis = *pPolygon->pPtGetBoundaryPoint(i),
-               PtNext = *pPolygon->pPtGetBoundaryPoint(j),
-               PtBuffer = PtGetPerpendicular(&PtThis, &PtNext, m_dCellSide, nHand);
-
-            PtVInnerBuffer.push_back(PtBuffer);
-         }
-
-//          // DEBUG STUFF
-//          LogStream << endl << "Timestep " << m_ulTimestep << ": coast " << nCoast << ", polygon " << nPoly << endl;
-//          LogStream << "Boundary\t\t\tBuffer" << endl;
-//          for (int i = 0; i < pPolygon->nGetBoundarySize()-1; i++)
-//             LogStream << "{" << pPolygon->pPtGetBoundaryPoint(i)->dGetX() << ", " << pPolygon->pPtGetBoundaryPoint(i)->dGetY() << "}\t{" << PtVInnerBuffer[i].dGetX() << ", " << PtVInnerBuffer[i].dGetY() << "}" << endl;
-//          LogStream << endl;
-
-         // Now look for a point that is within the polygon as a start point for the flood fill. For a first attempt, calculate the polygon's centroid
-         CGeom2DPoint PtStart = pPolygon->PtGetCentroid();
-
-         // Is the centroid within the inner buffer?
-         if (! bIsWithinPolygon(&PtStart, &PtVInnerBuffer))
-         {
-            // No, it is not: the polygon must be a concave polygon. So keep looking for a point which is definitely inside the polygon, using an alternative method
-            PtStart = PtFindPointInPolygon(&PtVInnerBuffer, pPolygon->nGetPointInPolygonSearchStartPoint());
-         }
+         // Find a point which is definitely within the polygon, as a start point for the flood fill
+         CGeom2DPoint PtStart = PtFindPolygonFillStartPoint(pPolygon, m_VCoast[nCoast].nGetSeaHandedness());
 
          // Safety check
          if (PtStart.dGetX() == DBL_NODATA)
@@ -383,6 +423,155 @@ void CSimulation::MarkPolygonCells(void)
 }
 
 
+/*===============================================================================================================================
+
+ Finds the cells of the raster grid which are within a coastal polygon, using an edge-table scanline rasterizer: there is no search for a start point, and no flood fill. A cell is within the polygon if its centroid is inside the polygon's vector boundary (using the even-odd rule, with each edge covering the rows from its upper end up to but not including its lower end, so that vertices are not counted twice). The result is a list of row spans, three ints per span: the row, then the first and last columns of the span. Spans are in row order, and are clipped to the grid. Does not use the raster grid, so may be called for several polygons at once
+
+===============================================================================================================================*/
+void CSimulation::RasterizePolygonInterior(CGeomCoastPolygon* pPolygon, vector<int>* pnVSpan) const
+{
+   // Ignore the duplicated node point at the end of the boundary
+   int nSize = pPolygon->nGetBoundarySize()-1;
+   if (nSize < 3)
+      return;
+
+   // Get the vertices in the raster-grid CRS (not rounded). Note that cell n extends from n to n+1, so its centroid is at n+0.5
+   vector<double>
+      dVX(nSize),
+      dVY(nSize);
+   for (int i = 0; i < nSize; i++)
+   {
+      dVX[i] = dExtCRSXToGridX(pPolygon->pPtGetBoundaryPoint(i)->dGetX());
+      dVY[i] = dExtCRSYToGridY(pPolygon->pPtGetBoundaryPoint(i)->dGetY());
+   }
+
+   // Build the edge table. Horizontal edges, and edges which do not cross a row of cell centroids, are ignored. Row nY's centroids are at nY+0.5, so the first row which an edge crosses is the first with nY+0.5 >= its upper end
+   vector<int>
+      nVEdgeStart,                     // The vertex at which each edge starts
+      nVEdgeLastRow;
+   vector<double>
+      dVEdgeSlope;                     // Change in x per row
+   vector<pair<int, int> >
+      prVEdgeByRow;                    // (first row, edge) for each edge, sorted by first row
+
+   for (int i = 0; i < nSize; i++)
+   {
+      int j = (i+1) % nSize;
+      if (dVY[i] == dVY[j])
+         continue;
+
+      int
+         nUpper = (dVY[i] < dVY[j] ? i : j),
+         nLower = (dVY[i] < dVY[j] ? j : i),
+         nFirstRow = static_cast<int>(ceil(dVY[nUpper] - 0.5)),
+         nLastRow = static_cast<int>(ceil(dVY[nLower] - 0.5)) - 1;
+
+      if (nFirstRow > nLastRow)
+         continue;
+
+      prVEdgeByRow.push_back(make_pair(nFirstRow, static_cast<int>(nVEdgeStart.size())));
+      nVEdgeStart.push_back(nUpper);
+      nVEdgeLastRow.push_back(nLastRow);
+      dVEdgeSlope.push_back((dVX[nLower] - dVX[nUpper]) / (dVY[nLower] - dVY[nUpper]));
+   }
+
+   if (prVEdgeByRow.empty())
+      return;
+
+   sort(prVEdgeByRow.begin(), prVEdgeByRow.end());
+
+   int
+      nRowMin = tMax(prVEdgeByRow[0].first, 0),
+      nRowMax = 0;
+   for (unsigned int n = 0; n < nVEdgeLastRow.size(); n++)
+      nRowMax = tMax(nRowMax, nVEdgeLastRow[n]);
+   nRowMax = tMin(nRowMax, m_nYGridMax-1);
+
+   // Now do a single pass down the rows, keeping a list of the edges which cross the present row. Edges which start above the grid become active at the first row
+   unsigned int nNextEdge = 0;
+   vector<int> nVActiveEdge;
+   vector<double> dVCrossing;
+   for (int nY = nRowMin; nY <= nRowMax; nY++)
+   {
+      // Add any edges which start at or above this row
+      while ((nNextEdge < prVEdgeByRow.size()) && (prVEdgeByRow[nNextEdge].first <= nY))
+         nVActiveEdge.push_back(prVEdgeByRow[nNextEdge++].second);
+
+      // Remove any edges which have ended, and get the x co-ord at which each of the others crosses this row
+      dVCrossing.clear();
+      unsigned int n = 0;
+      while (n < nVActiveEdge.size())
+      {
+         int nEdge = nVActiveEdge[n];
+         if (nVEdgeLastRow[nEdge] < nY)
+         {
+            nVActiveEdge[n] = nVActiveEdge.back();
+            nVActiveEdge.pop_back();
+            continue;
+         }
+
+         int nStart = nVEdgeStart[nEdge];
+         dVCrossing.push_back(dVX[nStart] + ((nY + 0.5 - dVY[nStart]) * dVEdgeSlope[nEdge]));
+         n++;
+      }
+
+      sort(dVCrossing.begin(), dVCrossing.end());
+
+      // Cells with centroids between each pair of crossings are inside the polygon: the first is the first cell with nX+0.5 >= the crossing
+      for (unsigned int m = 0; m+1 < dVCrossing.size(); m += 2)
+      {
+         int
+            nXFirst = tMax(static_cast<int>(ceil(dVCrossing[m] - 0.5)), 0),
+            nXLast = tMin(static_cast<int>(ceil(dVCrossing[m+1] - 0.5)) - 1, m_nXGridMax-1);
+
+         if (nXFirst > nXLast)
+            continue;
+
+         pnVSpan->push_back(nY);
+         pnVSpan->push_back(nXFirst);
+         pnVSpan->push_back(nXLast);
+      }
+   }
+}
+
+
+/*===============================================================================================================================
+
+ Returns a point which is definitely within a coastal polygon, for use as the start point of the flood fill. Returns a point with an x co-ord of DBL_NODATA if no such point can be found
+
+===============================================================================================================================*/
+CGeom2DPoint CSimulation::PtFindPolygonFillStartPoint(CGeomCoastPolygon* pPolygon, int const nHand) const
+{
+   // Since the polygon's vector boundary does not coincide exactly with the polygon's raster boundary, and the point-in-polygon check gives an indeterminate result if the point is exectly on the polygon's boundary, for safety we must construct a vector 'inner buffer' which is smaller than, and inside, the vector boundary
+   int nSize = pPolygon->nGetBoundarySize();
+   vector<CGeom2DPoint> PtVInnerBuffer;
+   for (int i = 0; i < nSize-1; i++)
+   {
+      int j = i+1;
+      if (i == nSize-2)       // We must ignore the duplicated node point
+         j = 0;
+      CGeom2DPoint
+         PtThis = *pPolygon->pPtGetBoundaryPoint(i),
+         PtNext = *pPolygon->pPtGetBoundaryPoint(j),
+         PtBuffer = PtGetPerpendicular(&PtThis, &PtNext, m_dCellSide, nHand);
+
+      PtVInnerBuffer.push_back(PtBuffer);
+   }
+
+   // For a first attempt, calculate the polygon's centroid
+   CGeom2DPoint PtStart = pPolygon->PtGetCentroid();
+
+   // Is the centroid within the inner buffer?
+   if (! bIsWithinPolygon(&PtStart, &PtVInnerBuffer))
+   {
+      // No, it is not: the polygon must be a concave polygon. So keep looking for a point which is definitely inside the polygon, using an alternative method
+      PtStart = PtFindPointInPolygon(&PtVInnerBuffer, pPolygon->nGetPointInPolygonSearchStartPoint());
+   }
+
+   return PtStart;
+}
+
+
 /*===============================================================================================================================
 
  For between-polygon potential sediment routing: find which are the adjacent polygons, and calc the length of the shared normal between this polygon and the adjacent polygons
@@ -45,6 +45,8 @@ using std::make_pair;
 #include "cme.h"
 #include "simulation.h"
 #include "coast.h"
+#include "profile_raster_cache.h"
+#include "parallel_profile_cache.h"
 
 
 /*===============================================================================================================================
@@ -66,6 +68,10 @@ bool bCurvaturePairCompareDescending(const pair<int, double> &prLeft, const pair
 ===============================================================================================================================*/
 int CSimulation::nCreateAllNormalProfilesAndCheckForIntersection(void)
 {
+   // The coastline-normal profiles are about to be rebuilt, so any cached parallel profiles are no longer valid
+   if (m_pParallelProfileCache)
+      m_pParallelProfileCache->Clear();
+
    // Create all coastline-normal profiles, in coastline-concave-curvature sequence i.e. the first profiles are created 'around' the most concave bits of coast. An index is also created which allows profiles to be accessed in along-cost sequence
    int nRet = nCreateAllNormalProfiles();
    if (nRet != RTN_OK)
@@ -123,7 +129,7 @@ int CSimulation::nCreateAllNormalProfiles(void)
       
       // Mark intervention coast points so they don't get searched (already done)
       for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
-         if (m_VCoast[nCoast].pGetCoastLandform(nCoastPoint)->nGetLandFormCategory() == LF_CAT_INTERVENTION)
+         if (m_VCoast[nCoast].nGetLandformCategory(nCoastPoint) == LF_CAT_INTERVENTION)
             bVCoastPointSearched[nCoastPoint] = true;
       
       // And mark points near the start and end of the coastline so that they don't get searched (will be creating 'special' start- and end-of-coast profiles there later)
@@ -217,7 +223,7 @@ void CSimulation::CreateInterventionProfiles(int const nCoast, int& nProfile, in
    
    // Mark non-intervention coast points so they don't get searched
    for (int nCoastPoint = 0; nCoastPoint < nCoastSize; nCoastPoint++)
-      if (m_VCoast[nCoast].pGetCoastLandform(nCoastPoint)->nGetLandFormCategory() != LF_CAT_INTERVENTION)
+      if (m_VCoast[nCoast].nGetLandformCategory(nCoastPoint) != LF_CAT_INTERVENTION)
          bVCoastPointSearched[nCoastPoint] = true;
    
    // TODO make this a user input
@@ -711,6 +717,10 @@ int CSimulation::nGetCoastNormalEndPoint(int const nCoast, int const nStartCoast
       double dDiscriminant = (dQuadB * dQuadB) - (4 * dQuadA * dQuadC);
       if (dDiscriminant < 0)
       {
+         // This may be called from within a parallel region, when cliff collapse deposition is batched
+#ifdef _OPENMP
+         #pragma omp critical (LogStream)
+#endif
          LogStream << ERR << "timestep " << m_ulTimestep << ": discriminant < 0 when finding profile end point on coastline " << nCoast << ", from coastline point " << nStartCoastPoint << "), ignored" << endl;
          return RTN_ERR_BADENDPOINT;
       }
@@ -1166,18 +1176,53 @@ int CSimulation::nPutAllProfilesOntoGrid(void)
             bHitLand           = false,
             bHitAnotherProfile = false;
 
-         RasterizeProfile(nCoast, nProfile, &VCellsToMark, &bVShared, bTooShort, bTruncated, bHitCoast, bHitLand, bHitAnotherProfile);
+         // Has this profile already been rasterized, in an earlier timestep?
+         int
+            nCacheEntry = INT_NODATA,
+            nStartX = static_cast<int>(dExtCRSXToGridX(pProfile->pPtGetPointInProfile(0)->dGetX())),
+            nStartY = static_cast<int>(dExtCRSYToGridY(pProfile->pPtGetPointInProfile(0)->dGetY()));
+         bool bGridEdge = (pProfile->bStartOfCoast() || pProfile->bEndOfCoast());
+         if (m_bCacheProfileRaster)
+            nCacheEntry = m_pProfileRasterCache->nFindEntry(nStartX, nStartY, pProfile->pPtVGetPoints(), bGridEdge);
+
+         if (nCacheEntry != INT_NODATA)
+            RasterizeProfileFromCache(nCoast, nProfile, nCacheEntry, &VCellsToMark, &bVShared, bTooShort, bHitCoast, bHitLand, bHitAnotherProfile);
+         else
+         {
+            vector<int> nVCellsInSegment;
+            RasterizeProfile(nCoast, nProfile, &VCellsToMark, &bVShared, &nVCellsInSegment, bTooShort, bTruncated, bHitCoast, bHitLand, bHitAnotherProfile);
+
+            // Truncated profiles have had their vertices changed, so are not cached
+            if (m_bCacheProfileRaster && (! bTruncated))
+            {
+               vector<CGeom2DPoint> PtVCellsExtCRS;
+               for (unsigned int k = 0; k < VCellsToMark.size(); k++)
+                  PtVCellsExtCRS.push_back(CGeom2DPoint(dGridCentroidXToExtCRSX(VCellsToMark[k].nGetX()), dGridCentroidYToExtCRSY(VCellsToMark[k].nGetY())));
+
+               m_pProfileRasterCache->AddEntry(nStartX, nStartY, pProfile->pPtVGetPoints(), bGridEdge, &VCellsToMark, &nVCellsInSegment, &PtVCellsExtCRS, bHitCoast, bHitLand);
+            }
+         }
 
          if ((! bTruncated) && (! bTooShort) && (! bHitCoast) && (! bHitLand) && (! bHitAnotherProfile))
          {
             // This profile is fine
             nValidProfiles++;
 
+            if (nCacheEntry != INT_NODATA)
+            {
+               // Re-use the cached raster-grid and external coordinates
+               pProfile->SetCellsInProfile(m_pProfileRasterCache->pPtiVGetCells(nCacheEntry));
+               pProfile->SetCellsInProfileExtCRS(m_pProfileRasterCache->pPtVGetCellsExtCRS(nCacheEntry));
+            }
+
             for (unsigned int k = 0; k < VCellsToMark.size(); k++)
             {
                // So mark each cell in the raster grid
                m_pRasterGrid->m_Cell[VCellsToMark[k].nGetX()][VCellsToMark[k].nGetY()].SetNormalProfile(nProfile);
 
+               if (nCacheEntry != INT_NODATA)
+                  continue;
+
                // Store the raster-grid coordinates in the profile object
                pProfile->AppendCellInProfile(VCellsToMark[k].nGetX(), VCellsToMark[k].nGetY());
 
@@ -1216,19 +1261,20 @@ int CSimulation::nPutAllProfilesOntoGrid(void)
  Given a pointer to a coastline-normal profile, returns an output vector of cells which are 'under' every line segment of the profile. If there is a problem with the profile (e.g. a rasterized cell is dry land or coast, or the profile has to be truncated) then we pass this back as an error code
 
 ===============================================================================================================================*/
-void CSimulation::RasterizeProfile(int const nCoast, int const nProfile, vector<CGeom2DIPoint>* pVIPointsOut, vector<bool>* pbVShared, bool& bTooShort, bool& bTruncated, bool& bHitCoast, bool& bHitLand, bool& bHitAnotherProfile)
+void CSimulation::RasterizeProfile(int const nCoast, int const nProfile, vector<CGeom2DIPoint>* pVIPointsOut, vector<bool>* pbVShared, vector<int>* pnVCellsInSegment, bool& bTooShort, bool& bTruncated, bool& bHitCoast, bool& bHitLand, bool& bHitAnotherProfile)
 {
    CGeomProfile* const pProfile = m_VCoast[nCoast].pGetProfile(nProfile);
 
    pVIPointsOut->clear();
+   pnVCellsInSegment->clear();
    int
       nSeg = 0,
-      nSegments = pProfile->nGetNumLineSegments(),
-      nProfiles = m_VCoast[nCoast].nGetNumProfiles();    // TODO this is a bodge, needed if we hit a profile which belongs to a different coast object
+      nSegments = pProfile->nGetNumLineSegments();
 
    for (nSeg = 0; nSeg < nSegments; nSeg++)
    {
       // Do once for every line segment
+      int nCellsBeforeSeg = pVIPointsOut->size();
       vector<CGeom2DPoint> PtVSegment;
       PtVSegment.push_back(*pProfile->pPtGetPointInProfile(nSeg));
       PtVSegment.push_back(*pProfile->pPtGetPointInProfile(nSeg+1));     // This is OK
@@ -1311,34 +1357,7 @@ void CSimulation::RasterizeProfile(int const nCoast, int const nProfile, vector<
             }
 
             // Check to see if we hit another profile which is not a coincident normal to this normal
-            static int nLastProfileChecked = -1;
-            if ((nProfile != nLastProfileChecked) && m_pRasterGrid->m_Cell[nX][nY].bIsNormalProfile())
-            {
-               // For the first time for this profile, we've hit a raster cell which is already marked as 'under' a normal profile. Get the number of the profile which marked this cell
-               int nHitProfile = m_pRasterGrid->m_Cell[nX][nY].nGetNormalProfile();
-
-               // TODO Bodge in case we hit a profile which belongs to a different coast
-               if (nHitProfile > nProfiles-1)
-               {
-                  bHitAnotherProfile = true;
-                  pProfile->SetHitAnotherProfile(true);
-
-                  LogStream << m_ulTimestep << ": profile " << nProfile << " hit another profile A (" << nHitProfile << ") at [" << nX << "][" << nY << "] = {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
-               }
-               else
-               {
-                  // Only set the flag if this isn't a coincident normal to one or other of the profiles
-                  if ((! pProfile->bFindProfileInCoincidentProfiles(nHitProfile)) && (! m_VCoast[nCoast].pGetProfile(nHitProfile)->bFindProfileInCoincidentProfiles(nProfile)))
-                  {
-                     bHitAnotherProfile = true;
-                     pProfile->SetHitAnotherProfile(true);
-
-                     LogStream << m_ulTimestep << ": profile " << nProfile << " hit another profile B (" << nHitProfile << ") at [" << nX << "][" << nY << "] = {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
-                  }
-
-                  nLastProfileChecked = nProfile;
-               }
-            }
+            CheckForHitAnotherProfile(nCoast, nProfile, nX, nY, bHitAnotherProfile);
          }
 
          // Append this point to the output vector
@@ -1350,6 +1369,8 @@ void CSimulation::RasterizeProfile(int const nCoast, int const nProfile, vector<
          dY += dYInc;
       }
 
+      pnVCellsInSegment->push_back(pVIPointsOut->size() - nCellsBeforeSeg);
+
       if (bTruncated)
          break;
    }
@@ -1382,6 +1403,95 @@ void CSimulation::RasterizeProfile(int const nCoast, int const nProfile, vector<
 }
 
 
+/*==============================================================================================================================
+
+ Does the same as RasterizeProfile(), but for a profile which has been rasterized in an earlier timestep and is still in the profile raster cache. The cached hit-coast and hit-land results are re-used, but the check for hitting another profile is always redone since it depends on the other profiles which are on the grid this timestep
+
+===============================================================================================================================*/
+void CSimulation::RasterizeProfileFromCache(int const nCoast, int const nProfile, int const nCacheEntry, vector<CGeom2DIPoint>* pVIPointsOut, vector<bool>* pbVShared, bool& bTooShort, bool& bHitCoast, bool& bHitLand, bool& bHitAnotherProfile)
+{
+   CGeomProfile* const pProfile = m_VCoast[nCoast].pGetProfile(nProfile);
+
+   *pVIPointsOut = *m_pProfileRasterCache->pPtiVGetCells(nCacheEntry);
+
+   // Rebuild the shared (i.e. multi-line) flags, since the coincident profiles may differ from when the entry was cached
+   vector<int> const* pnVCellsInSegment = m_pProfileRasterCache->pnVGetCellsInSegment(nCacheEntry);
+   for (unsigned int nSeg = 0; nSeg < pnVCellsInSegment->size(); nSeg++)
+   {
+      bool bShared = (pProfile->nGetNumCoincidentProfilesInLineSegment(nSeg) > 1);
+      pbVShared->insert(pbVShared->end(), pnVCellsInSegment->at(nSeg), bShared);
+   }
+
+   // Grid-edge profiles are not checked
+   if ((! pProfile->bStartOfCoast()) && (! pProfile->bEndOfCoast()))
+   {
+      if (m_pProfileRasterCache->bGetHitCoast(nCacheEntry))
+      {
+         bHitCoast = true;
+         pProfile->SetHitCoast(true);
+      }
+
+      if (m_pProfileRasterCache->bGetHitLand(nCacheEntry))
+      {
+         bHitLand = true;
+         pProfile->SetHitLand(true);
+      }
+
+      for (unsigned int k = 0; k < pVIPointsOut->size(); k++)
+         CheckForHitAnotherProfile(nCoast, nProfile, pVIPointsOut->at(k).nGetX(), pVIPointsOut->at(k).nGetY(), bHitAnotherProfile);
+   }
+
+   if (pVIPointsOut->size() < 3)
+   {
+      bTooShort = true;
+      pProfile->SetTooShort(true);
+
+      LogStream << m_ulTimestep << ": profile " << nProfile << " is TOO SHORT" << endl;
+   }
+}
+
+
+/*==============================================================================================================================
+
+ Checks whether a cell on a coastline-normal profile is already marked as being 'under' another profile which is not a coincident normal to this profile. If so, the profile is marked as having hit another profile
+
+===============================================================================================================================*/
+void CSimulation::CheckForHitAnotherProfile(int const nCoast, int const nProfile, int const nX, int const nY, bool& bHitAnotherProfile)
+{
+   CGeomProfile* const pProfile = m_VCoast[nCoast].pGetProfile(nProfile);
+   int nProfiles = m_VCoast[nCoast].nGetNumProfiles();    // TODO this is a bodge, needed if we hit a profile which belongs to a different coast object
+
+   static int nLastProfileChecked = -1;
+   if ((nProfile != nLastProfileChecked) && m_pRasterGrid->m_Cell[nX][nY].bIsNormalProfile())
+   {
+      // For the first time for this profile, we've hit a raster cell which is already marked as 'under' a normal profile. Get the number of the profile which marked this cell
+      int nHitProfile = m_pRasterGrid->m_Cell[nX][nY].nGetNormalProfile();
+
+      // TODO Bodge in case we hit a profile which belongs to a different coast
+      if (nHitProfile > nProfiles-1)
+      {
+         bHitAnotherProfile = true;
+         pProfile->SetHitAnotherProfile(true);
+
+         LogStream << m_ulTimestep << ": profile " << nProfile << " hit another profile A (" << nHitProfile << ") at [" << nX << "][" << nY << "] = {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
+      }
+      else
+      {
+         // Only set the flag if this isn't a coincident normal to one or other of the profiles
+         if ((! pProfile->bFindProfileInCoincidentProfiles(nHitProfile)) && (! m_VCoast[nCoast].pGetProfile(nHitProfile)->bFindProfileInCoincidentProfiles(nProfile)))
+         {
+            bHitAnotherProfile = true;
+            pProfile->SetHitAnotherProfile(true);
+
+            LogStream << m_ulTimestep << ": profile " << nProfile << " hit another profile B (" << nHitProfile << ") at [" << nX << "][" << nY << "] = {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
+         }
+
+         nLastProfileChecked = nProfile;
+      }
+   }
+}
+
+
 /*==============================================================================================================================
 
  Merges two profiles which intersect at their final (most seaward) line segments, seaward of their point of intersection
@@ -29,62 +29,11 @@
 using std::cout;
 using std::endl;
 
-#include <algorithm>
-using std::stable_sort;
-
 #include "cme.h"
 #include "simulation.h"
 #include "coast.h"
-
-
-/*===============================================================================================================================
-
- Function used to sort polygons before doing the polygon-to-polygon sediment budget
-
- For both LH and RH arguments, the first value is the polygon coast ID, the second value is the down- or up-coast direction, and subsequent numbers are adjacent polygon coastIDs in that direction. If the first argument must be ordered before the second, return true
-
-===============================================================================================================================*/
-bool bPolygonAndAdjCompare(const vector<int>& nVLeft, const vector<int>& nVRight)
-{
-   // For safety, check that the LHS polygon has at least one adjacent polygon (it should have, apart from the bad situation where just one big polygon is created)
-   if ((nVLeft.size() >= 3) && (nVRight.size() >= 3))
-   {
-      // Polygons at the grid edge are processed last, so put LHS grid-edge polygons on the RHS
-      if (nVLeft[2] == INT_NODATA)
-         return false;
-
-      // Polygons at the grid edge are processed last, so keep RHS grid-edge polygons where they are
-      if (nVRight[2] == INT_NODATA)
-         return true;
-
-      // Now sort out polygon-to-polygon dependencies. We need to put 'target' polygons after 'source' polygons, so that the source id processed before the target. So does the LHS polygon have the RHS polygon as one of its adjacent polygons?
-      for (unsigned int n = 2; n < nVLeft.size(); n++)
-      {
-         if (nVRight[0] == nVLeft[n])
-            // It does, so keep the existing sequence
-            return true;
-      }
-
-      // Does the RHS polygon have the LHS polygon as one of its adjacent polygons?
-      for (unsigned int n = 2; n < nVRight.size(); n++)
-      {
-         if (nVLeft[0] == nVRight[n])
-            // It does, so swap them
-            return false;
-      }
-   }
-
-   bool bDownCoast = nVLeft[1];
-   if (bDownCoast)
-      // Sediment going down-coast
-      return nVLeft < nVRight;
-   else
-      // Sediment going up-coast
-      return nVLeft > nVRight;
-
-   // Default return value, should never get here
-   return true;
-}
+#include "trace_writer.h"
+#include "beach_profile_cache.h"
 
 
 /*===============================================================================================================================
@@ -123,6 +72,10 @@ int CSimulation::nDoAllActualBeachErosionAndDeposition(void)
       LogStream << n << "\t\t" << m_pVCoastPolygon[n]->nGetGlobalID() << "\t\t\t" << m_pVCoastPolygon[n]->nGetCoastID() << "\t\t\t" << m_pVCoastPolygon[n]->dGetDeltaPotentialErosion() << "\t\t\t\t" << m_pVCoastPolygon[n]->dGetDeltaActualTotalSediment() << "\t\t\t" << m_pVCoastPolygon[n]->dGetDeltaActualUnconsFine() <<  "\t\t\t" << m_pVCoastPolygon[n]->dGetDeltaActualUnconsSand() << "\t\t\t" << m_pVCoastPolygon[n]->dGetDeltaActualUnconsCoarse() << endl;
    LogStream << endl;
 
+   // Parallel profile geometry is recorded during estimation, and re-used during actual erosion. Start afresh each timestep, since the coastline and profiles change
+   if (m_pBeachProfileCache)
+      m_pBeachProfileCache->Clear();
+
    // OK, we know the potential depth of erosion on each polygon, but we do not yet know the actual (supply-limited) depth. Nor do we know how much of the sediment which is to be removed is fine, sand or coarse. So estimate actual (supply-limited) sediment removal, but don't actually erode the polygon
    for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
    {
@@ -186,76 +139,73 @@ int CSimulation::nDoAllActualBeachErosionAndDeposition(void)
    LogStream << m_ulTimestep<< ": estimated sand erosion = " << dCheckSandErosion << " estimated sand deposition = " << dCheckSandDeposition << endl;
    LogStream << m_ulTimestep<< ": estimated coarse erosion = " << dCheckCoarseErosion << " estimated coarse deposition = " << dCheckCoarseDeposition << endl << endl;;
 
-   // Now route actually-eroded sand/coarse sediment to adjacent polygons (or off-grid)
-   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   // Now route actually-eroded sand/coarse sediment to adjacent polygons (or off-grid). First, for each coast, arrange the polygons into 'wavefronts': a polygon only receives sediment from polygons in earlier wavefronts. Coasts are independent of each other, so can be scheduled in parallel
+   int nNumCoasts = m_VCoast.size();
+   vector<vector<vector<int> > > nVVVWavefront(nNumCoasts);
+   vector<vector<int> > nVVCoastEndPoly(nNumCoasts);
+#ifdef _OPENMP
+   #pragma omp parallel for schedule(dynamic)
+#endif
+   for (int nCoast = 0; nCoast < nNumCoasts; nCoast++)
+      SchedulePolygonRouting(nCoast, &nVVVWavefront[nCoast], &nVVCoastEndPoly[nCoast]);
+
+   unsigned int nMaxWaves = 0;
+   for (int nCoast = 0; nCoast < nNumCoasts; nCoast++)
+      nMaxWaves = tMax(nMaxWaves, static_cast<unsigned int>(nVVVWavefront[nCoast].size()));
+
+   // Route one wavefront at a time, for all coasts together. The polygons in a wavefront (on this coast or on any other) do not depend on each other, so the sediment which each sends to its adjacent polygons is calculated in parallel. Then the changes are applied in coast and polygon sequence, so that sediment received by a polygon with several sources is always accumulated in the same order
+   for (unsigned int nWave = 0; nWave < nMaxWaves; nWave++)
    {
-      // Sort first
-      vector<vector<int> > nVVPolyAndAdjacent;
-//      for (int nPoly = 0; nPoly < m_VCoast[nCoast].nGetNumPolygons(); nPoly++)
-      for (int nPoly = m_VCoast[nCoast].nGetNumPolygons()-1; nPoly >= 0; nPoly--)
+      vector<PolygonRoutingRecord> VRecord;
+      for (int nCoast = 0; nCoast < nNumCoasts; nCoast++)
       {
-         CGeomCoastPolygon* pPoly = m_VCoast[nCoast].pGetPolygon(nPoly);
-
-         vector<int> nVPolyAndAdj;
+         if (nWave >= nVVVWavefront[nCoast].size())
+            continue;
 
-         // The first array item is the polygon coast ID
-         nVPolyAndAdj.push_back(pPoly->nGetCoastID());
-
-         if (pPoly->bDownCoastThisTimestep())
+         for (unsigned int n = 0; n < nVVVWavefront[nCoast][nWave].size(); n++)
          {
-            // Sediment is leaving this polygon in a down-coast direction: so set this as the second array item
-            nVPolyAndAdj.push_back(true);
-
-            // Set subsequent array items to be the IDs of adjacent polygons
-            for (int nAdj = 0; nAdj < pPoly->nGetNumDownCoastAdjacentPolygons(); nAdj++)
-            {
-               int nAdjPolyID = pPoly->nGetDownCoastAdjacentPolygon(nAdj);
-               nVPolyAndAdj.push_back(nAdjPolyID);
-            }
+            PolygonRoutingRecord Record;
+            Record.nCoast = nCoast;
+            Record.nPoly = nVVVWavefront[nCoast][nWave][n];
+            VRecord.push_back(Record);
          }
-         else
-         {
-            // Sediment is leaving this polygon in an up-coast direction: so set this as the second array item
-            nVPolyAndAdj.push_back(false);
+      }
 
-            // Set subsequent array items to be the IDs of adjacent polygons
-            for (int nAdj = 0; nAdj < pPoly->nGetNumUpCoastAdjacentPolygons(); nAdj++)
-            {
-               int nAdjPolyID = pPoly->nGetUpCoastAdjacentPolygon(nAdj);
-               nVPolyAndAdj.push_back(nAdjPolyID);
-            }
-         }
+      int nNumRecords = VRecord.size();
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic)
+#endif
+      for (int n = 0; n < nNumRecords; n++)
+      {
+         bool bTrace = (m_pTraceWriter && m_pTraceWriter->bTraceItem(VRecord[n].nPoly));
+         double dTraceStart = 0;
+         if (bTrace)
+            dTraceStart = m_pTraceWriter->dGetTime();
+
+         CalcPolygonRouting(&VRecord[n]);
 
-         nVVPolyAndAdjacent.push_back(nVPolyAndAdj);
+         if (bTrace)
+            m_pTraceWriter->AddSpan("Route sediment from polygon", "polygon", dTraceStart, VRecord[n].nCoast, "polygon", VRecord[n].nPoly);
       }
 
-//       LogStream << "UNSORTED SEQUENCE OF POLYGON PROCESSING" << endl;
-//       for (unsigned int n = 0; n < nVVPolyAndAdjacent.size(); n++)
-//       {
-//          for (unsigned int m = 0; m < nVVPolyAndAdjacent[n].size(); m++)
-//             LogStream << nVVPolyAndAdjacent[n][m] << " ";
-//          LogStream << endl;
-//       }
-//       LogStream << endl;
-
-      // Sort the array using bPolygonAndAdjCompare(), so that 'target' polygons are processed after 'source' polygons
-      stable_sort(nVVPolyAndAdjacent.begin(), nVVPolyAndAdjacent.end(), bPolygonAndAdjCompare);
-
-//       LogStream << "SORTED SEQUENCE OF POLYGON PROCESSING" << endl;
-//       for (unsigned int n = 0; n < nVVPolyAndAdjacent.size(); n++)
-//       {
-//          for (unsigned int m = 0; m < nVVPolyAndAdjacent[n].size(); m++)
-//             LogStream << nVVPolyAndAdjacent[n][m] << " ";
-//          LogStream << endl;
-//       }
-//       LogStream << endl;
-
-      // Now go through the polygons in the sorted sequence
-      for (int n = 0; n < m_VCoast[nCoast].nGetNumPolygons(); n++)
+      for (int n = 0; n < nNumRecords; n++)
+         ApplyPolygonRouting(&VRecord[n]);
+   }
+
+   // Polygons at the ends of each coast are done last, one at a time since with Mobius grid edges they can send sediment to each other, and they also change the off-grid totals
+   for (int nCoast = 0; nCoast < nNumCoasts; nCoast++)
+   {
+      for (unsigned int n = 0; n < nVVCoastEndPoly[nCoast].size(); n++)
       {
-         // And route this to adjacent polygons
-         int nPoly = nVVPolyAndAdjacent[n][0];
-         nRet = nRouteActualBeachErosionToAdjacentPolygons(nCoast, nPoly);
+         int nPoly = nVVCoastEndPoly[nCoast][n];
+
+         double
+            dFine = 0,
+            dSand = 0,
+            dCoarse = 0;
+         CalcSedimentToRouteFromPolygon(nCoast, nPoly, dFine, dSand, dCoarse);
+
+         nRet = nRouteActualBeachErosionToAdjacentPolygons(nCoast, nPoly, dFine, dSand, dCoarse);
          if (nRet != RTN_OK)
             return nRet;
       }
@@ -316,12 +266,27 @@ int CSimulation::nDoAllActualBeachErosionAndDeposition(void)
    // We have an actual sediment budget, in sediment size categories, for all polygons: so process all polygons and do either erosion or deposition on cells within each polygon
    for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
    {
+      double dCoastTraceStart = 0;
+      if (m_pTraceWriter && m_pTraceWriter->bIsActive())
+         dCoastTraceStart = m_pTraceWriter->dGetTime();
+
       for (int nPoly = 0; nPoly < m_VCoast[nCoast].nGetNumPolygons(); nPoly++)
       {
+         bool bTrace = (m_pTraceWriter && m_pTraceWriter->bTraceItem(nPoly));
+         double dTraceStart = 0;
+         if (bTrace)
+            dTraceStart = m_pTraceWriter->dGetTime();
+
          nRet = nDoWithinPolygonBeachRedistribution(nCoast, nPoly);
          if (nRet != RTN_OK)
             return nRet;
+
+         if (bTrace)
+            m_pTraceWriter->AddSpan("Beach redistribution within polygon", "polygon", dTraceStart, nCoast, "polygon", nPoly);
       }
+
+      if (m_pTraceWriter && m_pTraceWriter->bIsActive())
+         m_pTraceWriter->AddSpan("Beach redistribution on coast", "coast", dCoastTraceStart, nCoast, NULL, 0);
    }
 
    return RTN_OK;
@@ -330,22 +295,98 @@ int CSimulation::nDoAllActualBeachErosionAndDeposition(void)
 
 /*===============================================================================================================================
 
- Distribute the change in actual (supply-limited) unconsolidated beach sediment from this polygon to adjacent polygons
+ Builds the processing sequence for polygon-to-polygon routing of actual beach sediment on a coast. Each polygon which passes sediment to an adjacent polygon must be processed before that polygon, so the polygons and their adjacency (in each polygon's direction of sediment movement this timestep) form a dependency graph. This is split into topologically-sorted 'wavefronts', each containing polygons (in ascending sequence) which have no dependency on each other. Polygons at the ends of the coast, which pass sediment off-grid (or to the other end of the coast), are kept separate and processed last
 
 ===============================================================================================================================*/
-int CSimulation::nRouteActualBeachErosionToAdjacentPolygons(int const nCoast, int const nPoly)
+void CSimulation::SchedulePolygonRouting(int const nCoast, vector<vector<int> >* pnVVWavefront, vector<int>* pnVCoastEndPoly)
 {
-   int nNumPolygons = m_VCoast[nCoast].nGetNumPolygons() ;
+   int nNumPolygons = m_VCoast[nCoast].nGetNumPolygons();
 
-   CGeomCoastPolygon* pPolygon = m_VCoast[nCoast].pGetPolygon(nPoly);
+   vector<bool> bVCoastEnd(nNumPolygons, false);
+   vector<vector<int> > nVVTarget(nNumPolygons);
+   for (int nPoly = 0; nPoly < nNumPolygons; nPoly++)
+   {
+      CGeomCoastPolygon* pPoly = m_VCoast[nCoast].pGetPolygon(nPoly);
+      bool bDownCoast = pPoly->bDownCoastThisTimestep();
+      int nNumAdj = (bDownCoast ? pPoly->nGetNumDownCoastAdjacentPolygons() : pPoly->nGetNumUpCoastAdjacentPolygons());
 
-   double
-      dTotFineEroded = 0,
-      dTotSandEroded = 0,
-      dTotCoarseEroded = 0,
-      dTotFineToPoly = 0,
-      dTotSandToPoly = 0,
-      dTotCoarseToPoly = 0;
+      for (int nAdj = 0; nAdj < nNumAdj; nAdj++)
+      {
+         int nAdjPoly = (bDownCoast ? pPoly->nGetDownCoastAdjacentPolygon(nAdj) : pPoly->nGetUpCoastAdjacentPolygon(nAdj));
+         if (nAdjPoly == INT_NODATA)
+         {
+            // There is no adjacent polygon in this direction, so this is a coast-end polygon
+            bVCoastEnd[nPoly] = true;
+            break;
+         }
+
+         nVVTarget[nPoly].push_back(nAdjPoly);
+      }
+   }
+
+   // Count the dependencies of each polygon, ignoring those of coast-end polygons (these are done last in any case)
+   vector<int> nVNumSources(nNumPolygons, 0);
+   int nToSchedule = 0;
+   for (int nPoly = 0; nPoly < nNumPolygons; nPoly++)
+   {
+      if (bVCoastEnd[nPoly])
+      {
+         pnVCoastEndPoly->push_back(nPoly);
+         continue;
+      }
+
+      nToSchedule++;
+      for (unsigned int n = 0; n < nVVTarget[nPoly].size(); n++)
+         nVNumSources[nVVTarget[nPoly][n]]++;
+   }
+
+   vector<bool> bVDone(bVCoastEnd);
+   while (nToSchedule > 0)
+   {
+      // The next wavefront is every polygon which has not yet been scheduled, and which has no unscheduled source polygons
+      vector<int> nVWave;
+      for (int nPoly = 0; nPoly < nNumPolygons; nPoly++)
+      {
+         if ((! bVDone[nPoly]) && (nVNumSources[nPoly] == 0))
+            nVWave.push_back(nPoly);
+      }
+
+      if (nVWave.empty())
+      {
+         // There is a cycle (e.g. two adjacent polygons which each pass sediment to the other), so break it at the lowest-numbered unscheduled polygon
+         for (int nPoly = 0; nPoly < nNumPolygons; nPoly++)
+         {
+            if (! bVDone[nPoly])
+            {
+               nVWave.push_back(nPoly);
+               break;
+            }
+         }
+      }
+
+      for (unsigned int n = 0; n < nVWave.size(); n++)
+      {
+         int nPoly = nVWave[n];
+         bVDone[nPoly] = true;
+         nToSchedule--;
+
+         for (unsigned int m = 0; m < nVVTarget[nPoly].size(); m++)
+            nVNumSources[nVVTarget[nPoly][m]]--;
+      }
+
+      pnVVWavefront->push_back(nVWave);
+   }
+}
+
+
+/*===============================================================================================================================
+
+ Calculates the amount of each size class of unconsolidated sediment which is eroded from a polygon, and so is to be routed to adjacent polygons
+
+===============================================================================================================================*/
+void CSimulation::CalcSedimentToRouteFromPolygon(int const nCoast, int const nPoly, double& dTotFineEroded, double& dTotSandEroded, double& dTotCoarseEroded)
+{
+   CGeomCoastPolygon* pPolygon = m_VCoast[nCoast].pGetPolygon(nPoly);
 
    // 'Actual' includes sediment from platform erosion and cliff collapse, 'estimated' was estimated in nEstimateActualBeachErosionOnPolygon()
    double
@@ -353,11 +394,9 @@ int CSimulation::nRouteActualBeachErosionToAdjacentPolygons(int const nCoast, in
       dTotSandChange = pPolygon->dGetDeltaEstimatedUnconsSand() + pPolygon->dGetDeltaActualUnconsSand(),
       dTotCoarseChange = pPolygon->dGetDeltaEstimatedUnconsCoarse() + pPolygon->dGetDeltaActualUnconsCoarse();
 
-//    LogStream << m_ulTimestep << ": polygon " << nPoly << " has actual delta unconsolidated sediment (from platform erosion and cliff collapse): fine = " << pPolygon->dGetDeltaActualUnconsFine() << " sand = " << pPolygon->dGetDeltaActualUnconsSand() << " coarse = " << pPolygon->dGetDeltaActualUnconsCoarse() << " TOTAL = " << pPolygon->dGetDeltaActualUnconsFine() + pPolygon->dGetDeltaActualUnconsSand() + pPolygon->dGetDeltaActualUnconsCoarse() << endl;
-//    LogStream << m_ulTimestep << ": polygon " << nPoly << " has estimated delta unconsolidated sediment (from beach erosion): fine = " << pPolygon->dGetDeltaEstimatedUnconsFine() << " sand = " << pPolygon->dGetDeltaEstimatedUnconsSand() << " coarse = " << pPolygon->dGetDeltaEstimatedUnconsCoarse() << " TOTAL = " << pPolygon->dGetDeltaEstimatedUnconsFine() + pPolygon->dGetDeltaEstimatedUnconsSand() + pPolygon->dGetDeltaEstimatedUnconsCoarse() << " (potential erosion = " << -pPolygon->dGetDeltaPotentialErosion() << ")" << endl;
-//    LogStream << m_ulTimestep << ": polygon " << nPoly << " has total delta unconsolidated sediment (actual plus estimated): fine = " << dTotFineChange << " sand = " << dTotSandChange << " coarse = " << dTotCoarseChange << " TOTAL = " << dTotFineChange + dTotSandChange + dTotCoarseChange << endl;
-
    // If any of these total change values are +ve, it means deposition on this polygon. So ignore these values in terms of routing sediment off this polygon
+   dTotFineEroded = dTotSandEroded = dTotCoarseEroded = 0;
+
    if (dTotFineChange < 0)
       dTotFineEroded = -dTotFineChange;
 
@@ -366,6 +405,102 @@ int CSimulation::nRouteActualBeachErosionToAdjacentPolygons(int const nCoast, in
 
    if (dTotCoarseChange < 0)
       dTotCoarseEroded = -dTotCoarseChange;
+}
+
+
+/*===============================================================================================================================
+
+ Calculates the sediment which a polygon that is not at the end of its coast sends to each of its adjacent polygons, in the polygon's direction of sediment movement this timestep. Only the routing polygon is read, and nothing is changed, so this can be done in parallel for all polygons in a wavefront
+
+===============================================================================================================================*/
+void CSimulation::CalcPolygonRouting(PolygonRoutingRecord* pRecord)
+{
+   double
+      dTotFineEroded = 0,
+      dTotSandEroded = 0,
+      dTotCoarseEroded = 0;
+   CalcSedimentToRouteFromPolygon(pRecord->nCoast, pRecord->nPoly, dTotFineEroded, dTotSandEroded, dTotCoarseEroded);
+
+   CGeomCoastPolygon* pPolygon = m_VCoast[pRecord->nCoast].pGetPolygon(pRecord->nPoly);
+   bool bDownCoast = pPolygon->bDownCoastThisTimestep();
+   int nNumAdjPoly = (bDownCoast ? pPolygon->nGetNumDownCoastAdjacentPolygons() : pPolygon->nGetNumUpCoastAdjacentPolygons());
+
+   double
+      dTotFineToPoly = 0,
+      dTotSandToPoly = 0,
+      dTotCoarseToPoly = 0;
+
+   for (int n = 0; n < nNumAdjPoly; n++)
+   {
+      double
+         dBoundaryShare = (bDownCoast ? pPolygon->dGetDownCoastAdjacentPolygonBoundaryShare(n) : pPolygon->dGetUpCoastAdjacentPolygonBoundaryShare(n)),
+         dFineToPoly = dTotFineEroded * dBoundaryShare,
+         dSandToPoly = dTotSandEroded * dBoundaryShare,
+         dCoarseToPoly = dTotCoarseEroded * dBoundaryShare;
+
+      dTotFineToPoly += dFineToPoly;
+      dTotSandToPoly += dSandToPoly;
+      dTotCoarseToPoly += dCoarseToPoly;
+
+      pRecord->nVAdjPoly.push_back(bDownCoast ? pPolygon->nGetDownCoastAdjacentPolygon(n) : pPolygon->nGetUpCoastAdjacentPolygon(n));
+      pRecord->dVFineToAdj.push_back(dFineToPoly);
+      pRecord->dVSandToAdj.push_back(dSandToPoly);
+      pRecord->dVCoarseToAdj.push_back(dCoarseToPoly);
+
+      // As in nRouteActualBeachErosionToAdjacentPolygons(), the sediment removed from this polygon is the running total
+      pRecord->dVFineFromPoly.push_back(dTotFineToPoly);
+      pRecord->dVSandFromPoly.push_back(dTotSandToPoly);
+      pRecord->dVCoarseFromPoly.push_back(dTotCoarseToPoly);
+   }
+}
+
+
+/*===============================================================================================================================
+
+ Applies the sediment routing calculated by CalcPolygonRouting(): moves the sediment to each adjacent polygon, and removes it from the routing polygon
+
+===============================================================================================================================*/
+void CSimulation::ApplyPolygonRouting(PolygonRoutingRecord const* pRecord)
+{
+   CGeomCoastPolygon* pPolygon = m_VCoast[pRecord->nCoast].pGetPolygon(pRecord->nPoly);
+   string strDirection = (pPolygon->bDownCoastThisTimestep() ? "DOWN-COAST" : "UP-COAST");
+
+   for (unsigned int n = 0; n < pRecord->nVAdjPoly.size(); n++)
+   {
+      int nAdjPoly = pRecord->nVAdjPoly[n];
+      CGeomCoastPolygon* pAdjPoly = m_VCoast[pRecord->nCoast].pGetPolygon(nAdjPoly);
+      pAdjPoly->AddDeltaActualUnconsFine(pRecord->dVFineToAdj[n]);
+      pAdjPoly->AddDeltaActualUnconsSand(pRecord->dVSandToAdj[n]);
+      pAdjPoly->AddDeltaActualUnconsCoarse(pRecord->dVCoarseToAdj[n]);
+
+      pPolygon->AddDeltaActualUnconsFine(-pRecord->dVFineFromPoly[n]);
+      pPolygon->AddDeltaActualUnconsSand(-pRecord->dVSandFromPoly[n]);
+      pPolygon->AddDeltaActualUnconsCoarse(-pRecord->dVCoarseFromPoly[n]);
+
+      LogStream << m_ulTimestep << ": polygon " << pRecord->nPoly << " has actual sediment movement " << strDirection << " to polygon " << nAdjPoly << " fine = " << pRecord->dVFineToAdj[n] << " sand = " << pRecord->dVSandToAdj[n] << " coarse = " << pRecord->dVCoarseToAdj[n] << endl;
+   }
+}
+
+
+/*===============================================================================================================================
+
+ Distribute the change in actual (supply-limited) unconsolidated beach sediment from this polygon to adjacent polygons
+
+===============================================================================================================================*/
+int CSimulation::nRouteActualBeachErosionToAdjacentPolygons(int const nCoast, int const nPoly, double const dTotFineEroded, double const dTotSandEroded, double const dTotCoarseEroded)
+{
+   int nNumPolygons = m_VCoast[nCoast].nGetNumPolygons() ;
+
+   CGeomCoastPolygon* pPolygon = m_VCoast[nCoast].pGetPolygon(nPoly);
+
+   double
+      dTotFineToPoly = 0,
+      dTotSandToPoly = 0,
+      dTotCoarseToPoly = 0;
+
+//    LogStream << m_ulTimestep << ": polygon " << nPoly << " has actual delta unconsolidated sediment (from platform erosion and cliff collapse): fine = " << pPolygon->dGetDeltaActualUnconsFine() << " sand = " << pPolygon->dGetDeltaActualUnconsSand() << " coarse = " << pPolygon->dGetDeltaActualUnconsCoarse() << " TOTAL = " << pPolygon->dGetDeltaActualUnconsFine() + pPolygon->dGetDeltaActualUnconsSand() + pPolygon->dGetDeltaActualUnconsCoarse() << endl;
+//    LogStream << m_ulTimestep << ": polygon " << nPoly << " has estimated delta unconsolidated sediment (from beach erosion): fine = " << pPolygon->dGetDeltaEstimatedUnconsFine() << " sand = " << pPolygon->dGetDeltaEstimatedUnconsSand() << " coarse = " << pPolygon->dGetDeltaEstimatedUnconsCoarse() << " TOTAL = " << pPolygon->dGetDeltaEstimatedUnconsFine() + pPolygon->dGetDeltaEstimatedUnconsSand() + pPolygon->dGetDeltaEstimatedUnconsCoarse() << " (potential erosion = " << -pPolygon->dGetDeltaPotentialErosion() << ")" << endl;
+//    LogStream << m_ulTimestep << ": polygon " << nPoly << " has total delta unconsolidated sediment (actual plus estimated): fine = " << dTotFineChange << " sand = " << dTotSandChange << " coarse = " << dTotCoarseChange << " TOTAL = " << dTotFineChange + dTotSandChange + dTotCoarseChange << endl;
 
 //    LogStream << m_ulTimestep << ": dTotFineEroded = " << dTotFineEroded << " dTotSandEroded = " << dTotSandEroded << " dTotCoarseEroded = " << dTotCoarseEroded << endl;
 
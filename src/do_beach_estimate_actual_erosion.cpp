@@ -33,6 +33,7 @@ using std::endl;
 #include "cme.h"
 #include "simulation.h"
 #include "coast.h"
+#include "beach_profile_cache.h"
 
 
 /*===============================================================================================================================
@@ -153,6 +154,11 @@ int CSimulation::nEstimateActualBeachErosionOnPolygon(int const nCoast, int cons
          dParProfCoastElev = m_pRasterGrid->m_Cell[nCoastX][nCoastY].dGetSedimentTopElev(),
          dParProfEndElev = m_pRasterGrid->m_Cell[nParProfEndX][nParProfEndY].dGetSedimentTopElev();
 
+      // If estimation and application of beach erosion are fused, then record the geometry of this parallel profile so that it can be re-used during actual beach erosion
+      int nCacheEntry = INT_NODATA;
+      if (m_pBeachProfileCache)
+         nCacheEntry = m_pBeachProfileCache->nAddEntry(pPolygon->nGetGlobalID(), DIRECTION_DOWNCOAST, nCoastPoint, nXOffset, nYOffset, &PtiVParProfile);
+
       int
          nParProfLen,
          nInlandOffset = -1;
@@ -219,6 +225,9 @@ int CSimulation::nEstimateActualBeachErosionOnPolygon(int const nCoast, int cons
             // Append this to the parallel profile
             CGeom2DIPoint PtiTmp(nXParNew, nYParNew);
             PtiVParProfile.push_back(PtiTmp);
+
+            if (nCacheEntry != INT_NODATA)
+               m_pBeachProfileCache->AppendCell(nCacheEntry, &PtiTmp);
          }
 
          // Get the distance between the start and end of the parallel profile, in external CRS units. Note that the parallel profile co-ords are in reverse sequence
@@ -230,20 +239,32 @@ int CSimulation::nEstimateActualBeachErosionOnPolygon(int const nCoast, int cons
 
          // Solve for dA so that the existing elevations at the end of the parallel profile, and at the end of a Dean equilibrium profile on that part-normal, are the same
          double const dPower = 2.0 / 3.0;
-         double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
 
          // For the parallel profile, calculate the Dean equilibrium profile of the unconsolidated sediment h(y) = A * y^(2/3) where h(y) is the distance below the highest point in the profile at a distance y from the landward start of the profile
          nParProfLen = PtiVParProfile.size();
          dVParProfileDeanElev.resize(nParProfLen, 0);
 
-         double
-            dDistFromParProfStart = 0,
-            dInc = dParProfileLen / (nParProfLen-1);
-         for (int n = 0; n < nParProfLen; n++)
+         if (nCacheEntry != INT_NODATA)
          {
-            double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
-            dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
-            dDistFromParProfStart += dInc;
+            // Record the length and Dean profile shape of the parallel profile at this inland offset. The shape is calculated in the same way as below, so results are identical
+            vector<double> const* pdVShape = m_pBeachProfileCache->pdVAddDeanShape(nCacheEntry, dParProfileLen);
+            double dParProfA = (dParProfCoastElev - dParProfEndElev) / pdVShape->at(0);
+            for (int n = 0; n < nParProfLen; n++)
+               dVParProfileDeanElev[n] = dParProfCoastElev - (dParProfA * pdVShape->at(n+1));
+         }
+         else
+         {
+            double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
+
+            double
+               dDistFromParProfStart = 0,
+               dInc = dParProfileLen / (nParProfLen-1);
+            for (int n = 0; n < nParProfLen; n++)
+            {
+               double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
+               dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
+               dDistFromParProfStart += dInc;
+            }
          }
 
          double dParProfTotDiff = 0;
@@ -590,6 +611,11 @@ int CSimulation::nEstimateActualBeachErosionOnPolygon(int const nCoast, int cons
             dParProfCoastElev = m_pRasterGrid->m_Cell[nCoastX][nCoastY].dGetSedimentTopElev(),
             dParProfEndElev = m_pRasterGrid->m_Cell[nParProfEndX][nParProfEndY].dGetSedimentTopElev();
 
+         // If estimation and application of beach erosion are fused, then record the geometry of this parallel profile so that it can be re-used during actual beach erosion
+         int nCacheEntry = INT_NODATA;
+         if (m_pBeachProfileCache)
+            nCacheEntry = m_pBeachProfileCache->nAddEntry(pPolygon->nGetGlobalID(), DIRECTION_UPCOAST, nCoastPoint, nXOffset, nYOffset, &PtiVParProfile);
+
          int
             nParProfLen,
             nInlandOffset = -1;
@@ -656,6 +682,9 @@ int CSimulation::nEstimateActualBeachErosionOnPolygon(int const nCoast, int cons
                // Append this to the parallel profile
                CGeom2DIPoint PtiTmp(nXParNew, nYParNew);
                PtiVParProfile.push_back(PtiTmp);
+
+               if (nCacheEntry != INT_NODATA)
+                  m_pBeachProfileCache->AppendCell(nCacheEntry, &PtiTmp);
             }
 
             // Get the distance between the start and end of the parallel profile, in external CRS units. Note that the parallel profile co-ords are in reverse sequence
@@ -667,20 +696,32 @@ int CSimulation::nEstimateActualBeachErosionOnPolygon(int const nCoast, int cons
 
             // Solve for dA so that the existing elevations at the end of the parallel profile, and at the end of a Dean equilibrium profile on that part-normal, are the same
             double const dPower = 2.0 / 3.0;
-            double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
 
             // For the parallel profile, calculate the Dean equilibrium profile of the unconsolidated sediment h(y) = A * y^(2/3) where h(y) is the distance below the highest point in the profile at a distance y from the landward start of the profile
             nParProfLen = PtiVParProfile.size();
             dVParProfileDeanElev.resize(nParProfLen, 0);
 
-            double
-               dDistFromParProfStart = 0,
-               dInc = dParProfileLen / (nParProfLen-1);
-            for (int n = 0; n < nParProfLen; n++)
+            if (nCacheEntry != INT_NODATA)
             {
-               double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
-               dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
-               dDistFromParProfStart += dInc;
+               // Record the length and Dean profile shape of the parallel profile at this inland offset. The shape is calculated in the same way as below, so results are identical
+               vector<double> const* pdVShape = m_pBeachProfileCache->pdVAddDeanShape(nCacheEntry, dParProfileLen);
+               double dParProfA = (dParProfCoastElev - dParProfEndElev) / pdVShape->at(0);
+               for (int n = 0; n < nParProfLen; n++)
+                  dVParProfileDeanElev[n] = dParProfCoastElev - (dParProfA * pdVShape->at(n+1));
+            }
+            else
+            {
+               double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
+
+               double
+                  dDistFromParProfStart = 0,
+                  dInc = dParProfileLen / (nParProfLen-1);
+               for (int n = 0; n < nParProfLen; n++)
+               {
+                  double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
+                  dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
+                  dDistFromParProfStart += dInc;
+               }
             }
 
             double dParProfTotDiff = 0;
@@ -1019,4 +1060,3 @@ void CSimulation::EstimateActualBeachErosionOnCell(int const nX, int const nY, i
 //    LogStream << "\tEstimating actual erosion on [" << nX << "][" << nY << "] dPotentialErosion = " << dPotentialErosion << " dTotActualErosion = " << dTotActualErosion << " dFine = " << dFine << " dSand = " << dSand << " dCoarse = " << dCoarse << endl;
 }
 
-
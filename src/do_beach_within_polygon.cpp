@@ -33,6 +33,7 @@ using std::endl;
 #include "cme.h"
 #include "simulation.h"
 #include "coast.h"
+#include "beach_profile_cache.h"
 
 
 /*===============================================================================================================================
@@ -135,7 +136,7 @@ int CSimulation::nDoBeachErosionOnCells(int const nCoast, int const nPoly, doubl
    }
 
    // Shuffle the coast points, this is necessary so that leaving the loop does not create sequence-related artefacts
-   Rand1Shuffle(&(nVCoastPoint.at(0)), nCoastSegLen);
+   StreamShuffle(&(nVCoastPoint.at(0)), nCoastSegLen, RAND_STREAM_BEACH_EROSION_DOWNCOAST, nCoast, nPoly);
 
    // Estimate the volume of sediment which is to be eroded from each parallel profile
    double
@@ -160,12 +161,26 @@ int CSimulation::nDoBeachErosionOnCells(int const nCoast, int const nPoly, doubl
          nXOffset = nCoastX - PtiVUpCoastPartProfileCell.back().nGetX(),
          nYOffset = nCoastY - PtiVUpCoastPartProfileCell.back().nGetY();
 
+      // Was a parallel profile constructed at this coast point, with the same offset, while estimating actual beach erosion?
+      int nCacheEntry = INT_NODATA;
+      if (m_pBeachProfileCache)
+         nCacheEntry = m_pBeachProfileCache->nFindEntry(pPolygon->nGetGlobalID(), DIRECTION_DOWNCOAST, nCoastPoint, nXOffset, nYOffset);
+
       // Get the x-y coords of a profile starting from this coast point and parallel to the up-coast polygon boundary profile (these are in reverse sequence, like the boundary part-profile)
       vector<CGeom2DIPoint> PtiVParProfile;
-      for (int n = 0; n < nUpCoastPartProfileLen; n++)
+      if (nCacheEntry != INT_NODATA)
+      {
+         // It was, so re-use its cells (these have already been constrained to be within the grid)
+         for (int n = 0; n < nUpCoastPartProfileLen; n++)
+            PtiVParProfile.push_back(*m_pBeachProfileCache->pPtiGetCell(nCacheEntry, n));
+      }
+      else
       {
-         CGeom2DIPoint PtiTmp(PtiVUpCoastPartProfileCell[n].nGetX() + nXOffset, PtiVUpCoastPartProfileCell[n].nGetY() + nYOffset);
-         PtiVParProfile.push_back(PtiTmp);
+         for (int n = 0; n < nUpCoastPartProfileLen; n++)
+         {
+            CGeom2DIPoint PtiTmp(PtiVUpCoastPartProfileCell[n].nGetX() + nXOffset, PtiVUpCoastPartProfileCell[n].nGetY() + nYOffset);
+            PtiVParProfile.push_back(PtiTmp);
+         }
       }
 
       // Get the elevations of the start and end points of the parallel profiles (as we extend the profile inland, the elevation of the new coast point of the Dean profile is set to the elevation of the original coast point)
@@ -239,47 +254,74 @@ int CSimulation::nDoBeachErosionOnCells(int const nCoast, int const nPoly, doubl
             // Append this new landward cell to the up-coast part-profile
             PtiVUpCoastPartProfileCell.push_back(PtiThisUpCoastStart);
 
-            // And calculate the co-ords of a new landwards cell for the parallel profile
-            int
-               nXParNew = nXUpCoastThisStart + nXOffset,
-               nYParNew = nYUpCoastThisStart + nYOffset;
-
-            // Safety check
-            if (! bIsWithinGrid(nXParNew, nYParNew))
+            // And get the co-ords of a new landwards cell for the parallel profile: re-use the one from the cached parallel profile if there is one, otherwise calculate them
+            int nCell = nUpCoastPartProfileLen + nInlandOffset - 1;
+            if ((nCacheEntry != INT_NODATA) && (nCell < m_pBeachProfileCache->nGetNumCells(nCacheEntry)))
+               PtiVParProfile.push_back(*m_pBeachProfileCache->pPtiGetCell(nCacheEntry, nCell));
+            else
             {
+               int
+                  nXParNew = nXUpCoastThisStart + nXOffset,
+                  nYParNew = nYUpCoastThisStart + nYOffset;
+
+               // Safety check
+               if (! bIsWithinGrid(nXParNew, nYParNew))
+               {
 //                LogStream << WARN << "02 @@@@ while eroding polygon " << nPoly << " in DOWN-COAST direction (nInlandOffset = " << nInlandOffset << "), hit edge of grid at [" << nParProfEndX << "][" << nParProfEndY << "] for parallel profile from coast point " << nCoastPoint << " at [" << nCoastX << "][" << nCoastY << "]. Constraining this parallel profile at its landward end" << endl;
 
-               KeepWithinGrid(nCoastX, nCoastY, nXParNew, nYParNew);
-            }
+                  KeepWithinGrid(nCoastX, nCoastY, nXParNew, nYParNew);
+               }
 
-            // Append this to the parallel profile
-            CGeom2DIPoint PtiTmp(nXParNew, nYParNew);
-            PtiVParProfile.push_back(PtiTmp);
+               // Append this to the parallel profile
+               CGeom2DIPoint PtiTmp(nXParNew, nYParNew);
+               PtiVParProfile.push_back(PtiTmp);
+            }
          }
 
+         // Was this parallel profile's length and Dean profile shape, at this inland offset, recorded during estimation?
+         bool bCachedShape = ((nCacheEntry != INT_NODATA) && (nInlandOffset < m_pBeachProfileCache->nGetNumInlandOffsets(nCacheEntry)));
+
          // Get the distance between the start and end of the parallel profile, in external CRS units. Note that the parallel profile co-ords are in reverse sequence
-         CGeom2DPoint
-            PtStart = PtGridCentroidToExt(&PtiVParProfile.back()),
-            PtEnd = PtGridCentroidToExt(&PtiVParProfile[0]);
+         double dParProfileLen;
+         if (bCachedShape)
+            dParProfileLen = m_pBeachProfileCache->dGetLength(nCacheEntry, nInlandOffset);
+         else
+         {
+            CGeom2DPoint
+               PtStart = PtGridCentroidToExt(&PtiVParProfile.back()),
+               PtEnd = PtGridCentroidToExt(&PtiVParProfile[0]);
 
-         double dParProfileLen = dGetDistanceBetween(&PtStart, &PtEnd);
+            dParProfileLen = dGetDistanceBetween(&PtStart, &PtEnd);
+         }
 
          // Solve for dA so that the existing elevations at the end of the parallel profile, and at the end of a Dean equilibrium profile on that part-normal, are the same
          double const dPower = 2.0 / 3.0;
-         double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
 
          // For the parallel profile, calculate the Dean equilibrium profile of the unconsolidated sediment h(y) = A * y^(2/3) where h(y) is the distance below the highest point in the profile at a distance y from the landward start of the profile
          nParProfLen = PtiVParProfile.size();
          dVParProfileDeanElev.resize(nParProfLen, 0);
 
-         double
-            dDistFromParProfStart = 0,
-            dInc = dParProfileLen / (nParProfLen-1);
-         for (int n = 0; n < nParProfLen; n++)
+         if (bCachedShape)
          {
-            double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
-            dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
-            dDistFromParProfStart += dInc;
+            // Re-use the Dean profile shape which was recorded during estimation. This was calculated in the same way as below, so results are identical
+            vector<double> const* pdVShape = m_pBeachProfileCache->pdVGetDeanShape(nCacheEntry, nInlandOffset);
+            double dParProfA = (dParProfCoastElev - dParProfEndElev) / pdVShape->at(0);
+            for (int n = 0; n < nParProfLen; n++)
+               dVParProfileDeanElev[n] = dParProfCoastElev - (dParProfA * pdVShape->at(n+1));
+         }
+         else
+         {
+            double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
+
+            double
+               dDistFromParProfStart = 0,
+               dInc = dParProfileLen / (nParProfLen-1);
+            for (int n = 0; n < nParProfLen; n++)
+            {
+               double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
+               dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
+               dDistFromParProfStart += dInc;
+            }
          }
 
          double dParProfTotDiff = 0;
@@ -636,7 +678,7 @@ int CSimulation::nDoBeachErosionOnCells(int const nCoast, int const nPoly, doubl
       }
 
       // Shuffle the coast points, this is necessary so that leaving the loop does not create sequence-related artefacts
-      Rand1Shuffle(&(nVCoastPoint.at(0)), nCoastSegLen);
+      StreamShuffle(&(nVCoastPoint.at(0)), nCoastSegLen, RAND_STREAM_BEACH_EROSION_UPCOAST, nCoast, nPoly);
 
       // Now traverse the polygon's existing coastline in a random sequence, fitting a Dean profile at each coast point
       for (int n = 0; n < nCoastSegLen; n++)
@@ -653,12 +695,26 @@ int CSimulation::nDoBeachErosionOnCells(int const nCoast, int const nPoly, doubl
             nXOffset = nCoastX - PtiVDownCoastPartProfileCell.back().nGetX(),
             nYOffset = nCoastY - PtiVDownCoastPartProfileCell.back().nGetY();
 
+         // Was a parallel profile constructed at this coast point, with the same offset, while estimating actual beach erosion?
+         int nCacheEntry = INT_NODATA;
+         if (m_pBeachProfileCache)
+            nCacheEntry = m_pBeachProfileCache->nFindEntry(pPolygon->nGetGlobalID(), DIRECTION_UPCOAST, nCoastPoint, nXOffset, nYOffset);
+
          // Get the x-y coords of a profile starting from this coast point and parallel to the down-coast polygon boundary profile (these are in reverse sequence, like the boundary part-profile)
          vector<CGeom2DIPoint> PtiVParProfile;
-         for (int n = 0; n < nDownCoastPartProfileLen; n++)
+         if (nCacheEntry != INT_NODATA)
          {
-            CGeom2DIPoint PtiTmp(PtiVDownCoastPartProfileCell[n].nGetX() + nXOffset, PtiVDownCoastPartProfileCell[n].nGetY() + nYOffset);
-            PtiVParProfile.push_back(PtiTmp);
+            // It was, so re-use its cells (these have already been constrained to be within the grid)
+            for (int n = 0; n < nDownCoastPartProfileLen; n++)
+               PtiVParProfile.push_back(*m_pBeachProfileCache->pPtiGetCell(nCacheEntry, n));
+         }
+         else
+         {
+            for (int n = 0; n < nDownCoastPartProfileLen; n++)
+            {
+               CGeom2DIPoint PtiTmp(PtiVDownCoastPartProfileCell[n].nGetX() + nXOffset, PtiVDownCoastPartProfileCell[n].nGetY() + nYOffset);
+               PtiVParProfile.push_back(PtiTmp);
+            }
          }
 
          // Get the elevations of the start and end points of the parallel profiles (as we extend the profile inland, the elevation of the new coast point of the Dean profile is set to the elevation of the original coast point)
@@ -732,47 +788,74 @@ int CSimulation::nDoBeachErosionOnCells(int const nCoast, int const nPoly, doubl
                // Append this new landward cell to the down-coast part-profile
                PtiVDownCoastPartProfileCell.push_back(PtiThisDownCoastStart);
 
-               // And calculate the co-ords of a new landwards cell for the parallel profile
-               int
-                  nXParNew = nXDownCoastThisStart + nXOffset,
-                  nYParNew = nYDownCoastThisStart + nYOffset;
-
-               // Safety check
-               if (! bIsWithinGrid(nXParNew, nYParNew))
+               // And get the co-ords of a new landwards cell for the parallel profile: re-use the one from the cached parallel profile if there is one, otherwise calculate them
+               int nCell = nDownCoastPartProfileLen + nInlandOffset - 1;
+               if ((nCacheEntry != INT_NODATA) && (nCell < m_pBeachProfileCache->nGetNumCells(nCacheEntry)))
+                  PtiVParProfile.push_back(*m_pBeachProfileCache->pPtiGetCell(nCacheEntry, nCell));
+               else
                {
+                  int
+                     nXParNew = nXDownCoastThisStart + nXOffset,
+                     nYParNew = nYDownCoastThisStart + nYOffset;
+
+                  // Safety check
+                  if (! bIsWithinGrid(nXParNew, nYParNew))
+                  {
 //                   LogStream << WARN << "06 @@@@ while eroding polygon " << nPoly << " in UP-COAST direction, hit edge of grid at [" << nParProfEndX << "][" << nParProfEndY << "] for parallel profile from coast point " << nCoastPoint << " at [" << nCoastX << "][" << nCoastY << "]. Constraining this parallel profile at its landward end" << endl;
 
-                  KeepWithinGrid(nCoastX, nCoastY, nXParNew, nYParNew);
-               }
+                     KeepWithinGrid(nCoastX, nCoastY, nXParNew, nYParNew);
+                  }
 
-               // Append this to the parallel profile
-               CGeom2DIPoint PtiTmp(nXParNew, nYParNew);
-               PtiVParProfile.push_back(PtiTmp);
+                  // Append this to the parallel profile
+                  CGeom2DIPoint PtiTmp(nXParNew, nYParNew);
+                  PtiVParProfile.push_back(PtiTmp);
+               }
             }
 
+            // Was this parallel profile's length and Dean profile shape, at this inland offset, recorded during estimation?
+            bool bCachedShape = ((nCacheEntry != INT_NODATA) && (nInlandOffset < m_pBeachProfileCache->nGetNumInlandOffsets(nCacheEntry)));
+
             // Get the distance between the start and end of the parallel profile, in external CRS units. Note that the parallel profile co-ords are in reverse sequence
-            CGeom2DPoint
-               PtStart = PtGridCentroidToExt(&PtiVParProfile.back()),
-               PtEnd = PtGridCentroidToExt(&PtiVParProfile[0]);
+            double dParProfileLen;
+            if (bCachedShape)
+               dParProfileLen = m_pBeachProfileCache->dGetLength(nCacheEntry, nInlandOffset);
+            else
+            {
+               CGeom2DPoint
+                  PtStart = PtGridCentroidToExt(&PtiVParProfile.back()),
+                  PtEnd = PtGridCentroidToExt(&PtiVParProfile[0]);
 
-            double dParProfileLen = dGetDistanceBetween(&PtStart, &PtEnd);
+               dParProfileLen = dGetDistanceBetween(&PtStart, &PtEnd);
+            }
 
             // Solve for dA so that the existing elevations at the end of the parallel profile, and at the end of a Dean equilibrium profile on that part-normal, are the same
             double const dPower = 2.0 / 3.0;
-            double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
 
             // For the parallel profile, calculate the Dean equilibrium profile of the unconsolidated sediment h(y) = A * y^(2/3) where h(y) is the distance below the highest point in the profile at a distance y from the landward start of the profile
             nParProfLen = PtiVParProfile.size();
             dVParProfileDeanElev.resize(nParProfLen, 0);
 
-            double
-               dDistFromParProfStart = 0,
-               dInc = dParProfileLen / (nParProfLen-1);
-            for (int n = 0; n < nParProfLen; n++)
+            if (bCachedShape)
             {
-               double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
-               dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
-               dDistFromParProfStart += dInc;
+               // Re-use the Dean profile shape which was recorded during estimation. This was calculated in the same way as below, so results are identical
+               vector<double> const* pdVShape = m_pBeachProfileCache->pdVGetDeanShape(nCacheEntry, nInlandOffset);
+               double dParProfA = (dParProfCoastElev - dParProfEndElev) / pdVShape->at(0);
+               for (int n = 0; n < nParProfLen; n++)
+                  dVParProfileDeanElev[n] = dParProfCoastElev - (dParProfA * pdVShape->at(n+1));
+            }
+            else
+            {
+               double dParProfA = (dParProfCoastElev - dParProfEndElev) /  pow(dParProfileLen, dPower);
+
+               double
+                  dDistFromParProfStart = 0,
+                  dInc = dParProfileLen / (nParProfLen-1);
+               for (int n = 0; n < nParProfLen; n++)
+               {
+                  double dDistBelowHighest = dParProfA * pow(dDistFromParProfStart, dPower);
+                  dVParProfileDeanElev[n] = dParProfCoastElev - dDistBelowHighest;
+                  dDistFromParProfStart += dInc;
+               }
             }
 
             double dParProfTotDiff = 0;
@@ -1268,7 +1351,7 @@ int CSimulation::nDoBeachDepositionOnCells(int const nCoast, int const nPoly, do
    }
 
    // Shuffle the coast points, this is necessary so that leaving the loop does not create sequence-related artefacts
-   Rand1Shuffle(&(nVCoastPoint.at(0)), nCoastSegLen);
+   StreamShuffle(&(nVCoastPoint.at(0)), nCoastSegLen, RAND_STREAM_BEACH_DEPOSITION_DOWNCOAST, nCoast, nPoly);
 
    // Get the volume of sediment which is to be deposited on the polygon and on each parallel profile
    double
@@ -1741,7 +1824,7 @@ int CSimulation::nDoBeachDepositionOnCells(int const nCoast, int const nPoly, do
       }
 
       // Shuffle the coast points, this is necessary so that leaving the loop does not create sequence-related artefacts
-      Rand1Shuffle(&(nVCoastPoint.at(0)), nCoastSegLen);
+      StreamShuffle(&(nVCoastPoint.at(0)), nCoastSegLen, RAND_STREAM_BEACH_DEPOSITION_UPCOAST, nCoast, nPoly);
 
       // Recalc the targets for deposition per profile
       dSandTargetPerProfile = dSandToDepositOnPoly / nCoastSegLen;
@@ -34,68 +34,77 @@ using std::ios;
 
 #include "cme.h"
 #include "simulation.h"
-#include "cliff.h"
+#include "coast.h"
 
 
 /*===============================================================================================================================
 
- Update accumulated wave energy in coastal landform objects
+ Update accumulated wave energy in coastal landforms
 
 ===============================================================================================================================*/
 int CSimulation::nDoAllWaveEnergyToCoastLandforms(void)
 {
    int nRet = RTN_OK;
 
-   // First go along each coastline and update the total wave energy which it has experienced
+   // If cliff collapse deposition is being batched, this holds every cliff which collapses this timestep
+   vector<CliffDepositionRecord> VCollapse;
+
+   vector<int> nVReadyToCollapse;
+   vector<double> dVNotchExtension;
+
    for (int i = 0; i < static_cast<int>(m_VCoast.size()); i++)
    {
-      for (int j = 0; j < m_VCoast[i].nGetCoastlineSize(); j++)
-      {
-         CACoastLandform* pCoastLandform = m_VCoast[i].pGetCoastLandform(j);
+      // First go along the coastline and update the total wave energy which each coastal landform has experienced. At the same time, extend each cliff's erosional notch as a result of wave energy during this timestep: this-timestep notch extension (a length in external CRS units) is constrained to be no more than the length of one cell side, since the most we can remove in a single timestep is one coastal cell, and also cannot exceed the depth of sediment remaining on the cell. This also finds the cliffs whose notch is now extended enough to cause collapse (either because the overhang is greater than the threshold overhang, or because there is no sediment remaining)
+      m_VCoast[i].AccumulateWaveEnergyAndErodeCliffNotches(m_dCliffErodibility, m_dCellSide, m_dNotchOverhangAtCollapse, &dVNotchExtension, &nVReadyToCollapse);
 
-         // Update accumulated wave energy for the coastal landform object
-         double dWaveEnergy = m_VCoast[i].dGetWaveEnergy(j);
-//          assert(bIsFinite(dWaveEnergy));
-         pCoastLandform->IncTotAccumWaveEnergy(dWaveEnergy);
+      // Now do each cliff collapse, in along-coastline sequence
+      for (unsigned int m = 0; m < nVReadyToCollapse.size(); m++)
+      {
+         int j = nVReadyToCollapse[m];
 
-         // Now simulate how the coastal landform responds to this wave energy
-         int nCategory = pCoastLandform->nGetLandFormCategory();
-         if (nCategory == LF_CAT_CLIFF)
+         double
+            dFineCollapse = 0,
+            dSandCollapse = 0,
+            dCoarseCollapse = 0;
+
+         // So do the cliff collapse
+         nRet = nDoCliffCollapse(i, j, dVNotchExtension[j], dFineCollapse, dSandCollapse, dCoarseCollapse);
+         if (nRet != RTN_OK)
+            LogStream << m_ulTimestep << WARN << " problem with cliff collapse, continuing however" << endl;
+
+         CliffDepositionRecord Collapse;
+         Collapse.nCoast = i;
+         Collapse.nPointOnCoast = j;
+         Collapse.dFineCollapse = dFineCollapse;
+         Collapse.dSandCollapse = dSandCollapse;
+         Collapse.dCoarseCollapse = dCoarseCollapse;
+
+         if (m_bBatchCliffCollapseDeposition)
+            // Deposition is being batched, so just remember this collapse for now
+            VCollapse.push_back(Collapse);
+         else
          {
-            // This is a cliff
-            CRWCliff* pCliff = reinterpret_cast<CRWCliff*>(pCoastLandform);
-
-            // Calculate this-timestep cliff notch erosion (is a length in external CRS units)
-            double dNotchExtension = m_dCliffErodibility * dWaveEnergy;
-
-            // Constrain this-timestep notch extension if it is more than the length of one cell side (in external CRS units), since the most we can remove in a single timestep is one coastal cell
-            dNotchExtension = tMin(m_dCellSide, dNotchExtension);
-
-            // Extend the cliff object's erosional notch as a result of wave energy during this timestep. Note that extension may be constrained, since this-timestep extension cannot exceed the depth of sediment remaining on the cell
-            dNotchExtension = pCliff->dErodeNotch(dNotchExtension);        // Constrain
-
-            // OK, is the notch now extended enough to cause collapse (either because the overhang is greater than the threshold overhang, or because there is no sediment remaining)?
-            if (pCliff->bReadyToCollapse(m_dNotchOverhangAtCollapse))
+            // And put fine sediment into suspension, and deposit sand and/or coarse sediment as unconsolidated sediment
+            nRet = nDoCliffCollapseDeposition(&Collapse);
+            ApplyCliffDepositionRecord(&Collapse);
+            if (nRet != RTN_OK)
             {
-               // It is ready to collapse
-               double
-                  dFineCollapse = 0,
-                  dSandCollapse = 0,
-                  dCoarseCollapse = 0;
-
-               // So do the cliff collapse
-               nRet = nDoCliffCollapse(pCliff, dNotchExtension, dFineCollapse, dSandCollapse, dCoarseCollapse);
-               if (nRet != RTN_OK)
-                  LogStream << m_ulTimestep << WARN << " problem with cliff collapse, continuing however" << endl;
-
-               // And put fine sediment into suspension, and deposit sand and/or coarse sediment as unconsolidated sediment
-               nRet = nDoCliffCollapseDeposition(pCliff, dFineCollapse, dSandCollapse, dCoarseCollapse);
-               if (nRet != RTN_OK)
-                  return nRet;
+               if (nRet == RTN_ERR_LINETOGRID)
+                  cout << m_ulTimestep << ": error when rasterizing cells during cliff collapse" << endl;
+
+               return nRet;
             }
          }
       }
    }
+
+   // If deposition is being batched, now do it for every cliff which collapsed this timestep
+   if (! VCollapse.empty())
+   {
+      nRet = nDoAllCliffCollapseDeposition(&VCollapse);
+      if (nRet != RTN_OK)
+         return nRet;
+   }
    
    LogStream << endl << m_ulTimestep << ": cliff collapse = " << m_dThisTimestepCliffCollapseFine + m_dThisTimestepCliffCollapseSand + m_dThisTimestepCliffCollapseCoarse << " (fine = " << m_dThisTimestepCliffCollapseFine << ", sand = " << m_dThisTimestepCliffCollapseSand << ", coarse = " << m_dThisTimestepCliffCollapseCoarse << "), talus deposition = " << m_dThisTimestepCliffTalusSandDeposition + m_dThisTimestepCliffTalusCoarseDeposition << " (sand = " << m_dThisTimestepCliffTalusSandDeposition << ", coarse = " << m_dThisTimestepCliffTalusSandDeposition << ")" << endl;
 
@@ -105,18 +114,18 @@ int CSimulation::nDoAllWaveEnergyToCoastLandforms(void)
 
 /*===============================================================================================================================
 
- Simulates cliff collapse on a single cliff object: it updates both the cliff object and the cell 'under' the cliff object
+ Simulates cliff collapse on a single cliff, given by its coast and coast point: it updates both the cliff attributes on the coast and the cell 'under' the cliff
 
 ===============================================================================================================================*/
-int CSimulation::nDoCliffCollapse(CRWCliff* pCliff, double const dNotchDeepen, double& dFineCollapse, double& dSandCollapse, double& dCoarseCollapse)
+int CSimulation::nDoCliffCollapse(int const nCoast, int const nPoint, double const dNotchDeepen, double& dFineCollapse, double& dSandCollapse, double& dCoarseCollapse)
 {
    // Get the cliff cell's grid coords
    int 
-      nX = pCliff->pPtiGetCellMarkedAsLF()->nGetX(),
-      nY = pCliff->pPtiGetCellMarkedAsLF()->nGetY();
+      nX = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nPoint)->nGetX(),
+      nY = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nPoint)->nGetY();
 
-   // Then get the elevation of the base of the notch from the cliff object
-   double dNotchElev = pCliff->dGetNotchBaseElev() - m_dNotchBaseBelowSWL;
+   // Then get the elevation of the base of the notch from the cliff
+   double dNotchElev = m_VCoast[nCoast].dGetCliffNotchBaseElev(nPoint) - m_dNotchBaseBelowSWL;
 
    // Get the index of the layer containing the notch (layer 0 being just above basement)
    int nNotchLayer = m_pRasterGrid->m_Cell[nX][nY].nGetLayerAtElev(dNotchElev);
@@ -129,30 +138,25 @@ int CSimulation::nDoCliffCollapse(CRWCliff* pCliff, double const dNotchDeepen, d
 //    else
 //       LogStream << endl << m_ulTimestep << ": for cell [" << nX << "][" << nY << "] dNotchElev = " << dNotchElev << " sediment top elevation = " << m_pRasterGrid->m_Cell[nX][nY].dGetSedimentTopElev() << endl;
 
-   // Flag the coastline cliff object as having collapsed
-   pCliff->SetCliffCollapse(true);
-
    int nTopLayer = m_pRasterGrid->m_Cell[nX][nY].nGetTopLayerAboveBasement();
 
    // Safety check
    if (nTopLayer == INT_NODATA)
       return RTN_ERR_NO_TOP_LAYER;
 
-   double dRemaining = pCliff->dGetRemaining();
+   double dRemaining = m_VCoast[nCoast].dGetCliffRemaining(nPoint);
    if (dRemaining <= 0)
    {
-      // No cliff sediment left on this cliff object, so the cell which it occupies will no longer be a cliff in the next timestep
-      pCliff->SetAllSedimentGone();
+      // No cliff sediment left on this cliff, so the cell which it occupies will no longer be a cliff in the next timestep
+      m_VCoast[nCoast].SetCliffAllSedimentGone(nPoint);
 
       // Set the base of the collapse (see above)
-      pCliff->SetNotchBaseElev(dNotchElev);
+      m_VCoast[nCoast].SetCliffNotchBaseElev(nPoint, dNotchElev);
 
       // Set flags to say that the top layer has changed
       m_bConsChangedThisTimestep[nTopLayer] = true;
       m_bUnconsChangedThisTimestep[nTopLayer] = true;
 
-//      int nX = pCliff->pPtiGetCellMarkedAsLF()->nGetX();
-//      int nY = pCliff->pPtiGetCellMarkedAsLF()->nGetY();
 //      LogStream << m_ulTimestep << ": all sediment removed from cliff object after cliff collapse on [" << nX << "][" << nY << "], dNotchElev = " << dNotchElev << endl;
    }
 
@@ -291,7 +295,7 @@ int CSimulation::nDoCliffCollapse(CRWCliff* pCliff, double const dNotchDeepen, d
    m_pRasterGrid->m_Cell[nX][nY].SetSeaDepth();
 
    // The notch has gone
-   pCliff->SetNotchOverhang(0);
+   m_VCoast[nCoast].SetCliffNotchOverhang(nPoint, 0);
 
 //   LogStream << m_ulTimestep << ": cell [" << nX << "][" << nY << "] after removing sediment, dGetVolEquivSedTopElev() = " << m_pRasterGrid->m_Cell[nX][nY].dGetVolEquivSedTopElev() << ", dGetSedimentTopElev() = " << m_pRasterGrid->m_Cell[nX][nY].dGetSedimentTopElev() << endl << endl;
 
@@ -307,6 +311,137 @@ int CSimulation::nDoCliffCollapse(CRWCliff* pCliff, double const dNotchDeepen, d
 }
 
 
+/*===============================================================================================================================
+
+ Does talus deposition for a batch of cliff collapses. Deposition for cliffs whose deposition footprints do not overlap is independent, so the collapses are put into groups: the first group is every collapse which does not overlap any earlier collapse, the next group is every collapse which overlaps only collapses in the first group, and so on. Collapses within a group are then processed concurrently (if OpenMP is enabled), and the groups are processed in sequence. Finally the changes to this-timestep totals are applied in the original order, so that results are the same whatever the number of threads
+
+===============================================================================================================================*/
+int CSimulation::nDoAllCliffCollapseDeposition(vector<CliffDepositionRecord>* pVCollapse)
+{
+   int nCollapses = pVCollapse->size();
+
+   // Assign each collapse to a group. The group of a collapse is one more than the highest group of any earlier collapse whose footprint shares a cell with this collapse's footprint
+   vector<int>
+      nVCellGroup(m_nXGridMax * m_nYGridMax, -1),
+      nVGroup(nCollapses, 0);
+   int nGroups = 0;
+   for (int n = 0; n < nCollapses; n++)
+   {
+      vector<int> nVCell;
+      GetCliffCollapseDepositionCells(pVCollapse->at(n).nCoast, pVCollapse->at(n).nPointOnCoast, &nVCell);
+
+      int nGroup = 0;
+      for (unsigned int m = 0; m < nVCell.size(); m++)
+         nGroup = tMax(nGroup, nVCellGroup[nVCell[m]] + 1);
+
+      for (unsigned int m = 0; m < nVCell.size(); m++)
+         nVCellGroup[nVCell[m]] = nGroup;
+
+      nVGroup[n] = nGroup;
+      nGroups = tMax(nGroups, nGroup + 1);
+   }
+
+   vector<vector<int> > nVVGroupMember(nGroups);
+   for (int n = 0; n < nCollapses; n++)
+      nVVGroupMember[nVGroup[n]].push_back(n);
+
+   vector<int> nVRet(nCollapses, RTN_OK);
+   for (int nGroup = 0; nGroup < nGroups; nGroup++)
+   {
+      int nMembers = nVVGroupMember[nGroup].size();
+
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic)
+#endif
+      for (int m = 0; m < nMembers; m++)
+      {
+         nVRet[nVVGroupMember[nGroup][m]] = nDoCliffCollapseDeposition(&pVCollapse->at(nVVGroupMember[nGroup][m]));
+      }
+
+      // Stop at the first group with a problem
+      for (int m = 0; m < nMembers; m++)
+      {
+         int nRet = nVRet[nVVGroupMember[nGroup][m]];
+         if (nRet != RTN_OK)
+         {
+            if (nRet == RTN_ERR_LINETOGRID)
+               cout << m_ulTimestep << ": error when rasterizing cells during cliff collapse" << endl;
+
+            return nRet;
+         }
+      }
+   }
+
+   // Now apply the changes to this-timestep totals, in the original order
+   for (int n = 0; n < nCollapses; n++)
+      ApplyCliffDepositionRecord(&pVCollapse->at(n));
+
+   m_ulTotCliffCollapsesBatched += nCollapses;
+   m_ulTotCliffCollapseDepositionGroups += nGroups;
+
+   return RTN_OK;
+}
+
+
+/*===============================================================================================================================
+
+ Gets the cells which may be changed by talus deposition from a cliff collapse, i.e. the cells under every planview deposition profile, for every seaward offset up to CLIFF_DEPOSITION_MAX_SEAWARD_OFFSET. This follows the same steps as nDoCliffCollapseDeposition() but does not change anything. Cells are indexed as (nX * m_nYGridMax) + nY
+
+===============================================================================================================================*/
+void CSimulation::GetCliffCollapseDepositionCells(int const nCoast, int const nStartPoint, vector<int>* pnVCell)
+{
+   int
+      nCoastSize = m_VCoast[nCoast].nGetCoastlineSize(),
+      nProfileLength = static_cast<int>(dRound(m_dCliffDepositionPlanviewLength));
+
+   int nSigned = - (m_nCliffDepositionPlanviewWidth - 1) / 2;
+   for (int nAcross = 0; nAcross < m_nCliffDepositionPlanviewWidth; nAcross++)
+   {
+      int nThisPoint = nStartPoint + nSigned++;
+      if ((nThisPoint < 0) || (nThisPoint > (nCoastSize-1)))
+         continue;
+
+      CGeom2DPoint
+         PtStart,
+         PtEnd;
+      PtStart.SetX(dGridCentroidXToExtCRSX(m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nThisPoint)->nGetX()));
+      PtStart.SetY(dGridCentroidYToExtCRSY(m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nThisPoint)->nGetY()));
+
+      // nDoCliffCollapseDeposition() never uses a seaward offset larger than this, so the footprint covers every profile which it can write to
+      for (int nSeawardOffset = 0; nSeawardOffset <= CLIFF_DEPOSITION_MAX_SEAWARD_OFFSET; nSeawardOffset++)
+      {
+         double dThisProfileLength = (nProfileLength + nSeawardOffset + 1) * m_dCellSide;
+         if (nGetCoastNormalEndPoint(nCoast, nThisPoint, nCoastSize, &PtStart, dThisProfileLength, &PtEnd) != RTN_OK)
+            break;
+
+         vector<CGeom2DPoint> VTmpProfile;
+         VTmpProfile.push_back(PtStart);
+         VTmpProfile.push_back(PtEnd);
+         vector<CGeom2DIPoint> VCellsUnderProfile;
+         nRasterizeCliffCollapseProfile(&VTmpProfile, &VCellsUnderProfile);
+
+         for (unsigned int n = 0; n < VCellsUnderProfile.size(); n++)
+            pnVCell->push_back((VCellsUnderProfile[n].nGetX() * m_nYGridMax) + VCellsUnderProfile[n].nGetY());
+      }
+   }
+}
+
+
+/*===============================================================================================================================
+
+ Applies the changes which talus deposition from a single cliff collapse makes to this-timestep totals, in the order in which they were made
+
+===============================================================================================================================*/
+void CSimulation::ApplyCliffDepositionRecord(CliffDepositionRecord const* pRecord)
+{
+   for (unsigned int n = 0; n < pRecord->prVTotalChange.size(); n++)
+      *(pRecord->prVTotalChange[n].first) += pRecord->prVTotalChange[n].second;
+
+   for (unsigned int n = 0; n < pRecord->nVUnconsChangedLayer.size(); n++)
+      m_bUnconsChangedThisTimestep[pRecord->nVUnconsChangedLayer[n]] = true;
+}
+
+
 /*===============================================================================================================================
 
  Puts the fine sediment from a cliff collapse into suspension, and redistributes the sand-sized and coarse-sized sediment from a cliff collapse onto the foreshore, as unconsolidated talus
@@ -314,11 +449,16 @@ int CSimulation::nDoCliffCollapse(CRWCliff* pCliff, double const dNotchDeepen, d
  The talus is added to the existing beach volume (i.e. to the unconsolidated sediment). The shoreline is iteratively advanced seaward until all this volume is accommodated under a Dean equilibrium profile. This equilibrium beach profile is h(y) = A * y^(2/3) where h(y) is the water depth at a distance y from the shoreline and A is a sediment-dependent scale parameter
 
 ===============================================================================================================================*/
-int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFineCollapse, double const dSandCollapse, double const dCoarseCollapse)
+int CSimulation::nDoCliffCollapseDeposition(CliffDepositionRecord* pRecord)
 {
+   double const
+      dFineCollapse = pRecord->dFineCollapse,
+      dSandCollapse = pRecord->dSandCollapse,
+      dCoarseCollapse = pRecord->dCoarseCollapse;
+
    // Fine sediment goes into suspension
    if (dFineCollapse > SEDIMENT_ELEV_TOLERANCE)
-      m_dThisTimestepFineSedimentToSuspension += dFineCollapse;
+      pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepFineSedimentToSuspension, dFineCollapse));
 
    // Do we have any sand- or coarse-sized sediment to deposit?
    double dTotFromCollapse = dSandCollapse + dCoarseCollapse;
@@ -327,8 +467,8 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
 
    // OK, we have some sand- and/or coarse-sized sediment to deposit
    int
-      nCoast = pCliff->nGetCoast(),
-      nStartPoint = pCliff->nGetPointOnCoast(),
+      nCoast = pRecord->nCoast,
+      nStartPoint = pRecord->nPointOnCoast,
       nCoastSize = m_VCoast[nCoast].nGetCoastlineSize();
 
    double
@@ -376,8 +516,6 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
 
 //   LogStream << "dSandCollapse = " << dSandCollapse << " dCoarseCollapse = " << dCoarseCollapse << " m_nCliffDepositionPlanviewWidth = " << m_nCliffDepositionPlanviewWidth << endl;
 
-//    int nX = pCliff->pPtiGetCellMarkedAsLF()->nGetX();
-//    int nY = pCliff->pPtiGetCellMarkedAsLF()->nGetY();
 //   LogStream << "Cliff object is at cell[" << nX << "][" << nY << "] which is " << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << endl;
 
    for (int nAcross = 0; nAcross < m_nCliffDepositionPlanviewWidth; nAcross++)
@@ -395,8 +533,8 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
 //          LogStream << "dTotSandToDeposit WAS = " << dTotSandToDeposit << " dTotCoarseToDeposit WAS = " << dTotCoarseToDeposit << endl;
 
          // The start point of the profile would have been outside the grid, so just add this profile's sediment to the volume exported from the grid this timestep
-         m_dThisTimestepSandSedLostCliffCollapse += (dVToDepositPerProfile[nAcross] * dSandProp);
-         m_dThisTimestepCoarseSedLostCliffCollapse += (dVToDepositPerProfile[nAcross] * dCoarseProp);
+         pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepSandSedLostCliffCollapse, (dVToDepositPerProfile[nAcross] * dSandProp)));
+         pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepCoarseSedLostCliffCollapse, (dVToDepositPerProfile[nAcross] * dCoarseProp)));
 
          // Remove this volume from the total still to be deposited
          dTotSandToDeposit -= (dVToDepositPerProfile[nAcross] * dSandProp);
@@ -422,6 +560,10 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
 
          nSeawardOffset++;
 
+         // Cliff collapses are batched using deposition footprints which only go as far as this offset, so never go further
+         if (nSeawardOffset > CLIFF_DEPOSITION_MAX_SEAWARD_OFFSET)
+            break;
+
 //          if (nSeawardOffset > 20)
 //          {
 //             // Arbitrary safety check, if we can't store sufficient sediment with an offset of this size then move to the next point along the coast
@@ -443,8 +585,8 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
 //                LogStream << "END point of profile would have been outside the grid, so " << dVToDepositPerProfile[nAcross] << " exported from grid" << endl;
 
                // The end point of the profile would have been outside the grid, so just add this profile's sediment to the volume exported from the grid this timestep
-               m_dThisTimestepSandSedLostCliffCollapse += (dVToDepositPerProfile[nAcross] * dSandProp);
-               m_dThisTimestepCoarseSedLostCliffCollapse += (dVToDepositPerProfile[nAcross] * dCoarseProp);
+               pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepSandSedLostCliffCollapse, (dVToDepositPerProfile[nAcross] * dSandProp)));
+               pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepCoarseSedLostCliffCollapse, (dVToDepositPerProfile[nAcross] * dCoarseProp)));
 
                // Remove this volume from the total still to be deposited
                dTotSandToDeposit -= (dVToDepositPerProfile[nAcross] * dSandProp);
@@ -486,10 +628,8 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
 
          // Now get the raster cells under this profile
          if (nRasterizeCliffCollapseProfile(&VTmpProfile, &VCellsUnderProfile) != RTN_OK)
-         {
-            cout << m_ulTimestep << ": error when rasterizing cells during cliff collapse" << endl;
+            // This may be running concurrently, so the error message is written by nDoAllCliffCollapseDeposition()
             return RTN_ERR_LINETOGRID;
-         }
 
          int nRasterProfileLength = VCellsUnderProfile.size();
          vector<double> dVProfileNow(nRasterProfileLength);
@@ -639,7 +779,7 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
                   m_pRasterGrid->m_Cell[nX][nY].pGetLayerAboveBasement(nTopLayer)->pGetUnconsolidatedSediment()->SetSand(dSandNow + dPotentialSandToDeposit);
 
                   // Set the changed-this-timestep switch
-                  m_bUnconsChangedThisTimestep[nTopLayer] = true;
+                  pRecord->nVUnconsChangedLayer.push_back(nTopLayer);
 
                   dTotSandToDeposit -= dPotentialSandToDeposit;
 //                  dDepositedCheck += dPotentialSandToDeposit;
@@ -655,7 +795,7 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
                   m_pRasterGrid->m_Cell[nX][nY].pGetLayerAboveBasement(nTopLayer)->pGetUnconsolidatedSediment()->SetCoarse(dCoarseNow + dPotentialCoarseToDeposit);
 
                   // Set the changed-this-timestep switch
-                  m_bUnconsChangedThisTimestep[nTopLayer] = true;
+                  pRecord->nVUnconsChangedLayer.push_back(nTopLayer);
 
                   dTotCoarseToDeposit -= dPotentialCoarseToDeposit;
 //                  dDepositedCheck += dPotentialCoarseToDeposit;
@@ -709,10 +849,10 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
                   m_pRasterGrid->m_Cell[nX][nY].pGetLayerAboveBasement(nTopLayer)->pGetUnconsolidatedSediment()->SetFine(dRemaining);
 
                   // And set the changed-this-timestep switch
-                  m_bUnconsChangedThisTimestep[nTopLayer] = true;
+                  pRecord->nVUnconsChangedLayer.push_back(nTopLayer);
 
                   // And increment the per-timestep talus erosion total
-                  m_dThisTimestepCliffTalusFineErosion += dFine;
+                  pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepCliffTalusFineErosion, dFine));
                }
 
                if (nSandWeight)
@@ -731,10 +871,10 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
                   m_pRasterGrid->m_Cell[nX][nY].pGetLayerAboveBasement(nTopLayer)->pGetUnconsolidatedSediment()->SetSand(dRemaining);
 
                   // Set the changed-this-timestep switch
-                  m_bUnconsChangedThisTimestep[nTopLayer] = true;
+                  pRecord->nVUnconsChangedLayer.push_back(nTopLayer);
 
                   // And increment the per-timestep talus erosion total
-                  m_dThisTimestepCliffTalusSandErosion += dSand;
+                  pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepCliffTalusSandErosion, dSand));
                }
 
                if (nCoarseWeight)
@@ -753,10 +893,10 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
                   m_pRasterGrid->m_Cell[nX][nY].pGetLayerAboveBasement(nTopLayer)->pGetUnconsolidatedSediment()->SetCoarse(dRemaining);
 
                   // Set the changed-this-timestep switch
-                  m_bUnconsChangedThisTimestep[nTopLayer] = true;
+                  pRecord->nVUnconsChangedLayer.push_back(nTopLayer);
 
                   // And increment the per-timestep talus erosion total
-                  m_dThisTimestepCliffTalusCoarseErosion += dCoarse;
+                  pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepCliffTalusCoarseErosion, dCoarse));
                }
 
                // Set the actual erosion value for this cell
@@ -801,8 +941,8 @@ int CSimulation::nDoCliffCollapseDeposition(CRWCliff* pCliff, double const dFine
    }
 
    // Increment this-timestep totals for cliff collapse deposition
-   m_dThisTimestepCliffTalusSandDeposition += dSandCollapse;
-   m_dThisTimestepCliffTalusCoarseDeposition += dCoarseCollapse;
+   pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepCliffTalusSandDeposition, dSandCollapse));
+   pRecord->prVTotalChange.push_back(make_pair(&m_dThisTimestepCliffTalusCoarseDeposition, dCoarseCollapse));
 
    return RTN_OK;
 }
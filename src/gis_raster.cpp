@@ -161,7 +161,16 @@ int CSimulation::nReadBasementDEMData(void)
 
    // Next allocate memory for two 2D arrays of raster cell objects: tell the user what is happening
    AnnounceAllocateMemory();
-   int nRet = m_pRasterGrid->nCreateGrid();
+   string strGridTileFile = (m_strGridTileDir.empty() ? m_strOutPath : m_strGridTileDir);
+   strGridTileFile.append(GRIDTILESNAME);
+   strGridTileFile.append(SCRATCHEXT);
+
+   int nRet = m_pRasterGrid->nCreateGrid(m_nGridTileSide, m_dGridTileCacheMb, m_nLayers, strGridTileFile);
+   if (nRet == RTN_ERR_SCRATCH_FILE)
+   {
+      cerr << ERR << "cannot open " << strGridTileFile << " for grid tiles" << endl;
+      return nRet;
+   }
    if (nRet != RTN_OK)
       return nRet;
 
@@ -199,6 +208,9 @@ int CSimulation::nReadBasementDEMData(void)
 
          m_pRasterGrid->m_Cell[i][j].SetBasementElev(dTmp);
       }
+
+      // If the grid is tiled, this is a safe point to page out tiles
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 
    // Finished, so get rid of dataset object
@@ -696,6 +708,8 @@ int CSimulation::nReadRasterGISData(int const nDataItem, int const nLayer)
                }
             }
          }
+
+         m_pRasterGrid->m_Cell.PageOutUnused();
       }
 
       // Finished, so get rid of dataset object
@@ -1232,6 +1246,8 @@ bool CSimulation::bWriteRasterGISFloat(int const nDataItem, string const* strPlo
          // Write this value to the array
          pfRaster[n++] = dTmp;
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 
    // Create a single raster band
@@ -1610,6 +1626,8 @@ bool CSimulation::bWriteRasterGISInt(int const nDataItem, string const* strPlotT
          // Write it to the array
          pnRaster[n++] = nTmp;
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 
    // Create a single raster band
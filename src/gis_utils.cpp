@@ -853,6 +853,11 @@ bool CSimulation::bCheckVectorGISOutputFormat(void)
       m_strOGRVectorOutputExtension = ".shp";
 
    }
+   else if (m_strVectorGISOutFormat == "GPKG")
+   {
+      // GeoPackage can hold many layers in a single file, so is a good choice if all vector output is written to a single file
+      m_strOGRVectorOutputExtension = ".gpkg";
+   }
    // TODO Others
 
    return true;
@@ -1169,7 +1174,11 @@ bool CSimulation::bSaveAllVectorGISFiles(void)
       if (! bWriteVectorGIS(PLOT_SHADOW_ZONE_BOUNDARY, &PLOT_SHADOW_ZONE_BOUNDARY_TITLE))
          return false;
    }
-   
+
+   // If all vector GIS output for this save went to a single file, then close it
+   if (m_nVectorGISContainer == VECTOR_CONTAINER_SAVE)
+      CloseVectorGISContainer();
+
    return true;
 }
 
@@ -1445,6 +1454,9 @@ void CSimulation::GetRasterOutputMinMax(int const nDataItem, double& dMin, doubl
                dMin = dTmp;
          }
       }
+
+      // If the grid is tiled, this is a safe point to page out tiles
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 }
 
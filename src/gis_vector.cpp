@@ -37,7 +37,6 @@ using std::stringstream;
 #include "cme.h"
 #include "simulation.h"
 #include "coast.h"
-#include "cliff.h"
 
 
 /*==============================================================================================================================
@@ -325,90 +324,94 @@ using std::stringstream;
 ===============================================================================================================================*/
 bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitle)
 {
-   // Begin constructing the file name for this save
-   string strFilePathName(m_strOutPath);
+   // Get the name of the layer for this data item
+   string strLayerName;
 
    switch (nDataItem)
    {
       case (PLOT_COAST):
       {
-         strFilePathName.append(VECTOR_COAST_NAME);
+         strLayerName = VECTOR_COAST_NAME;
          break;
       }
 
       case (PLOT_NORMALS):
       {
-         strFilePathName.append(VECTOR_NORMALS_NAME);
+         strLayerName = VECTOR_NORMALS_NAME;
          break;
       }
 
       case (PLOT_INVALID_NORMALS):
       {
-         strFilePathName.append(VECTOR_INVALID_NORMALS_NAME);
+         strLayerName = VECTOR_INVALID_NORMALS_NAME;
          break;
       }
 
       case (PLOT_COAST_CURVATURE):
       {
-         strFilePathName.append(VECTOR_COAST_CURVATURE_NAME);
+         strLayerName = VECTOR_COAST_CURVATURE_NAME;
          break;
       }
 
       case (PLOT_WAVE_ORIENTATION_AND_HEIGHT):
       {
-         strFilePathName.append(VECTOR_WAVE_ANGLE_NAME);
+         strLayerName = VECTOR_WAVE_ANGLE_NAME;
          break;
       }
 
       case (PLOT_AVG_WAVE_ORIENTATION_AND_HEIGHT):
       {
-         strFilePathName.append(VECTOR_AVG_WAVE_ANGLE_NAME);
+         strLayerName = VECTOR_AVG_WAVE_ANGLE_NAME;
          break;
       }
 
       case (PLOT_WAVE_ENERGY_SINCE_COLLAPSE):
       {
-         strFilePathName.append(VECTOR_WAVE_ENERGY_SINCE_COLLAPSE_NAME);
+         strLayerName = VECTOR_WAVE_ENERGY_SINCE_COLLAPSE_NAME;
          break;
       }
 
       case (PLOT_MEAN_WAVE_ENERGY):
       {
-         strFilePathName.append(VECTOR_MEAN_WAVE_ENERGY_NAME);
+         strLayerName = VECTOR_MEAN_WAVE_ENERGY_NAME;
          break;
       }
 
       case (PLOT_BREAKING_WAVE_HEIGHT):
       {
-         strFilePathName.append(VECTOR_BREAKING_WAVE_HEIGHT_NAME);
+         strLayerName = VECTOR_BREAKING_WAVE_HEIGHT_NAME;
          break;
       }
 
       case (PLOT_POLYGON_NODES):
       {
-         strFilePathName.append(VECTOR_POLYGON_NODES_NAME);
+         strLayerName = VECTOR_POLYGON_NODES_NAME;
          break;
       }
 
       case (PLOT_POLYGON_BOUNDARY):
       {
-         strFilePathName.append(VECTOR_POLYGON_BOUNDARY_NAME);
+         strLayerName = VECTOR_POLYGON_BOUNDARY_NAME;
          break;
       }
 
       case (PLOT_CLIFF_NOTCH_SIZE):
       {
-         strFilePathName.append(VECTOR_CLIFF_NOTCH_SIZE_NAME);
+         strLayerName = VECTOR_CLIFF_NOTCH_SIZE_NAME;
          break;
       }
       
       case (PLOT_SHADOW_ZONE_BOUNDARY):
       {
-         strFilePathName.append(VECTOR_SHADOW_ZONE_LINE_NAME);
+         strLayerName = VECTOR_SHADOW_ZONE_LINE_NAME;
          break;
       }
    }
 
+   // Begin constructing the file name for this save
+   string strFilePathName(m_strOutPath);
+   strFilePathName.append(strLayerName);
+
    // Append the 'save number' to the filename, and prepend zeros to the save number
    strFilePathName.append("_");
    stringstream ststrTmp;
@@ -422,36 +425,83 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
    if (! m_strOGRVectorOutputExtension.empty())
       strFilePathName.append(m_strOGRVectorOutputExtension);
 
-   // Set up the vector driver
-   GDALDriver* pGDALDriver = GetGDALDriverManager()->GetDriverByName(m_strVectorGISOutFormat.c_str());
-   if (pGDALDriver == NULL)
-   {
-      cerr << ERR << "vector GIS output driver " << m_strVectorGISOutFormat << CPLGetLastErrorMsg() << endl;
-      return false;
-   }
-
-   // Now create the dataset
    GDALDataset* pGDALDataSet = NULL;
-   pGDALDataSet = pGDALDriver->Create(strFilePathName.c_str(), 0, 0, 0, GDT_Unknown, m_papszGDALVectorOptions);
-   if (pGDALDataSet == NULL)
-   {
-      cerr << ERR << "cannot create " << m_strVectorGISOutFormat << " named " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
-      return false;
-   }
-
-   // Create the output layer
    OGRLayer* pOGRLayer = NULL;
    OGRSpatialReference* pOGRSpatialRef = NULL;     // TODO add spatial reference
    OGRwkbGeometryType eGType = wkbUnknown;
    string strType = "unknown";
+   bool bNewLayer = true;
 
-   pOGRLayer = pGDALDataSet->CreateLayer(strFilePathNameNoExt.c_str(), pOGRSpatialRef, eGType, m_papszGDALVectorOptions);
-   if (pOGRLayer == NULL)
+   if (m_nVectorGISContainer == VECTOR_CONTAINER_NONE)
    {
-      cerr << ERR << "cannot create '" << strType << "' layer in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
-      return false;
+      // Set up the vector driver
+      GDALDriver* pGDALDriver = GetGDALDriverManager()->GetDriverByName(m_strVectorGISOutFormat.c_str());
+      if (pGDALDriver == NULL)
+      {
+         cerr << ERR << "vector GIS output driver " << m_strVectorGISOutFormat << CPLGetLastErrorMsg() << endl;
+         return false;
+      }
+
+      // Now create the dataset
+      pGDALDataSet = pGDALDriver->Create(strFilePathName.c_str(), 0, 0, 0, GDT_Unknown, m_papszGDALVectorOptions);
+      if (pGDALDataSet == NULL)
+      {
+         cerr << ERR << "cannot create " << m_strVectorGISOutFormat << " named " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+         return false;
+      }
+
+      // Create the output layer
+      pOGRLayer = pGDALDataSet->CreateLayer(strFilePathNameNoExt.c_str(), pOGRSpatialRef, eGType, m_papszGDALVectorOptions);
+      if (pOGRLayer == NULL)
+      {
+         cerr << ERR << "cannot create '" << strType << "' layer in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+         return false;
+      }
+   }
+   else
+   {
+      // There is no layer for this data item, so nothing to write
+      if (strLayerName.empty())
+         return true;
+
+      // All vector output goes into a single container, with one layer per data item. Get the container (this creates it, if it is not already open)
+      pGDALDataSet = pGetVectorGISContainer();
+      if (pGDALDataSet == NULL)
+         return false;
+
+      strFilePathName = m_strVectorGISContainer;
+
+      // If the container holds the whole run, then the layer may already have been created at an earlier save
+      pOGRLayer = pGDALDataSet->GetLayerByName(strLayerName.c_str());
+      if (pOGRLayer != NULL)
+         bNewLayer = false;
+      else
+      {
+         pOGRLayer = pGDALDataSet->CreateLayer(strLayerName.c_str(), pOGRSpatialRef, eGType, m_papszGDALVectorOptions);
+         if (pOGRLayer == NULL)
+         {
+            cerr << ERR << "cannot create '" << strLayerName << "' layer in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+            return false;
+         }
+
+         if (m_nVectorGISContainer == VECTOR_CONTAINER_RUN)
+         {
+            // Each feature is tagged with the timestep and the save number, so that saves can be told apart
+            OGRFieldDefn
+               OGRFieldTimestep(VECTOR_CONTAINER_TIMESTEP_FIELD.c_str(), OFTInteger),
+               OGRFieldSave(VECTOR_CONTAINER_SAVE_FIELD.c_str(), OFTInteger);
+            if ((pOGRLayer->CreateField(&OGRFieldTimestep) != OGRERR_NONE) || (pOGRLayer->CreateField(&OGRFieldSave) != OGRERR_NONE))
+            {
+               cerr << ERR << "cannot create timestep attribute fields for '" << strLayerName << "' layer in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+               return false;
+            }
+         }
+      }
    }
 
+   // A single feature object (and its geometry) is re-used for every feature in the layer
+   OGRFeature* pOGRFeature = NULL;
+
    switch (nDataItem)
    {
       case (PLOT_COAST):
@@ -462,41 +512,36 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
          // The layer has been created, so create an integer-numbered value (the number of the coast object) for the multi-line
          string strFieldValue1 = "Coast";
          OGRFieldDefn OGRField1(strFieldValue1.c_str(), OFTInteger);
-         if (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 1 '" << strFieldValue1 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
-         // OK, now do features
-         OGRLineString OGRls;
+         // OK, now create features, re-using the feature object and its geometry
+         OGRLineString* pOGRls = new OGRLineString;
+         pOGRFeature = pStartVectorGISFeatures(pGDALDataSet, pOGRLayer);
+         pOGRFeature->SetGeometryDirectly(pOGRls);
 
          for (int i = 0; i < static_cast<int>(m_VCoast.size()); i++)
          {
-            // Create a feature object, one per coast
-            OGRFeature *pOGRFeature = NULL;
-            pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
-
             // Set the feature's attribute (the coast number)
             pOGRFeature->SetField(strFieldValue1.c_str(), i);
 
-            // Now attach a geometry to the feature object
-            for (int j = 0; j < m_VCoast[i].pLGetCoastline()->nGetSize(); j++)
+            // Now set the feature's geometry
+            int nPoints = m_VCoast[i].pLGetCoastline()->nGetSize();
+            pOGRls->setNumPoints(nPoints, FALSE);
+            for (int j = 0; j < nPoints; j++)
                //  In external CRS
-               OGRls.addPoint(m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetX(), m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetY());
-
-            pOGRFeature->SetGeometry(&OGRls);
+               pOGRls->setPoint(j, m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetX(), m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetY());
 
             // Create the feature in the output layer
-            if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
+            if (! bCreateVectorGISFeature(pGDALDataSet, pOGRLayer, pOGRFeature))
             {
                cerr << ERR << "cannot create  " << strType << " feature " << strPlotTitle << " for coast " << i << " in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+               AbandonVectorGISFeatures(pGDALDataSet, pOGRFeature);
                return false;
             }
-
-            // Tidy up: empty the line string and get rid of the feature object
-            OGRls.empty();
-            OGRFeature::DestroyFeature(pOGRFeature);
          }
 
          break;
@@ -511,7 +556,7 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
          // The layer has been created, so create an integer-numbered value (the number of the normal) associated with the line
          string strFieldValue1 = "Normal";
          OGRFieldDefn OGRField1(strFieldValue1.c_str(), OFTInteger);
-         if (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 1 '" << strFieldValue1 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
@@ -530,34 +575,36 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
             OGRField4(strFieldValue4.c_str(), OFTInteger),
             OGRField5(strFieldValue5.c_str(), OFTInteger),
             OGRField6(strFieldValue6.c_str(), OFTInteger);
-         if (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 2 '" << strFieldValue2 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
-         if (pOGRLayer->CreateField(&OGRField3) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField3) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 3 '" << strFieldValue3 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
-         if (pOGRLayer->CreateField(&OGRField4) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField4) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 4 '" << strFieldValue4 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
-         if (pOGRLayer->CreateField(&OGRField5) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField5) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 5 '" << strFieldValue5 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
-         if (pOGRLayer->CreateField(&OGRField6) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField6) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 6 '" << strFieldValue6 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
-         // OK, now create features
-         OGRLineString OGRls;
+         // OK, now create features, re-using the feature object and its geometry
+         OGRLineString* pOGRls = new OGRLineString;
+         pOGRFeature = pStartVectorGISFeatures(pGDALDataSet, pOGRLayer);
+         pOGRFeature->SetGeometryDirectly(pOGRls);
 
          for (int i = 0; i < static_cast<int>(m_VCoast.size()); i++)
          {
@@ -567,10 +614,6 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
 
                if (((nDataItem == PLOT_NORMALS) && (pProfile->bOKIncStartAndEndOfCoast())) || ((nDataItem == PLOT_INVALID_NORMALS) && (! pProfile->bOKIncStartAndEndOfCoast())))
                {
-                  // Create a feature object, one per profile
-                  OGRFeature *pOGRFeature = NULL;
-                  pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
-
                   // Set the feature's attributes
                   pOGRFeature->SetField(strFieldValue1.c_str(), j);
                   pOGRFeature->SetField(strFieldValue2.c_str(), 0);
@@ -589,22 +632,19 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
                   if (pProfile->bHitAnotherProfile())
                      pOGRFeature->SetField(strFieldValue6.c_str(), 1);
 
-                  // Now attach a geometry to the feature object
-                  for (int k = 0; k < pProfile->nGetProfileSize(); k++)
-                     OGRls.addPoint(pProfile->pPtGetPointInProfile(k)->dGetX(), pProfile->pPtGetPointInProfile(k)->dGetY());
-
-                  pOGRFeature->SetGeometry(&OGRls);
-                  OGRls.empty();
+                  // Now set the feature's geometry
+                  int nPoints = pProfile->nGetProfileSize();
+                  pOGRls->setNumPoints(nPoints, FALSE);
+                  for (int k = 0; k < nPoints; k++)
+                     pOGRls->setPoint(k, pProfile->pPtGetPointInProfile(k)->dGetX(), pProfile->pPtGetPointInProfile(k)->dGetY());
 
                   // Create the feature in the output layer
-                  if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
+                  if (! bCreateVectorGISFeature(pGDALDataSet, pOGRLayer, pOGRFeature))
                   {
                      cerr << ERR << "cannot create  " << strType << " feature " << strPlotTitle << " for coast " << i << " and profile " << j << " in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+                     AbandonVectorGISFeatures(pGDALDataSet, pOGRFeature);
                      return false;
                   }
-
-                  // Tidy up: get rid of the feature object
-                  OGRFeature::DestroyFeature(pOGRFeature);
                }
             }
          }
@@ -636,29 +676,24 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
             strFieldValue1 = "Notch";
 
          OGRFieldDefn OGRField1(strFieldValue1.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 1 '" << strFieldValue1 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
-         // OK, now create features
-         OGRLineString OGRls;
-         OGRMultiLineString OGRmls;
-         OGRPoint OGRPt;
+         // OK, now create features, re-using the feature object and its geometry
+         OGRPoint* pOGRPt = new OGRPoint;
+         pOGRFeature = pStartVectorGISFeatures(pGDALDataSet, pOGRLayer);
+         pOGRFeature->SetGeometryDirectly(pOGRPt);
 
          for (int i = 0; i < static_cast<int>(m_VCoast.size()); i++)
          {
             for (int j = 0; j < m_VCoast[i].pLGetCoastline()->nGetSize(); j++)
             {
-               // Create a feature object, one per coastline point
-               OGRFeature *pOGRFeature = NULL;
-               pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
-
                // Set the feature's geometry (in external CRS)
-               OGRPt.setX(m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetX());
-               OGRPt.setY(m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetY());
-               pOGRFeature->SetGeometry(&OGRPt);
+               pOGRPt->setX(m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetX());
+               pOGRPt->setY(m_VCoast[i].pPtGetVectorCoastlinePoint(j)->dGetY());
 
                if (nDataItem == PLOT_COAST_CURVATURE)
                {
@@ -677,7 +712,7 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
                else if (nDataItem == PLOT_MEAN_WAVE_ENERGY)
                {
                   // Set the feature's attribute
-                  double dEnergy = m_VCoast[i].pGetCoastLandform(j)->dGetTotAccumWaveEnergy();
+                  double dEnergy = m_VCoast[i].dGetTotAccumWaveEnergy(j);
                   dEnergy *= 24;
                   dEnergy /= m_dSimElapsed;     // Is in energy units per day
 
@@ -700,31 +735,23 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
                }
                else if (nDataItem == PLOT_CLIFF_NOTCH_SIZE)
                {
-                  CACoastLandform* pCoastLandform = m_VCoast[i].pGetCoastLandform(j);
-                  int nCategory = pCoastLandform->nGetLandFormCategory();
                   double dNotchOverhang = DBL_NODATA;
 
-                  if (nCategory == LF_CAT_CLIFF)
-                  {
-                     CRWCliff* pCliff = reinterpret_cast<CRWCliff*>(pCoastLandform);
-
-                     // Get attribute values from the cliff object
-                     dNotchOverhang = pCliff->dGetNotchOverhang();
-                  }
+                  // Get attribute values from the cliff
+                  if (m_VCoast[i].nGetLandformCategory(j) == LF_CAT_CLIFF)
+                     dNotchOverhang = m_VCoast[i].dGetCliffNotchOverhang(j);
 
                   // Set the feature's attribute
                   pOGRFeature->SetField(strFieldValue1.c_str(), dNotchOverhang);
                }
 
                // Create the feature in the output layer
-               if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
+               if (! bCreateVectorGISFeature(pGDALDataSet, pOGRLayer, pOGRFeature))
                {
                   cerr << ERR << "cannot create " << strType << " feature " << strPlotTitle << " for coast " << i << " point " << j << " in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+                  AbandonVectorGISFeatures(pGDALDataSet, pOGRFeature);
                   return false;
                }
-
-               // Get rid of the feature object
-               OGRFeature::DestroyFeature(pOGRFeature);
             }
          }
 
@@ -743,7 +770,7 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
 
          // Create the first field
          OGRFieldDefn OGRField1(strFieldValue1.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 1 '" << strFieldValue1 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
@@ -751,55 +778,57 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
 
          // Create the second field
          OGRFieldDefn OGRField2(strFieldValue2.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 2 '" << strFieldValue2 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
-         // OK, now create features
-         OGRLineString OGRls;
-         OGRMultiLineString OGRmls;
-         OGRPoint OGRPt;
+         // OK, now create features, re-using the feature object and its geometry
+         OGRPoint* pOGRPt = new OGRPoint;
+         pOGRFeature = pStartVectorGISFeatures(pGDALDataSet, pOGRLayer);
+         pOGRFeature->SetGeometryDirectly(pOGRPt);
 
+         // Only sea cells are output, so if the grid is tiled then only visit the tiles which have been in use during this timestep
+         vector<pair<int, int> > prVRun;
          for (int nX = 0; nX < m_nXGridMax; nX++)
          {
-            for (int nY = 0; nY < m_nYGridMax; nY++)
+            m_pRasterGrid->m_Cell.GetActiveRuns(nX, 1, &prVRun);
+            for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
             {
-               // Only output a value if the cell is a sea cell which is not in the active zone (wave height and angle values are meaningless if in the active zone)
-               if ((m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (! m_pRasterGrid->m_Cell[nX][nY].bIsInActiveZone()))
+               for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
                {
-                  // Create a feature object, one per sea cell
-                  OGRFeature *pOGRFeature = NULL;
-                  pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
-
-                  // Set the feature's geometry (in external CRS)
-                  OGRPt.setX(dGridCentroidXToExtCRSX(nX));
-                  OGRPt.setY(dGridCentroidYToExtCRSY(nY));
-                  pOGRFeature->SetGeometry(&OGRPt);
-
-                  double
-                     dOrientation = m_pRasterGrid->m_Cell[nX][nY].dGetWaveOrientation(),
-                     dHeight = m_pRasterGrid->m_Cell[nX][nY].dGetWaveHeight();
+                  // Only output a value if the cell is a sea cell which is not in the active zone (wave height and angle values are meaningless if in the active zone)
+                  if ((m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (! m_pRasterGrid->m_Cell[nX][nY].bIsInActiveZone()))
+                  {
+                     // Set the feature's geometry (in external CRS)
+                     pOGRPt->setX(dGridCentroidXToExtCRSX(nX));
+                     pOGRPt->setY(dGridCentroidYToExtCRSY(nY));
 
-                  if ((dHeight == DBL_NODATA) || (dOrientation == DBL_NODATA))
-                     continue;
+                     double
+                        dOrientation = m_pRasterGrid->m_Cell[nX][nY].dGetWaveOrientation(),
+                        dHeight = m_pRasterGrid->m_Cell[nX][nY].dGetWaveHeight();
 
-                  // Set the feature's attributes
-                  pOGRFeature->SetField(strFieldValue1.c_str(), dOrientation);
-                  pOGRFeature->SetField(strFieldValue2.c_str(), dHeight);
+                     if ((dHeight == DBL_NODATA) || (dOrientation == DBL_NODATA))
+                        continue;
 
-                  // Create the feature in the output layer
-                  if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
-                  {
-                     cerr << ERR << "cannot create " << strType << " feature " << strPlotTitle << " for cell [" << nX << "][" << nY << "] in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
-                     return false;
+                     // Set the feature's attributes
+                     pOGRFeature->SetField(strFieldValue1.c_str(), dOrientation);
+                     pOGRFeature->SetField(strFieldValue2.c_str(), dHeight);
+
+                     // Create the feature in the output layer
+                     if (! bCreateVectorGISFeature(pGDALDataSet, pOGRLayer, pOGRFeature))
+                     {
+                        cerr << ERR << "cannot create " << strType << " feature " << strPlotTitle << " for cell [" << nX << "][" << nY << "] in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+                        AbandonVectorGISFeatures(pGDALDataSet, pOGRFeature);
+                        return false;
+                     }
                   }
-
-                  // Get rid of the feature object
-                  OGRFeature::DestroyFeature(pOGRFeature);
                }
             }
+
+            // If the grid is tiled, this is a safe point to page out tiles
+            m_pRasterGrid->m_Cell.PageOutUnused();
          }
       break;
       }
@@ -816,7 +845,7 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
 
          // Create the first field
          OGRFieldDefn OGRField1(strFieldValue1.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 1 '" << strFieldValue1 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
@@ -824,29 +853,24 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
 
          // Create the second field
          OGRFieldDefn OGRField2(strFieldValue2.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 2 '" << strFieldValue2 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
-         // OK, now create features
-         OGRLineString OGRls;
-         OGRMultiLineString OGRmls;
-         OGRPoint OGRPt;
+         // OK, now create features, re-using the feature object and its geometry
+         OGRPoint* pOGRPt = new OGRPoint;
+         pOGRFeature = pStartVectorGISFeatures(pGDALDataSet, pOGRLayer);
+         pOGRFeature->SetGeometryDirectly(pOGRPt);
 
          for (int nX = 0; nX < m_nXGridMax; nX++)
          {
             for (int nY = 0; nY < m_nYGridMax; nY++)
             {
-               // Create a feature object, one per sea cell
-               OGRFeature *pOGRFeature = NULL;
-               pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
-
                // Set the feature's geometry (in external CRS)
-               OGRPt.setX(dGridCentroidXToExtCRSX(nX));
-               OGRPt.setY(dGridCentroidYToExtCRSY(nY));
-               pOGRFeature->SetGeometry(&OGRPt);
+               pOGRPt->setX(dGridCentroidXToExtCRSX(nX));
+               pOGRPt->setY(dGridCentroidYToExtCRSY(nY));
 
                double
                   dOrientation = m_pRasterGrid->m_Cell[nX][nY].dGetTotWaveOrientation() / m_ulTimestep,
@@ -860,15 +884,16 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
                pOGRFeature->SetField(strFieldValue2.c_str(), dHeight);
 
                // Create the feature in the output layer
-               if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
+               if (! bCreateVectorGISFeature(pGDALDataSet, pOGRLayer, pOGRFeature))
                {
                   cerr << ERR << "cannot create " << strType << " feature " << strPlotTitle << " for cell [" << nX << "][" << nY << "] in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+                  AbandonVectorGISFeatures(pGDALDataSet, pOGRFeature);
                   return false;
                }
-
-               // Get rid of the feature object
-               OGRFeature::DestroyFeature(pOGRFeature);
             }
+
+            // If the grid is tiled, this is a safe point to page out tiles
+            m_pRasterGrid->m_Cell.PageOutUnused();
          }
       break;
       }
@@ -888,58 +913,56 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
             strFieldValue6 = "CrsSedChng";
 
          OGRFieldDefn OGRField1(strFieldValue1.c_str(), OFTInteger);
-         if (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 1 '" << strFieldValue1 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
          OGRFieldDefn OGRField2(strFieldValue2.c_str(), OFTInteger);
-         if (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField2) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 2 '" << strFieldValue2 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
          OGRFieldDefn OGRField3(strFieldValue3.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField3) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField3) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 3 '" << strFieldValue3 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
          OGRFieldDefn OGRField4(strFieldValue4.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField4) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField4) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 4 '" << strFieldValue4 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
          OGRFieldDefn OGRField5(strFieldValue5.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField5) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField5) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 5 '" << strFieldValue5 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
          OGRFieldDefn OGRField6(strFieldValue6.c_str(), OFTReal);
-         if (pOGRLayer->CreateField(&OGRField6) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField6) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 6 '" << strFieldValue6 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
 
-         // OK, now do features
-         OGRLineString OGRls;
+         // OK, now create features, re-using the feature object and its geometry
+         OGRLineString* pOGRls = new OGRLineString;
+         pOGRFeature = pStartVectorGISFeatures(pGDALDataSet, pOGRLayer);
+         pOGRFeature->SetGeometryDirectly(pOGRls);
 
          for (int i = 0; i < static_cast<int>(m_VCoast.size()); i++)
          {
             for (int j = 0; j < m_VCoast[i].nGetNumPolygons(); j++)
             {
-               // Create a feature object, one per polygon
-               OGRFeature *pOGRFeature = NULL;
-               pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
-
                CGeomCoastPolygon* pPolygon = m_VCoast[i].pGetPolygon(j);
 
                // Set the feature's attributes
@@ -950,23 +973,20 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
                pOGRFeature->SetField(strFieldValue5.c_str(), pPolygon->dGetDeltaActualUnconsSand());
                pOGRFeature->SetField(strFieldValue6.c_str(), pPolygon->dGetDeltaActualUnconsCoarse());
 
-               // Now attach a geometry to the feature object
-               for (int n = 0; n < pPolygon->nGetBoundarySize(); n++)
+               // Now set the feature's geometry
+               int nPoints = pPolygon->nGetBoundarySize();
+               pOGRls->setNumPoints(nPoints, FALSE);
+               for (int n = 0; n < nPoints; n++)
                   //  In external CRS
-                  OGRls.addPoint(pPolygon->pPtGetBoundaryPoint(n)->dGetX(), pPolygon->pPtGetBoundaryPoint(n)->dGetY());
-
-               pOGRFeature->SetGeometry(&OGRls);
+                  pOGRls->setPoint(n, pPolygon->pPtGetBoundaryPoint(n)->dGetX(), pPolygon->pPtGetBoundaryPoint(n)->dGetY());
 
                // Create the feature in the output layer
-               if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
+               if (! bCreateVectorGISFeature(pGDALDataSet, pOGRLayer, pOGRFeature))
                {
                   cerr << ERR << "cannot create " << strType << " feature " << strPlotTitle << " for coast " << i << " polygon " << j << " in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+                  AbandonVectorGISFeatures(pGDALDataSet, pOGRFeature);
                   return false;
                }
-
-               // Tidy up: empty the line string and get rid of the feature object
-               OGRls.empty();
-               OGRFeature::DestroyFeature(pOGRFeature);
             }
          }
 
@@ -981,43 +1001,37 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
          // Create an integer-numbered value (the number of the shadow zone line object) for the multi-line
          string strFieldValue1 = "ShadowLine";
          OGRFieldDefn OGRField1(strFieldValue1.c_str(), OFTInteger);
-         if (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE)
+         if (bNewLayer && (pOGRLayer->CreateField(&OGRField1) != OGRERR_NONE))
          {
             cerr << ERR << "cannot create " << strType << " attribute field 1 '" << strFieldValue1 << "' in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
             return false;
          }
          
-         // OK, now do features
-         OGRLineString OGRls;
+         // OK, now create features, re-using the feature object and its geometry
+         OGRLineString* pOGRls = new OGRLineString;
+         pOGRFeature = pStartVectorGISFeatures(pGDALDataSet, pOGRLayer);
+         pOGRFeature->SetGeometryDirectly(pOGRls);
          
          for (int i = 0; i < static_cast<int>(m_VCoast.size()); i++)
          {
             for (int j = 0; j < m_VCoast[i].nGetNumShadowZoneBoundaries(); j++)
             {
-               // Create a feature object, one per coast
-               OGRFeature *pOGRFeature = NULL;
-               pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
-               
                // Set the feature's attribute (the shadow zone line number)
                pOGRFeature->SetField(strFieldValue1.c_str(), j);
                
-               // Now attach a geometry to the feature object
-               CGeomLine LShadow = *m_VCoast[i].pGetShadowZoneBoundary(j);
-               OGRls.addPoint(LShadow.dGetXAt(0), LShadow.dGetYAt(0));
-               OGRls.addPoint(LShadow.dGetXAt(1), LShadow.dGetYAt(1));
-               
-               pOGRFeature->SetGeometry(&OGRls);
+               // Now set the feature's geometry
+               CGeomLine* pLShadow = m_VCoast[i].pGetShadowZoneBoundary(j);
+               pOGRls->setNumPoints(2, FALSE);
+               pOGRls->setPoint(0, pLShadow->dGetXAt(0), pLShadow->dGetYAt(0));
+               pOGRls->setPoint(1, pLShadow->dGetXAt(1), pLShadow->dGetYAt(1));
                
                // Create the feature in the output layer
-               if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
+               if (! bCreateVectorGISFeature(pGDALDataSet, pOGRLayer, pOGRFeature))
                {
                   cerr << ERR << "cannot create  " << strType << " feature " << strPlotTitle << j << " for coast " << i << " in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+                  AbandonVectorGISFeatures(pGDALDataSet, pOGRFeature);
                   return false;
                }
-               
-               // Tidy up: empty the line string and get rid of the feature object
-               OGRls.empty();
-               OGRFeature::DestroyFeature(pOGRFeature);
             }
          }
          
@@ -1025,8 +1039,181 @@ bool CSimulation::bWriteVectorGIS(int const nDataItem, string const* strPlotTitl
       }
    }
 
-   // Get rid of the dataset object
-   GDALClose(pGDALDataSet);
+   // Commit any outstanding features, and get rid of the feature object
+   if (! bEndVectorGISFeatures(pGDALDataSet, pOGRFeature))
+   {
+      cerr << ERR << "cannot commit " << strPlotTitle << " features in " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+      return false;
+   }
+
+   // Get rid of the dataset object, unless it is a container which will also hold later output
+   if (m_nVectorGISContainer == VECTOR_CONTAINER_NONE)
+      GDALClose(pGDALDataSet);
 
    return true;
 }
+
+
+/*==============================================================================================================================
+
+ Returns the dataset which holds all vector GIS output for this save, or for the whole run. The dataset is created if it is not already open
+
+===============================================================================================================================*/
+GDALDataset* CSimulation::pGetVectorGISContainer(void)
+{
+   if (m_pGDALVectorContainer != NULL)
+      return m_pGDALVectorContainer;
+
+   string strFilePathName(m_strOutPath);
+   strFilePathName.append(VECTOR_CONTAINER_NAME);
+
+   if (m_nVectorGISContainer == VECTOR_CONTAINER_SAVE)
+   {
+      // Append the 'save number' to the filename, and prepend zeros to the save number
+      strFilePathName.append("_");
+      stringstream ststrTmp;
+      ststrTmp << FillToWidth('0', MAX_SAVE_DIGITS) << m_nGISSave;
+      strFilePathName.append(ststrTmp.str());
+   }
+
+   // If desired, append an extension. But not for shapefiles: without an extension, a directory is created which holds one shapefile per layer
+   if ((! m_strOGRVectorOutputExtension.empty()) && (m_strVectorGISOutFormat != "ESRI Shapefile"))
+      strFilePathName.append(m_strOGRVectorOutputExtension);
+
+   // Set up the vector driver
+   GDALDriver* pGDALDriver = GetGDALDriverManager()->GetDriverByName(m_strVectorGISOutFormat.c_str());
+   if (pGDALDriver == NULL)
+   {
+      cerr << ERR << "vector GIS output driver " << m_strVectorGISOutFormat << CPLGetLastErrorMsg() << endl;
+      return NULL;
+   }
+
+   // Now create the dataset
+   m_pGDALVectorContainer = pGDALDriver->Create(strFilePathName.c_str(), 0, 0, 0, GDT_Unknown, m_papszGDALVectorOptions);
+   if (m_pGDALVectorContainer == NULL)
+   {
+      cerr << ERR << "cannot create " << m_strVectorGISOutFormat << " named " << strFilePathName << "\n" << CPLGetLastErrorMsg() << endl;
+      return NULL;
+   }
+
+   m_strVectorGISContainer = strFilePathName;
+
+   return m_pGDALVectorContainer;
+}
+
+
+/*==============================================================================================================================
+
+ Closes the dataset which holds all vector GIS output, if it is open
+
+===============================================================================================================================*/
+void CSimulation::CloseVectorGISContainer(void)
+{
+   if (m_pGDALVectorContainer != NULL)
+   {
+      GDALClose(m_pGDALVectorContainer);
+      m_pGDALVectorContainer = NULL;
+   }
+}
+
+
+/*==============================================================================================================================
+
+ Gets ready to write features to a vector GIS layer. Returns a feature object, which is then re-used for every feature in the layer. If the driver supports transactions, one is started: this is much quicker than having the driver commit each feature as it is created
+
+===============================================================================================================================*/
+OGRFeature* CSimulation::pStartVectorGISFeatures(GDALDataset* pGDALDataSet, OGRLayer* pOGRLayer)
+{
+   m_bVectorGISTransaction = false;
+   m_nVectorGISTransactionFeatures = 0;
+
+   if (pGDALDataSet->TestCapability(ODsCTransactions) && (pGDALDataSet->StartTransaction() == OGRERR_NONE))
+   {
+      m_bVectorGISTransaction = true;
+      m_ulTotVectorGISTransactions++;
+   }
+
+   OGRFeature* pOGRFeature = OGRFeature::CreateFeature(pOGRLayer->GetLayerDefn());
+
+   // If the container holds the whole run, tag the features with the timestep and the save number. Since the feature object is re-used, this only needs doing once
+   if (m_nVectorGISContainer == VECTOR_CONTAINER_RUN)
+   {
+      pOGRFeature->SetField(VECTOR_CONTAINER_TIMESTEP_FIELD.c_str(), static_cast<int>(m_ulTimestep));
+      pOGRFeature->SetField(VECTOR_CONTAINER_SAVE_FIELD.c_str(), m_nGISSave);
+   }
+
+   return pOGRFeature;
+}
+
+
+/*==============================================================================================================================
+
+ Creates a feature in a vector GIS layer. If a transaction is in progress, it is committed (and another is started) after every VECTOR_GIS_TRANSACTION_FEATURES features
+
+===============================================================================================================================*/
+bool CSimulation::bCreateVectorGISFeature(GDALDataset* pGDALDataSet, OGRLayer* pOGRLayer, OGRFeature* pOGRFeature)
+{
+   // The feature object is re-used, so unset its ID (which was set when the previous feature was created) so that the driver assigns a new one
+   pOGRFeature->SetFID(OGRNullFID);
+
+   if (pOGRLayer->CreateFeature(pOGRFeature) != OGRERR_NONE)
+      return false;
+
+   m_ulTotVectorGISFeatures++;
+
+   if (m_bVectorGISTransaction && (++m_nVectorGISTransactionFeatures >= VECTOR_GIS_TRANSACTION_FEATURES))
+   {
+      if (pGDALDataSet->CommitTransaction() != OGRERR_NONE)
+      {
+         m_bVectorGISTransaction = false;
+         return false;
+      }
+
+      m_nVectorGISTransactionFeatures = 0;
+      if (pGDALDataSet->StartTransaction() == OGRERR_NONE)
+         m_ulTotVectorGISTransactions++;
+      else
+         m_bVectorGISTransaction = false;
+   }
+
+   return true;
+}
+
+
+/*==============================================================================================================================
+
+ Finishes writing features to a vector GIS layer: commits any transaction which is in progress, and gets rid of the feature object
+
+===============================================================================================================================*/
+bool CSimulation::bEndVectorGISFeatures(GDALDataset* pGDALDataSet, OGRFeature* pOGRFeature)
+{
+   if (pOGRFeature != NULL)
+      OGRFeature::DestroyFeature(pOGRFeature);
+
+   if (m_bVectorGISTransaction)
+   {
+      m_bVectorGISTransaction = false;
+      if (pGDALDataSet->CommitTransaction() != OGRERR_NONE)
+         return false;
+   }
+
+   return true;
+}
+
+
+/*==============================================================================================================================
+
+ Gives up writing features to a vector GIS layer after an error: rolls back any transaction which is in progress, and gets rid of the feature object
+
+===============================================================================================================================*/
+void CSimulation::AbandonVectorGISFeatures(GDALDataset* pGDALDataSet, OGRFeature* pOGRFeature)
+{
+   if (pOGRFeature != NULL)
+      OGRFeature::DestroyFeature(pOGRFeature);
+
+   if (m_bVectorGISTransaction)
+   {
+      m_bVectorGISTransaction = false;
+      pGDALDataSet->RollbackTransaction();
+   }
+}
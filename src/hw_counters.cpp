@@ -0,0 +1,168 @@
+/*!
+ *
+ * \file hw_counters.cpp
+ * \brief Globally-available routines for reading hardware performance counters
+ * \details Uses the Linux perf_event_open() system call to count CPU cycles, instructions retired, last-level cache misses and branch mispredictions. Only user-space events are counted, so this works with the default perf_event_paranoid setting. The counters are inherited by threads created after they are opened, so work done by OpenMP threads is included provided that the counters are opened before the first parallel region. If the kernel or the hardware (e.g. in a virtual machine or container) does not support a counter, then it is simply marked as unavailable. On other platforms, no counters are available
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*==============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+==============================================================================================================================*/
+#ifdef __linux__
+   #include <linux/perf_event.h>
+   #include <sys/ioctl.h>
+   #include <sys/syscall.h>
+   #include <unistd.h>
+
+   #include <cstring>
+   using std::memset;
+#endif
+
+#include "cme.h"
+
+
+#ifdef __linux__
+// One file descriptor per counter, -1 if the counter is not available
+static int s_nCounterFile[NUM_HW_COUNTERS] = { -1, -1, -1, -1 };
+
+// The perf_event type of each counter
+static unsigned long long const s_ullCounterConfig[NUM_HW_COUNTERS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+
+/*==============================================================================================================================
+
+ Opens a single hardware counter for this process, and for any threads which it creates later. Returns the file descriptor, or -1 if this cannot be done
+
+==============================================================================================================================*/
+static int nOpenCounter(unsigned long long const ullConfig)
+{
+   perf_event_attr Attr;
+   memset(&Attr, 0, sizeof(Attr));
+   Attr.size = sizeof(Attr);
+   Attr.type = PERF_TYPE_HARDWARE;
+   Attr.config = ullConfig;
+   Attr.disabled = 1;
+   Attr.inherit = 1;
+   Attr.exclude_kernel = 1;
+   Attr.exclude_hv = 1;
+
+   // If there are more counters than the CPU has registers, the kernel time-slices them: so ask for the times needed to scale up the count
+   Attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+   // There is no glibc wrapper for this
+   return static_cast<int>(syscall(__NR_perf_event_open, &Attr, 0, -1, -1, 0));
+}
+#endif
+
+
+/*==============================================================================================================================
+
+ Opens and starts all the hardware counters which are available. Must be called before any OpenMP threads are created. Returns false if no counters are available
+
+==============================================================================================================================*/
+bool bStartHWCounters(void)
+{
+#ifdef __linux__
+   bool bAny = false;
+   for (int n = 0; n < NUM_HW_COUNTERS; n++)
+   {
+      s_nCounterFile[n] = nOpenCounter(s_ullCounterConfig[n]);
+      if (s_nCounterFile[n] < 0)
+         continue;
+
+      // Check that the counter can actually be read: some virtualized environments allow the counter to be opened, but it never runs
+      ioctl(s_nCounterFile[n], PERF_EVENT_IOC_ENABLE, 0);
+      unsigned long long ullValue[3];
+      if (read(s_nCounterFile[n], ullValue, sizeof(ullValue)) != sizeof(ullValue))
+      {
+         close(s_nCounterFile[n]);
+         s_nCounterFile[n] = -1;
+         continue;
+      }
+
+      bAny = true;
+   }
+
+   return bAny;
+#else
+   return false;
+#endif
+}
+
+
+/*==============================================================================================================================
+
+ Stops and closes all hardware counters
+
+==============================================================================================================================*/
+void StopHWCounters(void)
+{
+#ifdef __linux__
+   for (int n = 0; n < NUM_HW_COUNTERS; n++)
+   {
+      if (s_nCounterFile[n] >= 0)
+      {
+         close(s_nCounterFile[n]);
+         s_nCounterFile[n] = -1;
+      }
+   }
+#endif
+}
+
+
+/*==============================================================================================================================
+
+ Returns true if the given hardware counter is available
+
+==============================================================================================================================*/
+bool bHWCounterAvailable(int const nCounter)
+{
+#ifdef __linux__
+   return (s_nCounterFile[nCounter] >= 0);
+#else
+   return false;
+#endif
+}
+
+
+/*==============================================================================================================================
+
+ Reads the current value of every hardware counter into an array of NUM_HW_COUNTERS values. Counters which are not available, or which cannot be read, are set to zero. If the kernel had to time-slice a counter, then its value is scaled up to estimate the full count
+
+==============================================================================================================================*/
+void ReadHWCounters(unsigned long long* pullValue)
+{
+   for (int n = 0; n < NUM_HW_COUNTERS; n++)
+   {
+      pullValue[n] = 0;
+
+#ifdef __linux__
+      if (s_nCounterFile[n] < 0)
+         continue;
+
+      // The value, then the time enabled and the time running
+      unsigned long long ullRead[3];
+      if (read(s_nCounterFile[n], ullRead, sizeof(ullRead)) != sizeof(ullRead))
+         continue;
+
+      if ((ullRead[2] > 0) && (ullRead[2] < ullRead[1]))
+         pullValue[n] = static_cast<unsigned long long>(static_cast<double>(ullRead[0]) * ullRead[1] / ullRead[2]);
+      else
+         pullValue[n] = ullRead[0];
+#endif
+   }
+}
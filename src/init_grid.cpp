@@ -33,6 +33,7 @@ using std::endl;
 #include "coast.h"
 #include "simulation.h"
 #include "raster_grid.h"
+#include "arena.h"
 
 
 /*===============================================================================================================================
@@ -42,10 +43,26 @@ using std::endl;
 ===============================================================================================================================*/
 int CSimulation::nInitGridAndCalcStillWaterLevel(void)
 {
-   // Clear all vector coastlines, profiles, and polygons
-   m_VCoast.clear();
+   // Clear all vector coastlines, profiles, and polygons. If we are re-tracing coastlines incrementally, or caching rasterized profiles, then keep the previous timestep's coastlines
+   if (m_bIncrementalCoastTrace || m_bCacheProfileRaster)
+   {
+      m_VPrevCoast.clear();
+      m_VPrevCoast.swap(m_VCoast);
+   }
+   else
+      m_VCoast.clear();
    m_pVCoastPolygon.clear();
 
+   if (m_bUseTimestepArena)
+   {
+      // Nothing now remains in the arena which was used two timesteps ago (any coasts from the last timestep were allocated from the other arena) so swap the arenas, then reset the one which we will use this timestep
+      CArena* pTmp = m_pLastTimestepArena;
+      m_pLastTimestepArena = m_pThisTimestepArena;
+      m_pThisTimestepArena = pTmp;
+
+      m_pThisTimestepArena->Reset();
+   }
+
    // Do some every-timestep initialization
    m_nXMinBoundingBox                              = INT_MAX;
    m_nXMaxBoundingBox                              = INT_MIN;
@@ -105,7 +122,14 @@ int CSimulation::nInitGridAndCalcStillWaterLevel(void)
    // For the time being, and since we assume wave height and period constant just use the actual wave height and period to calculate the depth of closure
    m_dDepthOfClosure = (2.28 * m_dDeepWaterWaveHeight) - (68.5 * m_dDeepWaterWaveHeight * m_dDeepWaterWaveHeight / (m_dG * m_dWavePeriod * m_dWavePeriod));
 
-   // And go through all cells in the RasterGrid array
+   // If this is not the first timestep, initialize values for all cells. If the grid is tiled, only the tiles which are in memory are initialized now: the others are initialized when next paged in, so tiles far from the sea are not paged in each timestep just for this
+   if (m_ulTimestep > 1)
+   {
+      m_pRasterGrid->m_Cell.InitCells();
+      return RTN_OK;
+   }
+
+   // This is the first timestep, so go through all cells in the RasterGrid array
    unsigned int nZeroThickness = 0;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
@@ -114,21 +138,20 @@ int CSimulation::nInitGridAndCalcStillWaterLevel(void)
          // Initialize values for this cell
          m_pRasterGrid->m_Cell[nX][nY].InitCell();
 
-         if (m_ulTimestep == 1)
+         // Check to see that all cells have some sediment on them
+         double dSedThickness = m_pRasterGrid->m_Cell[nX][nY].dGetTotAllSedThickness();
+         if (dSedThickness <= 0)
          {
-            // Check to see that all cells have some sediment on them
-            double dSedThickness = m_pRasterGrid->m_Cell[nX][nY].dGetTotAllSedThickness();
-            if (dSedThickness <= 0)
-            {
-               nZeroThickness++;
-               
-               LogStream << m_ulTimestep << ": " << WARN << "total sediment thickness is " << dSedThickness << " at [" << nX << "][" << nY << "] {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
-            }
-
-            // For the first timestep only, calculate the elevation of all this cell's layers. During the rest of the simulation, each cell's elevation is re-calculated just after any change occurs on that cell
-            m_pRasterGrid->m_Cell[nX][nY].CalcAllLayerElevsAndD50();
+            nZeroThickness++;
+            
+            LogStream << m_ulTimestep << ": " << WARN << "total sediment thickness is " << dSedThickness << " at [" << nX << "][" << nY << "] {" << dGridCentroidXToExtCRSX(nX) << ", " << dGridCentroidYToExtCRSY(nY) << "}" << endl;
          }
+
+         // For the first timestep only, calculate the elevation of all this cell's layers. During the rest of the simulation, each cell's elevation is re-calculated just after any change occurs on that cell
+         m_pRasterGrid->m_Cell[nX][nY].CalcAllLayerElevsAndD50();
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
    
    if (nZeroThickness > 0)
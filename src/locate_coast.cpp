@@ -46,6 +46,7 @@ using std::stack;
 #include "simulation.h"
 #include "raster_grid.h"
 #include "coast.h"
+#include "profile_raster_cache.h"
 
 
 /*===============================================================================================================================
@@ -58,10 +59,23 @@ int CSimulation::nLocateSeaAndCoasts(void)
    // Find all connected sea cells
    FindAllSeaCells();
 
-   // Find every coastline on the raster grid, mark raster cells, then create the vector coastline
+   if (m_bCacheProfileRaster)
+   {
+      // None of last timestep's coastlines have yet been re-traced
+      m_bVPrevCoastReTraced.assign(m_VPrevCoast.size(), false);
+
+      m_PtiVPrevAbandonedCoastCell.swap(m_PtiVAbandonedCoastCell);
+      m_PtiVAbandonedCoastCell.clear();
+   }
+
+   // Find every coastline on the raster grid, mark raster cells, then create the vector coastline. If profiles are cached, then cached profiles which touch a changed part of a re-traced coastline are got rid of here
    int nRet = nTraceAllCoasts();
    if (nRet != RTN_OK)
       return nRet;
+
+   // Also get rid of cached profiles which touch other cells which have changed coast status since last timestep
+   if (m_bCacheProfileRaster)
+      UpdateProfileRasterCache();
    
    // Have we created any coasts?
    if (m_VCoast.empty())
@@ -74,6 +88,31 @@ int CSimulation::nLocateSeaAndCoasts(void)
 }
 
 
+/*===============================================================================================================================
+
+ Tells the profile raster cache about the cells which have changed coast status since last timestep, but which are not on the changed part of a re-traced coastline: i.e. the cells of last timestep's coastlines which have not been re-traced, and the cells of abandoned coastlines (these remain marked as coastline) this timestep and last timestep. Cached profiles which touch any of these cells are invalidated
+
+===============================================================================================================================*/
+void CSimulation::UpdateProfileRasterCache(void)
+{
+   for (unsigned int n = 0; n < m_VPrevCoast.size(); n++)
+   {
+      if (m_bVPrevCoastReTraced[n])
+         continue;
+
+      CGeomILine* pILPrev = m_VPrevCoast[n].pILGetTracedCells();
+      for (int j = 0; j < pILPrev->nGetSize(); j++)
+         m_pProfileRasterCache->CellChanged((*pILPrev)[j].nGetX(), (*pILPrev)[j].nGetY());
+   }
+
+   for (unsigned int n = 0; n < m_PtiVPrevAbandonedCoastCell.size(); n++)
+      m_pProfileRasterCache->CellChanged(m_PtiVPrevAbandonedCoastCell[n].nGetX(), m_PtiVPrevAbandonedCoastCell[n].nGetY());
+
+   for (unsigned int n = 0; n < m_PtiVAbandonedCoastCell.size(); n++)
+      m_pProfileRasterCache->CellChanged(m_PtiVAbandonedCoastCell[n].nGetX(), m_PtiVAbandonedCoastCell[n].nGetY());
+}
+
+
 /*===============================================================================================================================
 
  Finds and flags all sea areas which have at least one cell at a grid edge (i.e. does not flag 'inland' seas)
@@ -932,6 +971,13 @@ int CSimulation::nTraceCoastLine(int const nStartSearchDirection, int const nHan
       // Could not find the other end of the coastline
       LogStream << WARN << m_ulTimestep << ": abandoned tracing coastline from [" << nStartX << "][" << nStartY << "] {" << dGridCentroidXToExtCRSX(nStartX) << ", " << dGridCentroidYToExtCRSY(nStartY) << "} to [" << LTempGridCRS[nCoastSize-1].nGetX() << "][" << LTempGridCRS[nCoastSize-1].nGetY() << "] {" << dGridCentroidXToExtCRSX(LTempGridCRS[nCoastSize-1].nGetX()) << ", " << dGridCentroidYToExtCRSY(LTempGridCRS[nCoastSize-1].nGetY()) << "} after " << nRoundTheLoop << " iterations" << endl;
 
+      // These cells remain marked as coastline, but are not part of any coastline object, so the profile raster cache must be told about them separately
+      if (m_bCacheProfileRaster)
+      {
+         for (int n = 0; n < nCoastSize; n++)
+            m_PtiVAbandonedCoastCell.push_back(LTempGridCRS[n]);
+      }
+
       return RTN_OK;
    }
 
@@ -995,17 +1041,106 @@ int CSimulation::nTraceCoastLine(int const nStartSearchDirection, int const nHan
    for (int j = 0; j < nCoastSize; j++)
       LTempExtCRS.Append(dGridCentroidXToExtCRSX(LTempGridCRS[j].nGetX()), dGridCentroidYToExtCRSY(LTempGridCRS[j].nGetY()));
 
+   // If we are re-tracing incrementally, or caching rasterized profiles, look for the previous timestep's version of this coastline: it must start at the same cell, and have the same handedness and start and end edges
+   CRWCoast* pPrevCoast = NULL;
+   int
+      nSameAtStart = 0,
+      nSameAtEnd = 0;
+   if (m_bIncrementalCoastTrace || m_bCacheProfileRaster)
+   {
+      for (unsigned int n = 0; n < m_VPrevCoast.size(); n++)
+      {
+         CGeomILine* pILPrev = m_VPrevCoast[n].pILGetTracedCells();
+         if ((pILPrev->nGetSize() > 0) && ((*pILPrev)[0] == LTempGridCRS[0]) && (m_VPrevCoast[n].nGetSeaHandedness() == nHandedness) && (m_VPrevCoast[n].nGetStartEdge() == nStartEdge) && (m_VPrevCoast[n].nGetEndEdge() == nEndEdge))
+         {
+            pPrevCoast = &m_VPrevCoast[n];
+
+            if (m_bCacheProfileRaster)
+               m_bVPrevCoastReTraced[n] = true;
+
+            break;
+         }
+      }
+
+      if (pPrevCoast != NULL)
+      {
+         // Found it, so see how many traced cells at the start and at the end of the coastline are unchanged since last timestep
+         CGeomILine* pILPrev = pPrevCoast->pILGetTracedCells();
+         int
+            nPrevSize = pILPrev->nGetSize(),
+            nMaxSame = tMin(nCoastSize, nPrevSize);
+
+         while ((nSameAtStart < nMaxSame) && ((*pILPrev)[nSameAtStart] == LTempGridCRS[nSameAtStart]))
+            nSameAtStart++;
+
+         while ((nSameAtStart + nSameAtEnd < nMaxSame) && ((*pILPrev)[nPrevSize-1-nSameAtEnd] == LTempGridCRS[nCoastSize-1-nSameAtEnd]))
+            nSameAtEnd++;
+      }
+
+      if (m_bCacheProfileRaster)
+      {
+         // Only the cells on the changed part of the coastline (as it was last timestep, and as it is now) have changed coast status, so get rid of any cached profiles which touch these cells. If this coastline was not here last timestep, then all its cells have changed
+         if (pPrevCoast != NULL)
+         {
+            CGeomILine* pILPrev = pPrevCoast->pILGetTracedCells();
+            for (int j = nSameAtStart; j < pILPrev->nGetSize() - nSameAtEnd; j++)
+               m_pProfileRasterCache->CellChanged((*pILPrev)[j].nGetX(), (*pILPrev)[j].nGetY());
+         }
+
+         for (int j = nSameAtStart; j < nCoastSize - nSameAtEnd; j++)
+            m_pProfileRasterCache->CellChanged(LTempGridCRS[j].nGetX(), LTempGridCRS[j].nGetY());
+      }
+
+      // The rest of this routine only makes use of last timestep's coastline if we are re-tracing incrementally
+      if (! m_bIncrementalCoastTrace)
+         pPrevCoast = NULL;
+   }
+
    // Now do some smoothing of the vector output, if desired
-   if (m_nCoastSmooth == SMOOTH_RUNNING_MEAN)
-      LTempExtCRS = LSmoothCoastRunningMean(&LTempExtCRS, nStartEdge, nEndEdge);
-   else if (m_nCoastSmooth == SMOOTH_SAVITZKY_GOLAY)
-      LTempExtCRS = LSmoothCoastSavitzkyGolay(&LTempExtCRS, nStartEdge, nEndEdge);
+   if (pPrevCoast == NULL)
+   {
+      if (m_nCoastSmooth == SMOOTH_RUNNING_MEAN)
+         LTempExtCRS = LSmoothCoastRunningMean(&LTempExtCRS, nStartEdge, nEndEdge);
+      else if (m_nCoastSmooth == SMOOTH_SAVITZKY_GOLAY)
+         LTempExtCRS = LSmoothCoastSavitzkyGolay(&LTempExtCRS, nStartEdge, nEndEdge);
+   }
+   else if (m_nCoastSmooth != SMOOTH_NONE)
+   {
+      // Only smooth the changed part of the coastline, plus the filter half-width either side. Elsewhere, the smoothed points must be the same as last timestep
+      int
+         nHalfWindow = m_nCoastSmoothWindow / 2,
+         nSizeChange = nCoastSize - pPrevCoast->pILGetTracedCells()->nGetSize(),
+         nFirst = nSameAtStart - nHalfWindow,
+         nLast = nCoastSize - nSameAtEnd + nHalfWindow - 1;
+
+      CGeomLine LSmoothed;
+      if (m_nCoastSmooth == SMOOTH_RUNNING_MEAN)
+         LSmoothed = LSmoothCoastRunningMean(&LTempExtCRS, nStartEdge, nEndEdge, nFirst, nLast);
+      else
+         LSmoothed = LSmoothCoastSavitzkyGolay(&LTempExtCRS, nStartEdge, nEndEdge, nFirst, nLast);
+
+      CGeomLine* pLPrevSmoothed = pPrevCoast->pLGetTracedSmoothed();
+      for (int j = 0; j < nFirst; j++)
+         LSmoothed[j] = (*pLPrevSmoothed)[j];
+
+      for (int j = tMax(nLast+1, 0); j < nCoastSize; j++)
+         LSmoothed[j] = (*pLPrevSmoothed)[j - nSizeChange];
+
+      LTempExtCRS = LSmoothed;
+   }
 
    // Create a new coastline object and append to it the vector of coastline objects
-   CRWCoast CoastTmp;
+   CRWCoast CoastTmp(m_pThisTimestepArena);
    m_VCoast.push_back(CoastTmp);
    int nCoast = m_VCoast.size()-1;
 
+   if (m_bIncrementalCoastTrace || m_bCacheProfileRaster)
+   {
+      // Keep the traced cells and their smoothed equivalents, for use next timestep
+      m_VCoast[nCoast].SetTracedCells(&LTempGridCRS);
+      m_VCoast[nCoast].SetTracedSmoothed(&LTempExtCRS);
+   }
+
    CGeom2DPoint PtLast(DBL_MIN, DBL_MIN);
    for (int j = 0; j < nCoastSize; j++)
    {
@@ -1051,11 +1186,31 @@ int CSimulation::nTraceCoastLine(int const nStartSearchDirection, int const nHan
 //       LogStream << kk << " [" << m_VCoast.back().pPtiGetCellMarkedAsCoastline(kk)->nGetX() << "][" << m_VCoast.back().pPtiGetCellMarkedAsCoastline(kk)->nGetY() << "] {" << dGridCentroidXToExtCRSX(m_VCoast.back().pPtiGetCellMarkedAsCoastline(kk)->nGetX()) << ", " << dGridCentroidYToExtCRSY(m_VCoast.back().pPtiGetCellMarkedAsCoastline(kk)->nGetY()) << "}" << endl;
 //    LogStream << "-----------------" << endl;  
 
+   // If we have the previous timestep's version of this coastline, find how many vector coastline points at the start and at the end are unchanged
+   int
+      nSamePointsAtStart = 0,
+      nSamePointsAtEnd = 0;
+   if (pPrevCoast != NULL)
+   {
+      int
+         nNewSize = m_VCoast[nCoast].nGetCoastlineSize(),
+         nPrevSize = pPrevCoast->nGetCoastlineSize(),
+         nMaxSame = tMin(nNewSize, nPrevSize);
+
+      while ((nSamePointsAtStart < nMaxSame) && (*pPrevCoast->pPtGetVectorCoastlinePoint(nSamePointsAtStart) == m_VCoast[nCoast].pPtGetVectorCoastlinePoint(nSamePointsAtStart)))
+         nSamePointsAtStart++;
+
+      while ((nSamePointsAtStart + nSamePointsAtEnd < nMaxSame) && (*pPrevCoast->pPtGetVectorCoastlinePoint(nPrevSize-1-nSamePointsAtEnd) == m_VCoast[nCoast].pPtGetVectorCoastlinePoint(nNewSize-1-nSamePointsAtEnd)))
+         nSamePointsAtEnd++;
+
+      LogStream << m_ulTimestep << ": coastline " << nCoast << " re-traced incrementally, " << nSamePointsAtStart << " points unchanged at start and " << nSamePointsAtEnd << " at end" << endl;
+   }
+
    // Next calculate the curvature of the vector coastline
-   DoCoastCurvature(nCoast, nHandedness);
+   DoCoastCurvature(nCoast, nHandedness, pPrevCoast, nSamePointsAtStart, nSamePointsAtEnd);
 
    // Calculate values for the coast's flux orientation vector
-   CalcCoastTangents(nCoast);
+   CalcCoastTangents(nCoast, pPrevCoast, nSamePointsAtStart, nSamePointsAtEnd);
    
    return RTN_OK;
 }
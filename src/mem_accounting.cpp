@@ -0,0 +1,265 @@
+/*!
+ *
+ * \file mem_accounting.cpp
+ * \brief Globally-available routines for counting heap allocations and measuring memory use
+ * \details The global operator new and operator delete are replaced, so that (when switched on) every C++ heap allocation is counted, as are the bytes requested. Allocations made by C code (e.g. inside GDAL) are not counted, but do show up in the resident set size. The resident set size is read from /proc, so is only available on Linux
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*==============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+==============================================================================================================================*/
+#include <atomic>
+using std::atomic;
+using std::memory_order_relaxed;
+
+#include <cstdlib>
+using std::malloc;
+using std::free;
+using std::strtod;
+
+#include <cstring>
+using std::strstr;
+
+#include <new>
+using std::bad_alloc;
+using std::new_handler;
+using std::nothrow_t;
+
+#ifdef __linux__
+   #include <fcntl.h>
+   #include <unistd.h>
+#endif
+
+#include "cme.h"
+
+
+// These are used by the replacement operator new, so must be initialized before any allocation is made: this is guaranteed since they are constant-initialized
+static atomic<bool> s_bCountAllocs(false);
+static atomic<unsigned long long>
+   s_ullNumAllocs(0),
+   s_ullAllocBytes(0);
+
+
+/*==============================================================================================================================
+
+ Allocates memory for the replacement operator new, counting the allocation if required
+
+==============================================================================================================================*/
+static void* pAllocate(size_t nBytes)
+{
+   if (s_bCountAllocs.load(memory_order_relaxed))
+   {
+      s_ullNumAllocs.fetch_add(1, memory_order_relaxed);
+      s_ullAllocBytes.fetch_add(nBytes, memory_order_relaxed);
+   }
+
+   if (nBytes == 0)
+      nBytes = 1;
+
+   void* pMem;
+   while ((pMem = malloc(nBytes)) == NULL)
+   {
+      // As required for operator new, call the new-handler (if there is one) then try again
+      new_handler pHandler = std::get_new_handler();
+      if (! pHandler)
+         throw bad_alloc();
+
+      pHandler();
+   }
+
+   return pMem;
+}
+
+void* operator new(size_t nBytes)
+{
+   return pAllocate(nBytes);
+}
+
+void* operator new[](size_t nBytes)
+{
+   return pAllocate(nBytes);
+}
+
+void* operator new(size_t nBytes, nothrow_t const&) noexcept
+{
+   try
+   {
+      return pAllocate(nBytes);
+   }
+   catch (...)
+   {
+      return NULL;
+   }
+}
+
+void* operator new[](size_t nBytes, nothrow_t const&) noexcept
+{
+   try
+   {
+      return pAllocate(nBytes);
+   }
+   catch (...)
+   {
+      return NULL;
+   }
+}
+
+void operator delete(void* pMem) noexcept
+{
+   free(pMem);
+}
+
+void operator delete[](void* pMem) noexcept
+{
+   free(pMem);
+}
+
+void operator delete(void* pMem, nothrow_t const&) noexcept
+{
+   free(pMem);
+}
+
+void operator delete[](void* pMem, nothrow_t const&) noexcept
+{
+   free(pMem);
+}
+
+
+/*==============================================================================================================================
+
+ Switches counting of heap allocations on or off
+
+==============================================================================================================================*/
+void SetAllocCounting(bool const bCount)
+{
+   s_bCountAllocs.store(bCount, memory_order_relaxed);
+}
+
+
+/*==============================================================================================================================
+
+ Returns the number of heap allocations counted so far
+
+==============================================================================================================================*/
+unsigned long long ullGetNumAllocs(void)
+{
+   return s_ullNumAllocs.load(memory_order_relaxed);
+}
+
+
+/*==============================================================================================================================
+
+ Returns the number of bytes requested by the heap allocations counted so far
+
+==============================================================================================================================*/
+unsigned long long ullGetAllocBytes(void)
+{
+   return s_ullAllocBytes.load(memory_order_relaxed);
+}
+
+
+#ifdef __linux__
+/*==============================================================================================================================
+
+ Reads a small file from /proc into a buffer. This is done without C++ streams, so that it does not itself allocate
+
+==============================================================================================================================*/
+static bool bReadProcFile(char const* pszFile, char* szBuf, int const nBufSize)
+{
+   int nFile = open(pszFile, O_RDONLY);
+   if (nFile < 0)
+      return false;
+
+   ssize_t nRead = read(nFile, szBuf, nBufSize-1);
+   close(nFile);
+   if (nRead <= 0)
+      return false;
+
+   szBuf[nRead] = '\0';
+   return true;
+}
+#endif
+
+
+/*==============================================================================================================================
+
+ Returns the current resident set size in Mb, or zero if this is not available
+
+==============================================================================================================================*/
+double dGetCurrentRSS(void)
+{
+#ifdef __linux__
+   // The second field of statm is the number of resident pages
+   char szBuf[256];
+   if (! bReadProcFile("/proc/self/statm", szBuf, 256))
+      return 0;
+
+   char* pEnd;
+   strtod(szBuf, &pEnd);
+   double dPages = strtod(pEnd, NULL);
+
+   return dPages * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+#else
+   return 0;
+#endif
+}
+
+
+/*==============================================================================================================================
+
+ Returns the peak resident set size in Mb, since the start of the run or since the last successful call to bResetPeakRSS(). Returns zero if this is not available
+
+==============================================================================================================================*/
+double dGetPeakRSS(void)
+{
+#ifdef __linux__
+   char szBuf[4096];
+   if (! bReadProcFile("/proc/self/status", szBuf, 4096))
+      return 0;
+
+   char* pHWM = strstr(szBuf, "VmHWM:");
+   if (pHWM == NULL)
+      return 0;
+
+   // In kB
+   return strtod(pHWM + 6, NULL) / 1024.0;
+#else
+   return 0;
+#endif
+}
+
+
+/*==============================================================================================================================
+
+ Resets the peak resident set size to the current resident set size. This needs Linux 4.0 or later: returns false if it cannot be done
+
+==============================================================================================================================*/
+bool bResetPeakRSS(void)
+{
+#ifdef __linux__
+   int nFile = open("/proc/self/clear_refs", O_WRONLY);
+   if (nFile < 0)
+      return false;
+
+   bool bOK = (write(nFile, "5", 1) == 1);
+   close(nFile);
+
+   return bOK;
+#else
+   return false;
+#endif
+}
@@ -0,0 +1,116 @@
+/*!
+ *
+ * \file parallel_profile_cache.cpp
+ * \brief CParallelProfileCache routines
+ * \details Caches parallel profiles (as used for between-profile shore platform erosion) until the coastline-normal profiles are rebuilt
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include "cme.h"
+#include "parallel_profile_cache.h"
+
+
+CParallelProfileCache::CParallelProfileCache(void)
+:
+   m_ulHits(0),
+   m_ulMisses(0),
+   m_ulClears(0),
+   m_nEntries(0)
+{
+}
+
+CParallelProfileCache::~CParallelProfileCache(void)
+{
+}
+
+
+//! Empties the cache, this must be done whenever the coastline-normal profiles are rebuilt. The storage of each entry is kept for re-use
+void CParallelProfileCache::Clear(void)
+{
+   m_nEntries = 0;
+   m_nMKeyToEntry.clear();
+   m_ulClears++;
+}
+
+
+//! Looks for a cached parallel profile for the given coast, coastline-normal profile, distance from this profile, and direction. Returns the entry number, or INT_NODATA if not found
+int CParallelProfileCache::nFindEntry(int const nCoast, int const nProfile, int const nDistFromProfile, int const nDirection)
+{
+   map<pair<pair<int, int>, pair<int, int> >, int>::iterator it = m_nMKeyToEntry.find(std::make_pair(std::make_pair(nCoast, nProfile), std::make_pair(nDistFromProfile, nDirection)));
+   // May be called from several threads at once (but never at the same time as nAddEntry()), so the counters are updated atomically
+   if (it == m_nMKeyToEntry.end())
+   {
+#ifdef _OPENMP
+      #pragma omp atomic
+#endif
+      m_ulMisses++;
+      return INT_NODATA;
+   }
+
+#ifdef _OPENMP
+   #pragma omp atomic
+#endif
+   m_ulHits++;
+   return it->second;
+}
+
+
+//! Adds a parallel profile to the cache, and returns its entry number
+int CParallelProfileCache::nAddEntry(int const nCoast, int const nProfile, int const nDistFromProfile, int const nDirection, vector<CGeom2DIPoint> const* pPtiVCell, vector<CGeom2DPoint> const* pPtVCellExtCRS)
+{
+   if (m_nEntries == m_VEntry.size())
+      m_VEntry.push_back(CacheEntry());
+
+   int nEntry = m_nEntries++;
+
+   // Assignment re-uses the entry's existing storage, if there is enough of it
+   m_VEntry[nEntry].PtiVCell = *pPtiVCell;
+   m_VEntry[nEntry].PtVCellExtCRS = *pPtVCellExtCRS;
+
+   m_nMKeyToEntry[std::make_pair(std::make_pair(nCoast, nProfile), std::make_pair(nDistFromProfile, nDirection))] = nEntry;
+
+   return nEntry;
+}
+
+
+vector<CGeom2DIPoint> const* CParallelProfileCache::pPtiVGetCells(int const nEntry) const
+{
+   return &m_VEntry[nEntry].PtiVCell;
+}
+
+vector<CGeom2DPoint> const* CParallelProfileCache::pPtVGetCellsExtCRS(int const nEntry) const
+{
+   return &m_VEntry[nEntry].PtVCellExtCRS;
+}
+
+
+unsigned long CParallelProfileCache::ulGetHits(void) const
+{
+   return m_ulHits;
+}
+
+unsigned long CParallelProfileCache::ulGetMisses(void) const
+{
+   return m_ulMisses;
+}
+
+unsigned long CParallelProfileCache::ulGetClears(void) const
+{
+   return m_ulClears;
+}
@@ -0,0 +1,86 @@
+/*!
+ *
+ * \class CParallelProfileCache
+ * \brief Class used to cache parallel profiles during a single timestep
+ * \details Shore platform erosion between coastline-normal profiles is calculated on temporary profiles which are parallel to a coastline-normal profile, offset some distance along the coast. The cells 'under' each of these parallel profiles depend only on the coastline-normal profile, the offset, and the direction, so they are constructed once and then kept until the coastline-normal profiles are next rebuilt. This is only done when shore platform erosion is done in parallel: the parallel profiles are all constructed while finding the cells which each task changes, before the parallel section starts, and are then re-used within it
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file parallel_profile_cache.h
+ * \brief Contains CParallelProfileCache definitions
+ *
+ */
+
+#ifndef PARALLELPROFILECACHE_H
+#define PARALLELPROFILECACHE_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <vector>
+using std::vector;
+
+#include <map>
+using std::map;
+
+#include <utility>
+using std::pair;
+
+#include "2d_point.h"
+#include "2di_point.h"
+
+
+class CParallelProfileCache
+{
+private:
+   struct CacheEntry
+   {
+      vector<CGeom2DPoint>
+         PtVCellExtCRS;                   // The centroids (external CRS) of the cells under the parallel profile
+
+      vector<CGeom2DIPoint>
+         PtiVCell;                        // The cells (raster-grid CRS) under the parallel profile
+   };
+
+   unsigned long
+      m_ulHits,
+      m_ulMisses,
+      m_ulClears;
+
+   // Number of entries in m_VEntry which are in use. Entries beyond this are kept (with their storage) for re-use after the cache is cleared
+   unsigned int
+      m_nEntries;
+
+   vector<CacheEntry>
+      m_VEntry;
+
+   map<pair<pair<int, int>, pair<int, int> >, int>
+      m_nMKeyToEntry;                     // Maps (coast, coastline-normal profile, distance from profile, direction) to a slot in m_VEntry
+
+public:
+   CParallelProfileCache(void);
+   ~CParallelProfileCache(void);
+
+   void Clear(void);
+
+   int nFindEntry(int const, int const, int const, int const);
+   int nAddEntry(int const, int const, int const, int const, vector<CGeom2DIPoint> const*, vector<CGeom2DPoint> const*);
+
+   vector<CGeom2DIPoint> const* pPtiVGetCells(int const) const;
+   vector<CGeom2DPoint> const* pPtVGetCellsExtCRS(int const) const;
+
+   unsigned long ulGetHits(void) const;
+   unsigned long ulGetMisses(void) const;
+   unsigned long ulGetClears(void) const;
+};
+#endif // PARALLELPROFILECACHE_H
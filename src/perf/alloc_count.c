@@ -0,0 +1,112 @@
+/*!
+ *
+ * \file alloc_count.c
+ * \brief Counts heap allocations, for the performance regression harness
+ * \details Preloaded (with LD_PRELOAD) by run_perf.sh. Every call to malloc(), calloc(), realloc(), posix_memalign(), aligned_alloc() and memalign() is counted, as are the bytes requested: since the C++ operator new calls malloc(), this includes all C++ allocations. When the process exits, the totals are written to the file named by the CME_ALLOC_COUNT_FILE environment variable, together with the process's peak resident set size. This is measured from outside CoastalME, so it is available for any revision. Requires glibc
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+// glibc's own allocator entry points, so that we do not need dlsym() (which itself allocates)
+extern void* __libc_malloc(size_t);
+extern void* __libc_calloc(size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void* __libc_memalign(size_t, size_t);
+
+static unsigned long long
+   ullAllocs = 0,
+   ullBytes = 0;
+
+static void Count(size_t const nBytes)
+{
+   // OpenMP threads allocate too
+   __atomic_add_fetch(&ullAllocs, 1, __ATOMIC_RELAXED);
+   __atomic_add_fetch(&ullBytes, nBytes, __ATOMIC_RELAXED);
+}
+
+void* malloc(size_t nBytes)
+{
+   Count(nBytes);
+   return __libc_malloc(nBytes);
+}
+
+void* calloc(size_t nNum, size_t nBytes)
+{
+   Count(nNum * nBytes);
+   return __libc_calloc(nNum, nBytes);
+}
+
+void* realloc(void* pOld, size_t nBytes)
+{
+   Count(nBytes);
+   return __libc_realloc(pOld, nBytes);
+}
+
+// Aligned allocations (e.g. C++17 aligned operator new, and some OpenMP runtimes) do not go through malloc()
+int posix_memalign(void** ppMem, size_t nAlign, size_t nBytes)
+{
+   // The alignment must be a power of two multiple of sizeof(void*)
+   if ((nAlign % sizeof(void*) != 0) || ((nAlign & (nAlign - 1)) != 0) || (nAlign == 0))
+      return EINVAL;
+
+   Count(nBytes);
+   void* pMem = __libc_memalign(nAlign, nBytes);
+   if (pMem == NULL)
+      return ENOMEM;
+
+   *ppMem = pMem;
+   return 0;
+}
+
+void* aligned_alloc(size_t nAlign, size_t nBytes)
+{
+   Count(nBytes);
+   return __libc_memalign(nAlign, nBytes);
+}
+
+void* memalign(size_t nAlign, size_t nBytes)
+{
+   Count(nBytes);
+   return __libc_memalign(nAlign, nBytes);
+}
+
+__attribute__((destructor)) static void WriteAllocCount(void)
+{
+   char const* pszFile = getenv("CME_ALLOC_COUNT_FILE");
+   if (pszFile == NULL)
+      return;
+
+   // Get the peak resident set size (in Kb on Linux) before opening the file, since this allocates
+   struct rusage Usage;
+   double dPeakRSSMb = 0;
+   if (getrusage(RUSAGE_SELF, &Usage) == 0)
+      dPeakRSSMb = Usage.ru_maxrss / 1024.0;
+
+   FILE* pFile = fopen(pszFile, "w");
+   if (pFile == NULL)
+      return;
+
+   fprintf(pFile, "allocs %llu\nalloc_bytes %llu\npeak_rss_mb %.1f\n", ullAllocs, ullBytes, dPeakRSSMb);
+   fclose(pFile);
+}
@@ -0,0 +1,329 @@
+#!/bin/bash
+#
+# Performance regression harness for CoastalME
+#
+# Builds CoastalME (Release), then runs each of the GMD2017 scenarios in ../../in/GMD2017 for a fixed number of timesteps.
+# For each scenario, records:
+#    - wall time
+#    - wall time for each stage of the timestep (from the "Per-stage timings" section of the .out file)
+#    - peak resident set size, number of heap allocations and bytes allocated (using alloc_count.c, preloaded)
+#    - summary statistics for every raster GIS output file (from gdalinfo -stats), and column sums for every time series file
+# and compares these against the stored baseline in baseline/<scenario>.txt. Fails if any output has drifted beyond the
+# results tolerance, or if any performance figure is worse than the baseline by more than the performance tolerance.
+#
+# Usage: run_perf.sh [options] [scenario ...]
+#    --timesteps N          number of timesteps to run (default 20)
+#    --reps N               run each scenario N times, and use the best performance figures (default 3)
+#    --results-tol X        relative tolerance for output values (default 1e-6)
+#    --perf-tol X           fractional tolerance for performance figures (default 0.15)
+#    --build-dir DIR        where to build CoastalME (default ./build)
+#    --update-baseline      write the results of this run to baseline/, instead of comparing
+#    --baseline-rev REV     first build git revision REV (in a git worktree, using REV's own input files) and write its
+#                           results to baseline/, then compare this tree against it
+#
+# With no scenarios given, all four are run. Needs cmake, a C compiler, glibc, and the GDAL command-line tools.
+#
+# Run with --update-baseline (and commit the new baseline) whenever outputs are expected to change, or on new hardware.
+# There is no baseline to start with: run with --baseline-rev on the revision to compare against (or with --update-baseline
+# on an unchanged tree) first. Wall time, peak RSS and allocations are measured from outside CoastalME, so are compared for
+# any baseline revision. Older revisions do not write per-stage timings to the .out file, so these are only compared if the
+# baseline has them.
+
+timesteps=20
+reps=3
+resultstol=1e-6
+perftol=0.15
+updatebaseline=0
+baselinerev=""
+
+perfdir=$(cd "$(dirname "$0")" && pwd)
+srcdir=$(cd "$perfdir/.." && pwd)
+cmedir=$(cd "$srcdir/.." && pwd)
+builddir=$perfdir/build
+baselinedir=$perfdir/baseline
+scenarios=""
+
+# Stages which take less than this many seconds are too noisy to compare
+minstagetime=0.05
+
+while [ $# -gt 0 ]; do
+   case "$1" in
+      --timesteps)         timesteps=$2; shift ;;
+      --reps)              reps=$2; shift ;;
+      --results-tol)       resultstol=$2; shift ;;
+      --perf-tol)          perftol=$2; shift ;;
+      --build-dir)         builddir=$2; shift ;;
+      --update-baseline)   updatebaseline=1 ;;
+      --baseline-rev)      baselinerev=$2; shift ;;
+      -*)                  sed -n '2,/^$/s/^# \{0,1\}//p' "$0"; exit 2 ;;
+      *)                   scenarios="$scenarios $1" ;;
+   esac
+   shift
+done
+
+if [ -z "$scenarios" ]; then
+   scenarios="CliffFineBays CliffFineSandBays Groin UndefendedCoastLine"
+fi
+
+if [ "$timesteps" -lt 2 ]; then
+   echo "ERROR: must run at least 2 timesteps"
+   exit 2
+fi
+
+if [ -n "$baselinerev" ] && [ $updatebaseline -eq 1 ]; then
+   echo "ERROR: use only one of --baseline-rev and --update-baseline"
+   exit 2
+fi
+
+# ------------------------------------------------------------------------------------------------------------------------
+# Builds CoastalME (Release) from the source folder $1 in the build folder $2
+build_cme()
+{
+   local src=$1 build=$2
+   echo "CoastalME performance harness: building $src in $build (Release build)"
+   mkdir -p "$build" || return 1
+   (cd "$build" && cmake -G "Unix Makefiles" -DCMAKE_BUILD_TYPE=Release "$src" > cmake.log && make -j"$(nproc)" cme > make.log) || { echo "ERROR: build failed, see $build"; return 1; }
+}
+
+mkdir -p "$builddir" || exit 2
+cc -O2 -shared -fPIC -o "$builddir/alloc_count.so" "$perfdir/alloc_count.c" || { echo "ERROR: cannot build alloc_count.so"; exit 2; }
+
+# ------------------------------------------------------------------------------------------------------------------------
+# Sets up a working folder for a scenario, with a copy of the executable $exe, a cme.ini which points at an edited copy of the
+# scenario's .dat file, and links to the input folders of the tree $3. The .dat file is edited to run exactly $timesteps
+# timesteps, to save GIS output halfway through and at the end, and to record per-stage timings (if the .dat file has this)
+setup_scenario()
+{
+   local scenario=$1 workdir=$2 tree=$3
+   local dat
+   dat=$(ls "$tree/in/GMD2017/$scenario/"*.dat 2> /dev/null | head -1)
+   if [ -z "$dat" ]; then
+      echo "ERROR: no .dat file for scenario $scenario"
+      return 1
+   fi
+
+   rm -rf "$workdir"
+   mkdir -p "$workdir/out" || return 1
+   cp "$exe" "$workdir/" || return 1
+   for d in in scape cshore; do
+      ln -s "$tree/$d" "$workdir/$d"
+   done
+
+   # The timestep is e.g. "6 hours". Note that CoastalME runs one timestep fewer than duration / timestep
+   local step unit
+   read -r step unit <<< "$(sed -n 's/^Timestep[^:]*:[ \t]*\([0-9.]*\)[ \t]*\([a-z]*\).*/\1 \2/p' "$dat")"
+   local duration half full
+   duration=$(awk -v s="$step" -v n="$timesteps" 'BEGIN { print s * (n + 1) }')
+   half=$(awk -v s="$step" -v n="$timesteps" 'BEGIN { print s * int(n / 2) }')
+   full=$(awk -v s="$step" -v n="$timesteps" 'BEGIN { print s * n }')
+
+   sed -e "s/^\(Duration of simulation[^:]*:\).*/\1 $duration $unit/" \
+       -e "s/^\(Save times[^:]*:\).*/\1 $half $full $unit/" \
+       -e "s/^\(Record per-stage timings?[^:]*:\).*/\1 y/" \
+       "$dat" > "$workdir/scenario.dat"
+
+   sed -e "s#^\(Input data file[^:]*:\).*#\1 $workdir/scenario.dat#" \
+       -e "s#^\(Path for output[^:]*:\).*#\1 $workdir/out/#" \
+       "$tree/cme.ini" > "$workdir/cme.ini"
+}
+
+# ------------------------------------------------------------------------------------------------------------------------
+# Runs a scenario once, then writes its metrics (one "key value" per line) to stdout
+run_scenario()
+{
+   local workdir=$1
+   rm -rf "$workdir/out" && mkdir -p "$workdir/out"
+
+   local start end
+   start=$(date +%s.%N)
+   (cd "$workdir" && LD_PRELOAD="$builddir/alloc_count.so" CME_ALLOC_COUNT_FILE="$workdir/allocs.txt" ./cme > run.log 2>&1) || { echo "ERROR: CoastalME failed, see $workdir/run.log" >&2; return 1; }
+   end=$(date +%s.%N)
+
+   echo "perf.wall_time $(awk -v a="$start" -v b="$end" 'BEGIN { printf "%.3f", b - a }')"
+
+   # Per-stage timings, from the .out file. There are none if the executable is from an older revision. The .out file may also
+   # hold peak RSS, but this is ignored: alloc_count.so measures it for every revision
+   awk -F '\t: ' '
+      /^Per-stage timings/ { instage = 1; next }
+      instage && /^-/ { next }
+      instage && NF < 2 { instage = 0; next }
+      instage {
+         name = $1
+         sub(/[ ]+$/, "", name)
+         gsub(/ /, "_", name)
+         split($2, val, " ")
+         if (name != "Peak_resident_set_size")
+            print "stage." name, val[1]
+      }' "$workdir"/out/*.out
+
+   sed 's/^/perf./' "$workdir/allocs.txt"
+
+   # Raster GIS output: summary statistics, and a checksum (which is only reported, since bit-for-bit differences are allowed)
+   local f name
+   for f in $(cd "$workdir/out" && ls *.tif 2> /dev/null | sort); do
+      name=${f%.tif}
+      gdalinfo -stats "$workdir/out/$f" 2> /dev/null | sed -n 's/^ *STATISTICS_\(MINIMUM\|MAXIMUM\|MEAN\|STDDEV\)=\(.*\)/\1 \2/p' | \
+         awk -v n="$name" '{ print "result." n "." tolower($1), $2 }'
+      echo "md5.$name $(md5sum < "$workdir/out/$f" | cut -d ' ' -f 1)"
+   done
+
+   # Time series output: the sum of each column. The per-stage file holds timings, so is not an output
+   for f in $(cd "$workdir/out" && ls *.csv 2> /dev/null | grep -v '^stages\.csv$' | sort); do
+      name=${f%.csv}
+      awk -F ',' -v n="$name" '
+         { for (i = 1; i <= NF; i++) if ($i ~ /^[ ]*[-+0-9.eE]+[ ]*$/) { sum[i] += $i; if (i > ncols) ncols = i } }
+         END { for (i = 1; i <= ncols; i++) printf "result.%s.col%d %.10g\n", n, i, sum[i] }' "$workdir/out/$f"
+   done
+}
+
+# ------------------------------------------------------------------------------------------------------------------------
+# Combines the metrics from several runs: the best (lowest) of each performance figure, and the results from the first run
+# (these must be the same for every run)
+combine_reps()
+{
+   awk '
+      FNR == 1 { nfile++ }
+      {
+         if ($1 ~ /^(perf|stage)\./)
+         {
+            if (! ($1 in val) || $2 < val[$1])
+               val[$1] = $2
+         }
+         else if (nfile == 1)
+            val[$1] = $2
+         else if (val[$1] != $2)
+            printf "WARNING: %s differs between repetitions (%s, %s)\n", $1, val[$1], $2 > "/dev/stderr"
+         if (! ($1 in seen)) { seen[$1] = 1; order[++n] = $1 }
+      }
+      END { for (i = 1; i <= n; i++) print order[i], val[order[i]] }' "$@"
+}
+
+# ------------------------------------------------------------------------------------------------------------------------
+# Compares metrics against the baseline, writes a report to stdout, and returns non-zero if there is a regression. Per-stage
+# timings are only compared if both the baseline and this run have them
+compare_baseline()
+{
+   local metrics=$1 baseline=$2
+   awk -v rtol="$resultstol" -v ptol="$perftol" -v minstage="$minstagetime" '
+      function abs(x) { return x < 0 ? -x : x }
+      FNR == NR { base[$1] = $2; next }
+      {
+         now[$1] = $2
+         if (! ($1 in base))
+         {
+            if ($1 ~ /^stage\./)
+               printf "   UNCHECKED %-60s %s (not in baseline)\n", $1, $2
+            else
+            {
+               printf "   NEW       %-60s %s\n", $1, $2
+               fail = 1
+            }
+            next
+         }
+         if ($1 ~ /^md5\./)
+         {
+            if ($2 != base[$1])
+               printf "   CHANGED   %-60s (not bit-for-bit identical)\n", $1
+            next
+         }
+         if ($1 ~ /^result\./)
+         {
+            if (abs($2 - base[$1]) > rtol * (abs(base[$1]) > 1 ? abs(base[$1]) : 1))
+            {
+               printf "   DRIFT     %-60s %s (baseline %s)\n", $1, $2, base[$1]
+               fail = 1
+            }
+            next
+         }
+         if (($1 ~ /^stage\./) && (base[$1] < minstage) && ($2 < minstage))
+            next
+         change = (base[$1] > 0) ? ($2 - base[$1]) / base[$1] : 0
+         if (change > ptol)
+         {
+            printf "   SLOWER    %-60s %s (baseline %s, %+.1f%%)\n", $1, $2, base[$1], 100 * change
+            fail = 1
+         }
+         else if ($1 ~ /^perf\./)
+            printf "   OK        %-60s %s (baseline %s, %+.1f%%)\n", $1, $2, base[$1], 100 * change
+      }
+      END {
+         for (k in base)
+            if (! (k in now))
+            {
+               printf "   MISSING   %-60s\n", k
+               if (! (k ~ /^stage\./))
+                  fail = 1
+            }
+         exit fail
+      }' "$baseline" "$metrics"
+}
+
+# ------------------------------------------------------------------------------------------------------------------------
+# Runs a scenario $reps times with the executable $exe and the input files of the tree $2, and writes the combined metrics to
+# $1/metrics.txt
+run_reps()
+{
+   local workdir=$1 tree=$2
+   setup_scenario "$scenario" "$workdir" "$tree" || return 1
+
+   for rep in $(seq 1 "$reps"); do
+      run_scenario "$workdir" > "$workdir/metrics_$rep.txt" || return 1
+   done
+
+   combine_reps "$workdir"/metrics_*.txt > "$workdir/metrics.txt"
+}
+
+mkdir -p "$baselinedir"
+
+# ------------------------------------------------------------------------------------------------------------------------
+# If required, build the baseline revision in a git worktree, and write its results to the baseline
+if [ -n "$baselinerev" ]; then
+   basetree=$builddir/baseline-src
+   git -C "$cmedir" worktree remove --force "$basetree" > /dev/null 2>&1
+   rm -rf "$basetree"
+   git -C "$cmedir" worktree add --detach "$basetree" "$baselinerev" > /dev/null || { echo "ERROR: cannot check out revision $baselinerev"; exit 2; }
+   trap 'git -C "$cmedir" worktree remove --force "$basetree" > /dev/null 2>&1' EXIT
+   build_cme "$basetree/src" "$builddir/baseline-build" || exit 2
+   exe=$builddir/baseline-build/Release/cme
+
+   for scenario in $scenarios; do
+      echo
+      echo "$scenario: baseline from revision $baselinerev, $timesteps timesteps, $reps repetition(s)"
+      run_reps "$builddir/perf-baseline/$scenario" "$basetree" || { echo "ERROR: cannot run baseline revision for $scenario"; exit 2; }
+      cp "$builddir/perf-baseline/$scenario/metrics.txt" "$baselinedir/$scenario.txt"
+      echo "   Baseline written to $baselinedir/$scenario.txt"
+   done
+fi
+
+# ------------------------------------------------------------------------------------------------------------------------
+# Run everything
+build_cme "$srcdir" "$builddir" || exit 2
+exe=$builddir/Release/cme
+
+failed=""
+for scenario in $scenarios; do
+   workdir=$builddir/perf/$scenario
+   echo
+   echo "$scenario: $timesteps timesteps, $reps repetition(s)"
+
+   run_reps "$workdir" "$cmedir" || { failed="$failed $scenario"; continue; }
+
+   if [ $updatebaseline -eq 1 ]; then
+      cp "$workdir/metrics.txt" "$baselinedir/$scenario.txt"
+      echo "   Baseline written to $baselinedir/$scenario.txt"
+   elif [ ! -f "$baselinedir/$scenario.txt" ]; then
+      echo "   ERROR: no baseline, run with --update-baseline first"
+      failed="$failed $scenario"
+   elif ! compare_baseline "$workdir/metrics.txt" "$baselinedir/$scenario.txt"; then
+      failed="$failed $scenario"
+   fi
+done
+
+echo
+if [ -n "$failed" ]; then
+   echo "FAILED:$failed"
+   exit 1
+fi
+
+echo "PASSED"
+exit 0
@@ -369,11 +369,11 @@ void CGeomProfile::AppendCellInProfile(int const nX, int const nY)
    m_VCellInProfile.push_back(CGeom2DIPoint(nX, nY));
 }
 
-// void CGeomProfile::SetCellsInProfile(vector<CGeom2DIPoint>* VNewPoints)
-// {
-//    // In grid CRS
-//    m_VCellInProfile = *VNewPoints;
-// }
+void CGeomProfile::SetCellsInProfile(vector<CGeom2DIPoint> const* VNewPoints)
+{
+   // In grid CRS
+   m_VCellInProfile = *VNewPoints;
+}
 
 vector<CGeom2DIPoint>* CGeomProfile::pPtiVGetCellsInProfile(void)
 {
@@ -407,6 +407,12 @@ void CGeomProfile::AppendCellInProfileExtCRS(double const dX, double const dY)
    m_VCellInProfileExtCRS.push_back(CGeom2DPoint(dX, dY));
 }
 
+void CGeomProfile::SetCellsInProfileExtCRS(vector<CGeom2DPoint> const* VNewPoints)
+{
+   // In external CRS
+   m_VCellInProfileExtCRS = *VNewPoints;
+}
+
 
 //! Returns the index of the cell on this profile which has a sea depth which is just less than a given depth. If every cell on the profile has a sea depth which is less than the given depth it returns INT_NODATA
 int CGeomProfile::nGetCellGivenDepth(CGeomRasterGrid* const pGrid, double const dDepthIn)
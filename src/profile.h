@@ -118,12 +118,13 @@ public:
 
    void AppendCellInProfile(CGeom2DIPoint*);
    void AppendCellInProfile(int const, int const);
-//    void SetCellsInProfile(vector<CGeom2DIPoint>*);
+   void SetCellsInProfile(vector<CGeom2DIPoint> const*);
    vector<CGeom2DIPoint>* pPtiVGetCellsInProfile(void);
    CGeom2DIPoint* pPtiGetCellInProfile(int const);
    int nGetNumCellsInProfile(void) const;
 
    void AppendCellInProfileExtCRS(double const, double const);
+   void SetCellsInProfileExtCRS(vector<CGeom2DPoint> const*);
 //    vector<CGeom2DPoint>* PtVGetCellsInProfileExtCRS(void);
 
    int nGetCellGivenDepth(CGeomRasterGrid* const, double const);
@@ -0,0 +1,242 @@
+/*!
+ *
+ * \file profile_raster_cache.cpp
+ * \brief CProfileRasterCache routines
+ * \details Caches rasterized coastline-normal profiles between timesteps
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include "cme.h"
+#include "profile_raster_cache.h"
+
+
+//! Constructor, needs the size of the raster grid
+CProfileRasterCache::CProfileRasterCache(int const nXGridMax, int const nYGridMax)
+:
+   m_nXGridMax(nXGridMax),
+   m_nYGridMax(nYGridMax),
+   m_ulHits(0),
+   m_ulMisses(0),
+   m_ulInvalidated(0)
+{
+}
+
+CProfileRasterCache::~CProfileRasterCache(void)
+{
+}
+
+
+//! Marks a cache entry as unusable, and makes its slot available for re-use
+void CProfileRasterCache::InvalidateEntry(int const nEntry)
+{
+   if (! m_VEntry[nEntry].bValid)
+      return;
+
+   m_VEntry[nEntry].bValid = false;
+   m_VEntry[nEntry].PtVVertex.clear();
+   m_VEntry[nEntry].PtVCellExtCRS.clear();
+   m_VEntry[nEntry].PtiVCell.clear();
+   m_VEntry[nEntry].nVCellsInSegment.clear();
+
+   map<int, int>::iterator it = m_nMStartCellToEntry.find(m_VEntry[nEntry].nStartCell);
+   if ((it != m_nMStartCellToEntry.end()) && (it->second == nEntry))
+      m_nMStartCellToEntry.erase(it);
+
+   m_nVFreeEntry.push_back(nEntry);
+   m_ulInvalidated++;
+}
+
+
+//! Records that a cell is touched by a cache entry. Any out-of-date links for this cell are removed at the same time
+void CProfileRasterCache::LinkCell(int const nX, int const nY, int const nEntry)
+{
+   if ((nX < 0) || (nX >= m_nXGridMax) || (nY < 0) || (nY >= m_nYGridMax))
+      return;
+
+   vector<pair<int, unsigned long> >* pprVLinks = &m_prMCellToEntry[(nX * m_nYGridMax) + nY];
+
+   unsigned int n = 0;
+   while (n < pprVLinks->size())
+   {
+      int nLinked = pprVLinks->at(n).first;
+      if ((! m_VEntry[nLinked].bValid) || (m_VEntry[nLinked].ulGeneration != pprVLinks->at(n).second))
+      {
+         // This link is stale, so remove it
+         pprVLinks->at(n) = pprVLinks->back();
+         pprVLinks->pop_back();
+         continue;
+      }
+
+      // Don't link the same entry twice
+      if (nLinked == nEntry)
+         return;
+
+      n++;
+   }
+
+   pprVLinks->push_back(std::make_pair(nEntry, m_VEntry[nEntry].ulGeneration));
+}
+
+
+//! Called for a cell which has started or stopped being a coastline cell since the previous timestep: invalidates every cached profile which touches this cell
+void CProfileRasterCache::CellChanged(int const nX, int const nY)
+{
+   if ((nX < 0) || (nX >= m_nXGridMax) || (nY < 0) || (nY >= m_nYGridMax))
+      return;
+
+   int nCell = (nX * m_nYGridMax) + nY;
+
+   map<int, vector<pair<int, unsigned long> > >::iterator it = m_prMCellToEntry.find(nCell);
+   if (it == m_prMCellToEntry.end())
+      return;
+
+   for (unsigned int n = 0; n < it->second.size(); n++)
+   {
+      int nEntry = it->second[n].first;
+      if (m_VEntry[nEntry].ulGeneration == it->second[n].second)
+         InvalidateEntry(nEntry);
+   }
+
+   m_prMCellToEntry.erase(it);
+}
+
+
+//! Looks for a valid cache entry for a profile with the given start cell and vertices. Returns the entry number, or INT_NODATA if not found
+int CProfileRasterCache::nFindEntry(int const nStartX, int const nStartY, vector<CGeom2DPoint> const* pPtVVertex, bool const bGridEdge)
+{
+   map<int, int>::iterator it = m_nMStartCellToEntry.find((nStartX * m_nYGridMax) + nStartY);
+   if (it == m_nMStartCellToEntry.end())
+   {
+      m_ulMisses++;
+      return INT_NODATA;
+   }
+
+   CacheEntry* pEntry = &m_VEntry[it->second];
+   if ((! pEntry->bValid) || (pEntry->bGridEdge != bGridEdge) || (pEntry->PtVVertex.size() != pPtVVertex->size()))
+   {
+      m_ulMisses++;
+      return INT_NODATA;
+   }
+
+   // Must be an exact match, since even a tiny change in a vertex could change the rasterized cells
+   for (unsigned int n = 0; n < pPtVVertex->size(); n++)
+   {
+      if ((pEntry->PtVVertex[n].dGetX() != pPtVVertex->at(n).dGetX()) || (pEntry->PtVVertex[n].dGetY() != pPtVVertex->at(n).dGetY()))
+      {
+         m_ulMisses++;
+         return INT_NODATA;
+      }
+   }
+
+   m_ulHits++;
+   return it->second;
+}
+
+
+//! Adds (or replaces) the cache entry for a profile with the given start cell
+void CProfileRasterCache::AddEntry(int const nStartX, int const nStartY, vector<CGeom2DPoint> const* pPtVVertex, bool const bGridEdge, vector<CGeom2DIPoint> const* pPtiVCell, vector<int> const* pnVCellsInSegment, vector<CGeom2DPoint> const* pPtVCellExtCRS, bool const bHitCoast, bool const bHitLand)
+{
+   int nStartCell = (nStartX * m_nYGridMax) + nStartY;
+
+   // Get rid of any previous entry for this start cell
+   map<int, int>::iterator it = m_nMStartCellToEntry.find(nStartCell);
+   if (it != m_nMStartCellToEntry.end())
+      InvalidateEntry(it->second);
+
+   int nEntry;
+   if (m_nVFreeEntry.empty())
+   {
+      CacheEntry Entry;
+      Entry.ulGeneration = 0;
+      m_VEntry.push_back(Entry);
+      nEntry = m_VEntry.size()-1;
+   }
+   else
+   {
+      nEntry = m_nVFreeEntry.back();
+      m_nVFreeEntry.pop_back();
+      m_VEntry[nEntry].ulGeneration++;
+   }
+
+   CacheEntry* pEntry = &m_VEntry[nEntry];
+   pEntry->bValid = true;
+   pEntry->bGridEdge = bGridEdge;
+   pEntry->bHitCoast = bHitCoast;
+   pEntry->bHitLand = bHitLand;
+   pEntry->nStartCell = nStartCell;
+   pEntry->nVCellsInSegment = *pnVCellsInSegment;
+   pEntry->PtVVertex = *pPtVVertex;
+   pEntry->PtVCellExtCRS = *pPtVCellExtCRS;
+   pEntry->PtiVCell = *pPtiVCell;
+
+   m_nMStartCellToEntry[nStartCell] = nEntry;
+
+   // The hit-coast check also looks at the cell with the next-higher y co-ord, so link that cell too
+   for (unsigned int n = 0; n < pPtiVCell->size(); n++)
+   {
+      int
+         nX = pPtiVCell->at(n).nGetX(),
+         nY = pPtiVCell->at(n).nGetY();
+
+      LinkCell(nX, nY, nEntry);
+      LinkCell(nX, nY+1, nEntry);
+   }
+}
+
+
+vector<CGeom2DIPoint> const* CProfileRasterCache::pPtiVGetCells(int const nEntry) const
+{
+   return &m_VEntry[nEntry].PtiVCell;
+}
+
+vector<CGeom2DPoint> const* CProfileRasterCache::pPtVGetCellsExtCRS(int const nEntry) const
+{
+   return &m_VEntry[nEntry].PtVCellExtCRS;
+}
+
+vector<int> const* CProfileRasterCache::pnVGetCellsInSegment(int const nEntry) const
+{
+   return &m_VEntry[nEntry].nVCellsInSegment;
+}
+
+bool CProfileRasterCache::bGetHitCoast(int const nEntry) const
+{
+   return m_VEntry[nEntry].bHitCoast;
+}
+
+bool CProfileRasterCache::bGetHitLand(int const nEntry) const
+{
+   return m_VEntry[nEntry].bHitLand;
+}
+
+
+unsigned long CProfileRasterCache::ulGetHits(void) const
+{
+   return m_ulHits;
+}
+
+unsigned long CProfileRasterCache::ulGetMisses(void) const
+{
+   return m_ulMisses;
+}
+
+unsigned long CProfileRasterCache::ulGetInvalidated(void) const
+{
+   return m_ulInvalidated;
+}
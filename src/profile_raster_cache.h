@@ -0,0 +1,114 @@
+/*!
+ *
+ * \class CProfileRasterCache
+ * \brief Class used to cache rasterized coastline-normal profiles between timesteps
+ * \details The cells 'under' a coastline-normal profile (and the hit-coast check on those cells) only change if the profile's vertices change, or if one of these cells starts or stops being a coastline cell. So each rasterized profile is cached, keyed on its start cell and the vertices of its line segments, and reused until one of the cells which it touches changes status. The cells which have changed status are found when the coastlines are re-traced, so the cost of keeping the cache up to date depends on the length of coastline which has changed, not on the size of the grid
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file profile_raster_cache.h
+ * \brief Contains CProfileRasterCache definitions
+ *
+ */
+
+#ifndef PROFILERASTERCACHE_H
+#define PROFILERASTERCACHE_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <vector>
+using std::vector;
+
+#include <map>
+using std::map;
+
+#include <utility>
+using std::pair;
+
+#include "2d_point.h"
+#include "2di_point.h"
+
+
+class CProfileRasterCache
+{
+private:
+   struct CacheEntry
+   {
+      bool
+         bValid,                          // Is this entry still usable?
+         bGridEdge,                       // Was this a start-of-coast or end-of-coast profile (these are not checked when rasterized)?
+         bHitCoast,                       // Did the profile hit a coastline cell?
+         bHitLand;                        // Did the profile hit a dry land cell?
+
+      int
+         nStartCell;                      // Linear index (raster-grid CRS) of the profile's start cell
+
+      unsigned long
+         ulGeneration;                    // Incremented every time this slot is re-used, so that stale cell-to-entry links can be detected
+
+      vector<int>
+         nVCellsInSegment;                // The number of rasterized cells in each line segment of the profile
+
+      vector<CGeom2DPoint>
+         PtVVertex,                       // The profile's vertices (external CRS) when it was rasterized
+         PtVCellExtCRS;                   // The centroids (external CRS) of the rasterized cells
+
+      vector<CGeom2DIPoint>
+         PtiVCell;                        // The rasterized cells (raster-grid CRS)
+   };
+
+   int
+      m_nXGridMax,
+      m_nYGridMax;
+
+   unsigned long
+      m_ulHits,
+      m_ulMisses,
+      m_ulInvalidated;
+
+   vector<int>
+      m_nVFreeEntry;                      // Slots in m_VEntry which may be re-used
+
+   vector<CacheEntry>
+      m_VEntry;
+
+   map<int, int>
+      m_nMStartCellToEntry;               // Maps a profile start cell to a slot in m_VEntry
+
+   map<int, vector<pair<int, unsigned long> > >
+      m_prMCellToEntry;                   // Maps a cell to the slots (and slot generations) of cached profiles which touch it
+
+   void InvalidateEntry(int const);
+   void LinkCell(int const, int const, int const);
+
+public:
+   CProfileRasterCache(int const, int const);
+   ~CProfileRasterCache(void);
+
+   void CellChanged(int const, int const);
+
+   int nFindEntry(int const, int const, vector<CGeom2DPoint> const*, bool const);
+   void AddEntry(int const, int const, vector<CGeom2DPoint> const*, bool const, vector<CGeom2DIPoint> const*, vector<int> const*, vector<CGeom2DPoint> const*, bool const, bool const);
+
+   vector<CGeom2DIPoint> const* pPtiVGetCells(int const) const;
+   vector<CGeom2DPoint> const* pPtVGetCellsExtCRS(int const) const;
+   vector<int> const* pnVGetCellsInSegment(int const) const;
+   bool bGetHitCoast(int const) const;
+   bool bGetHitLand(int const) const;
+
+   unsigned long ulGetHits(void) const;
+   unsigned long ulGetMisses(void) const;
+   unsigned long ulGetInvalidated(void) const;
+};
+#endif // PROFILERASTERCACHE_H
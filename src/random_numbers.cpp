@@ -224,6 +224,82 @@ void CSimulation::Rand1Shuffle(int* nArray, int nLen)
    }
 }
 
+
+/*===============================================================================================================================
+
+ A counter-based random number generator. Rather than stepping a single global state (as the Tausworthe generators do), each random number is calculated directly from a stream key and a counter. The stream key is derived from the user-supplied seed, the timestep, and up to three integers which identify the caller (e.g. a stream code, coast and polygon). So each polygon (or cell) gets its own independent and reproducible stream of random numbers, and results do not depend on the order in which polygons are processed (or on the number of threads)
+
+ The mixing function is the 32-bit integer hash 'lowbias32' by C. Wellons, see https://nullprogram.com/blog/2018/07/31/ This is a bijection on 32-bit integers with very low bias. As for the Tausworthe generators, MASK is used so that the arithmetic is modulo 2^32 on 64 bit machines
+
+===============================================================================================================================*/
+unsigned long CSimulation::ulGetMix(unsigned long ulX)
+{
+   ulX &= MASK;
+   ulX ^= ulX >> 16;
+   ulX = (ulX * 0x7feb352dul) & MASK;
+   ulX ^= ulX >> 15;
+   ulX = (ulX * 0x846ca68bul) & MASK;
+   ulX ^= ulX >> 16;
+
+   return ulX;
+}
+
+
+unsigned long CSimulation::ulGetStreamKey(int const nStream, int const nA, int const nB) const
+{
+   // Chain the hash through each of the values which identify this stream. Note that the casts of negative values (e.g. INT_NODATA) are fine, since only the bit pattern matters
+   unsigned long ulKey = ulGetMix(m_ulRandSeed[1] ^ 0x9e3779b9ul);
+   ulKey = ulGetMix(ulKey ^ (m_ulTimestep & MASK));
+   ulKey = ulGetMix(ulKey ^ static_cast<unsigned long>(nStream));
+   ulKey = ulGetMix(ulKey ^ static_cast<unsigned long>(nA));
+   ulKey = ulGetMix(ulKey ^ static_cast<unsigned long>(nB));
+
+   return ulKey;
+}
+
+
+unsigned long CSimulation::ulGetStreamRand(unsigned long const ulKey, unsigned long const ulCounter)
+{
+   // Two rounds, so that consecutive counter values give unrelated outputs
+   return ulGetMix(ulGetMix(ulCounter ^ ulKey) + ulKey);
+}
+
+
+/*===============================================================================================================================
+
+ Shuffles an array of integers. If per-polygon random number streams are being used, the shuffle uses the counter-based stream identified by the last three parameters, otherwise it uses Rand1Shuffle() (which gives results identical to those from earlier versions of CoastalME)
+
+===============================================================================================================================*/
+void CSimulation::StreamShuffle(int* nArray, int nLen, int const nStream, int const nA, int const nB)
+{
+   if (! m_bPolygonRandStreams)
+   {
+      Rand1Shuffle(nArray, nLen);
+      return;
+   }
+
+   unsigned long
+      ulKey = ulGetStreamKey(nStream, nA, nB),
+      ulCounter = 0;
+
+   // Same algorithm as Rand1Shuffle(), i.e. each element is swapped with one of the elements before it
+   nLen--;
+   while (nLen > 0)
+   {
+      unsigned long ulScale = 4294967295ul / nLen;
+      unsigned int n1;
+      do
+      {
+         n1 = ulGetStreamRand(ulKey, ulCounter++) / ulScale;
+      }
+      while (n1 >= static_cast<unsigned int>(nLen));
+
+      unsigned int nTmp = nArray[n1];
+      nArray[n1] = nArray[nLen];
+      nArray[nLen--] = nTmp;
+   }
+}
+
 #ifdef RANDCHECK
 /*===============================================================================================================================
 
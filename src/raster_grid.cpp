@@ -55,17 +55,24 @@ CSimulation* CGeomRasterGrid::pGetSim(void)
 // }
 
 
-int CGeomRasterGrid::nCreateGrid(void)
+//! Creates the array of cells. If the tile side is zero, all cells are held in memory. Otherwise the cells are held as tiles with this many cells on each side, and as many tiles are kept in memory as will fit into the cache size (in Mb)
+int CGeomRasterGrid::nCreateGrid(int const nTileSide, double const dCacheMb, int const nLayers, string const& strScratchFile)
 {
-   // Create the 2D vector CGeomCell array
    int
       nXMax = m_pSim->nGetGridXMax(),
-      nYMax = m_pSim->nGetGridYMax();
-
-   // TODO Check if we don't have enough memory, if so return RTN_ERR_MEMALLOC
-   m_Cell.resize(nXMax);
-   for (int nX = 0; nX < nXMax; nX++)
-      m_Cell[nX].resize(nYMax);
+      nYMax = m_pSim->nGetGridYMax(),
+      nMaxTiles = 0;
+
+   if (nTileSide > 0)
+   {
+      // Estimate the memory needed for a tile, including each cell's layers and layer-top elevations, and some allowance for the overhead of each cell's two heap blocks
+      double dCellBytes = sizeof(CGeomCell) + (nLayers * sizeof(CRWCellLayer)) + ((nLayers + 1) * sizeof(double)) + (2 * GRID_TILE_HEAP_OVERHEAD);
+      nMaxTiles = static_cast<int>(dCacheMb * 1024 * 1024 / (dCellBytes * nTileSide * nTileSide));
+   }
+
+   int nRet = m_Cell.nCreate(nXMax, nYMax, nTileSide, nMaxTiles, nLayers, strScratchFile);
+   if (nRet != RTN_OK)
+      return nRet;
 
    // Initialize the CGeomCell shared pointer to the CGeomRasterGrid object
    CGeomCell::m_pGrid = this;
@@ -29,6 +29,7 @@
 ===============================================================================================================================*/
 #include "cme.h"
 #include "cell.h"
+#include "tiled_cell_array.h"
 
 
 class CGeomCell;           // Forward declaration
@@ -38,6 +39,7 @@ class CGeomRasterGrid
 {
    friend class CSimulation;
    friend class CGeomProfile;
+   friend class CBenchmark;
 
 private:
    double
@@ -47,7 +49,7 @@ private:
 
    CSimulation* m_pSim;
 
-   vector< vector<CGeomCell> > m_Cell;
+   CTiledCellArray m_Cell;
 
 public:
 
@@ -56,6 +58,6 @@ public:
 
    CSimulation* pGetSim(void);
 //    CGeomCell* pGetCell(int const, int const);
-   int nCreateGrid(void);
+   int nCreateGrid(int const, double const, int const, string const&);
 };
 #endif // RASTERGRID_H
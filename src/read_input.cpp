@@ -1781,6 +1781,209 @@ bool CSimulation::bReadRunData(void)
             if (strRH.find("y") != string::npos)
             m_bErodeShorePlatformAlternateDirection = true;
                break;
+
+         // ------------------------------------------------------ Performance -------------------------------------------------
+         case 71:
+            // Keep rasterized profiles between timesteps?
+            strRH = strToLower(&strRH);
+
+            m_bCacheProfileRaster = false;
+            if (strRH.find("y") != string::npos)
+               m_bCacheProfileRaster = true;
+            break;
+
+         case 72:
+            // Re-trace coastlines incrementally?
+            strRH = strToLower(&strRH);
+
+            m_bIncrementalCoastTrace = false;
+            if (strRH.find("y") != string::npos)
+               m_bIncrementalCoastTrace = true;
+            break;
+
+         case 73:
+            // Allocate coast, profile and polygon objects per-timestep?
+            strRH = strToLower(&strRH);
+
+            m_bUseTimestepArena = false;
+            if (strRH.find("y") != string::npos)
+               m_bUseTimestepArena = true;
+            break;
+
+         case 74:
+            // Rasterize polygons by scanline?
+            strRH = strToLower(&strRH);
+
+            m_bScanlinePolygonRaster = false;
+            if (strRH.find("y") != string::npos)
+               m_bScanlinePolygonRaster = true;
+            break;
+
+         case 75:
+            // Use per-polygon random number streams?
+            strRH = strToLower(&strRH);
+
+            m_bPolygonRandStreams = false;
+            if (strRH.find("y") != string::npos)
+               m_bPolygonRandStreams = true;
+            break;
+
+         case 76:
+            // Fuse estimation and application of beach erosion?
+            strRH = strToLower(&strRH);
+
+            m_bFuseBeachErosion = false;
+            if (strRH.find("y") != string::npos)
+               m_bFuseBeachErosion = true;
+            break;
+
+         case 77:
+            // Do shore platform erosion in parallel?
+            strRH = strToLower(&strRH);
+
+            m_bParallelPlatformErosion = false;
+            if (strRH.find("y") != string::npos)
+               m_bParallelPlatformErosion = true;
+            break;
+
+         case 78:
+            // Use tabulated linear wave theory (COVE only)?
+            strRH = strToLower(&strRH);
+
+            m_bTabulateLinearWaves = false;
+            if (strRH.find("y") != string::npos)
+               m_bTabulateLinearWaves = true;
+            break;
+
+         case 79:
+            // Find shadow zones by sweep line?
+            strRH = strToLower(&strRH);
+
+            m_bSweepLineShadowZones = false;
+            if (strRH.find("y") != string::npos)
+               m_bSweepLineShadowZones = true;
+            break;
+
+         case 80:
+            // Batch cliff collapse deposition?
+            strRH = strToLower(&strRH);
+
+            m_bBatchCliffCollapseDeposition = false;
+            if (strRH.find("y") != string::npos)
+               m_bBatchCliffCollapseDeposition = true;
+            break;
+
+         case 81:
+            // Cache wave propagation results?
+            strRH = strToLower(&strRH);
+
+            m_bCacheWaveResults = false;
+            if (strRH.find("y") != string::npos)
+               m_bCacheWaveResults = true;
+            break;
+
+         case 82:
+            // Vector GIS output container [0 = one file per item per save, 1 = one file per save, 2 = one file for whole run]
+            m_nVectorGISContainer = atoi(strRH.c_str());
+            if ((m_nVectorGISContainer != VECTOR_CONTAINER_NONE) && (m_nVectorGISContainer != VECTOR_CONTAINER_SAVE) && (m_nVectorGISContainer != VECTOR_CONTAINER_RUN))
+               strErr = "switch for vector GIS output container must be 0, 1 or 2";
+            break;
+
+         case 83:
+            // Record per-stage timings?
+            strRH = strToLower(&strRH);
+
+            m_bStageTimings = false;
+            if (strRH.find("y") != string::npos)
+               m_bStageTimings = true;
+            break;
+
+         case 84:
+            // Record per-stage memory use?
+            strRH = strToLower(&strRH);
+
+            m_bStageMemory = false;
+            if (strRH.find("y") != string::npos)
+               m_bStageMemory = true;
+            break;
+
+         case 85:
+            // Write Chrome trace of every Nth timestep [0 = no trace]
+            m_nTraceTimestepInterval = atoi(strRH.c_str());
+            if (m_nTraceTimestepInterval < 0)
+               strErr = "timestep interval for Chrome trace must be zero or greater";
+            break;
+
+         case 86:
+            // Trace every Nth profile and polygon [1 = all]
+            m_nTraceItemInterval = atoi(strRH.c_str());
+            if (m_nTraceItemInterval < 1)
+               strErr = "profile and polygon interval for Chrome trace must be 1 or greater";
+            break;
+
+         case 87:
+            // Maximum number of trace spans held in memory
+            m_nTraceBufferSize = atoi(strRH.c_str());
+            if (m_nTraceBufferSize < 1)
+               strErr = "maximum number of trace spans held in memory must be 1 or greater";
+            break;
+
+         case 88:
+            // Record per-stage hardware performance counters?
+            strRH = strToLower(&strRH);
+
+            m_bStageHWCounters = false;
+            if (strRH.find("y") != string::npos)
+               m_bStageHWCounters = true;
+            break;
+
+         case 89:
+            // Port for status server on localhost [0 = no status server]
+            m_nStatusPort = atoi(strRH.c_str());
+            if ((m_nStatusPort != 0) && ((m_nStatusPort < 1024) || (m_nStatusPort > 65535)))
+               strErr = "port for status server must be zero, or between 1024 and 65535";
+            break;
+
+         case 90:
+            // Publish grid fields and coastlines in shared memory every Nth timestep [0 = never]
+            m_nSharedExportInterval = atoi(strRH.c_str());
+            if (m_nSharedExportInterval < 0)
+               strErr = "timestep interval for shared-memory export must be zero or greater";
+            break;
+
+         case 91:
+            // Name of shared-memory segment [blank = /cme_ followed by run name and process ID], don't change case. POSIX requires a single leading slash
+            m_strSharedExportName = strRH;
+            if ((! m_strSharedExportName.empty()) && (m_strSharedExportName[0] != '/'))
+               m_strSharedExportName.insert(0, "/");
+            if (m_strSharedExportName.find('/', 1) != string::npos)
+               strErr = "name of shared-memory segment must not contain '/' except at the start";
+            break;
+
+         case 92:
+            // Side of each raster grid tile, in cells [0 = grid not tiled, all cells in memory]
+            m_nGridTileSide = atoi(strRH.c_str());
+            if ((m_nGridTileSide < 0) || ((m_nGridTileSide > 0) && ((m_nGridTileSide < GRID_TILE_MIN_SIDE) || (m_nGridTileSide > GRID_TILE_MAX_SIDE) || ((m_nGridTileSide & (m_nGridTileSide - 1)) != 0))))
+               strErr = "side of raster grid tile must be zero, or a power of two from " + strNumToStr(GRID_TILE_MIN_SIDE) + " to " + strNumToStr(GRID_TILE_MAX_SIDE);
+#ifndef CME_TILED_GRID
+            else if (m_nGridTileSide > 0)
+               strErr = "side of raster grid tile must be zero, since this build does not support tiled raster grids (rebuild with TILED_GRID set to ON)";
+#endif
+            break;
+
+         case 93:
+            // Memory for raster grid tiles (Mb)
+            m_dGridTileCacheMb = atof(strRH.c_str());
+            if ((m_nGridTileSide > 0) && (m_dGridTileCacheMb <= 0))
+               strErr = "memory for raster grid tiles must be greater than zero";
+            break;
+
+         case 94:
+            // Directory for raster grid tile scratch file [blank = output directory], don't change case
+            m_strGridTileDir = strRH;
+            if ((! m_strGridTileDir.empty()) && (m_strGridTileDir[m_strGridTileDir.size()-1] != PATH_SEPARATOR))
+               m_strGridTileDir.push_back(PATH_SEPARATOR);
+            break;
          }
 
          // Did an error occur?
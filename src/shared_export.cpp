@@ -0,0 +1,266 @@
+/*!
+ *
+ * \file shared_export.cpp
+ * \brief CSharedExport routines
+ * \details Publishes grid fields and coastlines in a double-buffered POSIX shared-memory segment. Only available on POSIX systems
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#ifndef _WIN32
+   #include <fcntl.h>
+   #include <sys/mman.h>
+   #include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+
+#include <cstring>
+using std::memcpy;
+using std::memset;
+using std::strcpy;
+
+#include "cme.h"
+#include "shared_export.h"
+
+
+//! Rounds a size in bytes up to a multiple of SHARED_EXPORT_ALIGN
+static size_t nAlign(size_t const nBytes)
+{
+   return ((nBytes + SHARED_EXPORT_ALIGN - 1) / SHARED_EXPORT_ALIGN) * SHARED_EXPORT_ALIGN;
+}
+
+
+CSharedExport::CSharedExport(string const& strName, int const nXGridMax, int const nYGridMax, int const nMaxCoasts, int const nMaxCoastPoints)
+:
+   m_nXGridMax(nXGridMax),
+   m_nYGridMax(nYGridMax),
+   m_nMaxCoasts(nMaxCoasts),
+   m_nMaxCoastPoints(nMaxCoastPoints),
+   m_nBackBuffer(1),
+   m_nSegmentSize(0),
+   m_pcSegment(NULL),
+   m_bAlreadyExists(false),
+   m_strName(strName)
+{
+}
+
+//! Unmaps and removes the segment. A reader which already has it mapped can carry on reading the last data published
+CSharedExport::~CSharedExport(void)
+{
+#ifndef _WIN32
+   if (m_pcSegment)
+   {
+      munmap(m_pcSegment, m_nSegmentSize);
+      shm_unlink(m_strName.c_str());
+   }
+#endif
+}
+
+
+//! Returns the name of the segment if none is given in the run-data file. This includes the process ID, so that runs with the same run name do not use the same segment
+string CSharedExport::strGetDefaultName(string const& strRunName)
+{
+   string strName = SHARED_EXPORT_DEFAULT_PREFIX + strRunName;
+#ifndef _WIN32
+   strName.append("_");
+   strName.append(std::to_string(static_cast<long>(getpid())));
+#endif
+   return strName;
+}
+
+
+//! Creates and maps the segment, then fills in the header. Returns false if this cannot be done, including if a segment with this name already exists (it may belong to another run, so is left alone)
+bool CSharedExport::bCreate(double const* pdGeoTransform, double const dMissingValue, int const nMissingValue)
+{
+#ifndef _WIN32
+   size_t nCells = static_cast<size_t>(m_nXGridMax) * m_nYGridMax;
+
+   SharedExportHeader Header;
+   memset(&Header, 0, sizeof(Header));
+   strcpy(Header.szMagic, SHARED_EXPORT_MAGIC);
+   Header.ulHeaderSize = sizeof(SharedExportHeader);
+   Header.ulBufferHeaderSize = sizeof(SharedExportBufferHeader);
+   Header.nXGridMax = m_nXGridMax;
+   Header.nYGridMax = m_nYGridMax;
+   Header.nMaxCoasts = m_nMaxCoasts;
+   Header.nMaxCoastPoints = m_nMaxCoastPoints;
+   for (int n = 0; n < 6; n++)
+      Header.dGeoTransform[n] = pdGeoTransform[n];
+   Header.dMissingValue = dMissingValue;
+   Header.nMissingValue = nMissingValue;
+
+   // Within each buffer, everything is aligned
+   Header.ullFloatFieldOffset = nAlign(sizeof(SharedExportBufferHeader));
+   Header.ullPolygonIDOffset = Header.ullFloatFieldOffset + nAlign(SHARED_EXPORT_NUM_FLOAT_FIELDS * nCells * sizeof(float));
+   Header.ullCoastStartOffset = Header.ullPolygonIDOffset + nAlign(nCells * sizeof(int32_t));
+   Header.ullCoastPointOffset = Header.ullCoastStartOffset + nAlign((m_nMaxCoasts + 1) * sizeof(int32_t));
+   Header.ullBufferSize = Header.ullCoastPointOffset + nAlign(2 * m_nMaxCoastPoints * sizeof(double));
+
+   // Each buffer starts on a new page
+   size_t nPage = sysconf(_SC_PAGESIZE);
+   Header.ullBufferOffset[0] = ((sizeof(SharedExportHeader) + nPage - 1) / nPage) * nPage;
+   Header.ullBufferOffset[1] = Header.ullBufferOffset[0] + ((Header.ullBufferSize + nPage - 1) / nPage) * nPage;
+   m_nSegmentSize = Header.ullBufferOffset[1] + Header.ullBufferSize;
+
+   // Readers only need to read
+   int nFile = shm_open(m_strName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+   if (nFile < 0)
+   {
+      m_bAlreadyExists = (errno == EEXIST);
+      return false;
+   }
+
+   if (ftruncate(nFile, m_nSegmentSize) < 0)
+   {
+      close(nFile);
+      shm_unlink(m_strName.c_str());
+      return false;
+   }
+
+   void* pMem = mmap(NULL, m_nSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, nFile, 0);
+   close(nFile);
+   if (pMem == MAP_FAILED)
+   {
+      shm_unlink(m_strName.c_str());
+      return false;
+   }
+
+   // The segment is zero-filled, so the sequence number is zero until the first buffer is published
+   m_pcSegment = static_cast<char*>(pMem);
+   memcpy(m_pcSegment, &Header, sizeof(Header));
+
+   return true;
+#else
+   return false;
+#endif
+}
+
+
+//! Returns a pointer to the start of a buffer
+char* CSharedExport::pcGetBuffer(int const nBuffer) const
+{
+   SharedExportHeader const* pHeader = reinterpret_cast<SharedExportHeader const*>(m_pcSegment);
+   return m_pcSegment + pHeader->ullBufferOffset[nBuffer];
+}
+
+
+//! Must be called before writing to the buffer which is to be published next, so that readers know that it is being overwritten
+void CSharedExport::StartWrite(void)
+{
+   SharedExportHeader* pHeader = reinterpret_cast<SharedExportHeader*>(m_pcSegment);
+   pHeader->ullWriting = pHeader->ullSequence + 1;
+
+   // Make sure that readers see this before they see any change to the buffer
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+
+//! Returns a pointer to one of the floating-point fields in the buffer which is to be published next
+float* CSharedExport::pfGetField(int const nField) const
+{
+   SharedExportHeader const* pHeader = reinterpret_cast<SharedExportHeader const*>(m_pcSegment);
+   return reinterpret_cast<float*>(pcGetBuffer(m_nBackBuffer) + pHeader->ullFloatFieldOffset) + (static_cast<size_t>(nField) * m_nXGridMax * m_nYGridMax);
+}
+
+
+//! Returns a pointer to the polygon ID field in the buffer which is to be published next
+int32_t* CSharedExport::pnGetPolygonID(void) const
+{
+   SharedExportHeader const* pHeader = reinterpret_cast<SharedExportHeader const*>(m_pcSegment);
+   return reinterpret_cast<int32_t*>(pcGetBuffer(m_nBackBuffer) + pHeader->ullPolygonIDOffset);
+}
+
+
+//! Returns a pointer to the index of the first point of each coastline, in the buffer which is to be published next
+int32_t* CSharedExport::pnGetCoastStart(void) const
+{
+   SharedExportHeader const* pHeader = reinterpret_cast<SharedExportHeader const*>(m_pcSegment);
+   return reinterpret_cast<int32_t*>(pcGetBuffer(m_nBackBuffer) + pHeader->ullCoastStartOffset);
+}
+
+
+//! Returns a pointer to the coastline points, in the buffer which is to be published next
+double* CSharedExport::pdGetCoastPoints(void) const
+{
+   SharedExportHeader const* pHeader = reinterpret_cast<SharedExportHeader const*>(m_pcSegment);
+   return reinterpret_cast<double*>(pcGetBuffer(m_nBackBuffer) + pHeader->ullCoastPointOffset);
+}
+
+
+//! Returns the maximum number of coastlines which can be published
+int CSharedExport::nGetMaxCoasts(void) const
+{
+   return m_nMaxCoasts;
+}
+
+
+//! Returns the maximum number of coastline points (all coastlines) which can be published
+int CSharedExport::nGetMaxCoastPoints(void) const
+{
+   return m_nMaxCoastPoints;
+}
+
+
+//! Fills in the header of the buffer which has just been written, then publishes it. The other buffer will be written next
+void CSharedExport::Publish(unsigned long const ulTimestep, double const dSimElapsed, int const nNumCoasts, int const nNumCoastPoints, bool const bTruncated)
+{
+   SharedExportBufferHeader* pBufferHeader = reinterpret_cast<SharedExportBufferHeader*>(pcGetBuffer(m_nBackBuffer));
+   pBufferHeader->ullTimestep = ulTimestep;
+   pBufferHeader->dSimElapsed = dSimElapsed;
+   pBufferHeader->nNumCoasts = nNumCoasts;
+   pBufferHeader->nNumCoastPoints = nNumCoastPoints;
+   pBufferHeader->nCoastsTruncated = (bTruncated ? 1 : 0);
+
+   // Make sure that readers see all of the buffer before they see the new sequence number
+   std::atomic_thread_fence(std::memory_order_release);
+
+   SharedExportHeader* pHeader = reinterpret_cast<SharedExportHeader*>(m_pcSegment);
+   pHeader->ullSequence = pHeader->ullSequence + 1;
+
+   m_nBackBuffer = 1 - m_nBackBuffer;
+}
+
+
+//! Returns the name of the segment
+string CSharedExport::strGetName(void) const
+{
+   return m_strName;
+}
+
+
+//! Returns true if bCreate() failed because a segment with this name already exists
+bool CSharedExport::bAlreadyExists(void) const
+{
+   return m_bAlreadyExists;
+}
+
+
+//! Returns the size of the segment in bytes
+size_t CSharedExport::nGetSize(void) const
+{
+   return m_nSegmentSize;
+}
+
+
+//! Returns the number of buffers published so far
+unsigned long long CSharedExport::ullGetSequence(void) const
+{
+   return (m_pcSegment ? reinterpret_cast<SharedExportHeader const*>(m_pcSegment)->ullSequence : 0);
+}
@@ -0,0 +1,140 @@
+/*!
+ *
+ * \class CSharedExport
+ * \brief Class used to publish grid fields and coastlines in POSIX shared memory, for live visualization
+ * \details Some raster fields (top elevation, sea depth, wave height and polygon ID) and the current coastlines are copied into a shared-memory segment every Nth timestep. A viewer or analysis program maps the segment read-only, and reads the data in place: there is no copying and no disk I/O.
+ *
+ * The segment holds a header, followed by two buffers. While the simulation writes one buffer, the other holds the most recent complete data. Before starting to write a buffer, the simulation sets the 'writing' counter in the header to the number which that buffer will have; when the buffer is complete, the sequence counter is set to this number. The most recent complete buffer is (sequence % 2). To read consistently, a reader should:
+ *
+ *    1. read the sequence counter S (if it is zero, no data has been published yet)
+ *    2. read what it needs from buffer (S % 2)
+ *    3. read the writing counter W. If W > S + 1 then the simulation has begun to overwrite the buffer, so go back to 1
+ *
+ * So a reader has a whole export interval in which to read a buffer. On weakly-ordered CPUs, the reader needs an acquire fence after step 1 and before step 3
+ *
+ * All values are in the byte order of the machine on which the simulation is running. Raster fields are stored by row, from the north edge of the grid, as for the GIS output
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file shared_export.h
+ * \brief Contains CSharedExport definitions
+ *
+ */
+
+#ifndef SHAREDEXPORT_H
+#define SHAREDEXPORT_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <cstddef>
+#include <stdint.h>
+
+#include <string>
+using std::string;
+
+
+char const     SHARED_EXPORT_MAGIC[]                  = "CMESHM1";
+size_t const   SHARED_EXPORT_ALIGN                    = 64;                // Everything within a buffer starts on a multiple of this many bytes
+
+// The floating-point raster fields, in the order in which they are stored in each buffer. The polygon ID field (32-bit integers) follows these
+int const
+   SHARED_EXPORT_TOP_ELEV = 0,
+   SHARED_EXPORT_SEA_DEPTH = 1,
+   SHARED_EXPORT_WAVE_HEIGHT = 2,
+   SHARED_EXPORT_NUM_FLOAT_FIELDS = 3;
+
+// The layout of the segment. These are plain structs, so that a reader (which need not be written in C++) can use the same layout
+struct SharedExportHeader
+{
+   char szMagic[8];                       // "CMESHM1", with a terminating zero
+   uint32_t ulHeaderSize;                 // Size of this struct in bytes
+   uint32_t ulBufferHeaderSize;           // Size of SharedExportBufferHeader in bytes
+   int32_t nXGridMax;                     // Grid size in cells
+   int32_t nYGridMax;
+   int32_t nMaxCoasts;                    // Capacity of the coastline part of each buffer
+   int32_t nMaxCoastPoints;
+   double dGeoTransform[6];               // As for the GIS output: maps cell (nX, nY) to external CRS coordinates
+   double dMissingValue;                  // Used for floating-point cells with no value
+   int32_t nMissingValue;                 // Used for integer cells with no value
+   int32_t nPadding;
+   uint64_t ullBufferOffset[2];           // Offset in bytes of each buffer from the start of the segment
+   uint64_t ullBufferSize;                // Size of each buffer in bytes
+   uint64_t ullFloatFieldOffset;          // Offsets in bytes from the start of a buffer: first float field, each is nXGridMax * nYGridMax floats
+   uint64_t ullPolygonIDOffset;           // Polygon ID field, nXGridMax * nYGridMax 32-bit ints
+   uint64_t ullCoastStartOffset;          // Index of the first point of each coastline, (nMaxCoasts + 1) 32-bit ints
+   uint64_t ullCoastPointOffset;          // Coastline points as (x, y) pairs of doubles, in external CRS units
+   volatile uint64_t ullSequence;         // Number of buffers published so far
+   volatile uint64_t ullWriting;          // Number of the buffer being written, or of the last buffer written
+};
+
+struct SharedExportBufferHeader
+{
+   uint64_t ullTimestep;
+   double dSimElapsed;                    // Hours
+   int32_t nNumCoasts;
+   int32_t nNumCoastPoints;               // Points for coastline n are nCoastStart[n] to nCoastStart[n+1] - 1
+   int32_t nCoastsTruncated;              // Non-zero if there were too many coastlines or coastline points to fit
+   int32_t nPadding;
+};
+
+
+class CSharedExport
+{
+private:
+   int
+      m_nXGridMax,
+      m_nYGridMax,
+      m_nMaxCoasts,
+      m_nMaxCoastPoints,
+      m_nBackBuffer;                      // The buffer being written
+
+   size_t
+      m_nSegmentSize;
+
+   char*
+      m_pcSegment;
+
+   bool
+      m_bAlreadyExists;                   // Set if bCreate() failed because a segment with this name already exists
+
+   string
+      m_strName;
+
+   char* pcGetBuffer(int const) const;
+
+public:
+   CSharedExport(string const&, int const, int const, int const, int const);
+   ~CSharedExport(void);
+
+   static string strGetDefaultName(string const&);
+
+   bool bCreate(double const*, double const, int const);
+   bool bAlreadyExists(void) const;
+
+   void StartWrite(void);
+
+   float* pfGetField(int const) const;
+   int32_t* pnGetPolygonID(void) const;
+   int32_t* pnGetCoastStart(void) const;
+   double* pdGetCoastPoints(void) const;
+   int nGetMaxCoasts(void) const;
+   int nGetMaxCoastPoints(void) const;
+
+   void Publish(unsigned long const, double const, int const, int const, bool const);
+
+   string strGetName(void) const;
+   size_t nGetSize(void) const;
+   unsigned long long ullGetSequence(void) const;
+};
+#endif // SHAREDEXPORT_H
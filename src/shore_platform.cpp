@@ -34,10 +34,15 @@ using std::ios;
 #include <iomanip>
 using std::setiosflags;
 
+#include <sstream>
+using std::ostringstream;
+
 #include "cme.h"
 #include "hermite_cubic.h"
 #include "simulation.h"
 #include "coast.h"
+#include "parallel_profile_cache.h"
+#include "trace_writer.h"
 
 
 /*===============================================================================================================================
@@ -49,33 +54,49 @@ int CSimulation::nDoAllShorePlatFormErosion(void)
 {
    static bool bForward = true;
 
-   // Do this for each coast
-   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   // Profile data is saved to file in sequence, so if this is wanted we cannot work in parallel
+   if (m_bParallelPlatformErosion && (! m_bOutputProfileData) && (! m_bOutputParallelProfileData))
    {
-      int const nNumProfiles = m_VCoast[nCoast].nGetNumProfiles();
-
-      // Calculate potential erosion on every coastline-normal profile. Can do this in the original, curvature-related, sequence of profiles
-      int nProfile = 0;
-      for ((bForward ? nProfile = 0 : nProfile = (nNumProfiles-1)); (bForward ? nProfile < nNumProfiles : nProfile >= 0); (bForward ? nProfile++ : nProfile--))
+      int const nRet = nDoAllPotentialPlatformErosionInParallel(bForward);
+      if (nRet != RTN_OK)
+         return nRet;
+   }
+   else
+   {
+      // Do this for each coast
+      for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
       {
-         // Calculate potential platform erosion along the length of this profile
-         int const nRet = nCalcPotentialPlatformErosionOnProfile(nCoast, nProfile);
-         if (nRet != RTN_OK)
-            return nRet;
-      }
+         int const nNumProfiles = m_VCoast[nCoast].nGetNumProfiles();
 
-      // Calculate potential platform erosion between the coastline-normal profiles. Do this in along-coastline sequence
-      int nProfIndex = 0;
-      for ((bForward ? nProfIndex = 0 : nProfIndex = (nNumProfiles-1)); (bForward ? nProfIndex < nNumProfiles : nProfIndex >= 0); (bForward ? nProfIndex++ : nProfIndex--))
-      {
-         // Calculate potential erosion for sea cells between this profile and the next profile (or up to the edge of the grid) on these cells
-         int nRet = nCalcPotentialPlatformErosionBetweenProfiles(nCoast, nProfIndex, DIRECTION_DOWNCOAST);
-         if (nRet != RTN_OK)
-            return nRet;
+         // Calculate potential erosion on every coastline-normal profile. Can do this in the original, curvature-related, sequence of profiles
+         int nProfile = 0;
+         for ((bForward ? nProfile = 0 : nProfile = (nNumProfiles-1)); (bForward ? nProfile < nNumProfiles : nProfile >= 0); (bForward ? nProfile++ : nProfile--))
+         {
+            // Calculate potential platform erosion along the length of this profile
+            PlatformErosionRecord Record;
+            int const nRet = nCalcPotentialPlatformErosionOnProfile(nCoast, nProfile, &Record);
+            ApplyPlatformErosionRecord(&Record, true);
+            if (nRet != RTN_OK)
+               return nRet;
+         }
 
-         nRet = nCalcPotentialPlatformErosionBetweenProfiles(nCoast, nProfIndex, DIRECTION_UPCOAST);
-         if (nRet != RTN_OK)
-            return nRet;
+         // Calculate potential platform erosion between the coastline-normal profiles. Do this in along-coastline sequence
+         int nProfIndex = 0;
+         for ((bForward ? nProfIndex = 0 : nProfIndex = (nNumProfiles-1)); (bForward ? nProfIndex < nNumProfiles : nProfIndex >= 0); (bForward ? nProfIndex++ : nProfIndex--))
+         {
+            // Calculate potential erosion for sea cells between this profile and the next profile (or up to the edge of the grid) on these cells
+            PlatformErosionRecord RecordDown;
+            int nRet = nCalcPotentialPlatformErosionBetweenProfiles(nCoast, nProfIndex, DIRECTION_DOWNCOAST, &RecordDown);
+            ApplyPlatformErosionRecord(&RecordDown, false);
+            if (nRet != RTN_OK)
+               return nRet;
+
+            PlatformErosionRecord RecordUp;
+            nRet = nCalcPotentialPlatformErosionBetweenProfiles(nCoast, nProfIndex, DIRECTION_UPCOAST, &RecordUp);
+            ApplyPlatformErosionRecord(&RecordUp, false);
+            if (nRet != RTN_OK)
+               return nRet;
+         }
       }
    }
 
@@ -89,15 +110,22 @@ int CSimulation::nDoAllShorePlatFormErosion(void)
    // Do the same for beach protection
    FillInBeachProtectionHoles();
 
-   // Finally calculate actual platform erosion on all sea cells (both on profiles, and between profiles)
+   // Finally calculate actual platform erosion on all sea cells (both on profiles, and between profiles). If the grid is tiled, only visit the tiles which have been in use during this timestep: no other cell can have potential platform erosion
+   vector<pair<int, int> > prVRun;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
-      for (int nY = 0; nY < m_nYGridMax; nY++)
+      m_pRasterGrid->m_Cell.GetActiveRuns(nX, 1, &prVRun);
+      for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
       {
-         if (m_pRasterGrid->m_Cell[nX][nY].bPotentialPlatformErosion())
-            // Calculate actual (supply-limited) shore platform erosion on each cell that has potential platform erosion, also add the eroded sand/coarse sediment to that cells's polygon, ready to be redistributed within the polygon during beach erosion/deposition
-            DoActualShorePlatformErosionOnCell(nX, nY);
+         for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
+         {
+            if (m_pRasterGrid->m_Cell[nX][nY].bPotentialPlatformErosion())
+               // Calculate actual (supply-limited) shore platform erosion on each cell that has potential platform erosion, also add the eroded sand/coarse sediment to that cells's polygon, ready to be redistributed within the polygon during beach erosion/deposition
+               DoActualShorePlatformErosionOnCell(nX, nY);
+         }
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
    
    LogStream << endl << m_ulTimestep << ": potential platform erosion = " << m_dThisTimestepPotentialPlatformErosion << " (on profiles = " << m_dTotPotErosionOnProfiles << ", between profiles = " << m_dTotPotErosionBetweenProfiles << ")" << endl;
@@ -107,6 +135,222 @@ int CSimulation::nDoAllShorePlatFormErosion(void)
 }
 
 
+/*===============================================================================================================================
+
+ Applies the changes which potential platform erosion on a profile (or between profiles) makes to this-timestep totals and check values, and writes any messages to the log file
+
+===============================================================================================================================*/
+void CSimulation::ApplyPlatformErosionRecord(PlatformErosionRecord const* pRecord, bool const bOnProfile)
+{
+   if (! pRecord->strLog.empty())
+      LogStream << pRecord->strLog;
+
+   // The changes are applied in the same sequence as they were made
+   for (unsigned int n = 0; n < pRecord->dVErosionChange.size(); n++)
+   {
+      m_dThisTimestepPotentialPlatformErosion += pRecord->dVErosionChange[n];
+
+      if (bOnProfile)
+         m_dTotPotErosionOnProfiles += pRecord->dVErosionChange[n];
+      else
+         m_dTotPotErosionBetweenProfiles += pRecord->dVErosionChange[n];
+   }
+
+   // Note that nNumCells may be -ve
+   m_ulThisTimestepNumPotentialPlatformErosionCells += pRecord->nNumCells;
+
+   if (bOnProfile)
+      m_ulTotPotentialPlatformErosionOnProfiles += pRecord->nNumCells;
+   else
+      m_ulTotPotentialPlatformErosionBetweenProfiles += pRecord->nNumCells;
+}
+
+
+/*===============================================================================================================================
+
+ Gets all cells (as (nX * m_nYGridMax) + nY) on which nCalcPotentialPlatformErosionBetweenProfiles() could change potential platform erosion, working from a given profile in a given direction. The parallel profiles are constructed in the same way, and are added to the parallel profile cache. May return more cells than are actually changed, but never fewer
+
+===============================================================================================================================*/
+void CSimulation::GetPlatformErosionBetweenProfilesCells(int const nCoast, int const nProfIndex, int const nDirection, vector<int>* pnVCell)
+{
+   int const nProfile = m_VCoast[nCoast].nGetProfileAtAlongCoastlinePosition(nProfIndex);
+   CGeomProfile* const pProfile = m_VCoast[nCoast].pGetProfile(nProfile);
+
+   if (! pProfile->bOKIncStartAndEndOfCoast())
+      return;
+
+   int const
+      nProfSize = pProfile->nGetNumCellsInProfile(),
+      nCoastProfileStart = pProfile->nGetNumCoastPoint(),
+      nProfileStartX = pProfile->pPtiVGetCellsInProfile()->at(0).nGetX(),
+      nProfileStartY = pProfile->pPtiVGetCellsInProfile()->at(0).nGetY(),
+      nCoastMax = m_VCoast[nCoast].nGetCoastlineSize();
+   int
+      nParCoastXLast = nProfileStartX,
+      nParCoastYLast = nProfileStartY;
+
+   // Move on, or leave the loop, under the same conditions as in nCalcPotentialPlatformErosionBetweenProfiles()
+   for (int nDistFromProfile = 1; ; nDistFromProfile++)
+   {
+      int nThisPointOnCoast = nCoastProfileStart;
+      if (nDirection == DIRECTION_DOWNCOAST)
+         nThisPointOnCoast += nDistFromProfile;
+      else
+         nThisPointOnCoast -= nDistFromProfile;
+
+      if ((nThisPointOnCoast < 0) || (nThisPointOnCoast >= nCoastMax))
+         break;
+
+      if (m_VCoast[nCoast].dGetDepthOfBreaking(nThisPointOnCoast) == DBL_NODATA)
+         continue;
+
+      int const
+         nParCoastX = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nThisPointOnCoast)->nGetX(),
+         nParCoastY = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nThisPointOnCoast)->nGetY();
+
+      if ((nParCoastX == nParCoastXLast) && (nParCoastY == nParCoastYLast))
+         continue;
+
+      if (m_pRasterGrid->m_Cell[nParCoastX][nParCoastY].bIsNormalProfile())
+         break;
+
+      nParCoastXLast = nParCoastX;
+      nParCoastYLast = nParCoastY;
+
+      int nCacheEntry = m_pParallelProfileCache->nFindEntry(nCoast, nProfile, nDistFromProfile, nDirection);
+      if (nCacheEntry == INT_NODATA)
+      {
+         vector<CGeom2DIPoint> PtiVGridParProfile;
+         vector<CGeom2DPoint> PtVExtCRSParProfile;
+
+         ConstructParallelProfile(nProfileStartX, nProfileStartY, nParCoastX, nParCoastY, nProfSize, pProfile->pPtiVGetCellsInProfile(), &PtiVGridParProfile, &PtVExtCRSParProfile);
+
+         nCacheEntry = m_pParallelProfileCache->nAddEntry(nCoast, nProfile, nDistFromProfile, nDirection, &PtiVGridParProfile, &PtVExtCRSParProfile);
+      }
+
+      // Only the cells between the first and last cells of the parallel profile are changed
+      vector<CGeom2DIPoint> const* pPtiVGridParProfile = m_pParallelProfileCache->pPtiVGetCells(nCacheEntry);
+      for (int i = 1; i < static_cast<int>(pPtiVGridParProfile->size())-1; i++)
+         pnVCell->push_back((pPtiVGridParProfile->at(i).nGetX() * m_nYGridMax) + pPtiVGridParProfile->at(i).nGetY());
+   }
+}
+
+
+/*===============================================================================================================================
+
+ Calculates potential platform erosion on and between all coastline-normal profiles, working on several profiles at once. The tasks (one for each profile, then two for the cells between each pair of profiles) are first put into levels: each task goes into the level after the highest level of any earlier task (in the sequential order used by nDoAllShorePlatFormErosion()) which changes any of the same cells. So tasks in the same level do not change any of the same cells, and can be done at the same time, while tasks which do change the same cells are still done in the sequential order. Each task's changes to this-timestep totals are recorded, then all are applied in sequential order. Results are therefore identical to those from the sequential version, whatever the number of threads
+
+===============================================================================================================================*/
+int CSimulation::nDoAllPotentialPlatformErosionInParallel(bool const bForward)
+{
+   // Each task is (coast, profile or profile index, direction), where direction is INT_NODATA for on-profile tasks
+   vector<int>
+      nVTaskCoast,
+      nVTaskProfile,
+      nVTaskDirection,
+      nVTaskLevel;
+
+   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   {
+      int const nNumProfiles = m_VCoast[nCoast].nGetNumProfiles();
+
+      for (int n = 0; n < nNumProfiles; n++)
+      {
+         nVTaskCoast.push_back(nCoast);
+         nVTaskProfile.push_back(bForward ? n : nNumProfiles-1-n);
+         nVTaskDirection.push_back(INT_NODATA);
+      }
+
+      for (int n = 0; n < nNumProfiles; n++)
+      {
+         for (int m = 0; m < 2; m++)
+         {
+            nVTaskCoast.push_back(nCoast);
+            nVTaskProfile.push_back(bForward ? n : nNumProfiles-1-n);
+            nVTaskDirection.push_back(m == 0 ? DIRECTION_DOWNCOAST : DIRECTION_UPCOAST);
+         }
+      }
+   }
+
+   int const nTasks = nVTaskCoast.size();
+
+   // Now put each task into a level. For each cell, this stores the highest level of any task so far which changes the cell
+   vector<int> nVCellLevel(m_nXGridMax * m_nYGridMax, -1);
+   int nMaxLevel = -1;
+   for (int nTask = 0; nTask < nTasks; nTask++)
+   {
+      vector<int> nVCell;
+      if (nVTaskDirection[nTask] == INT_NODATA)
+      {
+         CGeomProfile* const pProfile = m_VCoast[nVTaskCoast[nTask]].pGetProfile(nVTaskProfile[nTask]);
+         if (pProfile->bOKIncStartAndEndOfCoast())
+         {
+            // Only the cells between the first and last cells of the profile are changed
+            for (int i = 1; i < pProfile->nGetNumCellsInProfile()-1; i++)
+               nVCell.push_back((pProfile->pPtiVGetCellsInProfile()->at(i).nGetX() * m_nYGridMax) + pProfile->pPtiVGetCellsInProfile()->at(i).nGetY());
+         }
+      }
+      else
+         GetPlatformErosionBetweenProfilesCells(nVTaskCoast[nTask], nVTaskProfile[nTask], nVTaskDirection[nTask], &nVCell);
+
+      int nLevel = 0;
+      for (unsigned int n = 0; n < nVCell.size(); n++)
+         nLevel = tMax(nLevel, nVCellLevel[nVCell[n]] + 1);
+
+      for (unsigned int n = 0; n < nVCell.size(); n++)
+         nVCellLevel[nVCell[n]] = nLevel;
+
+      nVTaskLevel.push_back(nLevel);
+      nMaxLevel = tMax(nMaxLevel, nLevel);
+   }
+
+   // Get the tasks in each level
+   vector<vector<int> > nVVLevelTask(nMaxLevel+1);
+   for (int nTask = 0; nTask < nTasks; nTask++)
+      nVVLevelTask[nVTaskLevel[nTask]].push_back(nTask);
+
+   // Do the tasks, one level at a time
+   vector<PlatformErosionRecord> VRecord(nTasks);
+   vector<int> nVRet(nTasks, RTN_OK);
+   for (int nLevel = 0; nLevel <= nMaxLevel; nLevel++)
+   {
+      int const nLevelTasks = nVVLevelTask[nLevel].size();
+
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic)
+#endif
+      for (int n = 0; n < nLevelTasks; n++)
+      {
+         int const nTask = nVVLevelTask[nLevel][n];
+
+         bool bTrace = (m_pTraceWriter && m_pTraceWriter->bTraceItem(nVTaskProfile[nTask]));
+         double dTraceStart = 0;
+         if (bTrace)
+            dTraceStart = m_pTraceWriter->dGetTime();
+
+         if (nVTaskDirection[nTask] == INT_NODATA)
+            nVRet[nTask] = nCalcPotentialPlatformErosionOnProfile(nVTaskCoast[nTask], nVTaskProfile[nTask], &VRecord[nTask]);
+         else
+            nVRet[nTask] = nCalcPotentialPlatformErosionBetweenProfiles(nVTaskCoast[nTask], nVTaskProfile[nTask], nVTaskDirection[nTask], &VRecord[nTask]);
+
+         if (bTrace)
+            m_pTraceWriter->AddSpan((nVTaskDirection[nTask] == INT_NODATA ? "Platform erosion on profile" : "Platform erosion between profiles"), "profile", dTraceStart, nVTaskCoast[nTask], "profile", nVTaskProfile[nTask]);
+      }
+   }
+
+   // And finally apply the recorded changes in sequential order
+   for (int nTask = 0; nTask < nTasks; nTask++)
+   {
+      ApplyPlatformErosionRecord(&VRecord[nTask], (nVTaskDirection[nTask] == INT_NODATA));
+
+      if (nVRet[nTask] != RTN_OK)
+         return nVRet[nTask];
+   }
+
+   return RTN_OK;
+}
+
+
 /*==============================================================================================================================
 
  Calculates potential (i.e. unconstrained by available sediment) erosional lowering of the shore platform for a single coastline-normal profile, due to wave action.
@@ -116,10 +360,12 @@ int CSimulation::nDoAllShorePlatFormErosion(void)
  Originally coded in Matlab, by Andres Payo
 
 ==============================================================================================================================*/
-int CSimulation::nCalcPotentialPlatformErosionOnProfile(int const nCoast, int const nProfile)
+int CSimulation::nCalcPotentialPlatformErosionOnProfile(int const nCoast, int const nProfile, PlatformErosionRecord* pRecord)
 {
    CGeomProfile* const pProfile = m_VCoast[nCoast].pGetProfile(nProfile);
 
+   pRecord->nNumCells = 0;
+
    // Only work on this profile if it is problem-free TODO ANDRES Or if it has just hit dry land?
    if (! pProfile->bOKIncStartAndEndOfCoast())    //  || (pProfile->nGetProblemCode() == PROFILE_DRYLAND))
       return RTN_OK;
@@ -225,10 +471,13 @@ int CSimulation::nCalcPotentialPlatformErosionOnProfile(int const nCoast, int co
       // Constrain dDepthOverDB[i] to be between 0 (can get small -ve values due to rounding errors) and m_dDepthOverDBMax
       dVProfileDepthOverDB[i] = tMax(dVProfileDepthOverDB[i], 0.0);
       dVProfileDepthOverDB[i] = tMin(dVProfileDepthOverDB[i], m_dDepthOverDBMax);
+   }
 
-      // And then use the look-up table to find the value of erosion potential at this point on the profile
-      dVProfileErosionPotential[i] = dLookUpErosionPotential(dVProfileDepthOverDB[i]);
+   // And then use the look-up table to find the value of erosion potential at every point on the profile, in a single batch
+   LookUpErosionPotential(nProfSize, &dVProfileDepthOverDB[0], &dVProfileErosionPotential[0]);
 
+   for (int i = 0; i < nProfSize; i++)
+   {
       // If erosion potential (a -ve value) is tiny, set it to zero
       if (dVProfileErosionPotential[i] > -SEDIMENT_ELEV_TOLERANCE)
          dVProfileErosionPotential[i] = 0;
@@ -309,14 +558,9 @@ int CSimulation::nCalcPotentialPlatformErosionOnProfile(int const nCoast, int co
          // Set the potential (unconstrained) erosion for this cell, is a +ve value
          m_pRasterGrid->m_Cell[nX][nY].SetPotentialPlatformErosion(-dDeltaZ);
 
-         // Update this-timestep totals
-         m_ulThisTimestepNumPotentialPlatformErosionCells++;
-         m_dThisTimestepPotentialPlatformErosion -= dDeltaZ;       // Since dDeltaZ is a -ve value
-//             assert(m_dThisTimestepPotentialPlatformErosion >= 0);
-
-         // Increment the check values
-         m_ulTotPotentialPlatformErosionOnProfiles++;
-         m_dTotPotErosionOnProfiles -= dDeltaZ;
+         // Record the changes to this-timestep totals and to the check values, these are made by ApplyPlatformErosionRecord()
+         pRecord->nNumCells++;
+         pRecord->dVErosionChange.push_back(-dDeltaZ);             // Since dDeltaZ is a -ve value
       }
 
       // Finally, calculate the beach protection factor, this will be used in estimating actual (supply-limited) erosion
@@ -341,8 +585,10 @@ int CSimulation::nCalcPotentialPlatformErosionOnProfile(int const nCoast, int co
  Calculates potential platform erosion on cells to one side of a given coastline-normal profile, up to the next profile
 
 ==============================================================================================================================*/
-int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast, int const nProfIndex, int const nDirection)
+int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast, int const nProfIndex, int const nDirection, PlatformErosionRecord* pRecord)
 {
+   pRecord->nNumCells = 0;
+
    // Get the number of the coastline-normal profile
    int const nProfile = m_VCoast[nCoast].nGetProfileAtAlongCoastlinePosition(nProfIndex);
    CGeomProfile* const pProfile = m_VCoast[nCoast].pGetProfile(nProfile);
@@ -395,7 +641,9 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
       if (dDepthOfBreaking == DBL_NODATA)
       {
          // This parallel profile is not in the active zone, so no platform erosion here. Move on to the next point along the coastline in this direction
-         LogStream << m_ulTimestep << ": not in active zone at coast point " << nThisPointOnCoast << " when constructing parallel profile for potential platform erosion. Working from profile " << nProfile << ", " << (nDirection == DIRECTION_DOWNCOAST ? "down" : "up") << "-coast, dist from profile = " <<  nDistFromProfile << endl;
+         ostringstream strstr;
+         strstr << m_ulTimestep << ": not in active zone at coast point " << nThisPointOnCoast << " when constructing parallel profile for potential platform erosion. Working from profile " << nProfile << ", " << (nDirection == DIRECTION_DOWNCOAST ? "down" : "up") << "-coast, dist from profile = " <<  nDistFromProfile << endl;
+         pRecord->strLog += strstr.str();
          continue;
       }
 
@@ -409,7 +657,9 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
       if ((nParCoastX == nParCoastXLast) && (nParCoastY == nParCoastYLast))
       {
          // Should not happen, but could do due to rounding errors
-         LogStream << WARN << m_ulTimestep << ": coastline rounding problem on coast " << nCoast << " profile " << nProfile << " at [" << nParCoastX << "][" << nParCoastY << "]" << endl;
+         ostringstream strstr;
+         strstr << WARN << m_ulTimestep << ": coastline rounding problem on coast " << nCoast << " profile " << nProfile << " at [" << nParCoastX << "][" << nParCoastY << "]" << endl;
+         pRecord->strLog += strstr.str();
 
          // So move on to the next point along the coastline in this direction
          continue;
@@ -425,15 +675,39 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
       // Get the height of the associated breaking wave from the coast point: this height is used in beach protection calcs. Note that it will be DBL_NODATA if not in active zone
       double const dBreakingWaveHeight =  m_VCoast[nCoast].dGetBreakingWaveHeight(nThisPointOnCoast);
 
-      // OK, now construct a parallel profile
+      // OK, now construct a parallel profile, or get it from the cache if it has already been constructed since the coastline-normal profiles were last rebuilt
       vector<CGeom2DIPoint>
-         PtiVGridParProfile;        // Integer coords (grid CRS) of cells under the parallel profile
+         PtiVGridParProfileTmp;
       vector<CGeom2DPoint>
-         PtVExtCRSParProfile;        // Co-ords (external CRS) of cells under the parallel profile
+         PtVExtCRSParProfileTmp;
+      vector<CGeom2DIPoint> const*
+         pPtiVGridParProfile = &PtiVGridParProfileTmp;      // Integer coords (grid CRS) of cells under the parallel profile
+      vector<CGeom2DPoint> const*
+         pPtVExtCRSParProfile = &PtVExtCRSParProfileTmp;    // Co-ords (external CRS) of cells under the parallel profile
 
-      ConstructParallelProfile(nProfileStartX, nProfileStartY, nParCoastX, nParCoastY, nProfSize, pProfile->pPtiVGetCellsInProfile(), &PtiVGridParProfile, &PtVExtCRSParProfile);
+      int nCacheEntry = INT_NODATA;
+      if (m_pParallelProfileCache)
+         nCacheEntry = m_pParallelProfileCache->nFindEntry(nCoast, nProfile, nDistFromProfile, nDirection);
 
-      int const nParProfSize = PtiVGridParProfile.size();
+      if (nCacheEntry == INT_NODATA)
+      {
+         ConstructParallelProfile(nProfileStartX, nProfileStartY, nParCoastX, nParCoastY, nProfSize, pProfile->pPtiVGetCellsInProfile(), &PtiVGridParProfileTmp, &PtVExtCRSParProfileTmp);
+
+         // Don't add to the cache if running in parallel (all parallel profiles should have been added before the parallel section started, anyway)
+#ifdef _OPENMP
+         if (m_pParallelProfileCache && (! omp_in_parallel()))
+#else
+         if (m_pParallelProfileCache)
+#endif
+            m_pParallelProfileCache->nAddEntry(nCoast, nProfile, nDistFromProfile, nDirection, &PtiVGridParProfileTmp, &PtVExtCRSParProfileTmp);
+      }
+      else
+      {
+         pPtiVGridParProfile = m_pParallelProfileCache->pPtiVGetCells(nCacheEntry);
+         pPtVExtCRSParProfile = m_pParallelProfileCache->pPtVGetCellsExtCRS(nCacheEntry);
+      }
+
+      int const nParProfSize = pPtiVGridParProfile->size();
       // We have a parallel profile which starts at the coast, but is it long enough to be useful? May have been cut short because it extended outside the grid, or we hit an adjacent profile
       if (nParProfSize < 3)
       {
@@ -445,7 +719,7 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
       }
 
       // This parallel profile is OK, so calculate potential erosion along it. First calculate the length of the parallel profile in external CRS units
-      double const dParProfileLenXY = dGetDistanceBetween(&PtVExtCRSParProfile[0], &PtVExtCRSParProfile[nParProfSize-1]);
+      double const dParProfileLenXY = dGetDistanceBetween(&pPtVExtCRSParProfile->at(0), &pPtVExtCRSParProfile->at(nParProfSize-1));
 
       // Next calculate the distance between profile points, again in external CRS units. Assume that the sample points are equally spaced along the parallel profile (not quite true)
       double const dParSpacingXY = dParProfileLenXY / (nParProfSize - 1);
@@ -461,8 +735,8 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
       for (int i = 0; i < nParProfSize; i++)
       {
          int const
-            nXPar = PtiVGridParProfile[i].nGetX(),
-            nYPar = PtiVGridParProfile[i].nGetY();
+            nXPar = pPtiVGridParProfile->at(i).nGetX(),
+            nYPar = pPtiVGridParProfile->at(i).nGetY();
             
          // Is this a sea cell?
          if (! m_pRasterGrid->m_Cell[nXPar][nYPar].bIsInundated())
@@ -525,10 +799,13 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
          // Constrain dDepthOverDB[i] to be between 0 (can get small -ve due to rounding errors) and m_dDepthOverDBMax
          dVParProfileDepthOverDB[i] = tMax(dVParProfileDepthOverDB[i], 0.0);
          dVParProfileDepthOverDB[i] = tMin(dVParProfileDepthOverDB[i], m_dDepthOverDBMax);
+      }
 
-         // And then use the look-up table to find the value of erosion potential at this point on the profile
-         dVParProfileErosionPotential[i] = dLookUpErosionPotential(dVParProfileDepthOverDB[i]);
+      // And then use the look-up table to find the value of erosion potential at every point on the parallel profile, in a single batch
+      LookUpErosionPotential(nParProfSize, &dVParProfileDepthOverDB[0], &dVParProfileErosionPotential[0]);
 
+      for (int i = 0; i < nParProfSize; i++)
+      {
          // If erosion potential (a -ve value) is tiny, set it to zero
          if (dVParProfileErosionPotential[i] > -SEDIMENT_ELEV_TOLERANCE)
             dVParProfileErosionPotential[i] = 0;
@@ -586,8 +863,8 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
             dDeltaZ = dVParRecessionXY[i] * dSCAPESlope;
 
          int const
-            nXPar = PtiVGridParProfile[i].nGetX(),
-            nYPar = PtiVGridParProfile[i].nGetY();
+            nXPar = pPtiVGridParProfile->at(i).nGetX(),
+            nYPar = pPtiVGridParProfile->at(i).nGetY();
 
          // Store the local slope of the consolidated sediment, this is just for output display purposes
          m_pRasterGrid->m_Cell[nXPar][nYPar].SetLocalConsSlope(dVParConsSlope[i]);
@@ -606,14 +883,9 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
                // Use the larger of the two -ve values
                dDeltaZ = tMin(dPrevPotErosion, dDeltaZ);
 
-               // Adjust this-timestep totals, since this cell has already been eroded
-               m_ulThisTimestepNumPotentialPlatformErosionCells--;
-               m_dThisTimestepPotentialPlatformErosion += dPrevPotErosion;     // Since dPrevPotErosion is +ve
-//                   assert(m_dThisTimestepPotentialPlatformErosion >= 0);
-
-               // And also adjust the check values
-               m_ulTotPotentialPlatformErosionBetweenProfiles--;
-               m_dTotPotErosionBetweenProfiles += dPrevPotErosion;         // Since -ve
+               // Record adjustments to this-timestep totals and to the check values, since this cell has already been eroded
+               pRecord->nNumCells--;
+               pRecord->dVErosionChange.push_back(dPrevPotErosion);        // Since -ve
             }
 
             // Constrain the lowering so we don't get negative slopes or +ve erosion amounts (dDeltaZ must be -ve), this is implicit in SCAPE
@@ -625,14 +897,9 @@ int CSimulation::nCalcPotentialPlatformErosionBetweenProfiles(int const nCoast,
             m_pRasterGrid->m_Cell[nXPar][nYPar].SetPotentialPlatformErosion(-dDeltaZ);
 //               LogStream << "[" << nXPar << "][" << nYPar << "] = {" << dGridCentroidXToExtCRSX(nXPar) << ", " <<  dGridCentroidYToExtCRSY(nYPar) << "} has potential platform erosion = " << -dDeltaZ << endl;
 
-            // Update this-timestep totals
-            m_ulThisTimestepNumPotentialPlatformErosionCells++;
-            m_dThisTimestepPotentialPlatformErosion -= dDeltaZ;                // Since dDeltaZ is a -ve value
-//                assert(m_dThisTimestepPotentialPlatformErosion >= 0);
-
-            // Increment the check values
-            m_ulTotPotentialPlatformErosionBetweenProfiles++;
-            m_dTotPotErosionBetweenProfiles -= dDeltaZ;                    // Since -ve
+            // Record the changes to this-timestep totals and to the check values
+            pRecord->nNumCells++;
+            pRecord->dVErosionChange.push_back(-dDeltaZ);                  // Since dDeltaZ is a -ve value
          }
 
          // Finally, calculate the beach protection factor, this will be used in estimating actual (supply-limited) erosion
@@ -791,7 +1058,7 @@ void CSimulation::DoActualShorePlatformErosionOnCell(int const nX, int const nY)
       {
          // Can get occasional problems with polygon rasterization near the coastline, so also search the eight adjacent cells
          int nDirection[] = {ORIENTATION_NORTH, ORIENTATION_NORTH_EAST, ORIENTATION_EAST, ORIENTATION_SOUTH_EAST, ORIENTATION_SOUTH, ORIENTATION_SOUTH_WEST, ORIENTATION_WEST, ORIENTATION_NORTH_WEST};
-         Rand1Shuffle(nDirection, 8);
+         StreamShuffle(nDirection, 8, RAND_STREAM_PLATFORM_EROSION_ADJ_CELL, nX, nY);
 
          for (int n = 0; n < 8; n++)
          {
@@ -961,6 +1228,10 @@ bool CSimulation::bCreateErosionPotentialLookUp(vector<double> *VdDepthOverDBIn,
       // Erosion potential is unbounded, i.e. it is still -ve when we have reached the end of the look-up vector
       return false;
 
+   // Also make a padded copy of the look-up table for the batched look-up function. The extra values are all zero (as is the final value of the unpadded table) so reading past the end of the unpadded table gives the same result as the scalar look-up, and the batched look-up does not need a bounds check
+   m_VdErosionPotentialPadded = m_VdErosionPotential;
+   m_VdErosionPotentialPadded.resize(m_VdErosionPotential.size() + EROSION_POTENTIAL_LOOKUP_PADDING, 0);
+
    // All OK
    return true;
 }
@@ -996,6 +1267,37 @@ double CSimulation::dLookUpErosionPotential(double const dDepthOverDB) const
 }
 
 
+/*==============================================================================================================================
+
+ The batched erosion potential lookup: for each of nPoints values of Depth Over DB in pdDepthOverDB, it puts the corresponding value of erosion potential into pdErosionPotential. The results are identical to those from dLookUpErosionPotential(), but the loop has no branches so that the compiler can vectorize it (the table look-ups become gathers)
+
+==============================================================================================================================*/
+void CSimulation::LookUpErosionPotential(int const nPoints, double const* pdDepthOverDB, double* pdErosionPotential) const
+{
+   double const* pdTable = &m_VdErosionPotentialPadded[0];
+
+#ifdef _OPENMP
+   #pragma omp simd
+#endif
+   for (int i = 0; i < nPoints; i++)
+   {
+      // Clamp before calculating the look-up index, so that the index is always within the padded table. Values of Depth Over DB which exceed the maximum are dealt with below
+      double dDepthOverDB = tMin(pdDepthOverDB[i], m_dDepthOverDBMax);
+      double dLookUpIndex = dDepthOverDB * INVERSE_DEPTH_OVER_DB_INCREMENT;
+
+      // Depth Over DB is never -ve, so truncation gives the same integer part as modf()
+      int nIndex = static_cast<int>(dLookUpIndex);
+      double dFractPart = dLookUpIndex - nIndex;
+
+      // Always interpolate: if the fractional part is zero, this gives the same value as no interpolation
+      double dErosionPotential = pdTable[nIndex] - (dFractPart * (pdTable[nIndex] - pdTable[nIndex + 1]));
+
+      // If Depth Over DB exceeds the maximum, erosion potential is zero
+      pdErosionPotential[i] = (pdDepthOverDB[i] > m_dDepthOverDBMax ? 0 : dErosionPotential);
+   }
+}
+
+
 /*==============================================================================================================================
 
  Calculates the (inverse) beach protection factor as in SCAPE: 0 is fully protected, 1 = no protection
@@ -1043,63 +1345,71 @@ double CSimulation::dCalcBeachProtectionFactor(int const nX, int const nY, doubl
 ===============================================================================================================================*/
 void CSimulation::FillInBeachProtectionHoles(void)
 {
+   // If the grid is tiled, only visit the tiles which have been in use during this timestep: no other cell can be a sea cell
+   vector<pair<int, int> > prVRun;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
-      for (int nY = 0; nY < m_nYGridMax; nY++)
+      m_pRasterGrid->m_Cell.GetActiveRuns(nX, 1, &prVRun);
+      for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
       {
-         if ((m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (m_pRasterGrid->m_Cell[nX][nY].dGetBeachProtectionFactor() == DBL_NODATA))
+         for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
          {
-            // This is a sea cell, and it has an initialized beach protection value. So look at its N-S and W-E neighbours
-            int
-               nXTmp,
-               nYTmp,
-               nAdjacent = 0;
-            double
-               dBeachProtection = 0;
-
-            // North
-            nXTmp = nX;
-            nYTmp = nY-1;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
+            if ((m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (m_pRasterGrid->m_Cell[nX][nY].dGetBeachProtectionFactor() == DBL_NODATA))
             {
-               nAdjacent++;
-               dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
-            }
+               // This is a sea cell, and it has an initialized beach protection value. So look at its N-S and W-E neighbours
+               int
+                  nXTmp,
+                  nYTmp,
+                  nAdjacent = 0;
+               double
+                  dBeachProtection = 0;
+
+               // North
+               nXTmp = nX;
+               nYTmp = nY-1;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
+               {
+                  nAdjacent++;
+                  dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
+               }
 
-            // East
-            nXTmp = nX+1;
-            nYTmp = nY;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
-            {
-               nAdjacent++;
-               dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
-            }
+               // East
+               nXTmp = nX+1;
+               nYTmp = nY;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
+               {
+                  nAdjacent++;
+                  dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
+               }
 
-            // South
-            nXTmp = nX;
-            nYTmp = nY+1;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
-            {
-               nAdjacent++;
-               dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
-            }
+               // South
+               nXTmp = nX;
+               nYTmp = nY+1;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
+               {
+                  nAdjacent++;
+                  dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
+               }
 
-            // West
-            nXTmp = nX-1;
-            nYTmp = nY;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
-            {
-               nAdjacent++;
-               dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
-            }
+               // West
+               nXTmp = nX-1;
+               nYTmp = nY;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
+               {
+                  nAdjacent++;
+                  dBeachProtection += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor();
+               }
 
-            // If this sea cell has four neighbours with initialized beach protection values, then assume that it should not have an uninitialized beach protection value. Set it to the average of its neighbours
-            if (nAdjacent == 4)
-            {
-               m_pRasterGrid->m_Cell[nX][nY].SetBeachProtectionFactor(dBeachProtection / 4);
+               // If this sea cell has four neighbours with initialized beach protection values, then assume that it should not have an uninitialized beach protection value. Set it to the average of its neighbours
+               if (nAdjacent == 4)
+               {
+                  m_pRasterGrid->m_Cell[nX][nY].SetBeachProtectionFactor(dBeachProtection / 4);
+               }
             }
          }
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 }
 
@@ -1111,74 +1421,82 @@ void CSimulation::FillInBeachProtectionHoles(void)
 ===============================================================================================================================*/
 void CSimulation::FillPotentialPlatformErosionHoles(void)
 {
+   // If the grid is tiled, only visit the tiles which have been in use during this timestep: no other cell can be a sea cell
+   vector<pair<int, int> > prVRun;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
-      for (int nY = 0; nY < m_nYGridMax; nY++)
+      m_pRasterGrid->m_Cell.GetActiveRuns(nX, 1, &prVRun);
+      for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
       {
-         if ((m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (m_pRasterGrid->m_Cell[nX][nY].dGetPotentialPlatformErosion() == 0))
+         for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
          {
-            // This is a sea cell, it has a zero potential platform erosion value. So look at its N-S and W-E neighbours
-            int
-               nXTmp,
-               nYTmp,
-               nAdjacent = 0;
-            double
-               dPotentialPlatformErosion = 0;
-
-            // North
-            nXTmp = nX;
-            nYTmp = nY-1;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
+            if ((m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea()) && (m_pRasterGrid->m_Cell[nX][nY].dGetPotentialPlatformErosion() == 0))
             {
-               nAdjacent++;
-               dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
-            }
+               // This is a sea cell, it has a zero potential platform erosion value. So look at its N-S and W-E neighbours
+               int
+                  nXTmp,
+                  nYTmp,
+                  nAdjacent = 0;
+               double
+                  dPotentialPlatformErosion = 0;
+
+               // North
+               nXTmp = nX;
+               nYTmp = nY-1;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
+               {
+                  nAdjacent++;
+                  dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
+               }
 
-            // East
-            nXTmp = nX+1;
-            nYTmp = nY;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
-            {
-               nAdjacent++;
-               dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
-            }
+               // East
+               nXTmp = nX+1;
+               nYTmp = nY;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
+               {
+                  nAdjacent++;
+                  dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
+               }
 
-            // South
-            nXTmp = nX;
-            nYTmp = nY+1;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
-            {
-               nAdjacent++;
-               dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
-            }
+               // South
+               nXTmp = nX;
+               nYTmp = nY+1;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
+               {
+                  nAdjacent++;
+                  dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
+               }
 
-            // West
-            nXTmp = nX-1;
-            nYTmp = nY;
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
-            if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
-            {
-               nAdjacent++;
-               dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
-            }
+               // West
+               nXTmp = nX-1;
+               nYTmp = nY;
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetBeachProtectionFactor() != DBL_NODATA))
+               if ((bIsWithinGrid(nXTmp, nYTmp)) && (m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion() != 0))
+               {
+                  nAdjacent++;
+                  dPotentialPlatformErosion += m_pRasterGrid->m_Cell[nXTmp][nYTmp].dGetPotentialPlatformErosion();
+               }
 
-            // If this sea cell has four neighbours with non-zero potential platform erosion values, then assume that it should not have a zero potential platform erosion value. Set it to the average of its neighbours
-            if (nAdjacent == 4)
-            {
-               double dThisPotentialPlatformErosion = dPotentialPlatformErosion / 4;
+               // If this sea cell has four neighbours with non-zero potential platform erosion values, then assume that it should not have a zero potential platform erosion value. Set it to the average of its neighbours
+               if (nAdjacent == 4)
+               {
+                  double dThisPotentialPlatformErosion = dPotentialPlatformErosion / 4;
 
-               m_pRasterGrid->m_Cell[nX][nY].SetPotentialPlatformErosion(dThisPotentialPlatformErosion);
+                  m_pRasterGrid->m_Cell[nX][nY].SetPotentialPlatformErosion(dThisPotentialPlatformErosion);
 
-               // Update this-timestep totals
-               m_ulThisTimestepNumPotentialPlatformErosionCells++;
-               m_dThisTimestepPotentialPlatformErosion += dThisPotentialPlatformErosion;
+                  // Update this-timestep totals
+                  m_ulThisTimestepNumPotentialPlatformErosionCells++;
+                  m_dThisTimestepPotentialPlatformErosion += dThisPotentialPlatformErosion;
 
-               // Increment the check values
-               m_ulTotPotentialPlatformErosionBetweenProfiles++;
-               m_dTotPotErosionBetweenProfiles += dThisPotentialPlatformErosion;
+                  // Increment the check values
+                  m_ulTotPotentialPlatformErosionBetweenProfiles++;
+                  m_dTotPotErosionBetweenProfiles += dThisPotentialPlatformErosion;
+               }
             }
          }
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 }
 
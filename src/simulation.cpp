@@ -34,6 +34,14 @@ using std::ios;
 #include "simulation.h"
 #include "raster_grid.h"
 #include "coast.h"
+#include "profile_raster_cache.h"
+#include "parallel_profile_cache.h"
+#include "beach_profile_cache.h"
+#include "wave_result_cache.h"
+#include "trace_writer.h"
+#include "status_server.h"
+#include "shared_export.h"
+#include "arena.h"
 
 
 /*==============================================================================================================================
@@ -119,7 +127,23 @@ CSimulation::CSimulation(void)
    m_bGDALCanWriteFloat                            =
    m_bGDALCanWriteInt32                            =
    m_bScaleRasterOutput                            =
-   m_bWorldFile                                    = false;
+   m_bWorldFile                                    =
+   m_bCacheProfileRaster                           =
+   m_bIncrementalCoastTrace                        =
+   m_bUseTimestepArena                             =
+   m_bScanlinePolygonRaster                        =
+   m_bPolygonRandStreams                           =
+   m_bFuseBeachErosion                             =
+   m_bParallelPlatformErosion                      =
+   m_bTabulateLinearWaves                          =
+   m_bSweepLineShadowZones                         =
+   m_bBatchCliffCollapseDeposition                 =
+   m_bCacheWaveResults                             =
+   m_bStageTimings                                 =
+   m_bStageMemory                                  =
+   m_bStageHWCounters                              =
+   m_bCanResetPeakRSS                              =
+   m_bVectorGISTransaction                         = false;
 
    m_bGDALCanCreate                                = true;
 
@@ -147,7 +171,16 @@ CSimulation::CSimulation(void)
    m_nGlobalPolygonID                              =
    m_nUnconsSedimentHandlingAtGridEdges            =
    m_nBeachErosionDepositionEquation               = 
+   m_nVectorGISContainer                           =
+   m_nVectorGISTransactionFeatures                 =
+   m_nTraceTimestepInterval                        =
+   m_nStatusPort                                   =
+   m_nSharedExportInterval                         =
+   m_nGridTileSide                                 =
    m_nWavePropagationModel                         = 0;
+
+   m_nTraceItemInterval                            = 1;
+   m_nTraceBufferSize                              = 100000;
    
    m_nMissingValue                                 = INT_NODATA;
    
@@ -173,7 +206,11 @@ CSimulation::CSimulation(void)
    m_ulThisTimestepNumActualBeachErosionCells          =
    m_ulThisTimestepNumBeachDepositionCells             =
    m_ulTotPotentialPlatformErosionOnProfiles           =
-   m_ulTotPotentialPlatformErosionBetweenProfiles      = 0;
+   m_ulTotPotentialPlatformErosionBetweenProfiles      =
+   m_ulTotCliffCollapsesBatched                        =
+   m_ulTotCliffCollapseDepositionGroups                =
+   m_ulTotVectorGISFeatures                            =
+   m_ulTotVectorGISTransactions                        = 0;
 
    for (int i = 0; i < NRNG; i++)
       m_ulRandSeed[i]  = 0;
@@ -181,6 +218,34 @@ CSimulation::CSimulation(void)
    for (int i = 0; i < SAVEMAX; i++)
       m_dUSaveTime[i] = 0;
 
+   m_ullStageAllocsStart                               =
+   m_ullStageAllocBytesStart                           = 0;
+
+   for (int i = 0; i < NUM_STAGES; i++)
+   {
+      m_dStageTime[i]                     =
+      m_dThisTimestepStageTime[i]         =
+      m_dStagePeakRSS[i]                  =
+      m_dThisTimestepStagePeakRSS[i]      =
+      m_dThisTimestepStageEndRSS[i]       =
+      m_dStatusLastStageTime[i]           =
+      m_dStatusRollingStageTime[i]        = 0;
+
+      m_ullStageAllocs[i]                 =
+      m_ullStageAllocBytes[i]             =
+      m_ullThisTimestepStageAllocs[i]     =
+      m_ullThisTimestepStageAllocBytes[i] = 0;
+
+      for (int j = 0; j < NUM_HW_COUNTERS; j++)
+      {
+         m_ullStageHW[i][j]               =
+         m_ullThisTimestepStageHW[i][j]   = 0;
+      }
+   }
+
+   for (int j = 0; j < NUM_HW_COUNTERS; j++)
+      m_ullStageHWStart[j] = 0;
+
    m_dDurationUnitsMult                         =
    m_dNorthWestXExtCRS                          =
    m_dNorthWestYExtCRS                          =
@@ -198,6 +263,13 @@ CSimulation::CSimulation(void)
    m_dRSaveTime                                 =
    m_dRSaveInterval                             =
    m_dClkLast                                   =
+   m_dStageStart                                =
+   m_dStageStartRSS                             =
+   m_dTraceStageStart                           =
+   m_dGridTileCacheMb                           =
+   m_dStatusLastPublish                         =
+   m_dStatusTimestepTime                        =
+   m_dStatusRollingTimestepTime                 =
    m_dCPUClock                                  =
    m_dSeaWaterDensity                           =
    m_dThisTimestepSWL                           =
@@ -323,6 +395,16 @@ CSimulation::CSimulation(void)
    m_tSysEndTime                             = 0;
 
    m_pRasterGrid                             = NULL;
+   m_pProfileRasterCache                     = NULL;
+   m_pParallelProfileCache                   = NULL;
+   m_pBeachProfileCache                      = NULL;
+   m_pWaveResultCache                        = NULL;
+   m_pTraceWriter                            = NULL;
+   m_pStatusServer                           = NULL;
+   m_pSharedExport                           = NULL;
+   m_pGDALVectorContainer                    = NULL;
+   m_pThisTimestepArena                      =
+   m_pLastTimestepArena                      = NULL;
 }
 
 /*==============================================================================================================================
@@ -359,6 +441,42 @@ CSimulation::~CSimulation(void)
 
    if (m_pRasterGrid)
       delete m_pRasterGrid;
+
+   if (m_pProfileRasterCache)
+      delete m_pProfileRasterCache;
+
+   if (m_pParallelProfileCache)
+      delete m_pParallelProfileCache;
+
+   if (m_pBeachProfileCache)
+      delete m_pBeachProfileCache;
+
+   if (m_pWaveResultCache)
+      delete m_pWaveResultCache;
+
+   if (m_pTraceWriter)
+      delete m_pTraceWriter;
+
+   if (m_pStatusServer)
+      delete m_pStatusServer;
+
+   if (m_pSharedExport)
+      delete m_pSharedExport;
+
+   if (m_bStageHWCounters)
+      StopHWCounters();
+
+   CloseVectorGISContainer();
+
+   // Coast objects may have been allocated from the per-timestep arenas, so must be destroyed before the arenas are
+   m_VCoast.clear();
+   m_VPrevCoast.clear();
+
+   if (m_pThisTimestepArena)
+      delete m_pThisTimestepArena;
+
+   if (m_pLastTimestepArena)
+      delete m_pLastTimestepArena;
 }
 
 double CSimulation::dGetThisTimestepSWL(void) const
@@ -405,73 +523,17 @@ double CSimulation::dGetD50Coarse(void) const
 
 /*==============================================================================================================================
 
- The nDoSimulation member function of CSimulation sets up and runs the simulation
+ Creates the raster grid, reads in the basement DEM and creates the grid's cells and layers, then reads in the initial raster GIS files. Used by nDoSimulation(), and also by the cme_bench target
 
 ==============================================================================================================================*/
-int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
+int CSimulation::nCreateGridAndReadInitialRasters(void)
 {
-#ifdef RANDCHECK
-   CheckRand();
-   return RTN_OK;
-#endif
-
-   // ================================================== initialization section ================================================   
-   // Hello, World!
-   AnnounceStart();
-
-   // Start the clock ticking
-   StartClock();
-
-   // Find out the folder in which the CoastalME executable sits, in order to open the .ini file (they are assumed to be in the same folder)
-   if (! bFindExeDir(pcArgv[0]))
-      return (RTN_ERR_CMEDIR);
-
-   // Deal with command-line parameters
-   int nRet = nHandleCommandLineParams(nArg, pcArgv);
-   if (nRet != RTN_OK)
-      return (nRet);
-
-   // OK, we are off, tell the user about the licence and the start time
-   AnnounceLicence();
-
-   // Read the .ini file and get the name of the run-data file, and path for output etc.
-   if (! bReadIni())
-      return (RTN_ERR_INI);
-
-   // We have the name of the run-data input file, so read it
-   if (! bReadRunData())
-      return (RTN_ERR_RUNDATA);
-
-   // Check raster GIS output format
-   if (! bCheckRasterGISOutputFormat())
-      return (RTN_ERR_RASTER_GIS_OUT_FORMAT);
-
-   // Check vector GIS output format
-   if (! bCheckVectorGISOutputFormat())
-      return (RTN_ERR_VECTOR_GIS_OUT_FORMAT);
-
-   // Open log file
-   if (! bOpenLogFile())
-      return (RTN_ERR_LOGFILE);
-
-   // Set up the time series output files
-   if (! bSetUpTSFiles())
-      return (RTN_ERR_TSFILE);
-
-   // Initialize the random number generators
-   InitRand0(m_ulRandSeed[0]);
-   InitRand1(m_ulRandSeed[1]);
-
-   // If we are doing Savitzky-Golay smoothing of the vector coastline(s), calculate the filter coefficients
-   if (m_nCoastSmooth == SMOOTH_SAVITZKY_GOLAY)
-      CalcSavitzkyGolayCoeffs();
-
    // Create the raster grid object
    m_pRasterGrid = new CGeomRasterGrid(this);
 
    // Read in the basement DEM (NOTE MUST HAVE THIS FILE) and create the raster grid, then read in the basement DEM data to the array
    AnnounceReadBasementDEM();
-   nRet = nReadBasementDEMData();
+   int nRet = nReadBasementDEMData();
    if (nRet != RTN_OK)
       return nRet;
 
@@ -493,11 +555,8 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       }
    }
    
-   // We have at least one filename for the first layer, so add the correct number of layers. Note the the number of layers does not change during the simulation: however layers can decrease in thickness until they have zero thickness
+   // We have at least one filename for the first layer, so each cell has the correct number of layers: these were added when the grid was created (if the grid is tiled, they are added when each tile is first paged in, so this does not need a sweep of the grid). Note the the number of layers does not change during the simulation: however layers can decrease in thickness until they have zero thickness
    AnnounceAddLayers();
-   for (int nX = 0; nX < m_nXGridMax; nX++)
-      for (int nY = 0; nY < m_nYGridMax; nY++)
-         m_pRasterGrid->m_Cell[nX][nY].AppendLayers(m_nLayers);
 
    // Tell the user what is happening then read in the layer files
    AnnounceReadRasterFiles();
@@ -570,7 +629,178 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       if (nRet != RTN_OK)
          return (nRet);
    }
-   
+
+   // Were all the raster grid's tiles paged in and out OK?
+   if (m_pRasterGrid->m_Cell.bFailed())
+      return RTN_ERR_SCRATCH_FILE;
+
+   return RTN_OK;
+}
+
+
+/*==============================================================================================================================
+
+ Does misc initialization calcs once the raster grid has been read in, and creates any caches which are required. Used by nDoSimulation(), and also by the cme_bench target
+
+==============================================================================================================================*/
+void CSimulation::DoMiscInitialization(void)
+{
+   m_ulNumCells = m_nXGridMax * m_nYGridMax;
+   m_nCoastMax = COAST_LENGTH_MAX * tMax(m_nXGridMax, m_nYGridMax);                                        // Arbitrary but probably OK
+   m_nCoastMin = COAST_LENGTH_MIN_X_PROF_SPACE * m_dCoastNormalAvgSpacing / m_dCellSide;                   // Ditto
+   m_nCoastCurvatureInterval = tMax(dRound(m_dCoastNormalAvgSpacing / (m_dCellSide * 2)), 2.0);            // Ditto
+
+   // If we are keeping rasterized profiles between timesteps, then create the cache
+   if (m_bCacheProfileRaster)
+      m_pProfileRasterCache = new CProfileRasterCache(m_nXGridMax, m_nYGridMax);
+
+   // If shore platform erosion is done in parallel, then the parallel profiles are constructed before the parallel section starts, and kept in a cache for use within it
+   if (m_bParallelPlatformErosion)
+      m_pParallelProfileCache = new CParallelProfileCache;
+
+   // Ditto for the parallel profiles used in beach erosion, if estimation and application of beach erosion are fused
+   if (m_bFuseBeachErosion)
+      m_pBeachProfileCache = new CBeachProfileCache;
+
+   // Ditto for wave propagation results
+   if (m_bCacheWaveResults)
+      m_pWaveResultCache = new CWaveResultCache;
+
+   // If COVE's linear wave theory calculations are to be tabulated, then create the look-up tables
+   if (m_bTabulateLinearWaves)
+      CreateLinearWaveLookUp();
+
+   // If coast, profile and polygon objects are to be allocated per-timestep, then create the arenas
+   if (m_bUseTimestepArena)
+   {
+      m_pThisTimestepArena = new CArena;
+      m_pLastTimestepArena = new CArena;
+   }
+
+   // For beach erosion/deposition, conversion from immersed weight to bulk volumetric (sand and voids) transport rate (Leo Van Rijn)
+   m_dInmersedToBulkVolumetric = 1 / ((m_dBeachSedimentDensity - m_dSeaWaterDensity) * (1 - m_dBeachSedimentPorosity) * m_dG);
+
+   m_bConsChangedThisTimestep.resize(m_nLayers, false);
+   m_bUnconsChangedThisTimestep.resize(m_nLayers, false);
+
+   // Normalize erodibility values, so that none are > 1
+   double dTmp = m_dFineErodibility + m_dSandErodibility + m_dCoarseErodibility;
+   m_dFineErodibilityNormalized = m_dFineErodibility / dTmp;
+   m_dSandErodibilityNormalized = m_dSandErodibility / dTmp;
+   m_dCoarseErodibilityNormalized = m_dCoarseErodibility / dTmp;
+
+   // Intialise SWL
+   m_dThisTimestepSWL = m_dOrigSWL;
+
+   // If SWL changes during the simulation, calculate the per-timestep increment (could be -ve)
+   if (m_dFinalSWL != m_dOrigSWL)
+   {
+      m_dDeltaSWLPerTimestep = (m_dTimeStep * (m_dFinalSWL - m_dOrigSWL)) / m_dSimDuration;
+
+      // nCalcExternalForcing() is called at the start of every timestep, so we need to pre-remove the first increment in order to start with m_dThisTimestepSWL == m_dOrigSWL
+      m_dThisTimestepSWL -= m_dDeltaSWLPerTimestep;
+   }
+}
+
+
+/*==============================================================================================================================
+
+ The nDoSimulation member function of CSimulation sets up and runs the simulation
+
+==============================================================================================================================*/
+int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
+{
+#ifdef RANDCHECK
+   CheckRand();
+   return RTN_OK;
+#endif
+
+   // ================================================== initialization section ================================================   
+   // Hello, World!
+   AnnounceStart();
+
+   // Start the clock ticking
+   StartClock();
+
+   // Find out the folder in which the CoastalME executable sits, in order to open the .ini file (they are assumed to be in the same folder)
+   if (! bFindExeDir(pcArgv[0]))
+      return (RTN_ERR_CMEDIR);
+
+   // Deal with command-line parameters
+   int nRet = nHandleCommandLineParams(nArg, pcArgv);
+   if (nRet != RTN_OK)
+      return (nRet);
+
+   // OK, we are off, tell the user about the licence and the start time
+   AnnounceLicence();
+
+   // Read the .ini file and get the name of the run-data file, and path for output etc.
+   if (! bReadIni())
+      return (RTN_ERR_INI);
+
+   // We have the name of the run-data input file, so read it
+   if (! bReadRunData())
+      return (RTN_ERR_RUNDATA);
+
+   // If grid fields and coastlines are to be published in shared memory but no segment name was given, then use the default
+   if ((m_nSharedExportInterval > 0) && m_strSharedExportName.empty())
+      m_strSharedExportName = CSharedExport::strGetDefaultName(m_strRunName);
+
+   // Check raster GIS output format
+   if (! bCheckRasterGISOutputFormat())
+      return (RTN_ERR_RASTER_GIS_OUT_FORMAT);
+
+   // Check vector GIS output format
+   if (! bCheckVectorGISOutputFormat())
+      return (RTN_ERR_VECTOR_GIS_OUT_FORMAT);
+
+   // Open log file
+   if (! bOpenLogFile())
+      return (RTN_ERR_LOGFILE);
+
+   // If per-stage hardware performance counters are required, then start them. This must be done before any OpenMP threads are created, so that the threads inherit the counters. If no counters are available then carry on without them
+   if (m_bStageHWCounters && (! bStartHWCounters()))
+   {
+      cerr << WARN << "hardware performance counters are not available, so will not be recorded" << endl;
+      LogStream << WARN << "hardware performance counters are not available, so will not be recorded" << endl;
+      m_bStageHWCounters = false;
+   }
+
+   // Set up the time series output files
+   if (! bSetUpTSFiles())
+      return (RTN_ERR_TSFILE);
+
+   // If required, start the status server. It is only for monitoring, so if it cannot be started then carry on without it
+   if (m_nStatusPort > 0)
+   {
+      m_pStatusServer = new CStatusServer(m_nStatusPort);
+      if (m_pStatusServer->bStart())
+      {
+         LogStream << "Status server listening on http://127.0.0.1:" << m_nStatusPort << "/" << endl;
+         PublishStatus(STATUS_INITIALIZING);
+      }
+      else
+      {
+         cerr << WARN << "cannot start status server on port " << m_nStatusPort << ", continuing without it" << endl;
+         LogStream << WARN << "cannot start status server on port " << m_nStatusPort << ", continuing without it" << endl;
+         delete m_pStatusServer;
+         m_pStatusServer = NULL;
+      }
+   }
+
+   // Initialize the random number generators
+   InitRand0(m_ulRandSeed[0]);
+   InitRand1(m_ulRandSeed[1]);
+
+   // If we are doing Savitzky-Golay smoothing of the vector coastline(s), calculate the filter coefficients
+   if (m_nCoastSmooth == SMOOTH_SAVITZKY_GOLAY)
+      CalcSavitzkyGolayCoeffs();
+
+   // Create the raster grid, then read in the basement DEM and the initial raster GIS files
+   nRet = nCreateGridAndReadInitialRasters();
+   if (nRet != RTN_OK)
+      return nRet;
+
    // May wish to read in some vector files someday
 /*   AnnounceReadVectorFiles();
    if (! m_strInitialCoastlineFile.empty())
@@ -621,36 +851,56 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
    // Start initializing
    AnnounceInitializing();
 
-   // Misc initialization calcs
-   m_ulNumCells = m_nXGridMax * m_nYGridMax;
-   m_nCoastMax = COAST_LENGTH_MAX * tMax(m_nXGridMax, m_nYGridMax);                                        // Arbitrary but probably OK
-   m_nCoastMin = COAST_LENGTH_MIN_X_PROF_SPACE * m_dCoastNormalAvgSpacing / m_dCellSide;                   // Ditto
-   m_nCoastCurvatureInterval = tMax(dRound(m_dCoastNormalAvgSpacing / (m_dCellSide * 2)), 2.0);            // Ditto
+   // Misc initialization calcs, and create any caches
+   DoMiscInitialization();
 
-   // For beach erosion/deposition, conversion from immersed weight to bulk volumetric (sand and voids) transport rate (Leo Van Rijn)
-   m_dInmersedToBulkVolumetric = 1 / ((m_dBeachSedimentDensity - m_dSeaWaterDensity) * (1 - m_dBeachSedimentPorosity) * m_dG);
+   // If grid fields and coastlines are to be published in shared memory, then create the segment. This is only for monitoring, so if it cannot be created then carry on without it
+   if (m_nSharedExportInterval > 0)
+   {
+      m_pSharedExport = new CSharedExport(m_strSharedExportName, m_nXGridMax, m_nYGridMax, SHARED_EXPORT_MAX_COASTS, SHARED_EXPORT_COAST_POINTS_MULT * (m_nXGridMax + m_nYGridMax));
+      if (m_pSharedExport->bCreate(m_dGeoTransform, m_dMissingValue, m_nMissingValue))
+         LogStream << "Grid fields and coastlines published every " << m_nSharedExportInterval << " timesteps in shared-memory segment " << m_strSharedExportName << " (" << m_pSharedExport->nGetSize() / (1024.0 * 1024.0) << " Mb)" << endl;
+      else if (m_pSharedExport->bAlreadyExists())
+      {
+         cerr << WARN << "shared-memory segment " << m_strSharedExportName << " already exists (it may belong to another run, or be left over from a run which crashed), continuing without it" << endl;
+         LogStream << WARN << "shared-memory segment " << m_strSharedExportName << " already exists (it may belong to another run, or be left over from a run which crashed), continuing without it" << endl;
+         delete m_pSharedExport;
+         m_pSharedExport = NULL;
+      }
+      else
+      {
+         cerr << WARN << "cannot create shared-memory segment " << m_strSharedExportName << ", continuing without it" << endl;
+         LogStream << WARN << "cannot create shared-memory segment " << m_strSharedExportName << ", continuing without it" << endl;
+         delete m_pSharedExport;
+         m_pSharedExport = NULL;
+      }
+   }
 
-   m_bConsChangedThisTimestep.resize(m_nLayers, false);
-   m_bUnconsChangedThisTimestep.resize(m_nLayers, false);
+   // If a trace of the simulation is required, then open the trace file
+   if (m_nTraceTimestepInterval > 0)
+   {
+      string strTraceFile = m_strOutPath;
+      strTraceFile.append(TRACENAME);
+      strTraceFile.append(JSONEXT);
 
-   // Normalize erodibility values, so that none are > 1
-   double dTmp = m_dFineErodibility + m_dSandErodibility + m_dCoarseErodibility;
-   m_dFineErodibilityNormalized = m_dFineErodibility / dTmp;
-   m_dSandErodibilityNormalized = m_dSandErodibility / dTmp;
-   m_dCoarseErodibilityNormalized = m_dCoarseErodibility / dTmp;
+      m_pTraceWriter = new CTraceWriter(strTraceFile, m_nTraceTimestepInterval, m_nTraceItemInterval, m_nTraceBufferSize);
+      if (! m_pTraceWriter->bOpen())
+      {
+         cerr << ERR << "cannot open " << strTraceFile << " for output" << endl;
+         return (RTN_ERR_TEXT_FILE_WRITE);
+      }
+   }
 
-   // Intialise SWL
-   m_dThisTimestepSWL = m_dOrigSWL;
 
-   // If SWL changes during the simulation, calculate the per-timestep increment (could be -ve)
-   if (m_dFinalSWL != m_dOrigSWL)
+   // If required, start counting heap allocations. Also find out whether the peak resident set size can be reset at the start of each stage (if not, the peak for each stage is estimated)
+   if (m_bStageMemory)
    {
-      m_dDeltaSWLPerTimestep = (m_dTimeStep * (m_dFinalSWL - m_dOrigSWL)) / m_dSimDuration;
-
-      // nCalcExternalForcing() is called at the start of every timestep, so we need to pre-remove the first increment in order to start with m_dThisTimestepSWL == m_dOrigSWL
-      m_dThisTimestepSWL -= m_dDeltaSWLPerTimestep;
+      SetAllocCounting(true);
+      m_bCanResetPeakRSS = bResetPeakRSS() && (dGetPeakRSS() <= dGetCurrentRSS() + 1);
    }
 
+   // Initialization is done, so tell the status server. The time taken by the first timestep is measured from here
+   PublishStatus(STATUS_RUNNING);
 
    // ===================================================== The main loop ======================================================
    // Tell the user what is happening
@@ -663,6 +913,10 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       
       // Tell the user how the simulation is progressing
       AnnounceProgress();
+
+      // If a trace is being written, is this timestep to be traced?
+      if (m_pTraceWriter)
+         m_pTraceWriter->StartTimestep(m_ulTimestep);
       
       LogStream << "TIMESTEP " << m_ulTimestep << " ================================================================================================" << endl;
 
@@ -677,16 +931,25 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
          return nRet;
 
       // Do per-timestep intialization: set up the grid cells ready for this timestep, also initialize per-timestep totals
+      StartStage();
       nRet = nInitGridAndCalcStillWaterLevel();
+      nRet = nEndStage(STAGE_INIT_GRID, nRet);
       if (nRet != RTN_OK)
          return nRet;
 
       // Next find out which cells are inundated and locate the coastline(s)
+      StartStage();
       nRet = nLocateSeaAndCoasts();
+      if (nRet == RTN_OK)
+         // The coastlines have moved, so the tiles of the raster grid which are kept in memory may change
+         SetGridTileBand();
+
+      nRet = nEndStage(STAGE_LOCATE_SEA_AND_COASTS, nRet);
       if (nRet != RTN_OK)
          return nRet;
       
       // Locate estuaries
+      StartStage();
       nRet = nLocateAllEstuaries();
       if (nRet != RTN_OK)
          return nRet;
@@ -701,12 +964,19 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       if (nRet != RTN_OK)
          return nRet;
 
+      nRet = nEndStage(STAGE_ASSIGN_LANDFORMS, nRet);
+      if (nRet != RTN_OK)
+         return nRet;
+
       // Create the coastline-normal profiles
+      StartStage();
       nRet = nCreateAllNormalProfilesAndCheckForIntersection();
+      nRet = nEndStage(STAGE_CREATE_PROFILES, nRet);
       if (nRet != RTN_OK)
          return nRet;
       
       // Create the coast polygons
+      StartStage();
       nRet = nCreateAllPolygons();
       if (nRet != RTN_OK)
          return nRet;
@@ -714,18 +984,25 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       // Mark cells of the raster grid that are within each polygon, then calc the length of the shared normal between each polygon and the adjacent polygon(s)
       MarkPolygonCells();
       DoPolygonSharedBoundaries();
+      nRet = nEndStage(STAGE_CREATE_POLYGONS, nRet);
+      if (nRet != RTN_OK)
+         return nRet;
 
       // PropagateWind();
 
       // Propagate waves and define the active zone, also locate wave shadow zones
+      StartStage();
       nRet = nDoAllPropagateWaves();
+      nRet = nEndStage(STAGE_PROPAGATE_WAVES, nRet);
       if (nRet != RTN_OK)
          return nRet;
 
       if (m_bDoCoastPlatformErosion)
       {
          // Calculate elevation change on the consolidated sediment which comprises the coastal platform
+         StartStage();
          nRet = nDoAllShorePlatFormErosion();
+         nRet = nEndStage(STAGE_PLATFORM_EROSION, nRet);
          if (nRet != RTN_OK)
             return nRet;
       }
@@ -733,16 +1010,20 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       if (m_bDoCliffCollapse)
       {
          // Do all cliff collapses for this timestep (if any)
+         StartStage();
          nRet = nDoAllWaveEnergyToCoastLandforms();
+         nRet = nEndStage(STAGE_CLIFF_COLLAPSE, nRet);
          if (nRet != RTN_OK)
             return nRet;
       }
 
       // Next simulate beach erosion and deposition i.e. simulate alongshore transport of unconsolidated sediment (longshore drift) between polygons. First calculate potential sediment movement between polygons
+      StartStage();
       DoAllPotentialBeachErosion();
 
       // Do within-sediment redistribution of unconsolidated sediment, constraining potential sediment movement to give actual (i.e. supply-limited) sediment movement to/from each polygon in three size clases
       int nRet = nDoAllActualBeachErosionAndDeposition();
+      nRet = nEndStage(STAGE_BEACH_EROSION_DEPOSITION, nRet);
       if (nRet != RTN_OK)
          return nRet;
       
@@ -751,7 +1032,9 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       m_dThisTimestepFineSedimentToSuspension += dFineThisTimestep;
 
       // Do some end-of-timestep update to the raster grid, also update per-timestep and running totals
+      StartStage();
       nRet = nUpdateGrid();
+      nRet = nEndStage(STAGE_UPDATE_GRID, nRet);
       if (nRet != RTN_OK)
          return nRet;
      
@@ -760,6 +1043,10 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       if ((m_bSaveRegular && (m_dSimElapsed >= m_dRSaveTime) && (m_dSimElapsed < m_dSimDuration)) || (! m_bSaveRegular && (m_dSimElapsed >= m_dUSaveTime[m_nThisSave])))
       {
          m_bSaveGISThisTimestep = true;
+         StartStage();
+
+         // GIS output only reads cells, so if the grid is tiled then this is a passive sweep: the tiles which it pages in are paged out again first, and do not count as in use
+         m_pRasterGrid->m_Cell.StartPassiveSweep();
 
          // Save the values from the RasterGrid array into raster GIS files
          if (! bSaveAllRasterGISFiles())
@@ -768,9 +1055,26 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
          // Save the vector GIS files
          if (! bSaveAllVectorGISFiles())
             return (RTN_ERR_VECTOR_FILE_WRITE);
+
+         m_pRasterGrid->m_Cell.EndPassiveSweep();
+
+         nRet = nEndStage(STAGE_GIS_OUTPUT, RTN_OK);
+         if (nRet != RTN_OK)
+            return nRet;
+      }
+
+      // If required, publish grid fields and coastlines in shared memory. This is counted as GIS output
+      if (m_pSharedExport && ((m_ulTimestep % m_nSharedExportInterval) == 0))
+      {
+         StartStage();
+         PublishSharedExport();
+         nRet = nEndStage(STAGE_GIS_OUTPUT, RTN_OK);
+         if (nRet != RTN_OK)
+            return nRet;
       }
 
       // Output per-timestep results to the .out file
+      StartStage();
       if (! bWritePerTimestepResults())
          return (RTN_ERR_TEXT_FILE_WRITE);
 
@@ -778,8 +1082,23 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
       if (! bWriteTSFiles())
          return (RTN_ERR_TIMESERIES_FILE_WRITE);
 
+      nRet = nEndStage(STAGE_TEXT_OUTPUT, RTN_OK);
+      if (nRet != RTN_OK)
+         return nRet;
+
+      // Output per-stage timings and memory use for this timestep, if required
+      if (! bWriteStageTSFile())
+         return (RTN_ERR_TIMESERIES_FILE_WRITE);
+
       // Update grand totals
       UpdateGrandTotals();
+
+      // If this timestep was traced, write the trace
+      if (m_pTraceWriter && (! m_pTraceWriter->bEndTimestep()))
+         return (RTN_ERR_TEXT_FILE_WRITE);
+
+      // Let the status server know how the simulation is progressing
+      PublishStatus(STATUS_RUNNING);
    }  // ================================================ End of main loop ======================================================
 
    // =================================================== post-loop tidying =====================================================
@@ -791,6 +1110,8 @@ int CSimulation::nDoSimulation(int nArg, char* pcArgv[])
    if (nRet != RTN_OK)
       return (nRet);
 
+   PublishStatus(STATUS_FINISHED);
+
    return RTN_OK;
 }
 
@@ -48,16 +48,27 @@ using std::pair;
 
 int const
    NRNG    = 2,
-   SAVEMAX = 1000;
+   SAVEMAX = 1000,
+   NUM_STAGES = 12,                  // Number of stages of the timestep for which wall-clock time may be recorded, see STAGE_NAME in cme.h
+   NUM_HW_COUNTERS = 4;              // Number of hardware performance counters which may be recorded, see HW_COUNTER_NAME in cme.h
 
 class CGeomRasterGrid;               // Forward declarations
 class CRWCoast;
 class CGeomProfile;
 class CGeomCoastPolygon;
-class CRWCliff;
+class CProfileRasterCache;
+class CParallelProfileCache;
+class CBeachProfileCache;
+class CWaveResultCache;
+class CTraceWriter;
+class CStatusServer;
+class CSharedExport;
+class CArena;
 
 class CSimulation
 {
+   friend class CBenchmark;      // Used by the cme_bench target
+
 private:
    bool
       m_bBasementElevSave,
@@ -136,7 +147,23 @@ private:
       m_bGDALCanWriteFloat,
       m_bGDALCanWriteInt32,
       m_bScaleRasterOutput,
-      m_bWorldFile;
+      m_bWorldFile,
+      m_bCacheProfileRaster,
+      m_bIncrementalCoastTrace,
+      m_bUseTimestepArena,
+      m_bScanlinePolygonRaster,
+      m_bPolygonRandStreams,
+      m_bFuseBeachErosion,
+      m_bParallelPlatformErosion,
+      m_bTabulateLinearWaves,
+      m_bSweepLineShadowZones,
+      m_bBatchCliffCollapseDeposition,
+      m_bCacheWaveResults,
+      m_bStageTimings,
+      m_bStageMemory,                     // Count heap allocations and measure resident set size in each stage of the timestep?
+      m_bStageHWCounters,                 // Read hardware performance counters in each stage of the timestep?
+      m_bCanResetPeakRSS,
+      m_bVectorGISTransaction;            // Is a transaction in progress, while writing features to a vector GIS layer?
 
    char** m_papszGDALRasterOptions;
    char** m_papszGDALVectorOptions;
@@ -163,6 +190,14 @@ private:
       m_nGlobalPolygonID,                    // There are m_nGlobalPolygonID + 1 polygons at any time (all coasts)
       m_nUnconsSedimentHandlingAtGridEdges,
       m_nBeachErosionDepositionEquation,
+      m_nVectorGISContainer,                 // Write vector GIS output to one file per data item per save, to one file per save, or to one file for the whole run
+      m_nVectorGISTransactionFeatures,       // Number of features created in the vector GIS transaction which is in progress
+      m_nTraceTimestepInterval,              // Write a trace of every Nth timestep, zero if no trace is written
+      m_nTraceItemInterval,                  // Within each traced timestep, trace every Nth profile and polygon
+      m_nTraceBufferSize,                    // Maximum number of trace spans held in memory before being written
+      m_nStatusPort,                         // Port on the loopback interface for the status server, zero if there is no status server
+      m_nSharedExportInterval,               // Publish grid fields and coastlines in shared memory every Nth timestep, zero if not required
+      m_nGridTileSide,                       // Side (in cells) of each tile of the raster grid, zero if the grid is not tiled
       m_nMissingValue,
       m_nXMinBoundingBox,
       m_nXMaxBoundingBox,
@@ -190,7 +225,22 @@ private:
       m_ulThisTimestepNumActualBeachErosionCells,
       m_ulThisTimestepNumBeachDepositionCells,
       m_ulTotPotentialPlatformErosionOnProfiles,
-      m_ulTotPotentialPlatformErosionBetweenProfiles;
+      m_ulTotPotentialPlatformErosionBetweenProfiles,
+      m_ulTotCliffCollapsesBatched,
+      m_ulTotCliffCollapseDepositionGroups,
+      m_ulTotVectorGISFeatures,
+      m_ulTotVectorGISTransactions;
+
+   unsigned long long
+      m_ullStageAllocsStart,                          // Number of heap allocations counted when the current stage of the timestep started
+      m_ullStageAllocBytesStart,                      // Ditto, bytes requested
+      m_ullStageAllocs[NUM_STAGES],                   // Total heap allocations in each stage of the timestep
+      m_ullStageAllocBytes[NUM_STAGES],
+      m_ullThisTimestepStageAllocs[NUM_STAGES],
+      m_ullThisTimestepStageAllocBytes[NUM_STAGES],
+      m_ullStageHWStart[NUM_HW_COUNTERS],             // Hardware counter values when the current stage of the timestep started
+      m_ullStageHW[NUM_STAGES][NUM_HW_COUNTERS],      // Total hardware counts in each stage of the timestep
+      m_ullThisTimestepStageHW[NUM_STAGES][NUM_HW_COUNTERS];
 
    double
       m_dDurationUnitsMult,
@@ -210,6 +260,20 @@ private:
       m_dRSaveTime,
       m_dRSaveInterval,
       m_dUSaveTime[SAVEMAX],
+      m_dStageStart,                   // Wall-clock time (s) at which the current stage of the timestep started
+      m_dStageTime[NUM_STAGES],        // Total wall-clock time (s) spent in each stage of the timestep
+      m_dThisTimestepStageTime[NUM_STAGES],
+      m_dStageStartRSS,                // Resident set size (Mb) when the current stage of the timestep started
+      m_dTraceStageStart,              // Trace time (microseconds) at which the current stage of the timestep started
+      m_dGridTileCacheMb,              // Memory (Mb) for raster grid tiles, if the grid is tiled
+      m_dStatusLastPublish,            // Wall-clock time (s) at which the status was last sent to the status server
+      m_dStatusTimestepTime,           // Wall-clock time (s) taken by the latest timestep, for the status server
+      m_dStatusRollingTimestepTime,    // Ditto, rolling average
+      m_dStatusLastStageTime[NUM_STAGES],
+      m_dStatusRollingStageTime[NUM_STAGES],
+      m_dStagePeakRSS[NUM_STAGES],     // Peak resident set size (Mb) during each stage of the timestep
+      m_dThisTimestepStagePeakRSS[NUM_STAGES],
+      m_dThisTimestepStageEndRSS[NUM_STAGES],
       m_dClkLast,                      // Last value returned by clock()
       m_dCPUClock,                     // Total elapsed CPU time
       m_dGeoTransform[6],
@@ -374,8 +438,49 @@ private:
       m_strGDALRasterOutputDriverLongname,
       m_strGDALRasterOutputDriverExtension,
       m_strOGRVectorOutputExtension,
+      m_strVectorGISContainer,
       m_strRunName,
-      m_strDurationUnits;
+      m_strDurationUnits,
+      m_strSharedExportName,                    // Name of the shared-memory segment for grid fields and coastlines
+      m_strGridTileDir;                         // Directory for the raster grid tile scratch file, if the grid is tiled
+
+   // Changes which potential platform erosion on a profile (or between profiles) makes to this-timestep totals, and messages for the log file. These are recorded, and then applied in sequence, so that results are the same whether or not profiles are processed in parallel
+   struct PlatformErosionRecord
+   {
+      int nNumCells;                            // Net change in the number of cells with potential platform erosion
+      vector<double> dVErosionChange;           // Changes in total potential platform erosion, in sequence
+      string strLog;
+   };
+
+   // A cliff collapse, and the changes which talus deposition from it makes to this-timestep totals and layer-changed flags. These are recorded, and then applied in sequence, so that results are the same whether or not cliff collapse deposition is done in parallel
+   struct CliffDepositionRecord
+   {
+      int
+         nCoast,
+         nPointOnCoast;
+      double
+         dFineCollapse,
+         dSandCollapse,
+         dCoarseCollapse;
+      vector<pair<double*, double> > prVTotalChange;  // Changes to this-timestep totals, in sequence
+      vector<int> nVUnconsChangedLayer;               // Layers whose unconsolidated sediment has changed
+   };
+
+   // The sediment which a polygon routes to its adjacent polygons. This is calculated in parallel for all polygons in a wavefront, then applied in sequence so that results are the same whether or not routing is done in parallel
+   struct PolygonRoutingRecord
+   {
+      int
+         nCoast,
+         nPoly;
+      vector<int> nVAdjPoly;                          // Adjacent polygons which receive sediment, in sequence
+      vector<double>
+         dVFineToAdj,                                 // Sediment sent to each adjacent polygon
+         dVSandToAdj,
+         dVCoarseToAdj,
+         dVFineFromPoly,                              // Sediment removed from the routing polygon as each adjacent polygon is done
+         dVSandFromPoly,
+         dVCoarseFromPoly;
+   };
 
    struct RandState
    {
@@ -393,7 +498,8 @@ private:
       ErosionTSStream,
       DepositionTSStream,
       SedLostTSStream,
-      SedLoadTSStream;
+      SedLoadTSStream,
+      StageTSStream;
 
    vector<bool>
       m_bConsChangedThisTimestep,
@@ -409,6 +515,9 @@ private:
    vector<double>
       m_VdSliceElev,
       m_VdErosionPotential,            // For erosion potential lookup
+      m_VdErosionPotentialPadded,      // As above, but with trailing zeros so that the batched lookup never needs a bounds check
+      m_VdLinearWaveKsLookUp,          // For COVE linear wave theory lookup: shoaling coefficient times (depth / deep water wavelength)^(1/4)
+      m_VdLinearWaveCLookUp,           // Ditto: wave speed over deep water wave speed, divided by (depth / deep water wavelength)^(1/2)
       m_VdSavGolFCRWCoast,               // Savitzky-Golay filter coefficients for the coastline vector(s)
       m_VdSavGolFCGeomProfile;             // Savitzky-Golay filter coefficients for the profile vectors
 //       m_VdTideData;                    // Tide data: one record per timestep, is the change (m) from still water level for that timestep
@@ -451,9 +560,45 @@ private:
    // The coastline objects
    vector<CRWCoast> m_VCoast;
 
+   // The previous timestep's coastline objects, only kept if coastlines are re-traced incrementally or rasterized profiles are cached
+   vector<CRWCoast> m_VPrevCoast;
+
+   // If rasterized profiles are cached: which of the previous timestep's coastlines have been re-traced this timestep, and the cells of coastlines which were abandoned while being traced this timestep and last timestep
+   vector<bool> m_bVPrevCoastReTraced;
+   vector<CGeom2DIPoint> m_PtiVAbandonedCoastCell;
+   vector<CGeom2DIPoint> m_PtiVPrevAbandonedCoastCell;
+
    // Pointers to coast polygon objects
    vector<CGeomCoastPolygon*> m_pVCoastPolygon;
 
+   // Rasterized coastline-normal profiles, kept between timesteps
+   CProfileRasterCache* m_pProfileRasterCache;
+
+   // Parallel profiles for between-profile shore platform erosion, kept until the coastline-normal profiles are rebuilt
+   CParallelProfileCache* m_pParallelProfileCache;
+
+   // Geometry of the parallel profiles constructed while estimating actual beach erosion, re-used during actual beach erosion in the same timestep
+   CBeachProfileCache* m_pBeachProfileCache;
+
+   // Wave propagation results, kept between timesteps and re-used when the same (binned) wave forcing and bathymetry recur
+   CWaveResultCache* m_pWaveResultCache;
+
+   // Writes a Chrome trace of selected timesteps, NULL if no trace is being written
+   CTraceWriter* m_pTraceWriter;
+
+   // Serves the status of the simulation over HTTP on the loopback interface, NULL if not required
+   CStatusServer* m_pStatusServer;
+
+   // Publishes grid fields and coastlines in shared memory, NULL if not required
+   CSharedExport* m_pSharedExport;
+
+   // If all vector GIS output is written to a single file per save (or for the whole run), this is it
+   GDALDataset* m_pGDALVectorContainer;
+
+   // Per-timestep arenas for coast, profile and polygon objects. There are two of these, used in alternate timesteps, since the previous timestep's coasts may still be needed
+   CArena* m_pThisTimestepArena;
+   CArena* m_pLastTimestepArena;
+
 private:
    // Input and output routines
    static int nHandleCommandLineParams(int, char* []);
@@ -480,12 +625,20 @@ private:
    bool bWriteRasterGISFloat(int const, string const*, int const = 0);
    bool bWriteRasterGISInt(int const, string const*, double const = 0);
    bool bWriteVectorGIS(int const, string const*);
+   GDALDataset* pGetVectorGISContainer(void);
+   void CloseVectorGISContainer(void);
+   OGRFeature* pStartVectorGISFeatures(GDALDataset*, OGRLayer*);
+   bool bCreateVectorGISFeature(GDALDataset*, OGRLayer*, OGRFeature*);
+   bool bEndVectorGISFeatures(GDALDataset*, OGRFeature*);
+   void AbandonVectorGISFeatures(GDALDataset*, OGRFeature*);
    void GetRasterOutputMinMax(int const, double&, double&, int const, double const);
    void SetRasterFileCreationDefaults(void);
    int nInterpolateWavePropertiesToSeaCells(vector<int> const*, vector<int> const*, vector<double> const*, vector<double> const*);
    int nInterpolateWavePropertiesToActiveZoneCells(vector<int> const*, vector<int> const*, vector<bool> const*);
 
    // Initialization
+   int nCreateGridAndReadInitialRasters(void);
+   void DoMiscInitialization(void);
    bool bCreateErosionPotentialLookUp(vector<double>*, vector<double>*, vector<double>*);
 
    // Top-level simulation routines
@@ -499,16 +652,21 @@ private:
    int nDoAllPropagateWaves(void);
    int nDoAllShorePlatFormErosion(void);
    int nDoAllWaveEnergyToCoastLandforms(void);
-   int nDoCliffCollapse(CRWCliff*, double const, double&, double&, double&);
-   int nDoCliffCollapseDeposition(CRWCliff*, double const, double const, double const);
+   int nDoCliffCollapse(int const, int const, double const, double&, double&, double&);
+   int nDoCliffCollapseDeposition(CliffDepositionRecord*);
+   int nDoAllCliffCollapseDeposition(vector<CliffDepositionRecord>*);
+   void GetCliffCollapseDepositionCells(int const, int const, vector<int>*);
+   void ApplyCliffDepositionRecord(CliffDepositionRecord const*);
    int nUpdateGrid(void);
+   void SetGridTileBand(void);
 
    // Lower-level simulation routines
    void FindAllSeaCells(void);
    void FloodFillSea(int const, int const);
    int nTraceCoastLine(int const, int const, int const, int const);
    int nTraceAllCoasts(void);
-   void DoCoastCurvature(int const, int const);
+   void UpdateProfileRasterCache(void);
+   void DoCoastCurvature(int const, int const, CRWCoast* const = NULL, int const = 0, int const = 0);
    int nCreateAllNormalProfilesAndCheckForIntersection(void);
    int nCreateAllNormalProfiles(void);
    void CreateNaturalCapeNormals(int const, int&, int const, vector<bool>*, vector<pair<int, double> > const*);
@@ -523,32 +681,49 @@ private:
    void TruncateOneProfileRetainOtherProfile(int const, int const, int const, double const, double const, int const, int const, bool const);
    int nInsertPointIntoProfilesIfNeededThenUpdate(int const, int const, double const, double const, int const, int const, int const, bool const);
    void TruncateProfileAndAppendNew(int const, int const, int const, vector<CGeom2DPoint> const*, vector<vector<pair<int, int> > > const*);
-   void RasterizeProfile(int const, int const, vector<CGeom2DIPoint>*, vector<bool>*, bool&, bool&, bool&, bool&, bool&);
+   void RasterizeProfile(int const, int const, vector<CGeom2DIPoint>*, vector<bool>*, vector<int>*, bool&, bool&, bool&, bool&, bool&);
+   void RasterizeProfileFromCache(int const, int const, int const, vector<CGeom2DIPoint>*, vector<bool>*, bool&, bool&, bool&, bool&);
+   void CheckForHitAnotherProfile(int const, int const, int const, int const, bool&);
    int nRasterizeCliffCollapseProfile(vector<CGeom2DPoint> const*, vector<CGeom2DIPoint>*) const;
-   int nCalcPotentialPlatformErosionOnProfile(int const, int const);
-   int nCalcPotentialPlatformErosionBetweenProfiles(int const, int const, int const);
+   int nCalcPotentialPlatformErosionOnProfile(int const, int const, PlatformErosionRecord*);
+   int nCalcPotentialPlatformErosionBetweenProfiles(int const, int const, int const, PlatformErosionRecord*);
+   void ApplyPlatformErosionRecord(PlatformErosionRecord const*, bool const);
+   void GetPlatformErosionBetweenProfilesCells(int const, int const, int const, vector<int>*);
+   int nDoAllPotentialPlatformErosionInParallel(bool const);
    void ConstructParallelProfile(int const, int const, int const, int const, int const, vector<CGeom2DIPoint>* const, vector<CGeom2DIPoint>*, vector<CGeom2DPoint>*);
    double dCalcBeachProtectionFactor(int const, int const, double const);
    void FillInBeachProtectionHoles(void);
    void FillPotentialPlatformErosionHoles(void);
    void DoActualShorePlatformErosionOnCell(int const, int const);
    double dLookUpErosionPotential(double const) const;
+   void LookUpErosionPotential(int const, double const*, double*) const;
    static CGeom2DPoint PtChooseEndPoint(int const, CGeom2DPoint const*, CGeom2DPoint const*, double const, double const, double const, double const);
    int nGetCoastNormalEndPoint(int const, int const, int const, CGeom2DPoint const*, double const, CGeom2DPoint*);
    int nLandformToGrid(int const, int const);
    int nCalcWavePropertiesOnProfile(int const, int const, int const, vector<int>*, vector<int>*, vector<double>*, vector<double>*, vector<bool>*); 
+   void CreateLinearWaveLookUp(void);
+   void CalcLinearWavesOnProfile(int const, double const*, double const, double*, double*) const;
    int nGetThisProfileElevationVectorsForCShore(int const, int const, int const, vector<double>*, vector<double>*);
    int nCreateCShoreInfile(double const, double const, double const, double const , double const, double const, vector<double> const*, vector<double> const*);
    int nLookUpCShoreOutputs(string const*, int const, int const, vector<double> const*, vector<double>*);
    double dCalcWaveAngleToCoastNormal(double const, int const);
-   void CalcCoastTangents(int const);
+   void CalcCoastTangents(int const, CRWCoast* const = NULL, int const = 0, int const = 0);
    void InterpolateWavePropertiesToCoastline(int const, int const, int const);
    void InterpolateWavePropertiesToCells(int const, int const, int const);
    void ModifyBreakingWavePropertiesWithinShadowZoneToCoastline(int const, int const);
    static double dCalcCurvature(int const, CGeom2DPoint const*, CGeom2DPoint const*, CGeom2DPoint const*);
    void CalcD50AndFillWaveCalcHoles(void);
+   void CalcAllPolygonD50(void);
+   void SetAllPolygonD50(vector<int> const*, vector<double>*);
+   void CalcWaveEnergyAtAllCoastPoints(void);
+   unsigned long long ullGetWaveResultCacheSignature(vector<long long>*, vector<int>*, vector<int>*, vector<double>*);
+   void SaveWaveResultToCache(unsigned long long const, vector<long long> const*, vector<int> const*, vector<int> const*, vector<double> const*, vector<double> const*, vector<double> const*, vector<char> const*);
+   bool bRestoreWaveResultFromCache(unsigned long long const, vector<long long> const*, vector<int> const*, vector<int> const*, vector<double> const*);
    static bool bCurvaturePairCompareAscending(const pair<int, double>&, const pair<int, double>&);
    int nDoAllShadowZones(void);
+   void CalcWaveShadowBySweepLine(vector<double>*, vector<int>*, vector<int>*, vector<int>*);
+   int nDoAllShadowZonesBySweepLine(void);
+   static void RemoveNestedShadowZones(vector<int>*, vector<int>*);
    int nFindAllShadowZones(void);   
    int nFloodFillShadowZone(int const, int const, CGeom2DIPoint const*, int const, CGeom2DIPoint const*);
    int nSweepShadowZone(int const, int const, CGeom2DIPoint const*, int const, CGeom2DIPoint const*, int&);
@@ -558,13 +733,19 @@ private:
    static bool bIsWithinPolygon(CGeom2DPoint const*, vector<CGeom2DPoint> const*);
    static CGeom2DPoint PtFindPointInPolygon(vector<CGeom2DPoint> const*, int const);
    void MarkPolygonCells(void);
+   void RasterizePolygonInterior(CGeomCoastPolygon*, vector<int>*) const;
+   CGeom2DPoint PtFindPolygonFillStartPoint(CGeomCoastPolygon*, int const) const;
    void DoPolygonSharedBoundaries(void);
    void DoAllPotentialBeachErosion(void);
    int nDoAllActualBeachErosionAndDeposition(void);
    int nEstimateActualBeachErosionOnPolygon(int const, int const, double const);
    void EstimateActualBeachErosionOnCell(int const, int const, int const, double const, double&, double&, double&);
    void ErodeBeachConstrained(int const, int const, int const, double const, double&, double&, double&);
-   int nRouteActualBeachErosionToAdjacentPolygons(int const, int const);
+   void SchedulePolygonRouting(int const, vector<vector<int> >*, vector<int>*);
+   void CalcSedimentToRouteFromPolygon(int const, int const, double&, double&, double&);
+   int nRouteActualBeachErosionToAdjacentPolygons(int const, int const, double const, double const, double const);
+   void CalcPolygonRouting(PolygonRoutingRecord*);
+   void ApplyPolygonRouting(PolygonRoutingRecord const*);
    int nDoWithinPolygonBeachRedistribution(int const, int const);
    int nDoBeachErosionOnCells(int const, int const, double const);
    int nDoBeachDepositionOnCells(int const, int const, double const);
@@ -640,14 +821,22 @@ private:
    static string strDispTime(double const, bool const, bool const);
    static string strDispSimTime(double const);
    void AnnounceProgress(void);
+   void PublishStatus(string const&);
+   void PublishSharedExport(void);
    static string strGetErrorText(int const);
    string strListRasterFiles(void) const;
    string strListVectorFiles(void) const;
    string strListTSFiles(void) const;
    void CalcProcessStats(void);
+   void StartStage(void);
+   int nEndStage(int const, int const);
+   void WriteStageTimings(void);
+   void WriteStageMemory(void);
+   void WriteStageHWCounters(void);
+   bool bWriteStageTSFile(void);
    void CalcSavitzkyGolayCoeffs(void);
-   CGeomLine LSmoothCoastSavitzkyGolay(CGeomLine*, int const, int const) const;
-   CGeomLine LSmoothCoastRunningMean(CGeomLine*, int const, int const) const;
+   CGeomLine LSmoothCoastSavitzkyGolay(CGeomLine*, int const, int const, int const = 0, int const = INT_MAX) const;
+   CGeomLine LSmoothCoastRunningMean(CGeomLine*, int const, int const, int const = 0, int const = INT_MAX) const;
    vector<double> dVSmoothProfileSlope(vector<double>*);
 //    vector<double> dVCalCGeomProfileSlope(vector<CGeom2DPoint>*, vector<double>*);
    vector<double> dVSmoothProfileSavitzkyGolay(vector<double>*, vector<double>*);
@@ -682,6 +871,10 @@ private:
    double dGetRand0Gaussian(void);
 //    double dGetCGaussianPDF(double const);
    void Rand1Shuffle(int*, int);
+   static unsigned long ulGetMix(unsigned long);
+   unsigned long ulGetStreamKey(int const, int const, int const) const;
+   static unsigned long ulGetStreamRand(unsigned long const, unsigned long const);
+   void StreamShuffle(int*, int, int const, int const, int const);
 #ifdef RANDCHECK
    void CheckRand(void) const;
 #endif
@@ -80,10 +80,10 @@ void CSimulation::CalcSavitzkyGolayCoeffs(void)
 
 /*==============================================================================================================================
 
- Does smoothing of a CGeomLine coastline vector using a Savitzky-Golay filter
+ Does smoothing of a CGeomLine coastline vector using a Savitzky-Golay filter. If nFirst and nLast are given, then only points from nFirst to nLast (inclusive) are smoothed: other points in the returned CGeomLine are left blank
 
 ==============================================================================================================================*/
-CGeomLine CSimulation::LSmoothCoastSavitzkyGolay(CGeomLine* pLineIn, int const nStartEdge, int const nEndEdge) const
+CGeomLine CSimulation::LSmoothCoastSavitzkyGolay(CGeomLine* pLineIn, int const nStartEdge, int const nEndEdge, int const nFirst, int const nLast) const
 {
    // Note that m_nCoastSmoothWindow must be odd (have already checked this)
    int nHalfWindow = m_nCoastSmoothWindow / 2;
@@ -94,7 +94,7 @@ CGeomLine CSimulation::LSmoothCoastSavitzkyGolay(CGeomLine* pLineIn, int const n
    LTemp.Resize(nSize);
 
    // Apply the Savitzky-Golay smoothing filter
-   for (int i = 0; i < nSize; i++)
+   for (int i = tMax(nFirst, 0); i <= tMin(nSize-1, nLast); i++)
    {
       if (i < nHalfWindow)
       {
@@ -191,10 +191,10 @@ CGeomLine CSimulation::LSmoothCoastSavitzkyGolay(CGeomLine* pLineIn, int const n
 
 /*==============================================================================================================================
 
- Does running-mean smoothing of a CGeomLine coastline vector
+ Does running-mean smoothing of a CGeomLine coastline vector. If nFirst and nLast are given, then only points from nFirst to nLast (inclusive) are smoothed: other points in the returned CGeomLine are left unsmoothed
 
 ==============================================================================================================================*/
-CGeomLine CSimulation::LSmoothCoastRunningMean(CGeomLine* pLineIn, int const nStartEdge, int const nEndEdge) const
+CGeomLine CSimulation::LSmoothCoastRunningMean(CGeomLine* pLineIn, int const nStartEdge, int const nEndEdge, int const nFirst, int const nLast) const
 {
    // Note that m_nCoastSmoothWindow must be odd (have already checked this)
    int nHalfWindow = m_nCoastSmoothWindow / 2;
@@ -205,7 +205,7 @@ CGeomLine CSimulation::LSmoothCoastRunningMean(CGeomLine* pLineIn, int const nSt
    LTemp = *pLineIn;
 
    // Apply the running mean smoothing filter, with a variable window size at both ends of the line
-   for (int i = 0; i < nSize; i++)
+   for (int i = tMax(nFirst, 0); i <= tMin(nSize-1, nLast); i++)
    {
       bool bNearStartEdge = false, bNearEndEdge = false;
       int nTmpWindow = 0;
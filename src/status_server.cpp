@@ -0,0 +1,203 @@
+/*!
+ *
+ * \file status_server.cpp
+ * \brief CStatusServer routines
+ * \details A minimal HTTP/1.0 server, which listens only on the loopback interface. Every request is answered with the most recent status JSON, then the connection is closed. Only available on POSIX systems
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#ifndef _WIN32
+   #include <arpa/inet.h>
+   #include <netinet/in.h>
+   #include <poll.h>
+   #include <sys/socket.h>
+   #include <sys/time.h>
+   #include <unistd.h>
+
+   #include <cstring>
+   using std::memset;
+
+   // Not all platforms have this, but it is only needed where SIGPIPE would otherwise be raised
+   #ifndef MSG_NOSIGNAL
+      #define MSG_NOSIGNAL 0
+   #endif
+#endif
+
+#include <sstream>
+using std::stringstream;
+
+#include "cme.h"
+#include "status_server.h"
+
+
+CStatusServer::CStatusServer(int const nPort)
+:
+   m_nPort(nPort),
+   m_nSocket(-1),
+   m_ulRequests(0),
+   m_bStop(false),
+   m_strStatus("{}")
+{
+}
+
+CStatusServer::~CStatusServer(void)
+{
+   Stop();
+}
+
+
+//! Starts listening on the loopback interface, and starts the server thread. Returns false if this cannot be done (e.g. if the port is in use)
+bool CStatusServer::bStart(void)
+{
+#ifndef _WIN32
+   m_nSocket = socket(AF_INET, SOCK_STREAM, 0);
+   if (m_nSocket < 0)
+      return false;
+
+   int nOn = 1;
+   setsockopt(m_nSocket, SOL_SOCKET, SO_REUSEADDR, &nOn, sizeof(nOn));
+
+   sockaddr_in Addr;
+   memset(&Addr, 0, sizeof(Addr));
+   Addr.sin_family = AF_INET;
+   Addr.sin_port = htons(static_cast<unsigned short>(m_nPort));
+   Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if ((bind(m_nSocket, reinterpret_cast<sockaddr*>(&Addr), sizeof(Addr)) < 0) || (listen(m_nSocket, STATUS_SERVER_BACKLOG) < 0))
+   {
+      close(m_nSocket);
+      m_nSocket = -1;
+      return false;
+   }
+
+   m_Thread = std::thread(&CStatusServer::Serve, this);
+   return true;
+#else
+   return false;
+#endif
+}
+
+
+//! Stops the server thread, and stops listening
+void CStatusServer::Stop(void)
+{
+   m_bStop = true;
+
+   if (m_Thread.joinable())
+      m_Thread.join();
+
+#ifndef _WIN32
+   if (m_nSocket >= 0)
+   {
+      close(m_nSocket);
+      m_nSocket = -1;
+   }
+#endif
+}
+
+
+//! The server thread: waits for connections and answers them, until told to stop. The wait times out regularly, so that a request to stop is noticed
+void CStatusServer::Serve(void)
+{
+#ifndef _WIN32
+   while (! m_bStop)
+   {
+      pollfd Poll;
+      Poll.fd = m_nSocket;
+      Poll.events = POLLIN;
+      Poll.revents = 0;
+
+      if (poll(&Poll, 1, STATUS_SERVER_POLL_MS) <= 0)
+         continue;
+
+      int nClient = accept(m_nSocket, NULL, NULL);
+      if (nClient < 0)
+         continue;
+
+      Respond(nClient);
+      close(nClient);
+   }
+#endif
+}
+
+
+//! Reads a request from a client, then sends the current status. A client which is slow to send or receive is given up on, so cannot hold up other clients
+void CStatusServer::Respond(int const nClient)
+{
+#ifndef _WIN32
+   timeval Timeout;
+   Timeout.tv_sec = 0;
+   Timeout.tv_usec = STATUS_SERVER_POLL_MS * 1000;
+   setsockopt(nClient, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+   setsockopt(nClient, SOL_SOCKET, SO_SNDTIMEO, &Timeout, sizeof(Timeout));
+
+   // We don't care what was requested, but do need to read the request line before answering
+   char szBuf[BUF_SIZE];
+   if (recv(nClient, szBuf, BUF_SIZE, 0) <= 0)
+      return;
+
+   string strBody;
+   {
+      std::lock_guard<std::mutex> Lock(m_StatusMutex);
+      strBody = m_strStatus;
+   }
+   m_ulRequests++;
+
+   stringstream strstr;
+   strstr << "HTTP/1.0 200 OK\r\n";
+   strstr << "Content-Type: application/json\r\n";
+   strstr << "Cache-Control: no-cache\r\n";
+   strstr << "Content-Length: " << strBody.size() << "\r\n";
+   strstr << "Connection: close\r\n\r\n";
+   strstr << strBody;
+
+   string strResponse = strstr.str();
+   size_t nSent = 0;
+   while (nSent < strResponse.size())
+   {
+      ssize_t nRet = send(nClient, strResponse.c_str() + nSent, strResponse.size() - nSent, MSG_NOSIGNAL);
+      if (nRet <= 0)
+         return;
+
+      nSent += nRet;
+   }
+#endif
+}
+
+
+//! Hands over a new status string, which will be sent to clients from now on. The string is swapped rather than copied, so that the lock is held for as short a time as possible: on return, the argument holds the previous status
+void CStatusServer::SetStatus(string& strStatus)
+{
+   std::lock_guard<std::mutex> Lock(m_StatusMutex);
+   m_strStatus.swap(strStatus);
+}
+
+
+//! Returns the port on which the server listens
+int CStatusServer::nGetPort(void) const
+{
+   return m_nPort;
+}
+
+
+//! Returns the number of requests answered
+unsigned long CStatusServer::ulGetRequests(void) const
+{
+   return m_ulRequests;
+}
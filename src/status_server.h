@@ -0,0 +1,75 @@
+/*!
+ *
+ * \class CStatusServer
+ * \brief Class used to serve the status of a running simulation over HTTP
+ * \details When CoastalME is run as a batch job, stdout is not a tty and so no progress is shown. Instead, a minimal HTTP server can be run on the loopback interface: any GET request is answered with the latest status, as JSON. The server runs in its own thread, so the simulation thread never waits for a client; it only hands over a new status string at the end of each timestep
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file status_server.h
+ * \brief Contains CStatusServer definitions
+ *
+ */
+
+#ifndef STATUSSERVER_H
+#define STATUSSERVER_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <string>
+using std::string;
+
+
+class CStatusServer
+{
+private:
+   int
+      m_nPort,
+      m_nSocket;                          // The listening socket, -1 if not listening
+
+   std::atomic<unsigned long>
+      m_ulRequests;
+
+   std::atomic<bool>
+      m_bStop;
+
+   string
+      m_strStatus;
+
+   std::mutex
+      m_StatusMutex;                      // Guards m_strStatus
+
+   std::thread
+      m_Thread;
+
+   void Serve(void);
+   void Respond(int const);
+
+public:
+   explicit CStatusServer(int const);
+   ~CStatusServer(void);
+
+   bool bStart(void);
+   void Stop(void);
+
+   void SetStatus(string&);
+
+   int nGetPort(void) const;
+   unsigned long ulGetRequests(void) const;
+};
+#endif // STATUSSERVER_H
@@ -0,0 +1,650 @@
+/*!
+ *
+ * \file tiled_cell_array.cpp
+ * \brief CTiledCellArray routines
+ * \details Paging in is done on demand, from whichever thread first accesses a cell of the tile, and so is guarded by a mutex. Paging out is only done at safe points, which are always outside parallel regions
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <cstdio>
+#include <new>
+
+#include <algorithm>
+using std::sort;
+
+#include <iostream>
+using std::ios;
+
+#include <utility>
+using std::pair;
+using std::make_pair;
+
+#include "cme.h"
+#include "tiled_cell_array.h"
+
+
+CTiledCellArray::CTiledCellArray(void)
+:
+   m_bTiled(false),
+   m_nXMax(0),
+   m_nYMax(0),
+   m_nTileSide(0),
+   m_nShiftX(0),
+   m_nShiftY(0),
+   m_nMaskX(0),
+   m_nMaskY(0),
+   m_nTileStride(0),
+   m_nTilesX(0),
+   m_nTilesY(0),
+   m_nNumTiles(0),
+   m_nMaxResident(0),
+   m_nResident(0),
+   m_nPeakResident(0),
+   m_nLayers(0),
+   m_bPassiveSweep(false),
+   m_ulInit(0),
+   m_ulTrim(0),
+   m_ulTrimAtInit(0),
+   m_ulTrimAtLastInit(0),
+   m_ulLoads(0),
+   m_ulCreated(0),
+   m_ulEvictions(0),
+   m_ulCleanEvictions(0),
+   m_ullBytesRead(0),
+   m_ullBytesWritten(0),
+   m_ullFileSize(0),
+   m_pApTile(NULL),
+   m_pAucUsed(NULL),
+   m_bFailed(false),
+   m_pAllCells(NULL),
+   m_pSinkTile(NULL)
+{
+}
+
+CTiledCellArray::~CTiledCellArray(void)
+{
+   for (int n = 0; n < m_nNumTiles; n++)
+      delete [] m_pApTile[n].load(std::memory_order_relaxed);
+
+   delete [] m_pApTile;
+   delete [] m_pAucUsed;
+   delete [] m_pSinkTile;
+
+   if (m_ScratchStream.is_open())
+   {
+      m_ScratchStream.close();
+      remove(m_strFile.c_str());
+   }
+}
+
+
+//! Creates the array. If the tile side is zero, all cells are held in memory in a single block. Otherwise, the tile side must be a power of two, and the cache budget is given as a number of tiles. Every cell is given the number of layers, if tiled then when its tile is first paged in
+int CTiledCellArray::nCreate(int const nXMax, int const nYMax, int const nTileSide, int const nMaxResident, int const nLayers, string const& strFile)
+{
+   m_nXMax = nXMax;
+   m_nYMax = nYMax;
+   m_nLayers = nLayers;
+   m_bTiled = (nTileSide > 0);
+
+   if (m_bTiled)
+   {
+      m_nTileSide = nTileSide;
+      m_nShiftX = 0;
+      while ((1 << m_nShiftX) < nTileSide)
+         m_nShiftX++;
+
+      m_nShiftY = m_nShiftX;
+      m_nMaskX = m_nMaskY = nTileSide - 1;
+      m_nTileStride = nTileSide;
+      m_nTilesX = (nXMax + nTileSide - 1) >> m_nShiftX;
+      m_nTilesY = (nYMax + nTileSide - 1) >> m_nShiftY;
+      m_nMaxResident = tMax(nMaxResident, 1);
+   }
+   else
+   {
+      // A single tile which holds the whole grid. Shifting any valid cell coordinate this far gives zero, and masking it leaves it unchanged
+      m_nTileSide = 0;
+      m_nShiftX = m_nShiftY = 30;
+      m_nMaskX = m_nMaskY = (1 << 30) - 1;
+      m_nTileStride = nYMax;
+      m_nTilesX = m_nTilesY = 1;
+      m_nMaxResident = 1;
+   }
+
+   m_nNumTiles = m_nTilesX * m_nTilesY;
+
+   m_pApTile = new std::atomic<CGeomCell*>[m_nNumTiles];
+   m_pAucUsed = new std::atomic<unsigned char>[m_nNumTiles];
+   for (int n = 0; n < m_nNumTiles; n++)
+   {
+      m_pApTile[n].store(NULL, std::memory_order_relaxed);
+      m_pAucUsed[n].store(0, std::memory_order_relaxed);
+   }
+
+   if (! m_bTiled)
+   {
+      CGeomCell* pCells = new (std::nothrow) CGeomCell[static_cast<size_t>(nXMax) * nYMax];
+      if (NULL == pCells)
+         return RTN_ERR_MEMALLOC;
+
+      for (size_t n = 0; n < static_cast<size_t>(nXMax) * nYMax; n++)
+         pCells[n].AppendLayers(nLayers);
+
+      m_pApTile[0].store(pCells, std::memory_order_release);
+      m_pAucUsed[0].store(1, std::memory_order_relaxed);
+      m_pAllCells = pCells;
+      m_nResident = m_nPeakResident = 1;
+
+      return RTN_OK;
+   }
+
+   m_bVInBand.assign(m_nNumTiles, false);
+   m_bVOnDisk.assign(m_nNumTiles, false);
+   m_bVPassive.assign(m_nNumTiles, false);
+   m_ulVLastUsed.assign(m_nNumTiles, 0);
+   m_ulVActive.assign(m_nNumTiles, 0);
+   m_ulVInit.assign(m_nNumTiles, 0);
+   m_ullVOffset.assign(m_nNumTiles, 0);
+   m_ullVCapacity.assign(m_nNumTiles, 0);
+   m_ullVSize.assign(m_nNumTiles, 0);
+   m_ullVHash.assign(m_nNumTiles, 0);
+   m_nVResident.reserve(m_nMaxResident);
+
+   // Allocate the sink tile now, since there may not be enough memory to do so when it is needed. Its cells have the same number of layers as every other cell
+   m_pSinkTile = new (std::nothrow) CGeomCell[nCellsInTile()];
+   if (NULL == m_pSinkTile)
+      return RTN_ERR_MEMALLOC;
+
+   for (int n = 0; n < nCellsInTile(); n++)
+      m_pSinkTile[n].AppendLayers(nLayers);
+
+   // Tiles are only created when first accessed, so there is nothing in the scratch file yet
+   m_strFile = strFile;
+   m_ScratchStream.open(m_strFile.c_str(), ios::in | ios::out | ios::binary | ios::trunc);
+   if (! m_ScratchStream)
+      return RTN_ERR_SCRATCH_FILE;
+
+   return RTN_OK;
+}
+
+
+//! Returns the number of cells in each tile. Tiles at the top and right edges of the grid are the same size as the others, so some of their cells are never used
+int CTiledCellArray::nCellsInTile(void) const
+{
+   return m_nTileSide * m_nTileSide;
+}
+
+
+//! Brings a tile into memory, either by reading it from the scratch file or (if it has never been paged out) by creating it, then initializes its cells if this has not been done since InitCells() was last called. Any thread may call this, and more than one thread may ask for the same tile. If the tile cannot be brought in, the failure is recorded and the sink tile is returned instead: the simulation must then stop at the next safe point
+CGeomCell* CTiledCellArray::pPageIn(int const nTile)
+{
+   std::lock_guard<std::mutex> Lock(m_LoadMutex);
+
+   // Did another thread bring this tile in while we were waiting?
+   CGeomCell* pTile = m_pApTile[nTile].load(std::memory_order_acquire);
+   if (pTile != NULL)
+      return pTile;
+
+   int nCells = nCellsInTile();
+   pTile = new (std::nothrow) CGeomCell[nCells];
+   if (NULL == pTile)
+   {
+      Fail("cannot allocate memory for grid tile");
+      return m_pSinkTile;
+   }
+
+   if (m_bVOnDisk[nTile])
+   {
+      m_cVBuffer.resize(m_ullVSize[nTile]);
+      m_ScratchStream.seekg(m_ullVOffset[nTile]);
+      m_ScratchStream.read(&m_cVBuffer[0], m_ullVSize[nTile]);
+      if (! m_ScratchStream)
+      {
+         delete [] pTile;
+         Fail("cannot read grid tile from scratch file");
+         return m_pSinkTile;
+      }
+
+      char const* pc = &m_cVBuffer[0];
+      for (int n = 0; n < nCells; n++)
+         pc = pTile[n].pcReadFromBuffer(pc);
+
+      m_ulLoads++;
+      m_ullBytesRead += m_ullVSize[nTile];
+   }
+   else
+   {
+      for (int n = 0; n < nCells; n++)
+         pTile[n].AppendLayers(m_nLayers);
+
+      m_ulCreated++;
+   }
+
+   if (m_ulVInit[nTile] != m_ulInit)
+   {
+      for (int n = 0; n < nCells; n++)
+         pTile[n].InitCell();
+
+      m_ulVInit[nTile] = m_ulInit;
+   }
+
+   if (m_bPassiveSweep)
+      m_bVPassive[nTile] = true;
+   else
+      m_ulVActive[nTile] = m_ulTrim;
+
+   m_ulVLastUsed[nTile] = m_ulTrim;
+   m_nVResident.push_back(nTile);
+   m_nResident++;
+   m_nPeakResident = tMax(m_nPeakResident, m_nResident);
+
+   m_pApTile[nTile].store(pTile, std::memory_order_release);
+   return pTile;
+}
+
+
+//! Writes a tile to the scratch file (unless it is unchanged since it was last written) then frees its memory. Must only be called at a safe point. If the tile cannot be written, the failure is recorded and the tile is kept in memory
+void CTiledCellArray::PageOut(int const nTile)
+{
+   CGeomCell* pTile = m_pApTile[nTile].load(std::memory_order_relaxed);
+
+   int nCells = nCellsInTile();
+   m_cVBuffer.clear();
+   for (int n = 0; n < nCells; n++)
+      pTile[n].AppendToBuffer(&m_cVBuffer);
+
+   unsigned long long
+      ullSize = m_cVBuffer.size(),
+      ullNewHash = ullHash(&m_cVBuffer);
+
+   if (m_bVOnDisk[nTile] && (ullSize == m_ullVSize[nTile]) && (ullNewHash == m_ullVHash[nTile]))
+      m_ulCleanEvictions++;
+   else
+   {
+      // The number of layers is fixed, so a tile's size does not usually change. If it does grow, then it is given new space at the end of the file
+      if ((! m_bVOnDisk[nTile]) || (ullSize > m_ullVCapacity[nTile]))
+      {
+         m_ullVOffset[nTile] = m_ullFileSize;
+         m_ullVCapacity[nTile] = ullSize;
+         m_ullFileSize += ullSize;
+      }
+
+      m_ScratchStream.seekp(m_ullVOffset[nTile]);
+      m_ScratchStream.write(&m_cVBuffer[0], ullSize);
+      if (! m_ScratchStream)
+      {
+         Fail("cannot write grid tile to scratch file");
+         return;
+      }
+
+      m_bVOnDisk[nTile] = true;
+      m_ullVSize[nTile] = ullSize;
+      m_ullVHash[nTile] = ullNewHash;
+      m_ullBytesWritten += ullSize;
+   }
+
+   m_pApTile[nTile].store(NULL, std::memory_order_relaxed);
+   m_pAucUsed[nTile].store(0, std::memory_order_relaxed);
+   m_bVPassive[nTile] = false;
+   delete [] pTile;
+
+   m_ulEvictions++;
+   m_nResident--;
+}
+
+
+//! Called if a tile cannot be paged in or out. The tile's cells cannot be recovered, so the simulation cannot continue. This may be called by any thread (with m_LoadMutex held), so only the first failure is recorded here: the simulation checks bFailed() at the next safe point
+void CTiledCellArray::Fail(string const& strErr)
+{
+   if (m_bFailed.load(std::memory_order_relaxed))
+      return;
+
+   m_strError = strErr + " " + m_strFile;
+   m_bFailed.store(true, std::memory_order_release);
+}
+
+
+//! Returns a 64-bit FNV-1a hash of a buffer, used to tell whether a tile has changed since it was last written
+unsigned long long CTiledCellArray::ullHash(vector<char> const* pcVBuffer)
+{
+   unsigned long long ullHash = 14695981039346656037ULL;
+   for (unsigned int n = 0; n < pcVBuffer->size(); n++)
+   {
+      ullHash ^= static_cast<unsigned char>((*pcVBuffer)[n]);
+      ullHash *= 1099511628211ULL;
+   }
+
+   return ullHash;
+}
+
+
+//! Tiles which have been accessed since this was last done count as having been used now, and (unless a passive sweep is being done) as active now
+void CTiledCellArray::NoteUse(void)
+{
+   for (unsigned int n = 0; n < m_nVResident.size(); n++)
+   {
+      int nTile = m_nVResident[n];
+      if (m_pAucUsed[nTile].load(std::memory_order_relaxed) != 0)
+      {
+         m_ulVLastUsed[nTile] = m_ulTrim;
+         if (! m_bPassiveSweep)
+            m_ulVActive[nTile] = m_ulTrim;
+
+         m_pAucUsed[nTile].store(0, std::memory_order_relaxed);
+      }
+   }
+}
+
+
+//! Forgets the resident tiles which have been paged out
+void CTiledCellArray::ForgetPagedOut(void)
+{
+   unsigned int nKept = 0;
+   for (unsigned int n = 0; n < m_nVResident.size(); n++)
+   {
+      if (m_pApTile[m_nVResident[n]].load(std::memory_order_relaxed) != NULL)
+         m_nVResident[nKept++] = m_nVResident[n];
+   }
+   m_nVResident.resize(nKept);
+}
+
+
+//! Does the every-timestep initialization of all cells. If tiled, only the tiles which are in memory are initialized now: the others are initialized when they are next paged in. Must only be called at a safe point
+void CTiledCellArray::InitCells(void)
+{
+   if (! m_bTiled)
+   {
+      for (size_t n = 0; n < static_cast<size_t>(m_nXMax) * m_nYMax; n++)
+         m_pAllCells[n].InitCell();
+
+      return;
+   }
+
+   // Start a new period of activity, so that tiles which are initialized here but not then accessed do not count as active
+   NoteUse();
+   m_ulTrim++;
+   m_ulTrimAtLastInit = m_ulTrimAtInit;
+   m_ulTrimAtInit = m_ulTrim;
+
+   m_ulInit++;
+
+   int nCells = nCellsInTile();
+   for (unsigned int n = 0; n < m_nVResident.size(); n++)
+   {
+      int nTile = m_nVResident[n];
+      CGeomCell* pTile = m_pApTile[nTile].load(std::memory_order_relaxed);
+      for (int m = 0; m < nCells; m++)
+         pTile[m].InitCell();
+
+      m_ulVInit[nTile] = m_ulInit;
+   }
+}
+
+
+//! For a column of cells, gets the runs of cells (first, and one past the last) which are in tiles that have been accessed (other than by a passive sweep) since InitCells() was called nTimesteps ago, where nTimesteps is 1 or 2. Since the every-timestep values of any other cell are as set by InitCell(), the cells outside these runs are not in the sea and are not coastline, neither in this timestep nor (if nTimesteps is 2) in the previous timestep. If not tiled, the run is the whole column
+void CTiledCellArray::GetActiveRuns(int const nX, int const nTimesteps, vector<pair<int, int> >* pprVRun) const
+{
+   pprVRun->clear();
+
+   if (! m_bTiled)
+   {
+      pprVRun->push_back(make_pair(0, m_nYMax));
+      return;
+   }
+
+   unsigned long ulSince = (nTimesteps > 1 ? m_ulTrimAtLastInit : m_ulTrimAtInit);
+
+   int nTileX = nX >> m_nShiftX;
+   for (int nTileY = 0; nTileY < m_nTilesY; nTileY++)
+   {
+      // Has the tile been accessed since it was last noted as active?
+      int nTile = (nTileX * m_nTilesY) + nTileY;
+      bool bAccessed = ((! m_bPassiveSweep) && (m_pAucUsed[nTile].load(std::memory_order_relaxed) != 0));
+      if ((m_ulVActive[nTile] < ulSince) && (! bAccessed))
+         continue;
+
+      int
+         nYStart = nTileY << m_nShiftY,
+         nYEnd = tMin(nYStart + m_nTileSide, m_nYMax);
+
+      if ((! pprVRun->empty()) && (pprVRun->back().second == nYStart))
+         pprVRun->back().second = nYEnd;
+      else
+         pprVRun->push_back(make_pair(nYStart, nYEnd));
+   }
+}
+
+
+//! Starts a passive sweep, i.e. one which visits cells without this counting as activity: either it only reads cells (e.g. to write GIS output), or it only changes values which are kept from one timestep to the next. Tiles which are paged in during the sweep are paged out before any others, so that the sweep does not displace the tiles which the simulation is working on
+void CTiledCellArray::StartPassiveSweep(void)
+{
+   if (! m_bTiled)
+      return;
+
+   // Note which tiles the simulation has accessed, since accesses during the sweep do not count
+   NoteUse();
+   m_ulTrim++;
+
+   m_bPassiveSweep = true;
+}
+
+
+//! Ends a passive sweep, and pages out the tiles which it paged in (unless they are in the coastal band). A tile is only written to the scratch file if the sweep changed it. Must only be called at a safe point
+void CTiledCellArray::EndPassiveSweep(void)
+{
+   if (! m_bTiled)
+      return;
+
+   NoteUse();
+   m_bPassiveSweep = false;
+
+   for (unsigned int n = 0; (n < m_nVResident.size()) && (! m_bFailed.load(std::memory_order_relaxed)); n++)
+   {
+      int nTile = m_nVResident[n];
+      if (m_bVPassive[nTile] && (! m_bVInBand[nTile]))
+         PageOut(nTile);
+
+      m_bVPassive[nTile] = false;
+   }
+
+   ForgetPagedOut();
+}
+
+
+//! Empties the coastal band
+void CTiledCellArray::ClearBand(void)
+{
+   if (m_bTiled)
+      m_bVInBand.assign(m_nNumTiles, false);
+}
+
+
+//! Adds every tile which is within the given distance (in cells) of a cell to the coastal band
+void CTiledCellArray::AddToBand(int const nX, int const nY, int const nRadius)
+{
+   if (! m_bTiled)
+      return;
+
+   int
+      nTileXMin = tMax(nX - nRadius, 0) >> m_nShiftX,
+      nTileXMax = tMin(nX + nRadius, m_nXMax-1) >> m_nShiftX,
+      nTileYMin = tMax(nY - nRadius, 0) >> m_nShiftY,
+      nTileYMax = tMin(nY + nRadius, m_nYMax-1) >> m_nShiftY;
+
+   for (int nTileX = nTileXMin; nTileX <= nTileXMax; nTileX++)
+      for (int nTileY = nTileYMin; nTileY <= nTileYMax; nTileY++)
+         m_bVInBand[(nTileX * m_nTilesY) + nTileY] = true;
+}
+
+
+//! If more tiles are in memory than the cache budget allows, pages out tiles which are not in the coastal band, those which a passive sweep has finished with first, then least recently used first, until comfortably within the budget. Must only be called at a safe point, i.e. outside any parallel region and when no references to cells are held
+void CTiledCellArray::PageOutUnused(void)
+{
+   // If a tile could not be paged in or out, do not page out any more since the simulation is about to stop
+   if ((! m_bTiled) || m_bFailed.load(std::memory_order_acquire) || (m_nResident <= m_nMaxResident))
+      return;
+
+   // Tiles which have been accessed since the last time that this was done count as having been used now
+   NoteUse();
+
+   vector<pair<pair<int, unsigned long>, int> > prVCandidate;
+   for (unsigned int n = 0; n < m_nVResident.size(); n++)
+   {
+      int nTile = m_nVResident[n];
+      if (! m_bVInBand[nTile])
+         // Tiles which were paged in by a passive sweep, but which the sweep has finished with, come first
+         prVCandidate.push_back(make_pair(make_pair(((m_bVPassive[nTile] && (m_ulVLastUsed[nTile] < m_ulTrim)) ? 0 : 1), m_ulVLastUsed[nTile]), nTile));
+   }
+
+   sort(prVCandidate.begin(), prVCandidate.end());
+
+   // Go below the budget, so that this is not needed again straight away
+   int nTarget = tMax(static_cast<int>(m_nMaxResident * GRID_TILE_PAGE_OUT_TARGET), 1);
+   for (unsigned int n = 0; (n < prVCandidate.size()) && (m_nResident > nTarget) && (! m_bFailed.load(std::memory_order_relaxed)); n++)
+      PageOut(prVCandidate[n].second);
+
+   // Forget the tiles which were paged out
+   ForgetPagedOut();
+
+   m_ulTrim++;
+}
+
+
+//! Returns true if a tile could not be paged in or out. Must only be called at a safe point
+bool CTiledCellArray::bFailed(void) const
+{
+   return m_bFailed.load(std::memory_order_acquire);
+}
+
+
+//! Returns why a tile could not be paged in or out
+string CTiledCellArray::strGetError(void) const
+{
+   return m_strError;
+}
+
+
+//! Returns true if the cells are held as tiles
+bool CTiledCellArray::bIsTiled(void) const
+{
+   return m_bTiled;
+}
+
+
+//! Returns the side of each tile in cells, zero if not tiled
+int CTiledCellArray::nGetTileSide(void) const
+{
+   return m_nTileSide;
+}
+
+
+//! Returns the number of tiles
+int CTiledCellArray::nGetNumTiles(void) const
+{
+   return m_nNumTiles;
+}
+
+
+//! Returns the cache budget, in tiles
+int CTiledCellArray::nGetMaxResident(void) const
+{
+   return m_nMaxResident;
+}
+
+
+//! Returns the number of tiles in memory
+int CTiledCellArray::nGetResident(void) const
+{
+   return m_nResident;
+}
+
+
+//! Returns the largest number of tiles which have been in memory at once
+int CTiledCellArray::nGetPeakResident(void) const
+{
+   return m_nPeakResident;
+}
+
+
+//! Returns the number of tiles in the coastal band
+int CTiledCellArray::nGetInBand(void) const
+{
+   int nInBand = 0;
+   for (unsigned int n = 0; n < m_bVInBand.size(); n++)
+      if (m_bVInBand[n])
+         nInBand++;
+
+   return nInBand;
+}
+
+
+//! Returns the number of tiles read from the scratch file
+unsigned long CTiledCellArray::ulGetLoads(void) const
+{
+   return m_ulLoads;
+}
+
+
+//! Returns the number of tiles created when first accessed
+unsigned long CTiledCellArray::ulGetCreated(void) const
+{
+   return m_ulCreated;
+}
+
+
+//! Returns the number of tiles paged out
+unsigned long CTiledCellArray::ulGetEvictions(void) const
+{
+   return m_ulEvictions;
+}
+
+
+//! Returns the number of tiles paged out without being written, because they had not changed
+unsigned long CTiledCellArray::ulGetCleanEvictions(void) const
+{
+   return m_ulCleanEvictions;
+}
+
+
+//! Returns the number of bytes read from the scratch file
+unsigned long long CTiledCellArray::ullGetBytesRead(void) const
+{
+   return m_ullBytesRead;
+}
+
+
+//! Returns the number of bytes written to the scratch file
+unsigned long long CTiledCellArray::ullGetBytesWritten(void) const
+{
+   return m_ullBytesWritten;
+}
+
+
+//! Returns the size of the scratch file in bytes
+unsigned long long CTiledCellArray::ullGetFileSize(void) const
+{
+   return m_ullFileSize;
+}
+
+
+//! Returns the name of the scratch file
+string CTiledCellArray::strGetFile(void) const
+{
+   return m_strFile;
+}
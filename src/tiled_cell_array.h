@@ -0,0 +1,244 @@
+/*!
+ *
+ * \class CTiledCellArray
+ * \brief Class used to hold the raster grid's cells, either all in memory or as square tiles which are paged to and from a scratch file
+ * \details By default, all cells are held in memory in a single block, as before. Tiling is only available if CoastalME is built with CME_TILED_GRID defined (the TILED_GRID CMake option): otherwise a cell is found directly from its column, with no check for tiling, so cells are found as quickly as in a 2D vector. For domains which are too large for this, the cells can instead be held as square tiles of cells, with the number of tiles resident in memory limited by a cache budget. A tile is brought into memory (from the scratch file, or newly created) the first time that one of its cells is accessed. Cells are accessed by reference, and references are often kept for a while: so tiles are only ever paged out at safe points (between stages of a timestep, and between columns or rows of a few full-grid sweeps) when the model holds no such references. Tiles in the coastal band (near a coastline, where nearly all the work is done) are never paged out. The other resident tiles are paged out least-recently-used first, until the number of resident tiles is comfortably within the budget. A tile is only written to the scratch file if its contents have changed since it was last written. Cells are accessed as m_Cell[nX][nY] in both cases, just as for a 2D vector
+ * \details So that tiles far from the sea can stay on the scratch file, the every-timestep initialization of cells is done tile by tile: tiles which are in memory are initialized at once, the others when they are next paged in. A tile which has not been accessed since then cannot hold any sea or coastline cells, so sweeps which only look for these need only visit the tiles which have been accessed recently. Sweeps which must visit every cell (e.g. GIS output) are marked as passive: their accesses do not count, and the tiles which they page in are the first to be paged out again
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file tiled_cell_array.h
+ * \brief Contains CTiledCellArray definitions
+ *
+ */
+
+#ifndef TILEDCELLARRAY_H
+#define TILEDCELLARRAY_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <atomic>
+#include <mutex>
+
+#include <fstream>
+using std::fstream;
+
+#include <string>
+using std::string;
+
+#include <utility>
+using std::pair;
+
+#include <vector>
+using std::vector;
+
+#include "cell.h"
+
+
+class CTiledCellArray
+{
+public:
+#ifdef CME_TILED_GRID
+   // Returned by operator[], so that cells can be accessed as m_Cell[nX][nY]
+   class CColumn
+   {
+   private:
+      CTiledCellArray* m_pArray;
+      CGeomCell* m_pColumn;               // If not tiled, the column's first cell
+      int m_nX;
+
+   public:
+      CColumn(CTiledCellArray* pArray, CGeomCell* pColumn, int const nX)
+      :  m_pArray(pArray),
+         m_pColumn(pColumn),
+         m_nX(nX)
+      {
+      }
+
+      CGeomCell& operator[](int const nY) const
+      {
+         if (m_pColumn)
+            return m_pColumn[nY];
+
+         return m_pArray->Cell(m_nX, nY);
+      }
+   };
+#endif
+
+private:
+   bool
+      m_bTiled;                           // If false, all cells are in a single block which is always in memory
+
+   int
+      m_nXMax,
+      m_nYMax,
+      m_nTileSide,                        // In cells, a power of two. If not tiled, there is a single 'tile' of m_nXMax x m_nYMax cells
+      m_nShiftX,                          // Shifts and masks to find a cell's tile, and the cell's position within its tile
+      m_nShiftY,
+      m_nMaskX,
+      m_nMaskY,
+      m_nTileStride,                      // Cells in each column of a tile
+      m_nTilesX,
+      m_nTilesY,
+      m_nNumTiles,
+      m_nMaxResident,                     // The cache budget, in tiles
+      m_nResident,
+      m_nPeakResident,
+      m_nLayers;                          // Every cell has this many layers
+
+   bool
+      m_bPassiveSweep;                    // Is a passive sweep being done?
+
+   unsigned long
+      m_ulInit,                           // Number of times that cells have been initialized, used as the clock for tile initialization
+      m_ulTrim,                           // Number of times that tiles have been paged out (or cells initialized), used as the clock for least-recently-used
+      m_ulTrimAtInit,                     // Value of m_ulTrim when cells were last initialized
+      m_ulTrimAtLastInit,                 // Value of m_ulTrim when cells were initialized the time before
+      m_ulLoads,                          // Tiles read from the scratch file
+      m_ulCreated,                        // Tiles created without being read
+      m_ulEvictions,
+      m_ulCleanEvictions;                 // Tiles paged out without being written, since unchanged
+
+   unsigned long long
+      m_ullBytesRead,
+      m_ullBytesWritten,
+      m_ullFileSize;
+
+   string
+      m_strFile,
+      m_strError;                         // Why a tile could not be paged in or out
+
+   fstream
+      m_ScratchStream;
+
+   std::mutex
+      m_LoadMutex;                        // Guards paging in, since cells may be accessed by several threads at once
+
+   std::atomic<CGeomCell*>*
+      m_pApTile;                          // One per tile, NULL if the tile is not in memory
+
+   std::atomic<unsigned char>*
+      m_pAucUsed;                         // One per tile, set when any of the tile's cells is accessed
+
+   std::atomic<bool>
+      m_bFailed;                          // Set if a tile could not be paged in or out
+
+   CGeomCell*
+      m_pAllCells;                        // If not tiled, the single block of cells
+
+   CGeomCell*
+      m_pSinkTile;                        // Cells handed out in place of a tile which could not be paged in, so that threads can carry on until the next safe point
+
+   vector<bool>
+      m_bVInBand,                         // Is the tile in the coastal band?
+      m_bVOnDisk,                         // Has the tile ever been written to the scratch file?
+      m_bVPassive;                        // Was the tile paged in by a passive sweep?
+
+   vector<int>
+      m_nVResident;                       // The tiles which are in memory, in no particular order
+
+   vector<unsigned long>
+      m_ulVLastUsed,                      // Value of m_ulTrim when the tile was last known to have been accessed
+      m_ulVActive,                        // Value of m_ulTrim when the tile was last known to have been accessed, other than by a passive sweep
+      m_ulVInit;                          // Value of m_ulInit when the tile's cells were last initialized
+
+   vector<unsigned long long>
+      m_ullVOffset,                       // Where the tile is in the scratch file
+      m_ullVCapacity,                     // Size of the space for the tile in the scratch file
+      m_ullVSize,                         // Size of the tile as last written
+      m_ullVHash;                         // Hash of the tile as last written (or read)
+
+   vector<char>
+      m_cVBuffer;
+
+   CGeomCell* pPageIn(int const);
+   void PageOut(int const);
+   void Fail(string const&);
+   void NoteUse(void);
+   void ForgetPagedOut(void);
+   int nCellsInTile(void) const;
+   static unsigned long long ullHash(vector<char> const*);
+
+public:
+   CTiledCellArray(void);
+   ~CTiledCellArray(void);
+
+   int nCreate(int const, int const, int const, int const, int const, string const&);
+
+#ifndef CME_TILED_GRID
+   //! Returns a reference to a cell. Not tiled, since this build does not support tiling
+   CGeomCell& Cell(int const nX, int const nY)
+   {
+      return m_pAllCells[(static_cast<size_t>(nX) * m_nTileStride) + nY];
+   }
+
+   //! Returns a column's first cell, so that m_Cell[nX][nY] is found as quickly as in a 2D vector
+   CGeomCell* operator[](int const nX)
+   {
+      return m_pAllCells + (static_cast<size_t>(nX) * m_nTileStride);
+   }
+#else
+   //! Returns a reference to a cell, paging in its tile if necessary
+   CGeomCell& Cell(int const nX, int const nY)
+   {
+      // If not tiled, there is nothing to page in and tiles are never paged out, so no need to record use
+      if (! m_bTiled)
+         return m_pAllCells[(nX * m_nTileStride) + nY];
+
+      int nTile = ((nX >> m_nShiftX) * m_nTilesY) + (nY >> m_nShiftY);
+
+      CGeomCell* pTile = m_pApTile[nTile].load(std::memory_order_acquire);
+      if (pTile == NULL)
+         pTile = pPageIn(nTile);
+
+      if (m_pAucUsed[nTile].load(std::memory_order_relaxed) == 0)
+         m_pAucUsed[nTile].store(1, std::memory_order_relaxed);
+
+      return pTile[((nX & m_nMaskX) * m_nTileStride) + (nY & m_nMaskY)];
+   }
+
+   //! If not tiled, the column is found here, so that cells are found as quickly as in a 2D vector
+   CColumn operator[](int const nX)
+   {
+      return CColumn(this, (m_bTiled ? NULL : m_pAllCells + (static_cast<size_t>(nX) * m_nTileStride)), nX);
+   }
+#endif
+
+   void InitCells(void);
+   void GetActiveRuns(int const, int const, vector<pair<int, int> >*) const;
+   void StartPassiveSweep(void);
+   void EndPassiveSweep(void);
+   void ClearBand(void);
+   void AddToBand(int const, int const, int const);
+   void PageOutUnused(void);
+   bool bFailed(void) const;
+   string strGetError(void) const;
+
+   bool bIsTiled(void) const;
+   int nGetTileSide(void) const;
+   int nGetNumTiles(void) const;
+   int nGetMaxResident(void) const;
+   int nGetResident(void) const;
+   int nGetPeakResident(void) const;
+   int nGetInBand(void) const;
+   unsigned long ulGetLoads(void) const;
+   unsigned long ulGetCreated(void) const;
+   unsigned long ulGetEvictions(void) const;
+   unsigned long ulGetCleanEvictions(void) const;
+   unsigned long long ullGetBytesRead(void) const;
+   unsigned long long ullGetBytesWritten(void) const;
+   unsigned long long ullGetFileSize(void) const;
+   string strGetFile(void) const;
+};
+#endif // TILEDCELLARRAY_H
@@ -0,0 +1,271 @@
+/*!
+ *
+ * \file trace_writer.cpp
+ * \brief CTraceWriter routines
+ * \details Writes a trace of the simulation in Chrome trace-event format, i.e. a JSON array of events. Each span is written as a 'complete' event (phase "X"), with its start time and duration in microseconds; the thread ID is the OpenMP thread number. Trace viewers accept an array without the closing bracket, so the trace is still usable if the run stops early
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <iomanip>
+using std::fixed;
+using std::setprecision;
+
+#include <ostream>
+using std::endl;
+
+#include "cme.h"
+#include "trace_writer.h"
+
+
+CTraceWriter::CTraceWriter(string const& strFile, int const nTimestepInterval, int const nItemInterval, int const nMaxBuffered)
+:
+   m_bActive(false),
+   m_bFirstEvent(true),
+   m_bWriteError(false),
+   m_nTimestepInterval(nTimestepInterval),
+   m_nItemInterval(tMax(nItemInterval, 1)),
+   m_nMaxBuffered(tMax(nMaxBuffered, 1)),
+   m_ulTimestep(0),
+   m_ulNumTimesteps(0),
+   m_ulNumEvents(0),
+   m_ulNumFlushes(0),
+   m_dTimestepStart(0),
+   m_TimeZero(std::chrono::steady_clock::now()),
+   m_strFile(strFile)
+{
+   m_VEvent.reserve(m_nMaxBuffered);
+}
+
+CTraceWriter::~CTraceWriter(void)
+{
+   Close();
+}
+
+
+//! Opens the trace file and writes the start of the event array. Returns false if the file cannot be opened
+bool CTraceWriter::bOpen(void)
+{
+   m_TraceStream.open(m_strFile.c_str(), ios::out | ios::trunc);
+   if (! m_TraceStream)
+      return false;
+
+   m_TraceStream << fixed << setprecision(3);
+   m_TraceStream << "[" << endl;
+   m_TraceStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"" << PROGNAME << "\"}}";
+   m_bFirstEvent = false;
+
+   return true;
+}
+
+
+//! Writes any buffered spans, then names each thread which has been seen and closes the event array
+void CTraceWriter::Close(void)
+{
+   if (! m_TraceStream.is_open())
+      return;
+
+   // Don't use Flush() here, since that would leave a span in the buffer
+   for (unsigned int n = 0; n < m_VEvent.size(); n++)
+      WriteEvent(&m_VEvent[n]);
+   m_VEvent.clear();
+
+   for (unsigned int n = 0; n < m_bVThreadSeen.size(); n++)
+   {
+      if (m_bVThreadSeen[n])
+         m_TraceStream << "," << endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << n << ",\"args\":{\"name\":\"Thread " << n << "\"}}";
+   }
+
+   m_TraceStream << endl << "]" << endl;
+   m_TraceStream.close();
+}
+
+
+//! Writes a single span to the trace file
+void CTraceWriter::WriteEvent(TraceEvent const* pEvent)
+{
+   if (! m_bFirstEvent)
+      m_TraceStream << "," << endl;
+   m_bFirstEvent = false;
+
+   m_TraceStream << "{\"name\":\"" << pEvent->pszName << "\",\"cat\":\"" << pEvent->pszCategory << "\",\"ph\":\"X\",\"ts\":" << pEvent->dStart << ",\"dur\":" << pEvent->dDuration << ",\"pid\":1,\"tid\":" << pEvent->nThread << ",\"args\":{";
+
+   bool bComma = false;
+   if (pEvent->nCoast != INT_NODATA)
+   {
+      m_TraceStream << "\"coast\":" << pEvent->nCoast;
+      bComma = true;
+   }
+
+   if (pEvent->pszItem != NULL)
+   {
+      if (bComma)
+         m_TraceStream << ",";
+      m_TraceStream << "\"" << pEvent->pszItem << "\":" << pEvent->nItem;
+   }
+
+   m_TraceStream << "}}";
+
+   m_ulNumEvents++;
+}
+
+
+//! Writes all buffered spans to the trace file, then empties the buffer. The time taken to do this is itself recorded as a span, so that it is not mistaken for simulation time
+void CTraceWriter::Flush(void)
+{
+   if (m_VEvent.empty())
+      return;
+
+   double dStart = dGetTime();
+
+   for (unsigned int n = 0; n < m_VEvent.size(); n++)
+      WriteEvent(&m_VEvent[n]);
+
+   m_TraceStream.flush();
+   if (! m_TraceStream)
+      m_bWriteError = true;
+
+   m_VEvent.clear();
+   m_ulNumFlushes++;
+
+   TraceEvent Flush;
+   Flush.pszName = "Write trace";
+   Flush.pszCategory = "trace";
+   Flush.pszItem = NULL;
+#ifdef _OPENMP
+   Flush.nThread = omp_get_thread_num();
+#else
+   Flush.nThread = 0;
+#endif
+   Flush.nCoast = INT_NODATA;
+   Flush.nItem = 0;
+   Flush.dStart = dStart;
+   Flush.dDuration = dGetTime() - dStart;
+   m_VEvent.push_back(Flush);
+}
+
+
+//! Called at the start of every timestep: decides whether this timestep is to be traced. The first timestep is always traced, then every Nth timestep
+void CTraceWriter::StartTimestep(unsigned long const ulTimestep)
+{
+   m_ulTimestep = ulTimestep;
+   m_bActive = (m_nTimestepInterval > 0) && (((ulTimestep - 1) % m_nTimestepInterval) == 0);
+
+   if (m_bActive)
+   {
+      m_ulNumTimesteps++;
+      m_dTimestepStart = dGetTime();
+   }
+}
+
+
+//! Called at the end of every timestep: if it was traced, then records the span for the whole timestep and writes all buffered spans. Returns false if there has been an error writing to the trace file
+bool CTraceWriter::bEndTimestep(void)
+{
+   if (m_bActive)
+   {
+      AddSpan("Timestep", "timestep", m_dTimestepStart, INT_NODATA, "timestep", static_cast<int>(m_ulTimestep));
+      Flush();
+      m_bActive = false;
+   }
+
+   return (! m_bWriteError);
+}
+
+
+//! Returns true if the current timestep is being traced
+bool CTraceWriter::bIsActive(void) const
+{
+   return m_bActive;
+}
+
+
+//! Returns true if the current timestep is being traced, and the profile or polygon with this number is to be traced
+bool CTraceWriter::bTraceItem(int const nItem) const
+{
+   return m_bActive && ((nItem % m_nItemInterval) == 0);
+}
+
+
+//! Returns the time in microseconds since the trace was started
+double CTraceWriter::dGetTime(void) const
+{
+   return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_TimeZero).count();
+}
+
+
+//! Records a span which started at dStart (from dGetTime) and ends now. nCoast may be INT_NODATA, and pszItem may be NULL. May be called from within an OpenMP parallel region
+void CTraceWriter::AddSpan(char const* pszName, char const* pszCategory, double const dStart, int const nCoast, char const* pszItem, int const nItem)
+{
+   TraceEvent Event;
+   Event.pszName = pszName;
+   Event.pszCategory = pszCategory;
+   Event.pszItem = pszItem;
+#ifdef _OPENMP
+   Event.nThread = omp_get_thread_num();
+#else
+   Event.nThread = 0;
+#endif
+   Event.nCoast = nCoast;
+   Event.nItem = nItem;
+   Event.dStart = dStart;
+   Event.dDuration = dGetTime() - dStart;
+
+#ifdef _OPENMP
+   #pragma omp critical (Trace)
+#endif
+   {
+      if (Event.nThread >= static_cast<int>(m_bVThreadSeen.size()))
+         m_bVThreadSeen.resize(Event.nThread + 1, false);
+      m_bVThreadSeen[Event.nThread] = true;
+
+      m_VEvent.push_back(Event);
+
+      // Don't let the buffer grow without limit
+      if (static_cast<int>(m_VEvent.size()) >= m_nMaxBuffered)
+         Flush();
+   }
+}
+
+
+//! Returns the name of the trace file
+string CTraceWriter::strGetFile(void) const
+{
+   return m_strFile;
+}
+
+
+//! Returns the number of timesteps traced
+unsigned long CTraceWriter::ulGetNumTimesteps(void) const
+{
+   return m_ulNumTimesteps;
+}
+
+
+//! Returns the number of spans written to the trace file
+unsigned long CTraceWriter::ulGetNumEvents(void) const
+{
+   return m_ulNumEvents;
+}
+
+
+//! Returns the number of times that buffered spans were written to the trace file
+unsigned long CTraceWriter::ulGetNumFlushes(void) const
+{
+   return m_ulNumFlushes;
+}
@@ -0,0 +1,126 @@
+/*!
+ *
+ * \class CTraceWriter
+ * \brief Class used to write a trace of the simulation, in Chrome trace-event format
+ * \details Each traced timestep, each stage of the timestep, and the processing of individual coasts, profiles and polygons is recorded as a span (a start time and a duration) together with the OpenMP thread which did the work. When the trace file is opened in a trace viewer (e.g. chrome://tracing or Perfetto), the spans appear nested on a timeline, one row per thread, so that load imbalance between profiles or polygons can be seen. To keep the trace a manageable size, only every Nth timestep is traced, and within each traced timestep only every Mth profile or polygon. Spans are held in a buffer of fixed size, which is written to the trace file when it is full and at the end of each traced timestep
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file trace_writer.h
+ * \brief Contains CTraceWriter definitions
+ *
+ */
+
+#ifndef TRACEWRITER_H
+#define TRACEWRITER_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <chrono>
+
+#include <fstream>
+using std::ofstream;
+using std::ios;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+
+class CTraceWriter
+{
+private:
+   // A single span. The name, category and item label must all be string constants, or strings which last for the whole run
+   struct TraceEvent
+   {
+      char const*
+         pszName;
+
+      char const*
+         pszCategory;
+
+      char const*
+         pszItem;                         // Label for nItem, NULL if there is no item
+
+      int
+         nThread,
+         nCoast,                          // INT_NODATA if the span is not for a coast
+         nItem;
+
+      double
+         dStart,                          // Microseconds since the trace was started
+         dDuration;                       // Ditto
+   };
+
+   bool
+      m_bActive,                          // Is the current timestep being traced?
+      m_bFirstEvent,
+      m_bWriteError;
+
+   int
+      m_nTimestepInterval,
+      m_nItemInterval,
+      m_nMaxBuffered;
+
+   unsigned long
+      m_ulTimestep,
+      m_ulNumTimesteps,
+      m_ulNumEvents,
+      m_ulNumFlushes;
+
+   double
+      m_dTimestepStart;
+
+   std::chrono::steady_clock::time_point
+      m_TimeZero;
+
+   string
+      m_strFile;
+
+   ofstream
+      m_TraceStream;
+
+   vector<bool>
+      m_bVThreadSeen;
+
+   vector<TraceEvent>
+      m_VEvent;
+
+   void WriteEvent(TraceEvent const*);
+   void Flush(void);
+
+public:
+   CTraceWriter(string const&, int const, int const, int const);
+   ~CTraceWriter(void);
+
+   bool bOpen(void);
+   void Close(void);
+
+   void StartTimestep(unsigned long const);
+   bool bEndTimestep(void);
+
+   bool bIsActive(void) const;
+   bool bTraceItem(int const) const;
+   double dGetTime(void) const;
+
+   void AddSpan(char const*, char const*, double const, int const, char const*, int const);
+
+   string strGetFile(void) const;
+   unsigned long ulGetNumTimesteps(void) const;
+   unsigned long ulGetNumEvents(void) const;
+   unsigned long ulGetNumFlushes(void) const;
+};
+#endif // TRACEWRITER_H
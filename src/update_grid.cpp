@@ -38,22 +38,29 @@ using std::endl;
 ===============================================================================================================================*/
 int CSimulation::nUpdateGrid(void)
 {
-   // Go through all cells in the raster grid and calculate some this-timestep totals
+   // Go through all cells in the raster grid and calculate some this-timestep totals. If the grid is tiled, only visit the tiles which have been in use during this timestep: no other cell can be a sea cell or coastline
+   vector<pair<int, int> > prVRun;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
-      for (int nY = 0; nY < m_nYGridMax; nY++)
+      m_pRasterGrid->m_Cell.GetActiveRuns(nX, 1, &prVRun);
+      for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
       {
-         if (m_pRasterGrid->m_Cell[nX][nY].bIsCoastline())
-            m_ulThisTimestepNumCoastCells++;
-
-         if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
+         for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
          {
-            // Is a sea cell
-            m_ulThisTimestepNumSeaCells++;
+            if (m_pRasterGrid->m_Cell[nX][nY].bIsCoastline())
+               m_ulThisTimestepNumCoastCells++;
+
+            if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
+            {
+               // Is a sea cell
+               m_ulThisTimestepNumSeaCells++;
 
-            m_dThisTimestepTotSeaDepth += m_pRasterGrid->m_Cell[nX][nY].dGetSeaDepth();
+               m_dThisTimestepTotSeaDepth += m_pRasterGrid->m_Cell[nX][nY].dGetSeaDepth();
+            }
          }
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 
    // No sea cells?
@@ -61,15 +68,21 @@ int CSimulation::nUpdateGrid(void)
       // All land, assume this is an error
       return RTN_ERR_NOSEACELLS;
 
-   // Now go through all cells again and sort out suspended sediment load
+   // Now go through all cells again (again, if tiled, only those in tiles which have been in use during this timestep) and sort out suspended sediment load
    double dSuspPerSeaCell = m_ldGTotSuspendedSediment / m_ulThisTimestepNumSeaCells;
    for (int nX = 0; nX < m_nXGridMax; nX++)
    {
-      for (int nY = 0; nY < m_nYGridMax; nY++)
+      m_pRasterGrid->m_Cell.GetActiveRuns(nX, 1, &prVRun);
+      for (unsigned int nRun = 0; nRun < prVRun.size(); nRun++)
       {
-         if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
-            m_pRasterGrid->m_Cell[nX][nY].SetSuspendedSediment(dSuspPerSeaCell);
+         for (int nY = prVRun[nRun].first; nY < prVRun[nRun].second; nY++)
+         {
+            if (m_pRasterGrid->m_Cell[nX][nY].bIsInContiguousSea())
+               m_pRasterGrid->m_Cell[nX][nY].SetSuspendedSediment(dSuspPerSeaCell);
+         }
       }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
    }
 
    // Go along each coastline and update the grid with landform attributes, ready for next timestep
@@ -84,3 +97,27 @@ int CSimulation::nUpdateGrid(void)
    return RTN_OK;
 }
 
+
+
+/*===============================================================================================================================
+
+ If the raster grid is tiled, marks the tiles which are in the coastal band, i.e. within a coastline-normal length of a coastline. Nearly all the work of each timestep is done here, so these tiles are kept in memory
+
+===============================================================================================================================*/
+void CSimulation::SetGridTileBand(void)
+{
+   if (! m_pRasterGrid->m_Cell.bIsTiled())
+      return;
+
+   int nRadius = static_cast<int>(dRound(m_dCoastNormalLength * m_dInvCellSide)) + 1;
+
+   m_pRasterGrid->m_Cell.ClearBand();
+   for (int nCoast = 0; nCoast < static_cast<int>(m_VCoast.size()); nCoast++)
+   {
+      for (int nPoint = 0; nPoint < m_VCoast[nCoast].nGetCoastlineSize(); nPoint++)
+      {
+         CGeom2DIPoint* pPti = m_VCoast[nCoast].pPtiGetCellMarkedAsCoastline(nPoint);
+         m_pRasterGrid->m_Cell.AddToBand(pPti->nGetX(), pPti->nGetY(), nRadius);
+      }
+   }
+}
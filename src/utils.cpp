@@ -33,6 +33,8 @@
    #include <unistd.h>              // For isatty()
 #endif
 
+#include <chrono>
+
 #include <ctime>
 using std::time;
 using std::localtime;
@@ -68,6 +70,11 @@ using std::inner_product;
 
 #include "cme.h"
 #include "simulation.h"
+#include "trace_writer.h"
+#include "status_server.h"
+#include "shared_export.h"
+#include "raster_grid.h"
+#include "coast.h"
 
 
 /*==============================================================================================================================
@@ -1107,6 +1114,41 @@ bool CSimulation::bSetUpTSFiles(void)
       }
    }
 
+   if (m_bStageTimings || m_bStageMemory || m_bStageHWCounters)
+   {
+      // Per-stage timings, memory use and hardware performance counters
+      strTSFile = m_strOutPath;
+      strTSFile.append(STAGETSNAME);
+      strTSFile.append(CSVEXT);
+
+      // Open per-stage CSV file
+      StageTSStream.open(strTSFile.c_str(), ios::out | ios::trunc);
+      if (! StageTSStream)
+      {
+         // Error, cannot open per-stage time-series file
+         cerr << ERR << "cannot open " << strTSFile << " for output" << endl;
+         return false;
+      }
+
+      // Unlike the other time series files, this one has a header, since it has many columns
+      StageTSStream << "Timestep,Elapsed (hours)";
+      for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+      {
+         if (m_bStageTimings)
+            StageTSStream << "," << STAGE_NAME[nStage] << " time (s)";
+
+         if (m_bStageMemory)
+            StageTSStream << "," << STAGE_NAME[nStage] << " allocations," << STAGE_NAME[nStage] << " bytes allocated," << STAGE_NAME[nStage] << " end RSS (Mb)," << STAGE_NAME[nStage] << " peak RSS (Mb)";
+
+         if (m_bStageHWCounters)
+         {
+            for (int n = 0; n < NUM_HW_COUNTERS; n++)
+               StageTSStream << "," << STAGE_NAME[nStage] << " " << HW_COUNTER_NAME[n];
+         }
+      }
+      StageTSStream << endl;
+   }
+
    return true;
 }
 
@@ -1811,6 +1853,433 @@ void CSimulation::CalcProcessStats(void)
 }
 
 
+/*==============================================================================================================================
+
+ Returns the wall-clock time in seconds, from an arbitrary starting point
+
+==============================================================================================================================*/
+static double dGetWallClock(void)
+{
+   return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/*==============================================================================================================================
+
+ If per-stage timings are being recorded, notes the wall-clock time at the start of a stage of the timestep. If per-stage memory use is being recorded, notes the number of heap allocations so far and the resident set size, and resets the peak resident set size. If hardware performance counters are being recorded, notes their values. If this timestep is being traced, notes the trace time
+
+==============================================================================================================================*/
+void CSimulation::StartStage(void)
+{
+   if (m_bStageMemory)
+   {
+      m_ullStageAllocsStart = ullGetNumAllocs();
+      m_ullStageAllocBytesStart = ullGetAllocBytes();
+      m_dStageStartRSS = dGetCurrentRSS();
+
+      if (m_bCanResetPeakRSS)
+         bResetPeakRSS();
+   }
+
+   // The status server also needs per-stage timings
+   if (m_bStageTimings || m_pStatusServer)
+      m_dStageStart = dGetWallClock();
+
+   // Do this last, so that as little as possible of the above is counted
+   if (m_bStageHWCounters)
+      ReadHWCounters(m_ullStageHWStart);
+
+   if (m_pTraceWriter && m_pTraceWriter->bIsActive())
+      m_dTraceStageStart = m_pTraceWriter->dGetTime();
+}
+
+
+/*==============================================================================================================================
+
+ Adds the wall-clock time, heap allocations etc. since StartStage() was called to the totals for this stage. If this timestep is being traced, records the stage as a span. Returns the stage's return code, unless a tile of the raster grid could not be paged in or out during the stage, in which case returns RTN_ERR_SCRATCH_FILE
+
+==============================================================================================================================*/
+int CSimulation::nEndStage(int const nStage, int const nRet)
+{
+   // If the raster grid is tiled, page out tiles which are not needed. No references to cells are held between stages, so this is safe. Do it first, so that its cost is counted as part of this stage
+   if (m_pRasterGrid)
+      m_pRasterGrid->m_Cell.PageOutUnused();
+
+   // Then this, as early as possible for the same reason as in StartStage()
+   if (m_bStageHWCounters)
+   {
+      unsigned long long ullNow[NUM_HW_COUNTERS];
+      ReadHWCounters(ullNow);
+
+      for (int n = 0; n < NUM_HW_COUNTERS; n++)
+      {
+         unsigned long long ullCount = (ullNow[n] > m_ullStageHWStart[n] ? ullNow[n] - m_ullStageHWStart[n] : 0);
+         m_ullStageHW[nStage][n] += ullCount;
+         m_ullThisTimestepStageHW[nStage][n] += ullCount;
+      }
+   }
+
+   if (m_bStageTimings || m_pStatusServer)
+   {
+      double dElapsed = dGetWallClock() - m_dStageStart;
+      m_dStageTime[nStage] += dElapsed;
+      m_dThisTimestepStageTime[nStage] += dElapsed;
+   }
+
+   if (m_bStageMemory)
+   {
+      unsigned long long
+         ullAllocs = ullGetNumAllocs() - m_ullStageAllocsStart,
+         ullBytes = ullGetAllocBytes() - m_ullStageAllocBytesStart;
+
+      m_ullStageAllocs[nStage] += ullAllocs;
+      m_ullStageAllocBytes[nStage] += ullBytes;
+      m_ullThisTimestepStageAllocs[nStage] += ullAllocs;
+      m_ullThisTimestepStageAllocBytes[nStage] += ullBytes;
+
+      // If the peak resident set size could not be reset at the start of the stage, then the best we can do is the larger of the start and end values
+      double
+         dEndRSS = dGetCurrentRSS(),
+         dPeakRSS = (m_bCanResetPeakRSS ? dGetPeakRSS() : tMax(m_dStageStartRSS, dEndRSS));
+
+      m_dThisTimestepStageEndRSS[nStage] = dEndRSS;
+      m_dThisTimestepStagePeakRSS[nStage] = tMax(m_dThisTimestepStagePeakRSS[nStage], dPeakRSS);
+      m_dStagePeakRSS[nStage] = tMax(m_dStagePeakRSS[nStage], dPeakRSS);
+   }
+
+   if (m_pTraceWriter && m_pTraceWriter->bIsActive())
+      m_pTraceWriter->AddSpan(STAGE_NAME[nStage].c_str(), "stage", m_dTraceStageStart, INT_NODATA, NULL, 0);
+
+   // This is a safe point, so check whether the raster grid's tiles could all be paged in and out
+   if (m_pRasterGrid && m_pRasterGrid->m_Cell.bFailed())
+      return RTN_ERR_SCRATCH_FILE;
+
+   return nRet;
+}
+
+
+/*==============================================================================================================================
+
+ Writes the total wall-clock time spent in each stage of the timestep, and the peak resident set size, to the Out file
+
+==============================================================================================================================*/
+void CSimulation::WriteStageTimings(void)
+{
+   OutStream << endl;
+   OutStream << "Per-stage timings" << endl;
+   OutStream << "-----------------" << endl;
+
+   double dTotal = 0;
+   OutStream << resetiosflags(ios::floatfield) << setiosflags(ios::fixed) << setprecision(3);
+   for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+   {
+      string strName = STAGE_NAME[nStage];
+      strName.resize(45, ' ');
+      OutStream << strName << "\t: " << m_dStageTime[nStage] << " s" << endl;
+
+      dTotal += m_dStageTime[nStage];
+   }
+   OutStream << "All stages                                   \t: " << dTotal << " s" << endl;
+
+#if defined __GNUG__ && ! defined _WIN32
+   // Note that on Linux, ru_maxrss is in kilobytes. Also if per-stage memory use is being recorded, then ru_maxrss may have been reset, so use the largest per-stage peak instead if this is bigger
+   rusage ru;
+   if (getrusage(RUSAGE_SELF, &ru) >= 0)
+   {
+      double dPeakRSS = ru.ru_maxrss / 1024.0;
+      for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+         dPeakRSS = tMax(dPeakRSS, m_dStagePeakRSS[nStage]);
+
+      OutStream << "Peak resident set size                       \t: " << dPeakRSS << " Mb" << endl;
+   }
+#endif
+}
+
+
+/*==============================================================================================================================
+
+ Writes the total number of heap allocations, and the number of Mb requested, for each stage of the timestep to the Out file. Also writes the peak resident set size during each stage
+
+==============================================================================================================================*/
+void CSimulation::WriteStageMemory(void)
+{
+   OutStream << endl;
+   OutStream << "Per-stage memory use" << endl;
+   OutStream << "--------------------" << endl;
+
+   unsigned long long
+      ullTotAllocs = 0,
+      ullTotBytes = 0;
+   OutStream << resetiosflags(ios::floatfield) << setiosflags(ios::fixed) << setprecision(1);
+   for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+   {
+      string strName = STAGE_NAME[nStage];
+      strName.resize(45, ' ');
+      OutStream << strName << "\t: " << m_ullStageAllocs[nStage] << " allocations, " << m_ullStageAllocBytes[nStage] / (1024.0 * 1024.0) << " Mb allocated, peak resident set size " << m_dStagePeakRSS[nStage] << " Mb" << endl;
+
+      ullTotAllocs += m_ullStageAllocs[nStage];
+      ullTotBytes += m_ullStageAllocBytes[nStage];
+   }
+   OutStream << "All stages                                   \t: " << ullTotAllocs << " allocations, " << ullTotBytes / (1024.0 * 1024.0) << " Mb allocated" << endl;
+
+   if (! m_bCanResetPeakRSS)
+      OutStream << "NOTE: could not reset the peak resident set size at the start of each stage, so per-stage peaks are estimated from the resident set size at the start and end of each stage" << endl;
+}
+
+
+/*==============================================================================================================================
+
+ Writes the total hardware performance counts for each stage of the timestep to the Out file, together with instructions per cycle and cache and branch misses per thousand instructions. A stage with low instructions per cycle and many cache misses is likely to be limited by memory bandwidth, while one with many branch misses is likely to be limited by branch prediction
+
+==============================================================================================================================*/
+void CSimulation::WriteStageHWCounters(void)
+{
+   OutStream << endl;
+   OutStream << "Per-stage hardware performance counters (user space, all threads)" << endl;
+   OutStream << "-----------------------------------------------------------------" << endl;
+
+   OutStream << "                                             \t";
+   for (int n = 0; n < NUM_HW_COUNTERS; n++)
+      OutStream << setw(16) << HW_COUNTER_NAME[n];
+   OutStream << setw(10) << "IPC" << setw(14) << "cache MPKI" << setw(14) << "branch MPKI" << endl;
+
+   OutStream << resetiosflags(ios::floatfield) << setiosflags(ios::fixed) << setprecision(2);
+   for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+   {
+      string strName = STAGE_NAME[nStage];
+      strName.resize(45, ' ');
+      OutStream << strName << "\t";
+
+      for (int n = 0; n < NUM_HW_COUNTERS; n++)
+      {
+         if (bHWCounterAvailable(n))
+            OutStream << setw(16) << m_ullStageHW[nStage][n];
+         else
+            OutStream << setw(16) << "n/a";
+      }
+
+      double dInstructions = static_cast<double>(m_ullStageHW[nStage][HW_INSTRUCTIONS]);
+      if (bHWCounterAvailable(HW_INSTRUCTIONS) && bHWCounterAvailable(HW_CYCLES) && (m_ullStageHW[nStage][HW_CYCLES] > 0))
+         OutStream << setw(10) << dInstructions / m_ullStageHW[nStage][HW_CYCLES];
+      else
+         OutStream << setw(10) << "n/a";
+
+      if (bHWCounterAvailable(HW_INSTRUCTIONS) && bHWCounterAvailable(HW_CACHE_MISSES) && (dInstructions > 0))
+         OutStream << setw(14) << 1000 * m_ullStageHW[nStage][HW_CACHE_MISSES] / dInstructions;
+      else
+         OutStream << setw(14) << "n/a";
+
+      if (bHWCounterAvailable(HW_INSTRUCTIONS) && bHWCounterAvailable(HW_BRANCH_MISSES) && (dInstructions > 0))
+         OutStream << setw(14) << 1000 * m_ullStageHW[nStage][HW_BRANCH_MISSES] / dInstructions;
+      else
+         OutStream << setw(14) << "n/a";
+
+      OutStream << endl;
+   }
+
+   for (int n = 0; n < NUM_HW_COUNTERS; n++)
+   {
+      if (! bHWCounterAvailable(n))
+         OutStream << "NOTE: the " << HW_COUNTER_NAME[n] << " counter is not available on this system" << endl;
+   }
+}
+
+
+/*==============================================================================================================================
+
+ Writes this timestep's per-stage timings, memory use and hardware performance counts to the stages time series file, if any of these are being recorded. Then zeroes this timestep's values
+
+==============================================================================================================================*/
+bool CSimulation::bWriteStageTSFile(void)
+{
+   if (! (m_bStageTimings || m_bStageMemory || m_bStageHWCounters))
+      return true;
+
+   StageTSStream << m_ulTimestep << "," << m_dSimElapsed;
+   for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+   {
+      if (m_bStageTimings)
+         StageTSStream << "," << m_dThisTimestepStageTime[nStage];
+
+      if (m_bStageMemory)
+         StageTSStream << "," << m_ullThisTimestepStageAllocs[nStage] << "," << m_ullThisTimestepStageAllocBytes[nStage] << "," << m_dThisTimestepStageEndRSS[nStage] << "," << m_dThisTimestepStagePeakRSS[nStage];
+
+      if (m_bStageHWCounters)
+      {
+         // Counters which are not available are left empty
+         for (int n = 0; n < NUM_HW_COUNTERS; n++)
+         {
+            StageTSStream << ",";
+            if (bHWCounterAvailable(n))
+               StageTSStream << m_ullThisTimestepStageHW[nStage][n];
+
+            m_ullThisTimestepStageHW[nStage][n] = 0;
+         }
+      }
+
+      m_dThisTimestepStageTime[nStage] =
+      m_dThisTimestepStageEndRSS[nStage] =
+      m_dThisTimestepStagePeakRSS[nStage] = 0;
+      m_ullThisTimestepStageAllocs[nStage] =
+      m_ullThisTimestepStageAllocBytes[nStage] = 0;
+   }
+   StageTSStream << endl;
+
+   // Did a time series file write error occur?
+   if (StageTSStream.fail())
+      return false;
+
+   return true;
+}
+
+
+/*==============================================================================================================================
+
+ If the status server is running, sends it the current status of the simulation as JSON: timestep, simulated time, estimated time remaining, the wall-clock time taken by the latest timestep and by each stage of it (also rolling averages of these), numbers of coasts, profiles and polygons, and the mass balance errors. This is cheap, and never waits for a client
+
+==============================================================================================================================*/
+void CSimulation::PublishStatus(string const& strState)
+{
+   if (! m_pStatusServer)
+      return;
+
+   double dNow = dGetWallClock();
+   bool bTimestepDone = (strState == STATUS_RUNNING) && (m_ulTimestep > 0);
+   if (bTimestepDone)
+   {
+      // Update the rolling timings. For the first timestep, the rolling value is just the latest value
+      double dWeight = (m_ulTimestep > 1 ? STATUS_ROLLING_WEIGHT : 1);
+
+      m_dStatusTimestepTime = dNow - m_dStatusLastPublish;
+      m_dStatusRollingTimestepTime += dWeight * (m_dStatusTimestepTime - m_dStatusRollingTimestepTime);
+
+      for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+      {
+         double dStageTime = m_dStageTime[nStage] - m_dStatusLastStageTime[nStage];
+         m_dStatusLastStageTime[nStage] = m_dStageTime[nStage];
+         m_dStatusRollingStageTime[nStage] += dWeight * (dStageTime - m_dStatusRollingStageTime[nStage]);
+      }
+   }
+   m_dStatusLastPublish = dNow;
+
+   int
+      nProfiles = 0,
+      nPolygons = 0;
+   for (unsigned int n = 0; n < m_VCoast.size(); n++)
+   {
+      nProfiles += m_VCoast[n].nGetNumProfiles();
+      nPolygons += m_VCoast[n].nGetNumPolygons();
+   }
+
+   double
+      dWallElapsed = std::difftime(std::time(nullptr), m_tSysStartTime),
+      dFraction = (m_dSimDuration > 0 ? m_dSimElapsed / m_dSimDuration : 0),
+      dToGo = (dFraction > 0 ? (dWallElapsed / dFraction) - dWallElapsed : 0);
+
+   stringstream strstr;
+   strstr << setprecision(10);
+   strstr << "{\"program\":\"" << PROGNAME << "\",\"state\":\"" << strState << "\",\"timestep\":" << m_ulTimestep;
+   strstr << ",\"sim_elapsed_hours\":" << m_dSimElapsed << ",\"sim_duration_hours\":" << m_dSimDuration << ",\"percent_complete\":" << 100 * dFraction;
+   strstr << ",\"wall_elapsed_secs\":" << dWallElapsed << ",\"wall_remaining_secs\":" << dToGo;
+   strstr << ",\"timestep_secs\":" << m_dStatusTimestepTime << ",\"rolling_timestep_secs\":" << m_dStatusRollingTimestepTime;
+
+   strstr << ",\"stages\":[";
+   for (int nStage = 0; nStage < NUM_STAGES; nStage++)
+   {
+      if (nStage > 0)
+         strstr << ",";
+      strstr << "{\"name\":\"" << STAGE_NAME[nStage] << "\",\"rolling_secs\":" << m_dStatusRollingStageTime[nStage] << ",\"total_secs\":" << m_dStageTime[nStage] << "}";
+   }
+   strstr << "]";
+
+   strstr << ",\"coasts\":" << m_VCoast.size() << ",\"profiles\":" << nProfiles << ",\"polygons\":" << nPolygons;
+   strstr << ",\"mass_balance\":{\"erosion_error\":" << m_dThisTimestepMassBalanceErosionError << ",\"deposition_error\":" << m_dThisTimestepMassBalanceDepositionError << ",\"total_erosion_error\":" << m_ldGTotMassBalanceErosionError << ",\"total_deposition_error\":" << m_ldGTotMassBalanceDepositionError << "}";
+   strstr << "}";
+
+   string strStatus = strstr.str();
+   m_pStatusServer->SetStatus(strStatus);
+}
+
+
+/*==============================================================================================================================
+
+ Publishes top elevation, sea depth, wave height and polygon ID for every cell, and the coastlines, in shared memory. These are written directly into the shared-memory buffer which is not currently being read
+
+==============================================================================================================================*/
+void CSimulation::PublishSharedExport(void)
+{
+   m_pSharedExport->StartWrite();
+
+   float
+      * pfTopElev = m_pSharedExport->pfGetField(SHARED_EXPORT_TOP_ELEV),
+      * pfSeaDepth = m_pSharedExport->pfGetField(SHARED_EXPORT_SEA_DEPTH),
+      * pfWaveHeight = m_pSharedExport->pfGetField(SHARED_EXPORT_WAVE_HEIGHT);
+   int32_t* pnPolygonID = m_pSharedExport->pnGetPolygonID();
+
+   // Stored by row from the north edge, as for the raster GIS output. Each row is independent, so do this in parallel. If the grid is tiled, then do one row of tiles at a time, paging out in between: this only reads cells, so is a passive sweep
+   int nRowsAtOnce = (m_pRasterGrid->m_Cell.bIsTiled() ? m_pRasterGrid->m_Cell.nGetTileSide() : m_nYGridMax);
+   m_pRasterGrid->m_Cell.StartPassiveSweep();
+   for (int nYStart = 0; nYStart < m_nYGridMax; nYStart += nRowsAtOnce)
+   {
+      int nYEnd = tMin(nYStart + nRowsAtOnce, m_nYGridMax);
+
+#ifdef _OPENMP
+      #pragma omp parallel for
+#endif
+      for (int nY = nYStart; nY < nYEnd; nY++)
+      {
+         size_t nRowStart = static_cast<size_t>(nY) * m_nXGridMax;
+         for (int nX = 0; nX < m_nXGridMax; nX++)
+         {
+            CGeomCell* pCell = &m_pRasterGrid->m_Cell[nX][nY];
+            size_t n = nRowStart + nX;
+
+            pfTopElev[n] = static_cast<float>(pCell->dGetOverallTopElev());
+            pfSeaDepth[n] = static_cast<float>(pCell->dGetSeaDepth());
+            pfWaveHeight[n] = static_cast<float>(pCell->bIsInContiguousSea() ? pCell->dGetWaveHeight() : m_dMissingValue);
+            pnPolygonID[n] = pCell->nGetPolygonID();
+         }
+      }
+
+      m_pRasterGrid->m_Cell.PageOutUnused();
+   }
+   m_pRasterGrid->m_Cell.EndPassiveSweep();
+
+   // Now the coastlines, in external CRS units. If there is not enough room for them all, publish as many as will fit
+   int32_t* pnCoastStart = m_pSharedExport->pnGetCoastStart();
+   double* pdCoastPoint = m_pSharedExport->pdGetCoastPoints();
+   int
+      nCoasts = 0,
+      nPoints = 0;
+   bool bTruncated = false;
+   for (unsigned int nCoast = 0; nCoast < m_VCoast.size(); nCoast++)
+   {
+      CGeomLine* pLCoast = m_VCoast[nCoast].pLGetCoastline();
+      int nSize = pLCoast->nGetSize();
+      if ((nCoasts >= m_pSharedExport->nGetMaxCoasts()) || (nPoints + nSize > m_pSharedExport->nGetMaxCoastPoints()))
+      {
+         bTruncated = true;
+         break;
+      }
+
+      pnCoastStart[nCoasts] = nPoints;
+      for (int n = 0; n < nSize; n++)
+      {
+         pdCoastPoint[2 * nPoints] = pLCoast->dGetXAt(n);
+         pdCoastPoint[2 * nPoints + 1] = pLCoast->dGetYAt(n);
+         nPoints++;
+      }
+      nCoasts++;
+   }
+   pnCoastStart[nCoasts] = nPoints;
+
+   if (bTruncated)
+      LogStream << m_ulTimestep << ": " << WARN << "too many coastlines or coastline points for shared-memory export, only " << nCoasts << " of " << m_VCoast.size() << " coastlines published" << endl;
+
+   m_pSharedExport->Publish(m_ulTimestep, m_dSimElapsed, nCoasts, nPoints, bTruncated);
+}
+
+
 /*==============================================================================================================================
 
  Returns an error message given an error code
@@ -1975,6 +2444,9 @@ string CSimulation::strGetErrorText(int const nErr)
    case RTN_ERR_GRIDCREATE:
       strErr = "while running GDALGridCreate()";
       break;
+   case RTN_ERR_SCRATCH_FILE:
+      strErr = "cannot read or write grid tile scratch file";
+      break;
    default:
       // should never get here
       strErr = "unknown cause";
@@ -1995,6 +2467,14 @@ void CSimulation::DoSimulationEnd(int const nRtn)
    if (m_tSysEndTime == 0)
       m_tSysEndTime = std::time(nullptr);
 
+   // If a tile of the raster grid could not be paged in or out, then say why. Any other error since then may just be a consequence of this
+   if ((nRtn != RTN_OK) && m_pRasterGrid && m_pRasterGrid->m_Cell.bFailed())
+   {
+      cerr << ERR << m_pRasterGrid->m_Cell.strGetError() << endl;
+      if (LogStream && LogStream.is_open())
+         LogStream << ERR << m_pRasterGrid->m_Cell.strGetError() << endl;
+   }
+
    switch (nRtn)
    {
    case (RTN_OK):
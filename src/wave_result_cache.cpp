@@ -0,0 +1,222 @@
+/*!
+ *
+ * \file wave_result_cache.cpp
+ * \brief CWaveResultCache routines
+ * \details Caches the results of wave propagation between timesteps
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ */
+
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include "cme.h"
+#include "wave_result_cache.h"
+
+
+CWaveResultCache::CWaveResultCache(void)
+:
+   m_ulUses(0),
+   m_ulHits(0),
+   m_ulMisses(0),
+   m_ulRejected(0),
+   m_ulDiscarded(0)
+{
+}
+
+CWaveResultCache::~CWaveResultCache(void)
+{
+}
+
+
+//! Adds a value to a hash (this is the 64-bit FNV-1a hash, applied to each byte of the value in turn)
+unsigned long long CWaveResultCache::ullHash(unsigned long long const ullHashIn, long long const llValue)
+{
+   unsigned long long
+      ullHashOut = ullHashIn,
+      ullValue = static_cast<unsigned long long>(llValue);
+
+   for (int n = 0; n < 8; n++)
+   {
+      ullHashOut ^= (ullValue & 0xff);
+      ullHashOut *= 1099511628211ULL;
+      ullValue >>= 8;
+   }
+
+   return ullHashOut;
+}
+
+
+//! Returns the approximate number of bytes used by an entry
+unsigned long CWaveResultCache::ulGetEntryBytes(CacheEntry const* pEntry)
+{
+   unsigned long ulBytes = sizeof(CacheEntry);
+
+   ulBytes += pEntry->llVForcing.capacity() * sizeof(long long);
+   ulBytes += (pEntry->nVCoastCell.capacity() + pEntry->nVBlockSeaCells.capacity() + pEntry->nVShadowZoneCode.capacity()) * sizeof(int);
+   ulBytes += (pEntry->dVBlockElev.capacity() + pEntry->dVWaveHeight.capacity() + pEntry->dVWaveOrientation.capacity() + pEntry->dVTotWaveHeightIncr.capacity() + pEntry->dVTotWaveOrientationIncr.capacity()) * sizeof(double);
+   ulBytes += pEntry->cVFlags.capacity();
+
+   for (unsigned int n = 0; n < pEntry->VCoast.size(); n++)
+   {
+      CoastResult const* pCoast = &pEntry->VCoast[n];
+
+      ulBytes += sizeof(CoastResult);
+      ulBytes += pCoast->nVBreakingDistance.capacity() * sizeof(int);
+      ulBytes += (pCoast->dVBreakingWaveHeight.capacity() + pCoast->dVBreakingWaveOrientation.capacity() + pCoast->dVDepthOfBreaking.capacity() + pCoast->dVFluxOrientation.capacity()) * sizeof(double);
+
+      for (unsigned int m = 0; m < pCoast->LVShadowZoneBoundary.size(); m++)
+         ulBytes += sizeof(CGeomLine) + (pCoast->LVShadowZoneBoundary[m].nGetSize() * sizeof(CGeom2DPoint));
+   }
+
+   return ulBytes;
+}
+
+
+//! Returns true if an entry's signature matches the given signature: the binned forcing and bounding box, the coastline cells, and the number of sea cells in each block must be identical, and the mean elevation of each block must be within WAVE_CACHE_ELEV_TOLERANCE
+bool CWaveResultCache::bSignatureMatches(CacheEntry const* pEntry, vector<long long> const* pllVForcing, vector<int> const* pnVCoastCell, vector<int> const* pnVBlockSeaCells, vector<double> const* pdVBlockElev)
+{
+   if ((pEntry->llVForcing != *pllVForcing) || (pEntry->nVCoastCell != *pnVCoastCell) || (pEntry->nVBlockSeaCells != *pnVBlockSeaCells) || (pEntry->dVBlockElev.size() != pdVBlockElev->size()))
+      return false;
+
+   for (unsigned int n = 0; n < pdVBlockElev->size(); n++)
+   {
+      if (tAbs(pEntry->dVBlockElev[n] - pdVBlockElev->at(n)) > WAVE_CACHE_ELEV_TOLERANCE)
+         return false;
+   }
+
+   return true;
+}
+
+
+//! Looks for a cached result with the given key whose signature matches the given signature. Returns a pointer to the entry, or NULL if there is none. Either way, records a hit or a miss
+CWaveResultCache::CacheEntry const* CWaveResultCache::pFindEntry(unsigned long long const ullKey, vector<long long> const* pllVForcing, vector<int> const* pnVCoastCell, vector<int> const* pnVBlockSeaCells, vector<double> const* pdVBlockElev)
+{
+   m_ulUses++;
+
+   bool bRejected = false;
+   for (unsigned int n = 0; n < m_VEntry.size(); n++)
+   {
+      if (m_VEntry[n].ullKey != ullKey)
+         continue;
+
+      if (bSignatureMatches(&m_VEntry[n], pllVForcing, pnVCoastCell, pnVBlockSeaCells, pdVBlockElev))
+      {
+         m_VEntry[n].ulLastUsed = m_ulUses;
+         m_ulHits++;
+         return &m_VEntry[n];
+      }
+
+      bRejected = true;
+   }
+
+   // No usable result. If there was an entry with the same key, then either the bathymetry or the coastlines have changed too much since it was stored, or (very rarely) there was a hash collision
+   m_ulMisses++;
+   if (bRejected)
+      m_ulRejected++;
+
+   return NULL;
+}
+
+
+//! Returns an entry for a new result with the given key and signature, which the caller must then fill. If there is already an entry with this key and the same binned forcing and bounding box (which the caller could not use, because the bathymetry or the coastlines have changed) then it is overwritten, re-using its storage. Otherwise a new entry is added: the caller must then call LimitMemory()
+CWaveResultCache::CacheEntry* CWaveResultCache::pAddEntry(unsigned long long const ullKey, vector<long long> const* pllVForcing, vector<int> const* pnVCoastCell, vector<int> const* pnVBlockSeaCells, vector<double> const* pdVBlockElev)
+{
+   int nEntry = -1;
+   for (unsigned int n = 0; n < m_VEntry.size(); n++)
+   {
+      if ((m_VEntry[n].ullKey == ullKey) && (m_VEntry[n].llVForcing == *pllVForcing))
+      {
+         nEntry = n;
+         break;
+      }
+   }
+
+   if (nEntry < 0)
+   {
+      m_VEntry.push_back(CacheEntry());
+      nEntry = m_VEntry.size()-1;
+   }
+
+   // Assignment keeps the entry's existing storage, if there is enough of it
+   m_VEntry[nEntry].ullKey = ullKey;
+   m_VEntry[nEntry].ulLastUsed = m_ulUses;
+   m_VEntry[nEntry].llVForcing = *pllVForcing;
+   m_VEntry[nEntry].nVCoastCell = *pnVCoastCell;
+   m_VEntry[nEntry].nVBlockSeaCells = *pnVBlockSeaCells;
+   m_VEntry[nEntry].dVBlockElev = *pdVBlockElev;
+   m_VEntry[nEntry].VCoast.clear();
+
+   return &m_VEntry[nEntry];
+}
+
+
+//! Discards the least recently used entries (but never the given entry, which has just been filled) until the cache uses no more than WAVE_CACHE_MAX_MB
+void CWaveResultCache::LimitMemory(CacheEntry const* pKeep)
+{
+   double const dMaxBytes = WAVE_CACHE_MAX_MB * 1024 * 1024;
+
+   while ((m_VEntry.size() > 1) && (ulGetBytes() > dMaxBytes))
+   {
+      int nOldest = -1;
+      for (unsigned int n = 0; n < m_VEntry.size(); n++)
+      {
+         if (&m_VEntry[n] == pKeep)
+            continue;
+
+         if ((nOldest < 0) || (m_VEntry[n].ulLastUsed < m_VEntry[nOldest].ulLastUsed))
+            nOldest = n;
+      }
+
+      // Erasing an earlier entry moves the kept entry down by one
+      if (&m_VEntry[nOldest] < pKeep)
+         pKeep--;
+
+      m_VEntry.erase(m_VEntry.begin() + nOldest);
+      m_ulDiscarded++;
+   }
+}
+
+
+unsigned long CWaveResultCache::ulGetHits(void) const
+{
+   return m_ulHits;
+}
+
+unsigned long CWaveResultCache::ulGetMisses(void) const
+{
+   return m_ulMisses;
+}
+
+//! Returns the number of misses for which there was an entry with the same key, but with a signature which did not match
+unsigned long CWaveResultCache::ulGetRejected(void) const
+{
+   return m_ulRejected;
+}
+
+unsigned long CWaveResultCache::ulGetDiscarded(void) const
+{
+   return m_ulDiscarded;
+}
+
+//! Returns the approximate number of bytes used by all entries
+unsigned long CWaveResultCache::ulGetBytes(void) const
+{
+   unsigned long ulBytes = 0;
+   for (unsigned int n = 0; n < m_VEntry.size(); n++)
+      ulBytes += ulGetEntryBytes(&m_VEntry[n]);
+
+   return ulBytes;
+}
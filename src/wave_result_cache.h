@@ -0,0 +1,120 @@
+/*!
+ *
+ * \class CWaveResultCache
+ * \brief Class used to cache the results of wave propagation between timesteps
+ * \details With a varying wave climate, the same deep water wave height, period and orientation (and still water level) recur many times, and the near-shore bathymetry changes only slowly. So the results of wave propagation (the wave fields on each cell within the bounding box of the sea, and the breaking wave attributes at each coastline point) are stored, keyed on a hash of the binned forcing and the bounding box. Each entry also stores its signature: the binned forcing and bounding box, the coastline cells, and a coarse bathymetry signature (the mean elevation and number of sea cells in each block of cells). A later timestep re-uses the stored results only if its key is the same and its signature matches: the binned forcing, bounding box, coastline cells and numbers of sea cells must be identical, and the mean elevation of every block must be within a tolerance. So a hash collision can never restore the wrong results. The total memory used by the stored results is limited
+ * \author David Favis-Mortlock
+ * \author Andres Payo
+
+ * \date 2017
+ * \copyright GNU General Public License
+ *
+ * \file wave_result_cache.h
+ * \brief Contains CWaveResultCache definitions
+ *
+ */
+
+#ifndef WAVERESULTCACHE_H
+#define WAVERESULTCACHE_H
+/*===============================================================================================================================
+
+ This file is part of CoastalME, the Coastal Modelling Environment.
+
+ CoastalME is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+===============================================================================================================================*/
+#include <vector>
+using std::vector;
+
+#include "line.h"
+
+
+class CWaveResultCache
+{
+public:
+   // Wave propagation results for a single coastline
+   struct CoastResult
+   {
+      vector<int>
+         nVBreakingDistance;
+
+      vector<double>
+         dVBreakingWaveHeight,
+         dVBreakingWaveOrientation,
+         dVDepthOfBreaking,
+         dVFluxOrientation;
+
+      vector<CGeomLine>
+         LVShadowZoneBoundary;
+   };
+
+   // Wave propagation results for every cell within the bounding box of the sea, and for every coastline
+   struct CacheEntry
+   {
+      unsigned long long
+         ullKey;
+
+      unsigned long
+         ulLastUsed;                      // Used to find the least recently used entry
+
+      vector<long long>
+         llVForcing;                      // Binned forcing, bounding box, and the size of each coastline
+
+      vector<int>
+         nVCoastCell,                     // The cells marked as coastline, as (nX * m_nYGridMax) + nY, for every coastline in sequence
+         nVBlockSeaCells;                 // Per block: the number of cells in the contiguous sea
+
+      vector<double>
+         dVBlockElev;                     // Per block: the mean elevation
+
+      vector<char>
+         cVFlags;                         // Per cell: in active zone before holes are filled, in active zone, shadow zone boundary
+
+      vector<int>
+         nVShadowZoneCode;
+
+      vector<double>
+         dVWaveHeight,
+         dVWaveOrientation,
+         dVTotWaveHeightIncr,             // Per cell: increase in total wave height during wave propagation
+         dVTotWaveOrientationIncr;        // Per cell: increase in total wave orientation during wave propagation
+
+      vector<CoastResult>
+         VCoast;
+   };
+
+private:
+   unsigned long
+      m_ulUses,
+      m_ulHits,
+      m_ulMisses,
+      m_ulRejected,
+      m_ulDiscarded;
+
+   vector<CacheEntry>
+      m_VEntry;
+
+   static unsigned long ulGetEntryBytes(CacheEntry const*);
+   static bool bSignatureMatches(CacheEntry const*, vector<long long> const*, vector<int> const*, vector<int> const*, vector<double> const*);
+
+public:
+   CWaveResultCache(void);
+   ~CWaveResultCache(void);
+
+   static unsigned long long ullHash(unsigned long long const, long long const);
+
+   CacheEntry const* pFindEntry(unsigned long long const, vector<long long> const*, vector<int> const*, vector<int> const*, vector<double> const*);
+   CacheEntry* pAddEntry(unsigned long long const, vector<long long> const*, vector<int> const*, vector<int> const*, vector<double> const*);
+   void LimitMemory(CacheEntry const*);
+
+   unsigned long ulGetHits(void) const;
+   unsigned long ulGetMisses(void) const;
+   unsigned long ulGetRejected(void) const;
+   unsigned long ulGetDiscarded(void) const;
+   unsigned long ulGetBytes(void) const;
+};
+#endif // WAVERESULTCACHE_H
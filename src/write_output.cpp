@@ -43,6 +43,15 @@ using std::stringstream;
 
 #include "cme.h"
 #include "simulation.h"
+#include "profile_raster_cache.h"
+#include "parallel_profile_cache.h"
+#include "beach_profile_cache.h"
+#include "wave_result_cache.h"
+#include "trace_writer.h"
+#include "status_server.h"
+#include "shared_export.h"
+#include "raster_grid.h"
+#include "arena.h"
 
 
 /*==============================================================================================================================
@@ -419,6 +428,44 @@ void CSimulation::WriteStartRunDetails(void)
       OutStream << " (see " << m_strOutPath << EROSIONPOTENTIALLOOKUPFILE << ")";
    OutStream << endl;
    OutStream << " Erode coast in alternate directions?                      \t: " << (m_bErodeShorePlatformAlternateDirection ? "Y": "N") << endl;
+   OutStream << endl;
+
+   // ------------------------------------------------------ Performance ---------------------------------------------------------
+   OutStream << "Performance" << endl;
+   OutStream << " Keep rasterized profiles between timesteps?               \t: " << (m_bCacheProfileRaster ? "Y": "N") << endl;
+   OutStream << " Re-trace coastlines incrementally?                        \t: " << (m_bIncrementalCoastTrace ? "Y": "N") << endl;
+   OutStream << " Allocate coast objects per-timestep?                      \t: " << (m_bUseTimestepArena ? "Y": "N") << endl;
+   OutStream << " Rasterize polygons by scanline?                           \t: " << (m_bScanlinePolygonRaster ? "Y": "N") << endl;
+   OutStream << " Use per-polygon random number streams?                    \t: " << (m_bPolygonRandStreams ? "Y": "N") << endl;
+   OutStream << " Fuse estimation and application of beach erosion?         \t: " << (m_bFuseBeachErosion ? "Y": "N") << endl;
+   OutStream << " Do shore platform erosion in parallel?                    \t: " << (m_bParallelPlatformErosion ? "Y": "N") << endl;
+   OutStream << " Use tabulated linear wave theory (COVE only)?             \t: " << (m_bTabulateLinearWaves ? "Y": "N") << endl;
+   OutStream << " Find shadow zones by sweep line?                          \t: " << (m_bSweepLineShadowZones ? "Y": "N") << endl;
+   OutStream << " Batch cliff collapse deposition?                          \t: " << (m_bBatchCliffCollapseDeposition ? "Y": "N") << endl;
+   OutStream << " Cache wave propagation results?                           \t: " << (m_bCacheWaveResults ? "Y": "N") << endl;
+   OutStream << " Vector GIS output container                               \t: ";
+   if (m_nVectorGISContainer == VECTOR_CONTAINER_NONE)
+      OutStream << "one file per data item per save" << endl;
+   else if (m_nVectorGISContainer == VECTOR_CONTAINER_SAVE)
+      OutStream << "one file per save" << endl;
+   else if (m_nVectorGISContainer == VECTOR_CONTAINER_RUN)
+      OutStream << "one file for whole run" << endl;
+   OutStream << " Record per-stage timings?                                 \t: " << (m_bStageTimings ? "Y": "N") << endl;
+   OutStream << " Record per-stage memory use?                              \t: " << (m_bStageMemory ? "Y": "N") << endl;
+   OutStream << " Record per-stage hardware performance counters?           \t: " << (m_bStageHWCounters ? "Y": "N") << endl;
+   OutStream << " Port for status server on localhost [0 = none]            \t: " << m_nStatusPort << endl;
+   OutStream << " Shared-memory export every Nth timestep [0 = never]       \t: " << m_nSharedExportInterval << endl;
+   if (m_nSharedExportInterval > 0)
+      OutStream << " Name of shared-memory segment                             \t: " << m_strSharedExportName << endl;
+   OutStream << " Side of each raster grid tile [0 = not tiled]             \t: " << m_nGridTileSide << endl;
+   if (m_nGridTileSide > 0)
+   {
+      OutStream << " Memory for raster grid tiles (Mb)                         \t: " << m_dGridTileCacheMb << endl;
+      OutStream << " Directory for grid tile scratch file                      \t: " << (m_strGridTileDir.empty() ? m_strOutPath : m_strGridTileDir) << endl;
+   }
+   OutStream << " Write Chrome trace of every Nth timestep [0 = no trace]   \t: " << m_nTraceTimestepInterval << endl;
+   OutStream << " Trace every Nth profile and polygon [1 = all]             \t: " << m_nTraceItemInterval << endl;
+   OutStream << " Maximum number of trace spans held in memory              \t: " << m_nTraceBufferSize << endl;
 
    OutStream << endl << endl;
 
@@ -848,6 +895,9 @@ int CSimulation::nWriteEndRunDetails(void)
    if (! bSaveAllVectorGISFiles())
       return (RTN_ERR_VECTOR_FILE_WRITE);
 
+   // If all vector GIS output went to a single file for the whole run, then close it
+   CloseVectorGISContainer();
+
    OutStream << " GIS" << m_nGISSave << endl;
 
    // Print out run totals etc.
@@ -975,6 +1025,83 @@ int CSimulation::nWriteEndRunDetails(void)
    LogStream << "Between-profile average potential shore platform erosion = " << (m_ulTotPotentialPlatformErosionBetweenProfiles > 0 ? m_dTotPotErosionBetweenProfiles / m_ulTotPotentialPlatformErosionBetweenProfiles : 0) << " mm (n = " << m_ulTotPotentialPlatformErosionBetweenProfiles << ")" << endl;
    LogStream << endl;
 
+   // How well did the profile raster cache do?
+   if (m_bCacheProfileRaster)
+   {
+      LogStream << "Rasterized profiles re-used from earlier timesteps = " << m_pProfileRasterCache->ulGetHits() << ", rasterized afresh = " << m_pProfileRasterCache->ulGetMisses() << ", discarded = " << m_pProfileRasterCache->ulGetInvalidated() << endl;
+      LogStream << endl;
+   }
+
+   // How well did the parallel profile cache do?
+   if (m_pParallelProfileCache)
+   {
+      LogStream << "Parallel profiles re-used = " << m_pParallelProfileCache->ulGetHits() << ", constructed = " << m_pParallelProfileCache->ulGetMisses() << ", cache cleared = " << m_pParallelProfileCache->ulGetClears() << " times" << endl;
+      LogStream << endl;
+   }
+
+   // How often was parallel profile geometry from the estimation of beach erosion re-used?
+   if (m_pBeachProfileCache)
+   {
+      LogStream << "Parallel profiles from estimation re-used during beach erosion = " << m_pBeachProfileCache->ulGetHits() << ", constructed afresh = " << m_pBeachProfileCache->ulGetMisses() << endl;
+      LogStream << endl;
+   }
+
+   // How many vector GIS features were written, and in how many transactions?
+   LogStream << "Vector GIS features written = " << m_ulTotVectorGISFeatures << ", in " << m_ulTotVectorGISTransactions << " transactions" << endl;
+   LogStream << endl;
+
+   // How much was traced?
+   if (m_pTraceWriter)
+   {
+      LogStream << "Chrome trace of " << m_pTraceWriter->ulGetNumTimesteps() << " timesteps written to " << m_pTraceWriter->strGetFile() << ": " << m_pTraceWriter->ulGetNumEvents() << " spans, in " << m_pTraceWriter->ulGetNumFlushes() << " writes" << endl;
+      LogStream << endl;
+   }
+
+   // How often was the status server asked for the status?
+   if (m_pStatusServer)
+   {
+      LogStream << "Status server on port " << m_pStatusServer->nGetPort() << " answered " << m_pStatusServer->ulGetRequests() << " requests" << endl;
+      LogStream << endl;
+   }
+
+   // How many times were grid fields and coastlines published in shared memory?
+   if (m_pSharedExport)
+   {
+      LogStream << "Grid fields and coastlines published " << m_pSharedExport->ullGetSequence() << " times in shared-memory segment " << m_pSharedExport->strGetName() << endl;
+      LogStream << endl;
+   }
+
+   // If the raster grid was tiled, how much paging was done?
+   if (m_pRasterGrid && m_pRasterGrid->m_Cell.bIsTiled())
+   {
+      CTiledCellArray const* pCells = &m_pRasterGrid->m_Cell;
+      LogStream << "Raster grid held as " << pCells->nGetNumTiles() << " tiles of " << pCells->nGetTileSide() << " x " << pCells->nGetTileSide() << " cells, memory for " << pCells->nGetMaxResident() << " tiles. Most tiles in memory at once = " << pCells->nGetPeakResident() << ", tiles in coastal band at end = " << pCells->nGetInBand() << endl;
+      LogStream << "Grid tiles created = " << pCells->ulGetCreated() << ", read = " << pCells->ulGetLoads() << ", paged out = " << pCells->ulGetEvictions() << " (" << pCells->ulGetCleanEvictions() << " unchanged, so not written)" << endl;
+      LogStream << "Grid tile scratch file " << pCells->strGetFile() << ": " << pCells->ullGetFileSize() / (1024.0 * 1024.0) << " Mb, " << pCells->ullGetBytesRead() / (1024.0 * 1024.0) << " Mb read, " << pCells->ullGetBytesWritten() / (1024.0 * 1024.0) << " Mb written" << endl;
+      LogStream << endl;
+   }
+
+   // How well did the wave propagation result cache do?
+   if (m_pWaveResultCache)
+   {
+      LogStream << "Wave propagation results re-used = " << m_pWaveResultCache->ulGetHits() << ", calculated = " << m_pWaveResultCache->ulGetMisses() << " (of which " << m_pWaveResultCache->ulGetRejected() << " had a cached result whose bathymetry or coastlines did not match), discarded = " << m_pWaveResultCache->ulGetDiscarded() << ", memory used = " << m_pWaveResultCache->ulGetBytes() / (1024 * 1024) << " Mb" << endl;
+      LogStream << endl;
+   }
+
+   // How well were batched cliff collapses grouped for deposition?
+   if (m_bBatchCliffCollapseDeposition)
+   {
+      LogStream << "Cliff collapses batched for talus deposition = " << m_ulTotCliffCollapsesBatched << ", in " << m_ulTotCliffCollapseDepositionGroups << " non-overlapping groups" << endl;
+      LogStream << endl;
+   }
+
+   // How much memory did the per-timestep arenas need?
+   if (m_bUseTimestepArena)
+   {
+      LogStream << "Per-timestep arenas: maximum in use = " << tMax(m_pThisTimestepArena->ulGetMaxBytesInUse(), m_pLastTimestepArena->ulGetMaxBytesInUse()) << " bytes, reserved = " << m_pThisTimestepArena->ulGetBytesReserved() + m_pLastTimestepArena->ulGetBytesReserved() << " bytes, resets = " << m_pThisTimestepArena->ulGetResets() + m_pLastTimestepArena->ulGetResets() << endl;
+      LogStream << endl;
+   }
+
 #if ! defined RANDCHECK
    // Calculate length of run, write in file (note that m_dSimDuration is in hours)
    CalcTime(m_dSimDuration * 3600);
@@ -982,6 +1109,18 @@ int CSimulation::nWriteEndRunDetails(void)
 
    // Calculate statistics re. memory usage etc.
    CalcProcessStats();
+
+   // And how long each stage of the timestep took, if required
+   if (m_bStageTimings)
+      WriteStageTimings();
+
+   // Ditto for memory use
+   if (m_bStageMemory)
+      WriteStageMemory();
+
+   // Ditto for hardware performance counters
+   if (m_bStageHWCounters)
+      WriteStageHWCounters();
    OutStream << endl << "END OF RUN" << endl;
    LogStream << endl << "END OF RUN" << endl;
 